@@ -1,5 +1,6 @@
 #include "editor.hpp"
 
+#include <wren/mesh_cache.hpp>
 #include <wren/render_target.hpp>
 
 #include "filesystem_panel.hpp"
@@ -23,6 +24,7 @@ auto Editor::create(const std::shared_ptr<wren::Application> &app,
 
   auto editor = std::make_shared<Editor>(app->context());
   editor->editor_context_.asset_manager = asset_manager;
+  wren::MeshCache::shared()->database(asset_manager.database());
   editor->editor_context_.project_path = project_path;
   editor->load_scene();
 
@@ -43,6 +45,24 @@ auto Editor::create(const std::shared_ptr<wren::Application> &app,
              wren::vk::Shader::create(
                  app->context()->graphics_context->Device().get(), asset_path));
 
+  TRY_RESULT(const auto instanced_path,
+             editor->editor_context_.asset_manager.find_asset(
+                 "shaders/editor_mesh_instanced.wren_shader"));
+
+  TRY_RESULT(editor->instanced_mesh_shader_,
+             wren::vk::Shader::create(
+                 app->context()->graphics_context->Device().get(),
+                 instanced_path));
+
+  if (auto culling = wren::GpuCulling::create(app->context());
+      culling.has_value()) {
+    editor->culling_ = culling.value();
+  } else {
+    spdlog::warn("GPU culling unavailable ({}), culling on the CPU",
+                 culling.error().message());
+    editor->cpu_culling_ = std::make_shared<wren::CpuCulling>();
+  }
+
   TRY_RESULT(const auto graph, editor->build_render_graph(app->context()));
   TRY_RESULT(graph.build());
 
@@ -63,6 +83,7 @@ auto Editor::create(const std::shared_ptr<wren::Application> &app,
   editor->dset_[0] =
       ImGui_ImplVulkan_AddTexture(editor->texture_sampler_, scene_view,
                                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  editor->scene_view_ = scene_view;
 
   app->add_callback_to_phase(wren::CallbackPhase::Update,
                              [editor]() { editor->on_update(); });
@@ -78,20 +99,55 @@ Editor::Editor(const std::shared_ptr<wren::Context> &ctx)
 void Editor::on_update() {
   ZoneScoped;  // NOLINT
 
+  if (scene_loader_ != nullptr) {
+    if (const auto result = scene_loader_->update(kSceneLoadBudget);
+        !result.has_value()) {
+      spdlog::error("Failed to load scene: {}", result.error());
+      scene_loader_.reset();
+    } else if (scene_loader_->done()) {
+      scene_loader_.reset();
+    }
+  }
+
+  // Meshes changed on disk are loaded again
+  if (const auto changed = editor_context_.asset_manager.poll();
+      !changed.empty()) {
+    for (const auto &file : changed) {
+      wren::MeshCache::shared()->invalidate(file);
+    }
+
+    const auto &project = editor_context_.project_path;
+    scene_->world().each(
+        [&](wren::scene::components::MeshRenderer &mesh_renderer) {
+          const auto file =
+              std::filesystem::absolute(project / mesh_renderer.mesh_file())
+                  .lexically_normal();
+          if (std::ranges::find(changed, file) == changed.end()) return;
+          if (const auto result =
+                  mesh_renderer.update_mesh(project, mesh_renderer.mesh_file());
+              !result.has_value()) {
+            spdlog::warn("Failed to reload {}: {}", file.string(),
+                         result.error());
+          }
+        });
+  }
+
   if (scene_resized_.has_value()) {
     const auto &mesh_pass =
         wren_ctx_->renderer->get_graph().node_by_name("mesh")->render_pass;
 
     mesh_pass->resize_target(scene_resized_.value());
 
-    const auto scene_view = wren_ctx_->renderer->get_graph()
-                                .node_by_name("mesh")
-                                ->render_pass->colour_target()
-                                ->view();
-
-    ImGui_ImplVulkan_RemoveTexture(dset_[0]);
-    dset_[0] = ImGui_ImplVulkan_AddTexture(
-        texture_sampler_, scene_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    // The target is over-allocated, its image only changes once in a while
+    const auto scene_view = mesh_pass->colour_target()->view();
+    if (scene_view != scene_view_) {
+      wren_ctx_->graphics_context->deletion_queue()->push(
+          [dset = dset_[0]]() { ImGui_ImplVulkan_RemoveTexture(dset); });
+      dset_[0] = ImGui_ImplVulkan_AddTexture(
+          texture_sampler_, scene_view,
+          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+      scene_view_ = scene_view;
+    }
 
     camera_.aspect(static_cast<float>(scene_resized_->x()) /
                    static_cast<float>(scene_resized_->y()));
@@ -120,11 +176,25 @@ void Editor::on_update() {
   ImGui::Begin("Editor", nullptr, window_flags);
   if (ImGui::BeginMenuBar()) {
     if (ImGui::BeginMenu("File")) {
-      if (ImGui::MenuItem("Save")) {
+      // Saving a partially loaded scene would drop what isn't loaded yet
+      if (ImGui::MenuItem("Save", nullptr, false, scene_loader_ == nullptr)) {
         // SAVE the scene
 
-        auto file = editor_context_.project_path / "scene.wren";
-        wren::scene::serialize(scene_, file);
+        const auto file = editor_context_.project_path / "scene.wren";
+        const auto baked_file = std::filesystem::path{file}.replace_extension(
+            wren::scene::kBakedSceneExtension);
+        if (const auto saved = wren::scene::serialize(scene_, file);
+            !saved.has_value()) {
+          spdlog::error("Failed to save scene: {}", saved.error());
+        } else if (const auto baked =
+                       wren::scene::serialize_baked(scene_, baked_file);
+                   !baked.has_value()) {
+          // Loading reads the baked copy while it's newer than the TOML, a
+          // stale or half written one would hide what was just saved
+          spdlog::error("Failed to bake scene: {}", baked.error());
+          std::error_code ec;
+          std::filesystem::remove(baked_file, ec);
+        }
       }
 
       ImGui::EndMenu();
@@ -181,8 +251,16 @@ void Editor::on_update() {
     last_scene_size_ = curr_size_vec;
   }
 
-  ImGui::Image(dset_[0], {static_cast<float>(last_scene_size_.x()),
-                          static_cast<float>(last_scene_size_.y())});
+  // Only the part of the target that was rendered to
+  const auto scene_target = wren_ctx_->renderer->get_graph()
+                                .node_by_name("mesh")
+                                ->render_pass->colour_target();
+  const ImVec2 scene_uv{scene_target->size().x() / scene_target->extent().x(),
+                        scene_target->size().y() / scene_target->extent().y()};
+  ImGui::Image(dset_[0],
+               {static_cast<float>(last_scene_size_.x()),
+                static_cast<float>(last_scene_size_.y())},
+               {0, 0}, scene_uv);
   ImGui::End();
 
   render_inspector_panel(editor_context_, scene_, selected_entity_);
@@ -200,13 +278,52 @@ auto Editor::load_scene() -> wren::expected<void> {
 
   spdlog::info("Loading scene");
 
-  std::string scene_name;
+  const std::filesystem::path scene_file = "scene.wren";
+  const auto baked_file = std::filesystem::path{scene_file}.replace_extension(
+      wren::scene::kBakedSceneExtension);
+
+  // The TOML scene is the source, its baked copy is what's streamed in. It's
+  // baked again whenever the TOML is newer.
+  const auto& root = editor_context_.project_path;
+  std::error_code ec;
+  const auto source_time =
+      std::filesystem::last_write_time(root / scene_file, ec);
+  const auto baked_time =
+      std::filesystem::last_write_time(root / baked_file, ec);
+  if (ec || baked_time < source_time) {
+    if (const auto baked =
+            wren::scene::bake_scene(root / scene_file, root / baked_file);
+        !baked.has_value()) {
+      spdlog::warn("Failed to bake scene, loading the TOML: {}",
+                   baked.error());
+      return wren::scene::deserialize(root, scene_file, scene_);
+    }
+  }
 
-  wren::scene::deserialize(editor_context_.project_path, "scene.wren", scene_);
+  auto loader = wren::scene::SceneLoader::open(root, baked_file, scene_);
+  if (!loader.has_value()) {
+    spdlog::warn("Failed to load baked scene, loading the TOML: {}",
+                 loader.error());
+    return wren::scene::deserialize(root, scene_file, scene_);
+  }
+  // on_update() creates the entities a batch at a time
+  scene_loader_ = loader.value();
 
   return {};
 }
 
+auto Editor::view_projection() const -> wren::math::Mat4f {
+  auto projection = camera_.projection();
+  return projection * camera_.transform().matrix();
+}
+
+auto Editor::screen_projection() const -> wren::math::ScreenProjection {
+  // Not valid before the first layout, MeshRenderer keeps its level until then
+  return wren::math::ScreenProjection::from_camera(
+      camera_.transform().matrix(), camera_.projection(),
+      last_scene_size_.y());
+}
+
 auto Editor::build_render_graph(const std::shared_ptr<wren::Context> &ctx)
     -> wren::expected<wren::GraphBuilder> {
   wren::GraphBuilder builder(ctx);
@@ -217,13 +334,44 @@ auto Editor::build_render_graph(const std::shared_ptr<wren::Context> &ctx)
                          wren::scene::components::MeshRenderer>()
           .build();
 
+  if (culling_ != nullptr) {
+    builder.add_pass(
+        "cull",
+        wren::PassResources("cull")
+            .set_compute()
+            .add_shader(wren::GpuCulling::kShaderName, culling_->shader())
+            .add_shader(wren::GpuCulling::kMeshletShaderName,
+                        culling_->meshlet_shader())
+            .write(wren::GpuCulling::kDrawsResource),
+        [this, render_query](wren::RenderPass &pass, ::vk::CommandBuffer &cmd) {
+          culling_->begin(view_projection(), camera_.transform().matrix());
+          const auto projection = screen_projection();
+
+          render_query.each(
+              [this, &projection](
+                  const wren::scene::components::Transform &transform,
+                  wren::scene::components::MeshRenderer &mesh_renderer) {
+                const auto model = transform.matrix();
+                mesh_renderer.select_lod(projection, model);
+                mesh_renderer.cull(*culling_, model);
+              });
+
+          culling_->dispatch(pass, cmd);
+        });
+  }
+
+  auto mesh_resources = wren::PassResources("scene_viewer")
+                            .add_shader("mesh", mesh_shader_)
+                            .add_colour_target()
+                            .add_depth_target();
+  if (culling_ != nullptr) {
+    mesh_resources.add_shader("mesh_instanced", instanced_mesh_shader_)
+        .read(wren::GpuCulling::kDrawsResource);
+  }
+
   builder
       .add_pass(
-          "mesh",
-          wren::PassResources("scene_viewer")
-              .add_shader("mesh", mesh_shader_)
-              .add_colour_target()
-              .add_depth_target(),
+          "mesh", mesh_resources,
           [this, ctx, render_query](wren::RenderPass &pass,
                                     ::vk::CommandBuffer &cmd) {
             struct GLOBALS {
@@ -244,15 +392,53 @@ auto Editor::build_render_graph(const std::shared_ptr<wren::Context> &ctx)
             pass.bind_pipeline("mesh");
             pass.write_scratch_buffer(cmd, 0, 0, ubo);
 
+            if (cpu_culling_ == nullptr) {
+              // Meshlets and meshes the cull pass couldn't take
+              render_query.each(
+                  [this, &pass, cmd, ctx](
+                      const wren::scene::components::Transform &transform,
+                      wren::scene::components::MeshRenderer &mesh_renderer) {
+                    mesh_renderer.bind(ctx, pass, cmd, transform.matrix(),
+                                       culling_.get());
+                  });
+
+              // Everything else, one draw per mesh
+              pass.bind_pipeline("mesh_instanced");
+              pass.write_scratch_buffer(cmd, 0, 0, ubo);
+              culling_->draw_instances(pass, cmd);
+              return;
+            }
+
+            // Without GPU culling the draw list is culled here first
+            struct Draw {
+              wren::math::Mat4f model;
+              wren::scene::components::MeshRenderer *mesh_renderer;
+            };
+            std::vector<Draw> draws;
+
+            cpu_culling_->begin(view_projection());
+            const auto projection = screen_projection();
             render_query.each(
-                [cmd, ctx, this](
+                [this, &draws, &projection](
                     const wren::scene::components::Transform &transform,
                     wren::scene::components::MeshRenderer &mesh_renderer) {
-                  mesh_renderer.bind(ctx, mesh_shader_, cmd,
-                                     transform.matrix());
+                  const auto model = transform.matrix();
+                  const auto bounds = mesh_renderer.world_bounds(model);
+                  if (!bounds.has_value()) return;
+
+                  mesh_renderer.select_lod(projection, model);
+                  cpu_culling_->add(*bounds);
+                  draws.push_back({model, &mesh_renderer});
                 });
+            cpu_culling_->cull();
+
+            for (uint32_t i = 0; i < draws.size(); ++i) {
+              if (!cpu_culling_->visible(i)) continue;
+              draws[i].mesh_renderer->bind(ctx, pass, cmd, draws[i].model);
+            }
           })
-      .add_pass("ui", wren::PassResources("swapchain_target"),
+      .add_pass("ui",
+                wren::PassResources("swapchain_target").read("scene_viewer"),
                 [](wren::RenderPass &pass, ::vk::CommandBuffer &cmd) {
                   editor::ui::flush(cmd);
                 });
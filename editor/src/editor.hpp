@@ -4,13 +4,16 @@
 #include <imgui_impl_vulkan.h>
 #include <imgui_internal.h>
 
+#include <chrono>
 #include <filesystem>
 #include <memory>
 #include <tracy/Tracy.hpp>
 #include <vulkan/vulkan.hpp>
 #include <wren/application.hpp>
+#include <wren/culling.hpp>
 #include <wren/math/vector.hpp>
 #include <wren/mesh.hpp>
+#include <wren/scene/baked.hpp>
 #include <wren/scene/components/mesh.hpp>
 #include <wren/scene/deserialization.hpp>
 #include <wren/scene/scene.hpp>
@@ -25,6 +28,9 @@ namespace editor {
 
 class Editor {
  public:
+  //! @brief Time spent creating scene entities per frame while loading
+  static constexpr std::chrono::microseconds kSceneLoadBudget{4000};
+
   static auto create(const std::shared_ptr<wren::Application> &app,
                      const std::filesystem::path &project_path)
       -> wren::expected<std::shared_ptr<Editor>>;
@@ -39,6 +45,10 @@ class Editor {
   auto build_render_graph(const std::shared_ptr<wren::Context> &ctx)
       -> wren::expected<wren::GraphBuilder>;
 
+  [[nodiscard]] auto view_projection() const -> wren::math::Mat4f;
+  [[nodiscard]] auto screen_projection() const
+      -> wren::math::ScreenProjection;
+
   // Project
   Context editor_context_;
 
@@ -50,14 +60,22 @@ class Editor {
 
   // Scene management
   std::shared_ptr<wren::scene::Scene> scene_;
+  //! @brief Set while the scene is still streaming in
+  std::shared_ptr<wren::scene::SceneLoader> scene_loader_;
 
   std::shared_ptr<wren::Context> wren_ctx_;
 
   std::shared_ptr<wren::vk::Shader> mesh_shader_;
+  //! @brief Draws GPU culled instances, model matrices come from the culling
+  std::shared_ptr<wren::vk::Shader> instanced_mesh_shader_;
+  //! @brief GPU culling when available, CPU culling otherwise
+  std::shared_ptr<wren::GpuCulling> culling_;
+  std::shared_ptr<wren::CpuCulling> cpu_culling_;
   std::shared_ptr<wren::vk::Shader> viewer_shader_;
 
   // Scene viewer
   std::vector<VkDescriptorSet> dset_{};
+  vk::ImageView scene_view_;
   vk::Sampler texture_sampler_;
 
   std::optional<wren::math::Vec2f> scene_resized_;
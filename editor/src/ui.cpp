@@ -329,8 +329,22 @@ auto init(const std::shared_ptr<wren::Context>& context)
   init_info.MinImageCount = 2;
   init_info.ImageCount = context->renderer->swapchain_images_views().size();
   init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
-  init_info.RenderPass =
-      context->renderer->get_graph().node_by_name("ui")->render_pass->get();
+  const auto &ui_pass =
+      context->renderer->get_graph().node_by_name("ui")->render_pass;
+  init_info.RenderPass = ui_pass->get();
+
+  // Dynamic rendering passes don't have a render pass, ImGui builds its
+  // pipeline from the attachment formats instead
+  const auto colour_format =
+      static_cast<VkFormat>(ui_pass->pipeline_target().colour_format);
+  if (!ui_pass->get()) {
+    init_info.UseDynamicRendering = true;
+    init_info.PipelineRenderingCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &colour_format,
+    };
+  }
   init_info.DescriptorPool = pool;
   init_info.CheckVkResultFn = &check_result;
 
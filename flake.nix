@@ -49,7 +49,7 @@
 
           SDL2
           spdlog
-          # nlohmann_json
+          nlohmann_json
           tomlplusplus
 
           # vulkan / shaders
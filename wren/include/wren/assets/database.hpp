@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <wren/utils/result.hpp>
+
+namespace wren::assets {
+
+//! @brief An index of every file under a set of directories. Built with one
+//! walk over them and kept up to date with inotify, so looking an asset up is
+//! a hash lookup instead of a directory walk.
+//!
+//! Files are hashed the first time something asks for their hash, the hashes
+//! are kept in a manifest in the cache directory along with each file's size
+//! and write time, so unchanged files aren't read again on the next run.
+//! Imported artifacts (optimized meshes, ...) are stored in the cache directory
+//! under the hash of their source and its dependencies, an artifact that
+//! exists is up to date.
+//!
+//! Every member may be called from any thread, importers run on workers.
+class Database {
+ public:
+  //! @param roots Searched in order, an asset found in an earlier root wins
+  //! @param cache_dir Where the manifest and artifacts go, nothing is
+  //! persisted without one
+  static auto create(const std::vector<std::filesystem::path>& roots,
+                     const std::optional<std::filesystem::path>& cache_dir)
+      -> std::shared_ptr<Database>;
+
+  Database(const Database&) = delete;
+  Database(Database&&) = delete;
+  auto operator=(const Database&) -> Database& = delete;
+  auto operator=(Database&&) -> Database& = delete;
+  //! @brief Saves the manifest
+  ~Database();
+
+  //! @brief Resolve a path relative to a root or to any directory below one,
+  //! the same rules as utils::fs::file_exists_in_dir. Entries closer to
+  //! their root win.
+  [[nodiscard]] auto find(const std::filesystem::path& asset) const
+      -> expected<std::filesystem::path>;
+
+  //! @brief Content hash of a file found by find()
+  auto hash(const std::filesystem::path& file) -> expected<uint64_t>;
+
+  //! @brief Record that importing file reads dependency, changing the
+  //! dependency then changes file's artifacts too
+  void add_dependency(const std::filesystem::path& file,
+                      const std::filesystem::path& dependency);
+
+  //! @brief Where the artifact of kind (used as the extension) imported from
+  //! file goes. The name depends on the contents of file and its
+  //! dependencies, so if it exists it's current.
+  auto artifact(const std::filesystem::path& file, std::string_view kind)
+      -> expected<std::filesystem::path>;
+
+  //! @brief Apply the file system events since the last call. Returns the
+  //! files that were written, created or removed and every file depending
+  //! on them.
+  auto poll() -> std::vector<std::filesystem::path>;
+
+  auto save() const -> expected<void>;
+
+  [[nodiscard]] auto size() const -> std::size_t;
+
+ private:
+  struct Record {
+    std::size_t root = 0;
+    uintmax_t size = 0;
+    int64_t write_time = 0;
+    std::optional<uint64_t> hash;
+    std::vector<std::string> dependencies;
+  };
+
+  //! @brief A file a lookup key resolves to, the lowest priority wins
+  struct Candidate {
+    std::string file;
+    uint64_t priority = 0;
+  };
+
+  Database(std::vector<std::filesystem::path> roots,
+           std::optional<std::filesystem::path> cache_dir);
+
+  void index_directory(std::size_t root, const std::filesystem::path& dir);
+  void index_file(std::size_t root, const std::filesystem::path& file);
+  void remove_file(const std::string& file);
+  void watch(std::size_t root, const std::filesystem::path& dir);
+  void load_manifest();
+
+  //! @brief Lookup keys of a file, its path relative to each directory
+  //! between it and its root
+  auto keys(std::size_t root, const std::filesystem::path& file) const
+      -> std::vector<std::pair<std::string, uint64_t>>;
+
+  auto hash_of(const std::string& file, std::unordered_set<std::string>& seen)
+      -> expected<uint64_t>;
+
+  //! @brief Recursive, artifact() goes through find() and hash()
+  mutable std::recursive_mutex mutex_;
+
+  std::vector<std::filesystem::path> roots_;
+  std::optional<std::filesystem::path> cache_dir_;
+
+  //! @brief By absolute path
+  std::unordered_map<std::string, Record> records_;
+  std::unordered_map<std::string, std::vector<Candidate>> lookup_;
+  //! @brief Who depends on each file
+  std::unordered_map<std::string, std::unordered_set<std::string>> dependents_;
+  //! @brief Hashes from the last run, reused while size and time match
+  std::unordered_map<std::string, Record> manifest_;
+
+  int inotify_ = -1;
+  //! @brief Watched directory and its root per watch descriptor
+  std::unordered_map<int, std::pair<std::size_t, std::filesystem::path>>
+      watches_;
+};
+
+}  // namespace wren::assets
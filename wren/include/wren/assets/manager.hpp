@@ -1,25 +1,39 @@
 #pragma once
 
 #include <filesystem>
+#include <memory>
 #include <optional>
 #include <vector>
 #include <wren/utils/result.hpp>
 
+#include "database.hpp"
+
 namespace wren::assets {
 
 class Manager {
  public:
+  //! @brief Where a project's asset manifest and imported artifacts go
+  static constexpr auto kCacheDirectory = ".wren/cache";
+
   Manager() = default;
+  //! @brief Indexes the project and asset paths, see Database
   Manager(const std::vector<std::filesystem::path>& asset_paths,
-          const std::optional<std::filesystem::path>& project_path = {})
-      : asset_paths_(asset_paths), project_path_(project_path) {}
+          const std::optional<std::filesystem::path>& project_path = {});
 
   [[nodiscard]] auto find_asset(const std::filesystem::path&) const
       -> expected<std::filesystem::path>;
 
+  //! @brief Pick up changes on disk, returns the changed files, see
+  //! Database::poll()
+  auto poll() -> std::vector<std::filesystem::path>;
+
+  [[nodiscard]] auto database() const { return database_; }
+
  private:
   std::vector<std::filesystem::path> asset_paths_;
   std::optional<std::filesystem::path> project_path_;
+  //! @brief Shared between copies
+  std::shared_ptr<Database> database_;
 };
 
 }  // namespace wren::assets
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include <wren/math/bounds.hpp>
+#include <wren/math/culling.hpp>
+#include <wren/math/matrix.hpp>
+#include <wren/vk/buffer.hpp>
+#include <wren/vk/shader.hpp>
+
+#include "context.hpp"
+#include "mesh.hpp"
+
+namespace wren {
+
+class RenderPass;
+
+//! @brief Frustum culling on the CPU, for when the GPU path isn't available.
+//! Spheres are tested 8 at a time with SIMD and spread over threads once
+//! there are enough of them to pay for it.
+class CpuCulling {
+ public:
+  //! @brief Spheres below this count are culled on the calling thread
+  static constexpr std::size_t kParallelGrain = 16384;
+
+  //! @brief Start a new frame culled against the frustum of view_proj
+  void begin(const math::Mat4f& view_proj);
+
+  //! @brief Queue a sphere in world space
+  //! @returns The index to check with visible() after cull()
+  auto add(const math::BoundingSphere& sphere) -> uint32_t;
+
+  void cull();
+
+  [[nodiscard]] auto visible(uint32_t index) const -> bool {
+    return visible_.at(index) != 0;
+  }
+
+ private:
+  math::Frustum frustum_;
+  math::SphereSet spheres_;
+  std::vector<uint8_t> visible_;
+};
+
+//! @brief Frustum culling on the GPU. A compute pass tests every instance's
+//! bounding sphere and writes the indirect draws the passes after it use, so
+//! the CPU never looks at visibility. Instances of the same mesh share its
+//! buffers and are drawn together, the visible ones are compacted so a group
+//! is one drawIndexedIndirectCount whatever its size. Each draw's first
+//! instance is the instance's index, the vertex shader of the drawing
+//! pipeline reads the instance's model matrix with it. Meshes split into
+//! meshlets can be culled per meshlet instead, which also drops meshlets
+//! facing away from the camera.
+//!
+//! Each frame the instances are added, the compute pass calls dispatch() and
+//! the drawing pass calls draw_instances() with its instanced pipeline bound:
+//! @code
+//!   builder.add_pass("cull", PassResources("cull")
+//!                                .set_compute()
+//!                                .add_shader(GpuCulling::kShaderName, shader)
+//!                                .add_shader(GpuCulling::kMeshletShaderName,
+//!                                            meshlet_shader)
+//!                                .write(GpuCulling::kDrawsResource), ...)
+//! @endcode
+//!
+//! Needs drawIndirectFirstInstance, create() fails without it.
+class GpuCulling {
+ public:
+  static constexpr const char* kShaderName = "cull";
+  static constexpr const char* kMeshletShaderName = "cull_meshlets";
+  //! @brief Resource the culling pass writes, passes drawing read it
+  static constexpr const char* kDrawsResource = "cull_draws";
+
+  static auto create(const std::shared_ptr<Context>& ctx,
+                     uint32_t max_instances = 4096,
+                     uint32_t max_meshlets = 65536)
+      -> expected<std::shared_ptr<GpuCulling>>;
+
+  //! @brief Start a new frame culled against the frustum of view_proj, view
+  //! places the camera for the meshlet cone tests
+  void begin(const math::Mat4f& view_proj, const math::Mat4f& view);
+
+  //! @brief Queue an instance of a loaded mesh for culling, drawn by
+  //! draw_instances() with the other instances of the same mesh
+  //! @param sphere Bounding sphere in world space
+  //! @returns false when the buffers are full and the instance has to be
+  //! drawn directly
+  auto add(const std::shared_ptr<Mesh>& mesh,
+           const math::BoundingSphere& sphere, const math::Mat4f& model,
+           uint32_t index_count, uint32_t first_index = 0) -> bool;
+
+  //! @brief Queue every meshlet of a loaded mesh for culling
+  //! @returns The first of the mesh's meshlet draws, nothing when the mesh
+  //! has no meshlets on the GPU yet or the buffers are full
+  auto add_meshlets(const Mesh& mesh, const math::Mat4f& model)
+      -> std::optional<uint32_t>;
+
+  //! @brief Upload the instances and record the culling dispatches, called
+  //! from the execute function of a compute pass owning shader() and
+  //! meshlet_shader()
+  void dispatch(RenderPass& pass, const ::vk::CommandBuffer& cmd);
+
+  //! @brief Draw every visible instance add() queued, one indirect draw per
+  //! mesh. The bound pipeline takes the mesh's dequantization matrix as its
+  //! push constants and reads the model matrices, indexed by
+  //! gl_InstanceIndex, from a storage buffer at binding 1 of set 0.
+  void draw_instances(RenderPass& pass, const ::vk::CommandBuffer& cmd) const;
+
+  //! @brief Draw the meshlets add_meshlets() queued for the bound mesh, with
+  //! as few indirect draw calls as the device allows
+  void draw_meshlets(const ::vk::CommandBuffer& cmd, uint32_t first_draw,
+                     uint32_t count) const;
+
+  [[nodiscard]] auto shader() const { return shader_; }
+  [[nodiscard]] auto meshlet_shader() const { return meshlet_shader_; }
+  [[nodiscard]] auto instance_count() const {
+    return static_cast<uint32_t>(instances_.size());
+  }
+
+ private:
+  //! @brief Matches the Instance struct of the culling shader
+  struct Instance {
+    std::array<float, 4> sphere;
+    uint32_t index_count;
+    uint32_t first_index;
+    int32_t vertex_offset;
+    uint32_t group;
+    //! @brief The instance's slot in draws_, first_draw + its rank in the
+    //! group. Filled in by dispatch().
+    uint32_t draw;
+    uint32_t first_draw;
+    std::array<uint32_t, 2> padding;
+  };
+
+  //! @brief Instances drawing the same mesh, a range of both draw lists
+  struct Group {
+    std::shared_ptr<Mesh> mesh;
+    uint32_t first_draw = 0;
+    uint32_t count = 0;
+  };
+
+  struct Constants {
+    std::array<math::Vec4f, 6> planes;
+    uint32_t instance_count;
+  };
+
+  struct MeshletConstants {
+    std::array<math::Vec4f, 6> planes;
+    math::Vec4f camera;
+    uint32_t meshlet_count;
+    uint32_t first_draw;
+  };
+
+  //! @brief One mesh's meshlets, culled in its model space
+  struct MeshletBatch {
+    std::shared_ptr<vk::Buffer> meshlets;
+    MeshletConstants constants;
+  };
+
+  GpuCulling(uint32_t max_instances, uint32_t max_meshlets)
+      : max_instances_(max_instances), max_meshlets_(max_meshlets) {}
+
+  uint32_t max_instances_;
+  uint32_t max_meshlets_;
+  uint32_t max_draw_count_ = 1;
+  bool draw_indirect_count_ = false;
+
+  math::Mat4f view_proj_;
+  math::Vec3f camera_;
+  math::Frustum frustum_;
+  std::vector<Instance> instances_;
+  std::vector<math::Mat4f> models_;
+  std::vector<Group> groups_;
+  std::unordered_map<const Mesh*, uint32_t> group_of_;
+  std::vector<MeshletBatch> meshlet_batches_;
+  uint32_t meshlet_draw_count_ = 0;
+
+  std::shared_ptr<vk::Shader> shader_;
+  std::shared_ptr<vk::Shader> meshlet_shader_;
+
+  std::shared_ptr<vk::Buffer> instance_buffer_;
+  std::shared_ptr<vk::Buffer> model_buffer_;
+  //! @brief One draw per instance, culled ones draw no instances
+  std::shared_ptr<vk::Buffer> draws_;
+  //! @brief Only the visible instances, packed at the start of their
+  //! group's range
+  std::shared_ptr<vk::Buffer> visible_draws_;
+  //! @brief One uint32_t per group, the number of its visible_draws_
+  std::shared_ptr<vk::Buffer> visible_counts_;
+  std::shared_ptr<vk::Buffer> meshlet_draws_;
+};
+
+}  // namespace wren
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 #include <vulkan/vulkan.hpp>
@@ -11,12 +12,15 @@
 
 namespace wren {
 
+DEFINE_ERROR("RenderGraph", RenderGraphErrors, UnknownResource, Cycle)
+
 struct Node {
   std::string name;
   std::shared_ptr<RenderPass> render_pass;
 };
 
 using node_t = std::shared_ptr<Node>;
+//! @brief Producer and consumer of a resource
 using edge_t = std::pair<node_t, node_t>;
 
 struct Graph {
@@ -31,6 +35,7 @@ struct Graph {
     return nullptr;
   }
 
+  //! @brief In execution order
   std::vector<node_t> nodes;
   std::vector<edge_t> edges;
 };
@@ -46,7 +51,11 @@ class GraphBuilder {
 
   /**
     @brief Compiles the builder into an actual graph, it creates missing
-    resources for targets and binds targets to the swapchain
+    resources for targets and binds targets to the swapchain.
+
+    Passes are ordered by the resources they read and write, passes that
+    don't contribute to the swapchain are culled, and each pass only gets the
+    dependencies and layout transitions its resources actually need.
   */
   [[nodiscard]] auto compile() const -> expected<Graph>;
 
@@ -54,8 +63,12 @@ class GraphBuilder {
                 const RenderPass::execute_fn_t &fn) -> GraphBuilder &;
 
  private:
-  [[nodiscard]] auto create_target() const
-      -> expected<std::shared_ptr<RenderTarget>>;
+  //! @brief Order the passes so producers run before their consumers
+  //! @param dependencies The passes each pass has to run after
+  //! @param used Passes that weren't culled
+  [[nodiscard]] static auto sort_passes(
+      const std::vector<std::set<std::size_t>> &dependencies,
+      const std::vector<bool> &used) -> expected<std::vector<std::size_t>>;
 
   std::shared_ptr<Context> ctx_;
   std::vector<std::tuple<std::string, PassResources, RenderPass::execute_fn_t>>
@@ -4,6 +4,11 @@
 
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_handles.hpp>
+#include <wren/utils/deletion_queue.hpp>
+#include <wren/vk/bindless.hpp>
+#include <wren/vk/layout_cache.hpp>
+#include <wren/vk/submit_queue.hpp>
+#include <wren/vk/vertex_layout.hpp>
 
 #include "wren/utils/device.hpp"
 #include "wren/utils/queue.hpp"
@@ -39,6 +44,47 @@ class GraphicsContext {
 
   [[nodiscard]] auto allocator() const { return allocator_; }
 
+  //! @brief Descriptor set and pipeline layouts shared by every shader
+  [[nodiscard]] auto layout_cache() -> vk::LayoutCache & {
+    return layout_cache_;
+  }
+
+  //! @brief How meshes store their vertices, change it before any mesh is
+  //! loaded or pipeline created
+  [[nodiscard]] auto vertex_layout() const -> const vk::VertexLayout & {
+    return vertex_layout_;
+  }
+  void vertex_layout(const vk::VertexLayoutOptions &options) {
+    vertex_layout_ = vk::VertexLayout(options);
+  }
+
+  //! @brief The global bindless descriptor set, null when the device doesn't
+  //! support descriptor indexing
+  [[nodiscard]] auto bindless() const { return bindless_; }
+
+  //! @brief Objects retired here are destroyed once the GPU has completed
+  //! the frame they were retired in
+  [[nodiscard]] auto deletion_queue() const { return deletion_queue_; }
+
+  //! @brief Submissions to the graphics queue, the deletion queue is keyed on
+  //! its timeline
+  [[nodiscard]] auto graphics_queue() const { return graphics_queue_; }
+
+  //! @brief Submissions to a dedicated compute queue, null when the device
+  //! doesn't have a compute only queue family
+  [[nodiscard]] auto compute_queue() const { return compute_queue_; }
+
+  //! @brief The families of every queue in use, for buffers written on one
+  //! queue and read on another
+  [[nodiscard]] auto queue_families() const -> std::vector<uint32_t> {
+    std::vector<uint32_t> families = {graphics_queue_->family()};
+    if (compute_queue_ != nullptr &&
+        compute_queue_->family() != families.front()) {
+      families.push_back(compute_queue_->family());
+    }
+    return families;
+  }
+
   auto SetupDevice() -> expected<void>;
 
   auto GetSwapchainSupport() {
@@ -73,6 +119,14 @@ class GraphicsContext {
 
   VmaAllocator allocator_{};
 
+  vk::LayoutCache layout_cache_;
+  vk::VertexLayout vertex_layout_;
+  std::shared_ptr<vk::BindlessHeap> bindless_;
+  std::shared_ptr<utils::DeletionQueue> deletion_queue_ =
+      std::make_shared<utils::DeletionQueue>();
+  std::shared_ptr<vk::SubmitQueue> graphics_queue_;
+  std::shared_ptr<vk::SubmitQueue> compute_queue_;
+
 #ifdef WREN_DEBUG
   auto CreateDebugMessenger() -> expected<void>;
   ::vk::DebugUtilsMessengerEXT debug_messenger;
@@ -3,11 +3,18 @@
 #include <vk_mem_alloc.h>
 #include <vulkan/vulkan_core.h>
 
+#include <filesystem>
+#include <ranges>
 #include <vulkan/vulkan.hpp>
+#include <wren/math/bounds.hpp>
 #include <wren/math/matrix.hpp>
+#include <wren/math/meshlet.hpp>
 #include <wren/math/vector.hpp>
+#include <wren/utils/result.hpp>
 #include <wren/vk/buffer.hpp>
 #include <wren/vk/shader.hpp>
+#include <wren/vk/submit_queue.hpp>
+#include <wren/vk/vertex_layout.hpp>
 
 #include "utils/device.hpp"
 
@@ -35,33 +42,153 @@ const std::array kQuadVertices = {
     Vertex{.pos = {0.5f, 0.5f, 0.0f}, .normal = {0.0f, 0.0f, 1.0f}},
     Vertex{.pos = {-0.5f, 0.5f, 0.0f}, .normal = {1.0f, 1.0f, 1.0f}}};
 
-const std::vector<uint16_t> kQuadIndices = {0, 1, 2, 2, 3, 0};
+const std::vector<uint32_t> kQuadIndices = {0, 1, 2, 2, 3, 0};
+
+//! @brief A range of the index buffer drawing the mesh at one level of detail
+struct MeshLod {
+  uint32_t first_index = 0;
+  uint32_t index_count = 0;
+  //! @brief How far the simplified surface is from the original, in model
+  //! space units
+  float error = 0;
+};
+
+//! @brief Matches the Meshlet struct of the meshlet culling shader
+struct GpuMeshlet {
+  std::array<float, 4> sphere;
+  //! @brief Axis and cutoff
+  std::array<float, 4> cone;
+  uint32_t first_index;
+  uint32_t index_count;
+  std::array<uint32_t, 2> padding;
+};
 
 class Mesh {
  public:
+  //! @brief Levels of detail generated at most, including the original
+  static constexpr std::size_t kMaxLods = 6;
+
+  //! @brief Meshes with fewer triangles are culled as a whole, splitting them
+  //! into meshlets costs more draws than it saves
+  static constexpr std::size_t kMeshletMinTriangles = 16384;
+
   Mesh() = default;
 
-  Mesh(const vulkan::Device& device, VmaAllocator allocator);
+  //! @brief A unit quad, loaded with the layout the pipelines are built with
+  Mesh(const vulkan::Device& device,
+       const std::shared_ptr<vk::SubmitQueue>& submit_queue,
+       VmaAllocator allocator, const vk::VertexLayout& layout);
   Mesh(const std::vector<Vertex>& vertices,
-       const std::vector<uint16_t>& indices);
-
-  void load(const vulkan::Device& device, VmaAllocator allocator);
+       const std::vector<uint32_t>& indices);
+
+  //! @brief Upload the mesh with its vertices encoded for layout, GPU buffers
+  //! are retired into deletion_queue when the mesh is destroyed. The CPU
+  //! copies of the vertices and indices are freed once uploaded, so a mesh is
+  //! only loaded once.
+  //! @param submit_queue Runs the copies without waiting for them, work
+  //! submitted to it afterwards can draw the mesh right away
+  //! @param queue_families Queues reading the meshlet buffer
+  void load(const vulkan::Device& device,
+            const std::shared_ptr<vk::SubmitQueue>& submit_queue,
+            VmaAllocator allocator, const vk::VertexLayout& layout,
+            const std::shared_ptr<utils::DeletionQueue>& deletion_queue =
+                nullptr,
+            std::span<const uint32_t> queue_families = {});
+
+  //! @brief Simplify the mesh into a chain of levels of detail, each with
+  //! about half the triangles of the one before. The levels share the vertex
+  //! buffer and are appended to the index buffer, call before load().
+  void generate_lods(float reduction = 0.5F);
+
+  //! @brief Reorder the triangles of every level of detail for the vertex
+  //! cache and less overdraw, then the vertices in the order they're first
+  //! drawn. Unused vertices are dropped. Call after generate_lods() and
+  //! before load().
+  void optimize();
+
+  //! @brief Split the finest level of detail into meshlets that are culled
+  //! separately, regrouping its triangles so each meshlet is a range of the
+  //! index buffer. Call after optimize() and before load().
+  void build_meshlets();
 
   void shader(const std::shared_ptr<vk::Shader>& shader) { shader_ = shader; }
-  void draw(const ::vk::CommandBuffer& cmd) const;
+  void draw(const ::vk::CommandBuffer& cmd, std::size_t lod = 0) const;
   void bind(const ::vk::CommandBuffer& cmd) const;
 
   [[nodiscard]] auto loaded() const { return loaded_; }
 
+  //! @brief Whether the GPU has finished copying the buffers, queues other
+  //! than the one load() submitted to may only read them after
+  [[nodiscard]] auto uploaded() const {
+    return upload_queue_ == nullptr ||
+           upload_queue_->is_complete(upload_value_);
+  }
+
+  //! @brief Maps the positions stored by the vertex layout back into model
+  //! space, multiply the model matrix by it
+  [[nodiscard]] auto dequantization() const -> const math::Mat4f& {
+    return dequantization_;
+  }
+
+  //! @brief Bounds in model space, computed once from the vertices
+  [[nodiscard]] auto aabb() const -> const math::AABB& { return aabb_; }
+  [[nodiscard]] auto bounding_sphere() const -> const math::BoundingSphere& {
+    return bounding_sphere_;
+  }
+
+  //! @brief Levels of detail, finest first. Always has at least the
+  //! original mesh.
+  [[nodiscard]] auto lods() const -> const std::vector<MeshLod>& {
+    return lods_;
+  }
+  //! @brief The error of each of lods(), for math::select_lod()
+  [[nodiscard]] auto lod_errors() const {
+    return std::views::transform(lods_, &MeshLod::error);
+  }
+
+  //! @brief Meshlets of the finest level of detail, empty unless
+  //! build_meshlets() was called
+  [[nodiscard]] auto meshlets() const -> const std::vector<math::Meshlet>& {
+    return meshlets_;
+  }
+  //! @brief GpuMeshlets for the culling shader, null without meshlets
+  [[nodiscard]] auto meshlet_buffer() const { return meshlet_buffer_; }
+
+  [[nodiscard]] auto index_count(std::size_t lod = 0) const {
+    return lods_.at(lod).index_count;
+  }
+  [[nodiscard]] auto first_index(std::size_t lod = 0) const {
+    return lods_.at(lod).first_index;
+  }
+
  private:
+  friend auto write_mesh_file(const Mesh& mesh, uint64_t source_hash,
+                              const std::filesystem::path& file)
+      -> expected<void>;
+  friend auto read_mesh_file(const std::filesystem::path& file,
+                             uint64_t source_hash) -> expected<Mesh>;
+
+  void compute_bounds();
+  [[nodiscard]] auto positions() const -> std::vector<math::Vec3f>;
+
   bool loaded_ = false;
+  std::shared_ptr<vk::SubmitQueue> upload_queue_;
+  uint64_t upload_value_ = 0;
+  math::Mat4f dequantization_ = math::Mat4f::identity();
+
+  math::AABB aabb_;
+  math::BoundingSphere bounding_sphere_;
 
   std::shared_ptr<vk::Shader> shader_;
   std::vector<Vertex> vertices_;
-  std::vector<uint16_t> indices_;
+  std::vector<uint32_t> indices_;
+  std::vector<MeshLod> lods_{MeshLod{}};
+  std::vector<math::Meshlet> meshlets_;
   std::shared_ptr<vk::Buffer> index_buffer_;
-  std::shared_ptr<vk::Buffer> vertex_buffer_;
+  //! @brief One per binding of the vertex layout
+  std::vector<std::shared_ptr<vk::Buffer>> vertex_buffers_;
   std::shared_ptr<vk::Buffer> uniform_buffer_;
+  std::shared_ptr<vk::Buffer> meshlet_buffer_;
 };
 
 }  // namespace wren
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <wren/utils/result.hpp>
+
+#include "assets/database.hpp"
+#include "mesh.hpp"
+#include "mesh_loader.hpp"
+
+namespace wren {
+
+//! @brief Meshes shared by everything drawing the same file, keyed by path
+//! and import settings. The cache only holds weak references: a mesh is
+//! imported once while anything uses it and freed with its GPU buffers when
+//! the last handle goes away.
+//!
+//! With an asset database imported meshes are also written to its cache
+//! directory as mesh files (see write_mesh_file()), later runs read those
+//! instead of importing the source again while its hash matches.
+class MeshCache {
+ public:
+  //! @brief The cache mesh renderers load through
+  static auto shared() -> const std::shared_ptr<MeshCache>&;
+
+  //! @brief The mesh imported from file with settings, imported now if
+  //! nothing holds it. Safe to call from several threads, the same mesh
+  //! requested by two of them at once may be imported twice but only one
+  //! copy is kept.
+  auto get(const std::filesystem::path& file,
+           const MeshImportSettings& settings = {})
+      -> expected<std::shared_ptr<Mesh>>;
+
+  //! @brief Where imported meshes are cached on disk, null to always import
+  void database(std::shared_ptr<assets::Database> database);
+
+  //! @brief Import file again on its next get(), for when it changed on
+  //! disk. Handles already out keep the old mesh.
+  void invalidate(const std::filesystem::path& file);
+
+  //! @brief Meshes in use
+  [[nodiscard]] auto size() const -> std::size_t;
+
+ private:
+  struct Key {
+    std::string file;
+    MeshImportSettings settings;
+
+    auto operator==(const Key&) const -> bool = default;
+  };
+
+  struct KeyHash {
+    auto operator()(const Key& key) const -> std::size_t;
+  };
+
+  //! @brief From the mesh file cached for file and settings if it's current,
+  //! otherwise from the source, writing the mesh file for the next time
+  auto import(const std::filesystem::path& file,
+              const MeshImportSettings& settings) -> expected<Mesh>;
+
+  mutable std::mutex mutex_;
+  std::shared_ptr<assets::Database> database_;
+  std::unordered_map<Key, std::weak_ptr<Mesh>, KeyHash> meshes_;
+};
+
+}  // namespace wren
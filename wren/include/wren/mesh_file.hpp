@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <wren/utils/result.hpp>
+
+#include "mesh.hpp"
+
+namespace wren {
+
+DEFINE_ERROR("MeshFile", MeshFileErrors, NotAMeshFile, UnsupportedVersion,
+             Corrupt, StaleSource)
+
+//! @brief Bumped whenever the layout of mesh files or the output of an
+//! importer changes, older files are imported again from their source. The
+//! artifact name only follows the source and the import settings, so without
+//! a bump a stale mesh stays current forever.
+//!
+//! 2: GLB meshes are imported, version 1 cached them empty
+//! 3: Mirrored GLB nodes keep their winding and normals
+constexpr uint32_t kMeshFileVersion = 3;
+
+//! @brief Artifact kind of imported meshes, see assets::Database::artifact()
+constexpr auto kMeshFileExtension = "wmesh";
+
+//! @brief Write an imported mesh as the engine's own mesh file: a header with
+//! the bounds, then the vertices, indices, levels of detail and meshlets
+//! exactly as Mesh holds them. Call before the mesh is loaded, loading frees
+//! the vertices.
+//! @param source_hash Content hash of the file the mesh was imported from
+auto write_mesh_file(const Mesh& mesh, uint64_t source_hash,
+                     const std::filesystem::path& file) -> expected<void>;
+
+//! @brief Read a mesh file back, each array is one copy out of the mapped
+//! file with no parsing. Fails with StaleSource when it was written for
+//! another version of the source.
+auto read_mesh_file(const std::filesystem::path& file, uint64_t source_hash)
+    -> expected<Mesh>;
+
+}  // namespace wren
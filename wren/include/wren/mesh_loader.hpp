@@ -8,6 +8,20 @@ namespace wren {
 
 DEFINE_ERROR("MeshLoader", MeshLoaderError, ExtensionNotSupported)
 
-auto load_mesh(const std::filesystem::path& mesh_path) -> expected<Mesh>;
+//! @brief How a mesh file is turned into a Mesh, meshes imported with
+//! different settings are different assets
+struct MeshImportSettings {
+  //! @brief Triangles kept by each level of detail, see Mesh::generate_lods()
+  float lod_reduction = 0.5F;
+  //! @brief Split meshes with enough triangles into meshlets
+  bool meshlets = true;
+
+  auto operator==(const MeshImportSettings&) const -> bool = default;
+};
+
+//! @brief Import a mesh file, every call parses it again. Use MeshCache to
+//! share meshes between renderers.
+auto load_mesh(const std::filesystem::path& mesh_path,
+               const MeshImportSettings& settings = {}) -> expected<Mesh>;
 
 }  // namespace wren
@@ -1,8 +1,12 @@
 #pragma once
 
 #include <memory>
+#include <optional>
+#include <span>
 #include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 #include <vulkan/vulkan.hpp>
 #include <wren/vk/buffer.hpp>
 #include <wren/vk/image.hpp>
@@ -20,8 +24,32 @@ namespace vk {
 class Buffer;
 }
 
+//! @brief How a pass loads, stores and transitions one of its attachments.
+//! Worked out by the graph compiler from the other passes using the resource.
+struct AttachmentUsage {
+  ::vk::AttachmentLoadOp load_op = ::vk::AttachmentLoadOp::eClear;
+  ::vk::AttachmentStoreOp store_op = ::vk::AttachmentStoreOp::eStore;
+  ::vk::ImageLayout initial_layout = ::vk::ImageLayout::eUndefined;
+  ::vk::ImageLayout final_layout = ::vk::ImageLayout::eUndefined;
+};
+
+//! @brief Synchronization of a pass with the passes around it
+struct PassSync {
+  AttachmentUsage colour;
+  AttachmentUsage depth;
+
+  //! @brief Only the dependencies on passes that actually share a resource
+  std::vector<::vk::SubpassDependency> dependencies;
+
+  //! @brief The pass reads something a compute pass wrote, shader writes
+  //! have to be made visible before it starts
+  bool after_compute = false;
+};
+
 class PassResources {
  public:
+  static constexpr std::string_view kSwapchainTarget = "swapchain_target";
+
   PassResources(std::string target_prefix)
       : target_prefix_(std::move(target_prefix)) {}
 
@@ -41,8 +69,53 @@ class PassResources {
     return *this;
   }
 
+  //! @brief Run the pass on the async compute queue when there is one. The
+  //! pass records dispatches only and can't have targets.
+  auto set_compute() -> PassResources& {
+    compute_ = true;
+    return *this;
+  }
+
+  //! @brief Declare that the pass writes a resource the graph doesn't own,
+  //! like a storage buffer, so passes reading it are ordered after it
+  auto write(const std::string& resource) -> PassResources& {
+    writes_.push_back(resource);
+    return *this;
+  }
+
+  //! @brief Declare that the pass samples a resource written by another
+  //! pass. Colour targets are named after their pass's target prefix, depth
+  //! targets get a "_depth" suffix.
+  auto read(const std::string& resource) -> PassResources& {
+    reads_.push_back(resource);
+    return *this;
+  }
+
   auto has_colour_target() const { return colour_target_; }
   auto has_depth_target() const { return depth_target_; }
+  [[nodiscard]] auto is_compute() const { return compute_; }
+
+  [[nodiscard]] auto reads() const -> const std::vector<std::string>& {
+    return reads_;
+  }
+
+  [[nodiscard]] auto writes() const -> const std::vector<std::string>& {
+    return writes_;
+  }
+
+  //! @brief Name of the colour resource written by the pass, if any
+  [[nodiscard]] auto colour_resource() const -> std::optional<std::string> {
+    if (compute_) return std::nullopt;
+    if (colour_target_ || target_prefix_ == kSwapchainTarget)
+      return target_prefix_;
+    return std::nullopt;
+  }
+
+  //! @brief Name of the depth resource written by the pass, if any
+  [[nodiscard]] auto depth_resource() const -> std::optional<std::string> {
+    if (depth_target_ && !compute_) return target_prefix_ + "_depth";
+    return std::nullopt;
+  }
 
   auto target_prefix() const { return target_prefix_; }
   auto shaders() const { return shaders_; }
@@ -52,6 +125,10 @@ class PassResources {
 
   bool colour_target_ = false;
   bool depth_target_ = false;
+  bool compute_ = false;
+
+  std::vector<std::string> reads_;
+  std::vector<std::string> writes_;
 
   std::unordered_map<std::string, std::shared_ptr<vk::Shader>> shaders_;
 };
@@ -64,7 +141,7 @@ class RenderPass {
                      const std::string& name, const PassResources& resources,
                      const std::shared_ptr<RenderTarget>& colour_target,
                      const std::shared_ptr<RenderTarget>& depth_target,
-                     const execute_fn_t& fn)
+                     const PassSync& sync, const execute_fn_t& fn)
       -> expected<std::shared_ptr<RenderPass>>;
 
   void execute();
@@ -75,6 +152,18 @@ class RenderPass {
   [[nodiscard]] auto get_scratch_buffer(uint32_t set, uint32_t binding,
                                         size_t size) -> void*;
 
+  //! @brief Push storage buffers to consecutive bindings of the bound
+  //! pipeline's push descriptor set
+  void push_storage_buffers(const ::vk::CommandBuffer& cmd,
+                            std::span<const ::vk::DescriptorBufferInfo> buffers,
+                            uint32_t first_binding = 0);
+
+  //! @brief Write push constants for the bound pipeline, cheaper than a
+  //! scratch buffer for small per draw data
+  template <typename T>
+  void push_constants(const ::vk::CommandBuffer& cmd, const T& data,
+                      uint32_t offset = 0);
+
   auto resize_target(const math::Vec2f& new_size) -> expected<void>;
 
   void on_resource_resized(const std::pair<float, float>& size);
@@ -84,6 +173,8 @@ class RenderPass {
   auto colour_target() const { return colour_target_; }
   auto resources() const { return resources_; }
 
+  [[nodiscard]] auto is_compute() const { return resources_.is_compute(); }
+
   [[nodiscard]] auto get_command_buffers() const { return command_buffers_; }
 
   [[nodiscard]] auto get_framebuffer() const { return framebuffer_; }
@@ -92,8 +183,14 @@ class RenderPass {
 
   void bind_pipeline(const std::string& pipeline_name);
 
+  //! @brief The render pass, null when the device uses dynamic rendering
   [[nodiscard]] auto get() const { return render_pass_; }
 
+  //! @brief What pipelines drawing in this pass have to be compatible with
+  [[nodiscard]] auto pipeline_target() const -> const vk::PipelineTarget& {
+    return pipeline_target_;
+  }
+
  private:
   RenderPass(const std::shared_ptr<Context>& ctx, std::string name,
              PassResources resources,
@@ -101,6 +198,17 @@ class RenderPass {
              const std::shared_ptr<RenderTarget>& depth_target,
              execute_fn_t fn);
 
+  auto create_render_pass(const ::vk::Device& device) -> expected<void>;
+
+  //! @brief Record the execute function inside the pass's attachments
+  void record_rendering(::vk::CommandBuffer& cmd);
+
+  //! @brief Transition the attachments and begin dynamic rendering
+  void begin_rendering(const ::vk::CommandBuffer& cmd,
+                       const ::vk::Extent2D& extent);
+  //! @brief End dynamic rendering and transition to the final layouts
+  void end_rendering(const ::vk::CommandBuffer& cmd);
+
   std::shared_ptr<Context> ctx_;
 
   std::string name_;
@@ -111,6 +219,9 @@ class RenderPass {
 
   execute_fn_t execute_fn_;
 
+  PassSync sync_;
+  vk::PipelineTarget pipeline_target_;
+
   ::vk::RenderPass render_pass_;
 
   ::vk::CommandPool command_pool_;
@@ -136,7 +247,8 @@ void RenderPass::write_scratch_buffer(const ::vk::CommandBuffer& cmd,
              ctx_->graphics_context->allocator(), sizeof(data),
              VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
              VmaAllocationCreateFlagBits::
-                 VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT)});
+                 VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+             ctx_->graphics_context->deletion_queue())});
   }
 
   auto buffer = ubos_.at({set, binding});
@@ -146,8 +258,21 @@ void RenderPass::write_scratch_buffer(const ::vk::CommandBuffer& cmd,
   std::array writes = {::vk::WriteDescriptorSet{
       {}, binding, 0, ::vk::DescriptorType::eUniformBuffer, {}, buffer_info}};
 
-  cmd.pushDescriptorSetKHR(::vk::PipelineBindPoint::eGraphics,
+  cmd.pushDescriptorSetKHR(last_bound_shader_->bind_point(),
                            last_bound_shader_->pipeline_layout(), set, writes);
 }
 
+template <typename T>
+void RenderPass::push_constants(const ::vk::CommandBuffer& cmd, const T& data,
+                                uint32_t offset) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  static_assert(sizeof(T) <= 128,
+                "Only 128 bytes of push constants are guaranteed");
+
+  const auto& range =
+      last_bound_shader_->layout_description().push_constant_range;
+  cmd.pushConstants(last_bound_shader_->pipeline_layout(), range.stageFlags,
+                    offset, sizeof(T), &data);
+}
+
 }  // namespace wren
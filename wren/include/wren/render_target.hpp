@@ -1,5 +1,8 @@
 #pragma once
 
+#include <vk_mem_alloc.h>
+
+#include <memory>
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_handles.hpp>
 #include <wren/math/vector.hpp>
@@ -11,37 +14,81 @@
 
 namespace wren {
 
+//! @brief Memory owned jointly by targets whose lifetimes don't overlap
+using SharedMemory = std::shared_ptr<VmaAllocation_T>;
+
+//! @brief How a target is used within the graph, decided by the compiler
+struct RenderTargetOptions {
+  //! @brief Read by a shader once rendered
+  bool sampled = true;
+  //! @brief Only an attachment of a single pass and never stored, can live
+  //! in lazily allocated memory
+  bool transient = false;
+  //! @brief Alias this allocation instead of allocating memory
+  SharedMemory memory;
+};
+
 class RenderTarget {
  public:
+  using Options = RenderTargetOptions;
+
   //! @brief Craete a RenderTarget object with all defaults for a colour target
   //! @param ctx The full application context
-  static auto create(const std::shared_ptr<Context>& ctx)
+  //! @param options Usage and memory placement of the target
+  static auto create(const std::shared_ptr<Context>& ctx,
+                     const Options& options = {})
       -> expected<std::shared_ptr<RenderTarget>>;
 
   //! @brief Create e render target to be used as a depth target
   //! @param ctx the full application context
+  //! @param options Usage and memory placement of the target
   //! @returns On success a shared_ptr to the created depth RenderTarget
   //!   or an error
-  static auto create_depth(const std::shared_ptr<Context>& ctx)
+  static auto create_depth(const std::shared_ptr<Context>& ctx,
+                           const Options& options = {.sampled = false})
       -> expected<std::shared_ptr<RenderTarget>>;
 
+  //! @brief Memory needed by a target created with the same arguments
+  static auto memory_requirements(const std::shared_ptr<Context>& ctx,
+                                  bool depth, const Options& options)
+      -> expected<::vk::MemoryRequirements>;
+
   static auto create(const math::Vec2f& size, ::vk::Format format,
                      ::vk::SampleCountFlagBits sample_count,
                      ::vk::ImageView image_view,
                      ::vk::ImageUsageFlags image_usage)
       -> expected<std::shared_ptr<RenderTarget>>;
 
+  //! @brief Change the size rendered to. The image is allocated in buckets
+  //! and only reallocated when the new size doesn't fit or wastes most of
+  //! it, the old image is destroyed once in flight frames are done with it.
   auto resize(const std::shared_ptr<Context>& ctx, const math::Vec2f& new_size)
       -> expected<void>;
 
   [[nodiscard]] auto view() const { return view_; }
   auto view(const ::vk::ImageView& view) { view_ = view; }
 
+  [[nodiscard]] auto image() const -> ::vk::Image {
+    return image_.has_value() ? image_->get() : external_image_;
+  }
+  //! @brief Set the image of a target wrapping an external image
+  auto image(const ::vk::Image& image) { external_image_ = image; }
+
+  [[nodiscard]] auto aspect() const { return aspect_; }
+
   [[nodiscard]] auto format() const { return format_; }
   auto format(const ::vk::Format& format) { format_ = format; }
 
+  //! @brief The size rendered to, can be smaller than extent()
   [[nodiscard]] auto size() const { return size_; }
-  auto size(const math::Vec2f& size) { size_ = size; }
+  //! @brief Set the size of a target wrapping an external image
+  auto size(const math::Vec2f& size) {
+    size_ = size;
+    extent_ = size;
+  }
+
+  //! @brief The size the image is allocated with
+  [[nodiscard]] auto extent() const { return extent_; }
 
   [[nodiscard]] auto sample_count() const { return sample_count_; }
 
@@ -53,22 +100,30 @@ class RenderTarget {
  private:
   RenderTarget() = default;
 
-  std::function<expected<void>()> transition_fn_;
+  static auto colour_usage(const Options& options) -> ::vk::ImageUsageFlags;
+  static auto depth_usage(const Options& options) -> ::vk::ImageUsageFlags;
+
+  //! @brief (Re)create the image and view for the current size and options
+  auto create_image(const std::shared_ptr<Context>& ctx) -> expected<void>;
+
+  Options options_;
 
   // TODO This might not be necessary, the size can stay in the render pass
   math::Vec2f size_;
+  math::Vec2f extent_;
 
   ::vk::SampleCountFlagBits sample_count_;
 
   ::vk::Format format_;
 
   std::optional<vk::Image> image_;
+  ::vk::Image external_image_;
   ::vk::ImageView view_;
 
   ::vk::ImageUsageFlags image_usage_;
 
   ::vk::ImageLayout final_layout_ = ::vk::ImageLayout::ePresentSrcKHR;
-  ::vk::ImageAspectFlags aspect_;
+  ::vk::ImageAspectFlags aspect_ = ::vk::ImageAspectFlagBits::eColor;
 };
 
 }  // namespace wren
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_enums.hpp>
 #include <vulkan/vulkan_structs.hpp>
+#include <wren/vk/submit_queue.hpp>
 
 #include "mesh.hpp"
 #include "wren/graph.hpp"
@@ -37,9 +39,12 @@ class Renderer {
     render_targets_.emplace(name, target);
   }
 
+  //! @brief Record and submit one-off work on the graphics queue without
+  //! waiting for it
+  //! @returns The point to wait for on the graphics queue's timeline
   auto submit_command_buffer(
       const std::function<void(::vk::CommandBuffer &)> &cmd_buf)
-      -> expected<void>;
+      -> expected<vk::TimelinePoint>;
 
  private:
   explicit Renderer(const std::shared_ptr<Context> &ctx);
@@ -72,10 +77,11 @@ class Renderer {
 
   ::vk::Semaphore image_available;
   ::vk::Semaphore render_finished;
-  ::vk::Fence in_flight_fence;
+
+  //! @brief Signalled once the last frame submitted is done
+  vk::TimelinePoint frame_done_;
 
   ::vk::CommandPool command_pool_;
-  ::vk::CommandBuffer one_time_cmd_buffer;
 
   Graph render_graph_;
 
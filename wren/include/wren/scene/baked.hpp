@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <wren/utils/result.hpp>
+
+#include "scene.hpp"
+
+namespace wren::scene {
+
+DEFINE_ERROR("BakedScene", BakedSceneErrors, NotABakedScene,
+             UnsupportedVersion, Corrupt, NameConflict, UnsupportedComponent)
+
+//! @brief Bumped whenever the layout of baked scenes changes, older files are
+//! rejected and have to be baked again from their TOML source
+constexpr uint32_t kBakedSceneVersion = 1;
+
+//! @brief Extension of baked scenes, written next to the TOML scene
+constexpr auto kBakedSceneExtension = ".wscene";
+
+//! @brief Write the scene in the baked binary format, every component type is
+//! stored as one contiguous column. Only names, transforms and mesh renderers
+//! have a column, scenes with any other registered component fail with
+//! UnsupportedComponent and have to be loaded from their TOML.
+auto serialize_baked(const std::shared_ptr<Scene>& scene,
+                     const std::filesystem::path& out_file) -> expected<void>;
+
+//! @brief Loads a baked scene a batch of entities at a time. The file is
+//! mapped and each batch's slice of the transform column handed to flecs as
+//! is with one bulk insert. Meshes are loaded on worker threads, each file
+//! once however many entities use it, and handed to their mesh renderers as
+//! they finish. Names have to be unique within the file and unused in the
+//! scene, open() fails with NameConflict before anything is created.
+class SceneLoader {
+ public:
+  //! @brief Entities created per bulk insert
+  static constexpr std::size_t kBatchSize = 1024;
+
+  //! @param load_assets Load the meshes mesh renderers reference
+  static auto open(const std::filesystem::path& project_root,
+                   const std::filesystem::path& file,
+                   const std::shared_ptr<Scene>& scene,
+                   bool load_assets = true)
+      -> expected<std::shared_ptr<SceneLoader>>;
+
+  SceneLoader(const SceneLoader&) = delete;
+  SceneLoader(SceneLoader&&) = delete;
+  auto operator=(const SceneLoader&) -> SceneLoader& = delete;
+  auto operator=(SceneLoader&&) -> SceneLoader& = delete;
+  //! @brief Waits for meshes still loading
+  ~SceneLoader();
+
+  //! @brief Create batches of entities until budget runs out (at least one
+  //! batch), then hand out the meshes that finished loading. Meant to be
+  //! called once a frame.
+  auto update(std::chrono::microseconds budget) -> expected<void>;
+
+  //! @brief Create every remaining entity and wait for all the meshes
+  auto finish() -> expected<void>;
+
+  //! @brief Every entity exists, meshes may still be loading
+  [[nodiscard]] auto entities_done() const -> bool;
+  [[nodiscard]] auto done() const -> bool;
+
+  [[nodiscard]] auto entity_count() const -> std::size_t;
+  [[nodiscard]] auto loaded_entities() const -> std::size_t;
+
+ private:
+  struct Stream;
+
+  explicit SceneLoader(std::unique_ptr<Stream> stream);
+
+  std::unique_ptr<Stream> stream_;
+};
+
+//! @brief Load a baked scene in one go, see SceneLoader
+//! @param load_assets Load the meshes mesh renderers reference
+auto deserialize_baked(const std::filesystem::path& project_root,
+                       const std::filesystem::path& file,
+                       const std::shared_ptr<Scene>& scene,
+                       bool load_assets = true) -> expected<void>;
+
+//! @brief Convert a TOML scene into a baked one, without loading any assets
+auto bake_scene(const std::filesystem::path& toml_file,
+                const std::filesystem::path& baked_file) -> expected<void>;
+
+//! @brief Convert a baked scene back into its editable TOML form
+auto unbake_scene(const std::filesystem::path& baked_file,
+                  const std::filesystem::path& toml_file) -> expected<void>;
+
+}  // namespace wren::scene
@@ -1,70 +1,142 @@
 #pragma once
 
+#include <boost/describe.hpp>
 #include <filesystem>
+#include <memory>
 #include <optional>
+#include <wren/culling.hpp>
 #include <wren/math/matrix.hpp>
+#include <wren/math/simplify.hpp>
 #include <wren/mesh.hpp>
-#include <wren/mesh_loader.hpp>
+#include <wren/mesh_cache.hpp>
 
 #include "wren/context.hpp"
+#include "wren/render_pass.hpp"
 
 namespace wren::scene::components {
 
 class MeshRenderer {
  public:
-  auto bind(const std::shared_ptr<Context>& ctx,
-            const std::shared_ptr<vk::Shader>& shader,
-            const ::vk::CommandBuffer& cmd, const math::Mat4f& model_mat) {
-    if (!mesh_.has_value()) return;
+  MeshRenderer() = default;
+  //! @brief A mesh renderer for a mesh that isn't loaded yet, see load_assets()
+  explicit MeshRenderer(std::filesystem::path path) : path_(std::move(path)) {}
+
+  //! @brief Draw the mesh. Meshlets cull() queued are drawn through the
+  //! culling pass's indirect draws, whole instances it queued are left to
+  //! GpuCulling::draw_instances().
+  auto bind(const std::shared_ptr<Context>& ctx, RenderPass& pass,
+            const ::vk::CommandBuffer& cmd, const math::Mat4f& model_mat,
+            const GpuCulling* culling = nullptr) {
+    if (mesh_ == nullptr) return;
+    if (culling != nullptr && instanced_) return;
     if (!mesh_->loaded())
       mesh_->load(ctx->graphics_context->Device(),
-                  ctx->graphics_context->allocator());
+                  ctx->graphics_context->graphics_queue(),
+                  ctx->graphics_context->allocator(),
+                  ctx->graphics_context->vertex_layout(),
+                  ctx->graphics_context->deletion_queue(),
+                  ctx->graphics_context->queue_families());
 
     struct LOCALS {
       wren::math::Mat4f model;
     };
-    LOCALS ubo{};
+    // Quantized positions are scaled back by the model matrix
+    auto model = model_mat;
+    pass.push_constants(cmd, LOCALS{.model = model * mesh_->dequantization()});
 
-    ubo.model = model_mat;
-
-    // Load UBO if not there
-    if (ubo_ == nullptr) {
-      ubo_ = vk::Buffer::create(
-          ctx->graphics_context->allocator(), sizeof(ubo),
-          VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-          VmaAllocationCreateFlagBits::
-              VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+    mesh_->bind(cmd);
+    if (culling != nullptr && meshlet_draw_.has_value()) {
+      culling->draw_meshlets(cmd, *meshlet_draw_,
+                             static_cast<uint32_t>(mesh_->meshlets().size()));
+    } else {
+      mesh_->draw(cmd, lod_);
     }
+  }
 
-    ubo_->set_data_raw(&ubo, sizeof(LOCALS));
+  //! @brief Pick the level of detail drawn from now on by how large the
+  //! simplification error would be on screen. The level is kept while the
+  //! projection isn't valid, new meshes start at the finest one.
+  auto select_lod(const math::ScreenProjection& projection,
+                  const math::Mat4f& model_mat) {
+    if (mesh_ == nullptr || !projection.valid()) return;
+
+    const auto& local = mesh_->bounding_sphere();
+    const auto world = local.transformed(model_mat);
+    // Errors are in model space, scale them like the bounds
+    const auto scale = local.radius > 0 ? world.radius / local.radius : 1.0F;
+
+    lod_ = math::select_lod(mesh_->lod_errors(),
+                            projection.pixels_per_unit(world.center) * scale,
+                            lod_);
+  }
 
-    ::vk::DescriptorBufferInfo buffer_info(ubo_->get(), 0, sizeof(LOCALS));
-    std::array writes = {::vk::WriteDescriptorSet{
-        {}, 1, 0, ::vk::DescriptorType::eUniformBuffer, {}, buffer_info}};
+  [[nodiscard]] auto lod() const { return lod_; }
 
-    cmd.pushDescriptorSetKHR(::vk::PipelineBindPoint::eGraphics,
-                             shader->pipeline_layout(), 0, writes);
+  //! @brief Queue the mesh for GPU culling. Meshes with meshlets are culled
+  //! per meshlet at full detail and drawn by bind(), anything else is culled
+  //! as a whole and drawn by GpuCulling::draw_instances().
+  auto cull(GpuCulling& culling, const math::Mat4f& model_mat) {
+    instanced_ = false;
+    meshlet_draw_.reset();
+    // Meshes are loaded by the first bind(), until then they're drawn directly
+    if (mesh_ == nullptr || !mesh_->loaded()) return;
 
-    mesh_->bind(cmd);
-    mesh_->draw(cmd);
+    if (lod_ == 0) {
+      meshlet_draw_ = culling.add_meshlets(*mesh_, model_mat);
+      if (meshlet_draw_.has_value()) return;
+    }
+    instanced_ = culling.add(mesh_, world_bounds(model_mat).value(),
+                             model_mat, mesh_->index_count(lod_),
+                             mesh_->first_index(lod_));
+  }
+
+  //! @brief The mesh's bounding sphere placed by model_mat
+  [[nodiscard]] auto world_bounds(const math::Mat4f& model_mat) const
+      -> std::optional<math::BoundingSphere> {
+    if (mesh_ == nullptr) return std::nullopt;
+    return mesh_->bounding_sphere().transformed(model_mat);
   }
 
   auto update_mesh(const std::filesystem::path& project_root,
                    const std::filesystem::path& mesh_path) -> expected<void> {
-    mesh_file_ = mesh_path;
+    path_ = mesh_path;
+    return load_assets(project_root);
+  }
 
-    TRY_RESULT(mesh_, load_mesh(project_root / mesh_path));
+  //! @brief Load the mesh at mesh_file(), relative to the project, through
+  //! the shared MeshCache so renderers of the same file share one mesh
+  auto load_assets(const std::filesystem::path& project_root)
+      -> expected<void> {
+    TRY_RESULT(auto mesh, MeshCache::shared()->get(project_root / path_));
+    set_mesh(std::move(mesh));
 
     return {};
   }
 
-  [[nodiscard]] auto mesh() const { return mesh_; }
-  [[nodiscard]] auto mesh_file() const { return mesh_file_; }
+  //! @brief Use a mesh loaded elsewhere for mesh_file()
+  void set_mesh(std::shared_ptr<Mesh> mesh) {
+    mesh_ = std::move(mesh);
+    lod_ = 0;
+  }
+
+  [[nodiscard]] auto mesh() const -> const std::shared_ptr<Mesh>& {
+    return mesh_;
+  }
+  [[nodiscard]] auto mesh_file() const { return path_; }
 
  private:
-  std::optional<Mesh> mesh_;
-  std::filesystem::path mesh_file_;
-  std::shared_ptr<vk::Buffer> ubo_;
+  //! @brief Shared with every renderer of the same file
+  std::shared_ptr<Mesh> mesh_;
+  //! @brief The mesh file, the only thing scenes save
+  std::filesystem::path path_;
+
+  //! @brief Drawn with the other instances of the mesh this frame
+  bool instanced_ = false;
+  //! @brief First of this frame's meshlet draws
+  std::optional<uint32_t> meshlet_draw_;
+  std::size_t lod_ = 0;
+
+  BOOST_DESCRIBE_CLASS(MeshRenderer, (), (), (), (path_))
 };
 
 }  // namespace wren::scene::components
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <boost/describe.hpp>
 #include <wren/math/geometry.hpp>
 #include <wren/math/matrix.hpp>
 #include <wren/math/quaternion.hpp>
@@ -31,4 +32,6 @@ struct Transform {
   }
 };
 
+BOOST_DESCRIBE_STRUCT(Transform, (), (position, rotation, scale))
+
 }  // namespace wren::scene::components
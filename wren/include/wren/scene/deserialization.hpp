@@ -7,8 +7,15 @@
 
 namespace wren::scene {
 
+DEFINE_ERROR("Scene", SceneErrors, InvalidScene)
+
+//! @brief Load a TOML scene into scene, components are read through the
+//! scene's ComponentRegistry and unknown ones are skipped
+//! @param load_assets Load the assets components reference (meshes), off
+//! when the scene is only being converted
 auto deserialize(const std::filesystem::path& project_root,
                  const std::filesystem::path& file,
-                 const std::shared_ptr<Scene>& scene) -> expected<void>;
+                 const std::shared_ptr<Scene>& scene, bool load_assets = true)
+    -> expected<void>;
 
-}
+}  // namespace wren::scene
@@ -23,6 +23,8 @@ class Entity {
   template <typename T, typename... Args>
   void add_component(Args&&... args);
 
+  [[nodiscard]] auto handle() const -> flecs::entity { return entity_; }
+
  private:
   flecs::entity entity_;
 
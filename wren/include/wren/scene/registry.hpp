@@ -0,0 +1,217 @@
+#pragma once
+
+#include <flecs.h>
+
+#include <array>
+#include <boost/describe.hpp>
+#include <boost/mp11.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <toml++/toml.hpp>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <wren/math/vector.hpp>
+#include <wren/utils/enums.hpp>
+#include <wren/utils/result.hpp>
+
+namespace wren::scene {
+
+//! @brief How one component type is saved and loaded. Everything is plain
+//! function pointers generated from the type's Boost.Describe description.
+struct ComponentType {
+  //! @brief Key of the component in scene files
+  std::string name;
+  flecs::id_t id = 0;
+
+  auto (*to_toml)(const void* component) -> toml::table = nullptr;
+  void (*from_toml)(const toml::table& table, void* component) = nullptr;
+  //! @brief Loads whatever the component references once its fields are
+  //! read, null for components without assets
+  auto (*load_assets)(const std::filesystem::path& project_root,
+                      void* component) -> expected<void> = nullptr;
+};
+
+template <typename T>
+concept HasAssets = requires(T t, const std::filesystem::path& root) {
+  { t.load_assets(root) } -> std::same_as<expected<void>>;
+};
+
+namespace detail {
+
+template <typename T>
+concept Vector = requires { typename T::vec_t; } &&
+                 std::is_base_of_v<typename T::vec_t, T>;
+
+template <typename T>
+constexpr bool kDescribedClass =
+    boost::describe::has_describe_members<T>::value;
+
+template <typename T>
+constexpr bool kDescribedEnum =
+    boost::describe::has_describe_enumerators<T>::value;
+
+constexpr std::array<std::string_view, 4> kVectorKeys = {"x", "y", "z", "w"};
+
+//! @brief Member names with the trailing underscore of private members cut
+constexpr auto field_name(std::string_view name) -> std::string_view {
+  if (name.ends_with('_')) name.remove_suffix(1);
+  return name;
+}
+
+template <typename T>
+auto to_toml(const T& value) -> toml::table;
+
+template <typename T>
+void from_toml(const toml::table& table, T& value);
+
+template <typename T>
+void write_value(toml::table& out, std::string_view key, const T& value) {
+  if constexpr (std::is_same_v<T, bool> || std::is_floating_point_v<T>) {
+    out.insert_or_assign(key, value);
+  } else if constexpr (std::is_integral_v<T>) {
+    out.insert_or_assign(key, static_cast<int64_t>(value));
+  } else if constexpr (kDescribedEnum<T>) {
+    out.insert_or_assign(key, utils::enum_to_string(value));
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    out.insert_or_assign(key, value);
+  } else if constexpr (std::is_same_v<T, std::filesystem::path>) {
+    out.insert_or_assign(key, value.generic_string());
+  } else if constexpr (Vector<T>) {
+    toml::table vec;
+    for (std::size_t i = 0; i < value.data.size(); ++i) {
+      vec.insert_or_assign(kVectorKeys.at(i), value.data.at(i));
+    }
+    out.insert_or_assign(key, std::move(vec));
+  } else if constexpr (kDescribedClass<T>) {
+    out.insert_or_assign(key, to_toml(value));
+  } else {
+    static_assert(sizeof(T) == 0, "No TOML conversion for this type");
+  }
+}
+
+//! @brief Fields missing from the file keep their current value
+template <typename T>
+void read_value(toml::node_view<const toml::node> node, T& value) {
+  if (!node) return;
+
+  if constexpr (std::is_arithmetic_v<T>) {
+    if (const auto v = node.value<T>()) value = *v;
+  } else if constexpr (kDescribedEnum<T>) {
+    if (const auto v = node.value<std::string>()) {
+      value = utils::string_to_enum<T>(*v).value_or(value);
+    }
+  } else if constexpr (std::is_same_v<T, std::string> ||
+                       std::is_same_v<T, std::filesystem::path>) {
+    if (const auto v = node.value<std::string>()) value = *v;
+  } else if constexpr (Vector<T>) {
+    for (std::size_t i = 0; i < value.data.size(); ++i) {
+      read_value(node[kVectorKeys.at(i)], value.data.at(i));
+    }
+  } else if constexpr (kDescribedClass<T>) {
+    if (const auto* table = node.as_table()) from_toml(*table, value);
+  } else {
+    static_assert(sizeof(T) == 0, "No TOML conversion for this type");
+  }
+}
+
+template <typename T>
+using Members =
+    boost::describe::describe_members<T, boost::describe::mod_any_access>;
+
+template <typename T>
+auto to_toml(const T& value) -> toml::table {
+  toml::table table;
+  boost::mp11::mp_for_each<Members<T>>([&](auto member) {
+    write_value(table, field_name(member.name), value.*member.pointer);
+  });
+  return table;
+}
+
+template <typename T>
+void from_toml(const toml::table& table, T& value) {
+  boost::mp11::mp_for_each<Members<T>>([&](auto member) {
+    read_value(table[field_name(member.name)], value.*member.pointer);
+  });
+}
+
+}  // namespace detail
+
+//! @brief Every component type scenes save, looked up by flecs id while
+//! saving and by name while loading
+class ComponentRegistry {
+ public:
+  //! @brief Register a component described with BOOST_DESCRIBE_STRUCT or
+  //! BOOST_DESCRIBE_CLASS, its members (private ones too) are what's saved.
+  //! Components with a load_assets(project_root) member have it called after
+  //! being loaded.
+  template <typename T>
+  void add(flecs::world& world, std::string name);
+
+  [[nodiscard]] auto find(flecs::id_t id) const -> const ComponentType* {
+    const auto it = by_id_.find(id);
+    return it == by_id_.end() ? nullptr : &types_.at(it->second);
+  }
+
+  [[nodiscard]] auto find(std::string_view name) const
+      -> const ComponentType* {
+    const auto it = by_name_.find(name);
+    return it == by_name_.end() ? nullptr : &types_.at(it->second);
+  }
+
+  [[nodiscard]] auto types() const -> const std::vector<ComponentType>& {
+    return types_;
+  }
+
+ private:
+  struct NameHash {
+    using is_transparent = void;
+    auto operator()(std::string_view name) const {
+      return std::hash<std::string_view>{}(name);
+    }
+  };
+
+  std::vector<ComponentType> types_;
+  std::unordered_map<flecs::id_t, std::size_t> by_id_;
+  std::unordered_map<std::string, std::size_t, NameHash, std::equal_to<>>
+      by_name_;
+};
+
+template <typename T>
+concept HasWorldInit = requires(const flecs::world& world) { T::init(world); };
+
+template <typename T>
+void ComponentRegistry::add(flecs::world& world, std::string name) {
+  static_assert(detail::kDescribedClass<T>,
+                "Components need a Boost.Describe description to be saved");
+
+  if constexpr (HasWorldInit<T>) T::init(world);
+
+  ComponentType type{
+      .name = std::move(name),
+      .id = world.component<T>().id(),
+      .to_toml = [](const void* component) {
+        return detail::to_toml(*static_cast<const T*>(component));
+      },
+      .from_toml =
+          [](const toml::table& table, void* component) {
+            detail::from_toml(table, *static_cast<T*>(component));
+          },
+  };
+  if constexpr (HasAssets<T>) {
+    type.load_assets = [](const std::filesystem::path& project_root,
+                          void* component) {
+      return static_cast<T*>(component)->load_assets(project_root);
+    };
+  }
+
+  const auto index = types_.size();
+  by_id_.insert_or_assign(type.id, index);
+  by_name_.insert_or_assign(type.name, index);
+  types_.push_back(std::move(type));
+}
+
+}  // namespace wren::scene
@@ -4,6 +4,8 @@
 
 #include <memory>
 
+#include "registry.hpp"
+
 namespace wren::scene {
 
 class Entity;
@@ -17,10 +19,16 @@ class Scene : public std::enable_shared_from_this<Scene> {
   auto world() const -> const flecs::world& { return ecs_; }
   auto world() -> flecs::world& { return ecs_; }
 
+  //! @brief The component types saved with the scene, the built in ones are
+  //! registered up front
+  auto components() const -> const ComponentRegistry& { return components_; }
+  auto components() -> ComponentRegistry& { return components_; }
+
  private:
-  Scene() = default;
+  Scene();
 
   flecs::world ecs_;
+  ComponentRegistry components_;
 };
 
 }  // namespace wren::scene
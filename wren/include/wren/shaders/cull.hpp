@@ -0,0 +1,148 @@
+#pragma once
+
+#include <string_view>
+
+namespace wren::shaders {
+
+//! @brief Tests instance bounding spheres against the frustum. Instances are
+//! grouped by the mesh they draw, each group has a range of both draw lists.
+//! Every instance gets an indirect draw with an instance count of 0 or 1 in
+//! its slot of the group's range, visible ones are also appended to the
+//! group's range of a compacted list with a count per group. The first
+//! instance of each draw is the instance's index, the vertex shader reads the
+//! instance's model matrix with it.
+const std::string_view kCullCompShader = R"(
+#version 450
+
+layout(local_size_x = 64) in;
+
+struct Instance {
+    vec4 sphere;
+    uint index_count;
+    uint first_index;
+    int vertex_offset;
+    uint group;
+    // Slot in draws, and the first slot of the group in both lists
+    uint draw;
+    uint first_draw;
+    uint padding[2];
+};
+
+struct DrawCommand {
+    uint index_count;
+    uint instance_count;
+    uint first_index;
+    int vertex_offset;
+    uint first_instance;
+};
+
+layout(set = 0, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+
+layout(set = 0, binding = 1) writeonly buffer Draws {
+    DrawCommand draws[];
+};
+
+layout(set = 0, binding = 2) writeonly buffer VisibleDraws {
+    DrawCommand visible_draws[];
+};
+
+layout(set = 0, binding = 3) buffer VisibleCounts {
+    uint visible_counts[];
+};
+
+layout(push_constant) uniform CULL {
+    vec4 planes[6];
+    uint instance_count;
+} cull;
+
+void main() {
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= cull.instance_count) return;
+
+    Instance instance = instances[index];
+
+    bool visible = true;
+    for (int i = 0; i < 6; ++i) {
+        vec4 plane = cull.planes[i];
+        visible = visible &&
+            dot(plane.xyz, instance.sphere.xyz) + plane.w >= -instance.sphere.w;
+    }
+
+    DrawCommand draw = DrawCommand(instance.index_count, visible ? 1 : 0,
+        instance.first_index, instance.vertex_offset, index);
+    draws[instance.draw] = draw;
+
+    if (visible) {
+        uint slot = atomicAdd(visible_counts[instance.group], 1);
+        visible_draws[instance.first_draw + slot] = draw;
+    }
+}
+)";
+
+//! @brief Tests a mesh's meshlets against the frustum and their normal cones
+//! against the camera, writing one indirect draw per meshlet. Everything is
+//! in the mesh's model space, the planes and camera are transformed into it
+//! on the CPU.
+const std::string_view kMeshletCullCompShader = R"(
+#version 450
+
+layout(local_size_x = 64) in;
+
+struct Meshlet {
+    vec4 sphere;
+    vec4 cone;
+    uint first_index;
+    uint index_count;
+    uint padding0;
+    uint padding1;
+};
+
+struct DrawCommand {
+    uint index_count;
+    uint instance_count;
+    uint first_index;
+    int vertex_offset;
+    uint first_instance;
+};
+
+layout(set = 0, binding = 0) readonly buffer Meshlets {
+    Meshlet meshlets[];
+};
+
+layout(set = 0, binding = 1) writeonly buffer Draws {
+    DrawCommand draws[];
+};
+
+layout(push_constant) uniform CULL {
+    vec4 planes[6];
+    vec4 camera;
+    uint meshlet_count;
+    uint first_draw;
+} cull;
+
+void main() {
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= cull.meshlet_count) return;
+
+    Meshlet meshlet = meshlets[index];
+
+    bool visible = true;
+    for (int i = 0; i < 6; ++i) {
+        vec4 plane = cull.planes[i];
+        visible = visible &&
+            dot(plane.xyz, meshlet.sphere.xyz) + plane.w >= -meshlet.sphere.w;
+    }
+
+    // Every triangle faces away when the camera is far enough behind the cone
+    vec3 to_centre = meshlet.sphere.xyz - cull.camera.xyz;
+    visible = visible && dot(to_centre, meshlet.cone.xyz) <
+        meshlet.cone.w * length(to_centre) + meshlet.sphere.w;
+
+    draws[cull.first_draw + index] = DrawCommand(meshlet.index_count,
+        visible ? 1 : 0, meshlet.first_index, 0, 0);
+}
+)";
+
+}  // namespace wren::shaders
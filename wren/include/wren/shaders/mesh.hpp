@@ -8,14 +8,15 @@ const std::string_view kMeshVertShader = R"(
 #version 450
 
 layout(location = 0) in vec3 in_position;
-layout(location = 1) in vec3 in_color;
+// Locations follow wren::vk::VertexLayout, the normal at 1 isn't read
+layout(location = 2) in vec4 in_color;
 
 layout(binding = 0) uniform GLOBALS {
     mat4 view;
     mat4 proj;
 } globals;
 
-layout(binding = 1) uniform LOCALS {
+layout(push_constant) uniform LOCALS {
     mat4 model;
 } locals;
 
@@ -23,7 +24,7 @@ layout(location = 0) out vec3 out_color;
 
 void main() {
     gl_Position = globals.proj * globals.view * locals.model * vec4(in_position, 1.0);
-    out_color = in_color;
+    out_color = in_color.rgb;
 }
 )";
 
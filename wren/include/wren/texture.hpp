@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include <wren/utils/result.hpp>
+#include <wren/vk/image.hpp>
+
+#include "assets/database.hpp"
+#include "graphics_context.hpp"
+#include "texture_file.hpp"
+
+namespace wren {
+
+//! @brief A texture whose GPU image holds only the coarsest mips of its file,
+//! from resident_mip() down. The finer mips are uploaded and dropped by the
+//! TextureStreamer it was loaded through.
+class Texture {
+ public:
+  Texture(const Texture&) = delete;
+  Texture(Texture&&) = delete;
+  auto operator=(const Texture&) = delete;
+  auto operator=(Texture&&) = delete;
+  //! @brief The image is destroyed once in flight frames are done with it
+  ~Texture();
+
+  [[nodiscard]] auto width() const { return file_.width(); }
+  [[nodiscard]] auto height() const { return file_.height(); }
+  [[nodiscard]] auto mip_count() const { return file_.mip_count(); }
+
+  //! @brief The finest mip on the GPU, mip 0 of the image
+  [[nodiscard]] auto resident_mip() const { return resident_mip_; }
+
+  //! @brief Bytes of GPU memory held by the resident mips
+  [[nodiscard]] auto resident_bytes() const -> std::size_t;
+
+  [[nodiscard]] auto view() const { return view_; }
+
+  //! @brief Where shaders find the texture in the bindless heap, null
+  //! without one. The image is replaced whenever the resident mips change,
+  //! so look it up each frame rather than keeping it.
+  [[nodiscard]] auto bindless_index() const { return bindless_index_; }
+
+ private:
+  friend class TextureStreamer;
+
+  Texture(std::shared_ptr<GraphicsContext> graphics_context, TextureFile file)
+      : graphics_context_(std::move(graphics_context)),
+        file_(std::move(file)) {}
+
+  //! @brief Bytes mips from first_mip down would take on the GPU
+  [[nodiscard]] auto bytes_from(uint32_t first_mip) const -> std::size_t;
+
+  //! @brief Replace the image with one holding mips from first_mip down,
+  //! copied from the mapped file
+  auto make_resident(uint32_t first_mip, const ::vk::Sampler& sampler)
+      -> expected<void>;
+
+  //! @brief Hand the current image to the deletion queue
+  void retire();
+
+  //! @brief Destroy an image, its view and heap slot once in flight frames
+  //! are done with them. A null view or no slot is skipped.
+  void destroy_later(const vk::Image& image, ::vk::ImageView view,
+                     std::optional<uint32_t> bindless_index) const;
+
+  std::shared_ptr<GraphicsContext> graphics_context_;
+  TextureFile file_;
+
+  std::optional<vk::Image> image_;
+  ::vk::ImageView view_;
+  std::optional<uint32_t> bindless_index_;
+  uint32_t resident_mip_ = 0;
+
+  //! @brief Set by TextureStreamer::request(), read on the next update
+  uint32_t wanted_mip_ = 0;
+  uint64_t requested_update_ = 0;
+};
+
+struct TextureStreamerOptions {
+  //! @brief GPU memory all textures may use together, textures are only
+  //! ever as fine as fits
+  std::size_t budget = std::size_t{256} << 20U;
+  //! @brief Bytes uploaded per update at most, at least one texture is
+  //! always uploaded so a large one can't stall forever
+  std::size_t upload_budget = std::size_t{16} << 20U;
+  //! @brief Mips this size and smaller are uploaded on load and never
+  //! dropped, something is always there to sample
+  uint32_t tail_size = 64;
+  //! @brief Updates a texture keeps its mips without being requested
+  //! before they may be dropped for others
+  uint64_t keep_updates = 60;
+};
+
+//! @brief Loads textures and streams their mips in and out. Textures start
+//! with only their coarse tail on the GPU, whoever draws them calls
+//! request() with the size they cover on screen, and update() uploads the
+//! mips that are visibly missing within the memory budget, dropping the
+//! finest mips of the textures requested least recently to make room.
+//!
+//! Imported textures are cached as texture files, in the asset database's
+//! cache directory when there is one (see write_texture_file()).
+class TextureStreamer {
+ public:
+  using Options = TextureStreamerOptions;
+
+  static auto create(const std::shared_ptr<GraphicsContext>& graphics_context,
+                     const Options& options = {})
+      -> expected<std::shared_ptr<TextureStreamer>>;
+
+  TextureStreamer(const TextureStreamer&) = delete;
+  TextureStreamer(TextureStreamer&&) = delete;
+  auto operator=(const TextureStreamer&) = delete;
+  auto operator=(TextureStreamer&&) = delete;
+  ~TextureStreamer();
+
+  //! @brief Where imported textures are cached, without one they go to the
+  //! temporary directory
+  void database(std::shared_ptr<assets::Database> database);
+
+  //! @brief Import or reuse the texture file of a TGA and upload its tail
+  auto load(const std::filesystem::path& file,
+            const TextureImportSettings& settings = {})
+      -> expected<std::shared_ptr<Texture>>;
+
+  //! @brief Note that texture was drawn covering screen_pixels across, the
+  //! largest request between two updates wins
+  void request(const std::shared_ptr<Texture>& texture, float screen_pixels);
+
+  //! @brief Stream mips in and out, once per frame on the render thread
+  auto update() -> expected<void>;
+
+  [[nodiscard]] auto resident_bytes() const -> std::size_t;
+  [[nodiscard]] auto options() const -> const Options& { return options_; }
+
+  //! @brief Trilinear, repeating sampler every texture is bound with
+  [[nodiscard]] auto sampler() const { return sampler_; }
+
+ private:
+  TextureStreamer(std::shared_ptr<GraphicsContext> graphics_context,
+                  const Options& options)
+      : graphics_context_(std::move(graphics_context)), options_(options) {}
+
+  auto import(const std::filesystem::path& file,
+              const TextureImportSettings& settings) -> expected<TextureFile>;
+
+  //! @brief The coarsest mips kept resident
+  [[nodiscard]] auto tail_mip(const Texture& texture) const -> uint32_t;
+
+  std::shared_ptr<GraphicsContext> graphics_context_;
+  Options options_;
+  ::vk::Sampler sampler_;
+
+  mutable std::mutex mutex_;
+  std::shared_ptr<assets::Database> database_;
+  std::vector<std::weak_ptr<Texture>> textures_;
+  //! @brief Requests are stamped with it, textures start at 0
+  uint64_t update_ = 1;
+};
+
+}  // namespace wren
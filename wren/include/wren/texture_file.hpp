@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+#include <wren/utils/mapped_file.hpp>
+#include <wren/utils/result.hpp>
+
+namespace wren {
+
+DEFINE_ERROR("TextureFile", TextureFileErrors, NotATextureFile,
+             UnsupportedVersion, Corrupt, StaleSource, UnsupportedImage)
+
+//! @brief Bumped whenever the layout of texture files changes, older files
+//! are imported again from their source
+constexpr uint32_t kTextureFileVersion = 1;
+
+//! @brief Artifact kind of imported textures, see assets::Database::artifact()
+constexpr auto kTextureFileExtension = "wtex";
+
+enum class TextureFormat : uint32_t {
+  Rgba8 = 0,
+  //! @brief 4x4 blocks of 8 bytes, see math::encode_bc1()
+  Bc1 = 1,
+};
+
+struct TextureImportSettings {
+  //! @brief Block compress the mips, an eighth of the memory of RGBA8
+  bool compress = true;
+  //! @brief Colour data, filtered in linear space and sampled as sRGB. Turn
+  //! off for normal maps and other data.
+  bool srgb = true;
+
+  auto operator==(const TextureImportSettings&) const -> bool = default;
+};
+
+//! @brief Decoded source pixels, 4 bytes per texel in rows from the top
+struct RgbaImage {
+  uint32_t width = 0;
+  uint32_t height = 0;
+  std::vector<uint8_t> pixels;
+};
+
+//! @brief Read an uncompressed true colour or greyscale TGA
+auto load_tga(const std::filesystem::path& file) -> expected<RgbaImage>;
+
+//! @brief Import an image as a texture file: the full mip chain down to 1x1,
+//! compressed as set, finest mip first.
+//! @param source_hash Content hash of the file the image was read from
+auto write_texture_file(const RgbaImage& image,
+                        const TextureImportSettings& settings,
+                        uint64_t source_hash,
+                        const std::filesystem::path& file) -> expected<void>;
+
+//! @brief A mapped texture file. Nothing is read up front, a mip's pages are
+//! only touched when it's uploaded, so keeping every texture open costs
+//! address space rather than memory.
+class TextureFile {
+ public:
+  //! @brief Fails with StaleSource when the file was written for another
+  //! version of the source
+  static auto open(const std::filesystem::path& file, uint64_t source_hash)
+      -> expected<TextureFile>;
+
+  [[nodiscard]] auto format() const { return format_; }
+  [[nodiscard]] auto srgb() const { return srgb_; }
+  [[nodiscard]] auto width() const { return width_; }
+  [[nodiscard]] auto height() const { return height_; }
+  [[nodiscard]] auto mip_count() const {
+    return static_cast<uint32_t>(mips_.size());
+  }
+
+  //! @brief The texels of a mip, in the file's format
+  [[nodiscard]] auto mip(uint32_t level) const -> std::span<const std::byte>;
+
+  //! @brief Bytes of a mip once on the GPU, decoded to RGBA8 when
+  //! decompress is set
+  [[nodiscard]] auto mip_size(uint32_t level, bool decompress) const
+      -> std::size_t;
+
+ private:
+  struct Mip {
+    uint64_t offset = 0;
+    uint64_t size = 0;
+  };
+
+  explicit TextureFile(utils::MappedFile file) : file_(std::move(file)) {}
+
+  utils::MappedFile file_;
+  TextureFormat format_ = TextureFormat::Rgba8;
+  bool srgb_ = false;
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  std::vector<Mip> mips_;
+};
+
+}  // namespace wren
@@ -18,8 +18,39 @@ class Device {
 
   [[nodiscard]] auto get_present_queue() const { return present_queue_; }
 
+  //! @brief The queue of a dedicated compute family, null without one
+  [[nodiscard]] auto get_compute_queue() const { return compute_queue_; }
+
   [[nodiscard]] auto command_pool() const { return command_pool_; }
 
+  //! @brief Whether the descriptor indexing features needed by
+  //! vk::BindlessHeap were enabled
+  [[nodiscard]] auto supports_bindless() const { return bindless_; }
+
+  //! @brief Whether VK_KHR_dynamic_rendering was enabled
+  [[nodiscard]] auto supports_dynamic_rendering() const {
+    return dynamic_rendering_;
+  }
+
+  //! @brief Whether BC compressed formats can be sampled
+  [[nodiscard]] auto supports_bc_textures() const { return bc_textures_; }
+
+  //! @brief Draws one indirect draw call can make, 1 without the
+  //! multiDrawIndirect feature
+  [[nodiscard]] auto max_draw_indirect_count() const {
+    return max_draw_indirect_count_;
+  }
+
+  //! @brief Whether indirect draws may start at an instance other than 0
+  [[nodiscard]] auto supports_draw_indirect_first_instance() const {
+    return draw_indirect_first_instance_;
+  }
+
+  //! @brief Whether VK_KHR_draw_indirect_count was enabled
+  [[nodiscard]] auto supports_draw_indirect_count() const {
+    return draw_indirect_count_;
+  }
+
  private:
   auto create_device(const ::vk::Instance &instance,
                      const ::vk::PhysicalDevice &physical_device,
@@ -29,6 +60,14 @@ class Device {
   ::vk::Device device_;
   ::vk::Queue graphics_queue_;
   ::vk::Queue present_queue_;
+  ::vk::Queue compute_queue_;
+
+  bool bindless_ = false;
+  bool dynamic_rendering_ = false;
+  bool bc_textures_ = false;
+  uint32_t max_draw_indirect_count_ = 1;
+  bool draw_indirect_first_instance_ = false;
+  bool draw_indirect_count_ = false;
 };
 
 }  // namespace wren::vulkan
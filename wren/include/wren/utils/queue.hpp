@@ -11,6 +11,9 @@ namespace wren::vulkan {
 struct QueueFamilyIndices {
   uint32_t graphics_index;
   uint32_t present_index;
+  //! @brief A family that can compute but not draw, so work submitted to it
+  //! runs alongside the graphics queue
+  std::optional<uint32_t> compute_index;
 };
 
 class Queue {
@@ -0,0 +1,450 @@
+#include "assets/database.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <fstream>
+#include <mutex>
+#include <toml++/toml.hpp>
+#include <wren/utils/hash.hpp>
+#include <wren/utils/mapped_file.hpp>
+
+#include "wren/utils/tracy.hpp"  // IWYU pragma: keep
+
+#if __has_include(<sys/inotify.h>)
+#define WREN_ASSETS_HAS_INOTIFY
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace wren::assets {
+
+namespace {
+
+constexpr auto kManifestFile = "manifest.toml";
+constexpr int64_t kManifestVersion = 1;
+
+auto normalize(const std::filesystem::path& path) -> std::string {
+  std::error_code ec;
+  auto absolute = std::filesystem::absolute(path, ec);
+  if (ec) absolute = path;
+  return absolute.lexically_normal().generic_string();
+}
+
+auto write_time(const std::filesystem::path& file) -> int64_t {
+  std::error_code ec;
+  const auto time = std::filesystem::last_write_time(file, ec);
+  return ec ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+}  // namespace
+
+auto Database::create(const std::vector<std::filesystem::path>& roots,
+                      const std::optional<std::filesystem::path>& cache_dir)
+    -> std::shared_ptr<Database> {
+  ZoneScoped;
+
+  auto database =
+      std::shared_ptr<Database>(new Database(roots, cache_dir));
+  spdlog::info("Indexed {} assets", database->size());
+  return database;
+}
+
+Database::Database(std::vector<std::filesystem::path> roots,
+                   std::optional<std::filesystem::path> cache_dir)
+    : roots_(std::move(roots)), cache_dir_(std::move(cache_dir)) {
+  if (cache_dir_.has_value()) {
+    std::error_code ec;
+    std::filesystem::create_directories(*cache_dir_, ec);
+    load_manifest();
+  }
+
+#ifdef WREN_ASSETS_HAS_INOTIFY
+  inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_ < 0) {
+    spdlog::warn("inotify unavailable, assets won't be reloaded on change");
+  }
+#endif
+
+  for (std::size_t root = 0; root < roots_.size(); ++root) {
+    index_directory(root, roots_[root]);
+  }
+
+  // Whatever is still current has been merged into the index
+  manifest_.clear();
+}
+
+Database::~Database() {
+  if (const auto saved = save(); !saved.has_value()) {
+    spdlog::warn("Failed to save the asset manifest: {}", saved.error());
+  }
+
+#ifdef WREN_ASSETS_HAS_INOTIFY
+  if (inotify_ >= 0) ::close(inotify_);
+#endif
+}
+
+auto Database::find(const std::filesystem::path& asset) const
+    -> expected<std::filesystem::path> {
+  std::scoped_lock lock(mutex_);
+  if (asset.is_absolute()) {
+    const auto key = normalize(asset);
+    if (records_.contains(key)) return std::filesystem::path{key};
+  }
+
+  const auto it = lookup_.find(asset.lexically_normal().generic_string());
+  if (it == lookup_.end() || it->second.empty()) {
+    return std::unexpected(
+        std::make_error_code(std::errc::no_such_file_or_directory));
+  }
+
+  const auto best = std::ranges::min_element(
+      it->second, {}, [](const Candidate& c) { return c.priority; });
+  return std::filesystem::path{best->file};
+}
+
+auto Database::hash(const std::filesystem::path& file) -> expected<uint64_t> {
+  std::scoped_lock lock(mutex_);
+  auto key = normalize(file);
+  if (!records_.contains(key)) {
+    TRY_RESULT(const auto found, find(file));
+    key = found.generic_string();
+  }
+
+  auto& record = records_.at(key);
+  if (record.hash.has_value()) return *record.hash;
+
+  auto mapped = utils::MappedFile::open(key);
+  if (!mapped.has_value()) return std::unexpected(mapped.error());
+  record.hash = utils::fnv1a(mapped->data());
+  return *record.hash;
+}
+
+void Database::add_dependency(const std::filesystem::path& file,
+                              const std::filesystem::path& dependency) {
+  std::scoped_lock lock(mutex_);
+  const auto key = normalize(file);
+  const auto dependency_key = normalize(dependency);
+
+  dependents_[dependency_key].insert(key);
+
+  const auto record = records_.find(key);
+  if (record == records_.end()) return;
+  auto& dependencies = record->second.dependencies;
+  if (std::ranges::find(dependencies, dependency_key) == dependencies.end()) {
+    dependencies.push_back(dependency_key);
+  }
+}
+
+auto Database::artifact(const std::filesystem::path& file,
+                        std::string_view kind)
+    -> expected<std::filesystem::path> {
+  std::scoped_lock lock(mutex_);
+  if (!cache_dir_.has_value()) {
+    return std::unexpected(
+        std::make_error_code(std::errc::operation_not_supported));
+  }
+
+  auto key = normalize(file);
+  if (!records_.contains(key)) {
+    TRY_RESULT(const auto found, find(file));
+    key = found.generic_string();
+  }
+
+  std::unordered_set<std::string> seen;
+  TRY_RESULT(const auto hash, hash_of(key, seen));
+  return *cache_dir_ / fmt::format("{:016x}.{}", hash, kind);
+}
+
+auto Database::size() const -> std::size_t {
+  std::scoped_lock lock(mutex_);
+  return records_.size();
+}
+
+auto Database::hash_of(const std::string& file,
+                       std::unordered_set<std::string>& seen)
+    -> expected<uint64_t> {
+  TRY_RESULT(auto combined, hash(file));
+  if (!seen.insert(file).second) return combined;
+
+  // Copied, hashing a dependency may index it
+  const auto dependencies = records_.at(file).dependencies;
+  for (const auto& dependency : dependencies) {
+    TRY_RESULT(const auto dependency_hash, hash_of(dependency, seen));
+    combined = utils::fnv1a(
+        std::as_bytes(std::span(&dependency_hash, 1)), combined);
+  }
+  return combined;
+}
+
+auto Database::poll() -> std::vector<std::filesystem::path> {
+  std::scoped_lock lock(mutex_);
+  std::unordered_set<std::string> changed;
+
+#ifdef WREN_ASSETS_HAS_INOTIFY
+  if (inotify_ < 0) return {};
+
+  alignas(inotify_event) std::array<char, 4096> buffer{};
+  while (true) {
+    const auto length = ::read(inotify_, buffer.data(), buffer.size());
+    if (length <= 0) break;
+
+    for (const char* ptr = buffer.data(); ptr < buffer.data() + length;) {
+      const auto* event = reinterpret_cast<const inotify_event*>(ptr);
+      ptr += sizeof(inotify_event) + event->len;
+
+      if ((event->mask & IN_Q_OVERFLOW) != 0) {
+        spdlog::warn("Missed asset changes, reindexing");
+        for (std::size_t root = 0; root < roots_.size(); ++root) {
+          index_directory(root, roots_[root]);
+        }
+        continue;
+      }
+
+      const auto watch = watches_.find(event->wd);
+      if (watch == watches_.end()) continue;
+      if ((event->mask & IN_IGNORED) != 0) {
+        watches_.erase(watch);
+        continue;
+      }
+      if (event->len == 0) continue;
+
+      const auto [root, dir] = watch->second;
+      const auto path = dir / event->name;
+      const auto key = normalize(path);
+
+      if ((event->mask & IN_ISDIR) != 0) {
+        // Files moved along with a directory don't get events of their own,
+        // nor do files written before a new directory is watched
+        std::vector<std::string> moved;
+        const auto collect = [&] {
+          for (const auto& [file, _] : records_) {
+            if (file.starts_with(key + "/")) moved.push_back(file);
+          }
+        };
+        if ((event->mask & (IN_CREATE | IN_MOVED_TO)) != 0) {
+          index_directory(root, path);
+          collect();
+        } else if ((event->mask & IN_MOVED_FROM) != 0) {
+          collect();
+          for (const auto& file : moved) remove_file(file);
+        }
+        changed.insert(moved.begin(), moved.end());
+        continue;
+      }
+
+      if ((event->mask & (IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO)) != 0) {
+        index_file(root, path);
+      } else if ((event->mask & (IN_DELETE | IN_MOVED_FROM)) != 0) {
+        remove_file(key);
+      }
+      changed.insert(key);
+    }
+  }
+#endif
+
+  // Anything depending on a changed file changed too
+  std::vector<std::string> pending(changed.begin(), changed.end());
+  while (!pending.empty()) {
+    const auto file = std::move(pending.back());
+    pending.pop_back();
+
+    const auto dependents = dependents_.find(file);
+    if (dependents == dependents_.end()) continue;
+    for (const auto& dependent : dependents->second) {
+      if (changed.insert(dependent).second) pending.push_back(dependent);
+    }
+  }
+
+  return {changed.begin(), changed.end()};
+}
+
+auto Database::save() const -> expected<void> {
+  std::scoped_lock lock(mutex_);
+  if (!cache_dir_.has_value()) return {};
+
+  toml::array files;
+  for (const auto& [file, record] : records_) {
+    if (!record.hash.has_value() && record.dependencies.empty()) continue;
+
+    toml::array dependencies;
+    for (const auto& dependency : record.dependencies) {
+      dependencies.push_back(dependency);
+    }
+    files.push_back(toml::table{
+        {"path", file},
+        {"size", static_cast<int64_t>(record.size)},
+        {"write_time", record.write_time},
+        {"hash", record.hash.has_value() ? fmt::format("{:016x}", *record.hash)
+                                         : std::string{}},
+        {"dependencies", dependencies},
+    });
+  }
+
+  std::ofstream out(*cache_dir_ / kManifestFile);
+  out << toml::table{{"version", kManifestVersion}, {"files", files}};
+  if (!out) return std::unexpected(std::make_error_code(std::errc::io_error));
+
+  return {};
+}
+
+void Database::load_manifest() {
+  const auto path = *cache_dir_ / kManifestFile;
+  if (!std::filesystem::exists(path)) return;
+
+  toml::table table;
+  try {
+    table = toml::parse_file(path.string());
+  } catch (const toml::parse_error& error) {
+    spdlog::warn("Ignoring broken asset manifest: {}", error.description());
+    return;
+  }
+  if (table["version"].value_or(int64_t{0}) != kManifestVersion) return;
+
+  const auto* files = table["files"].as_array();
+  if (files == nullptr) return;
+
+  for (const auto& node : *files) {
+    const auto* file = node.as_table();
+    if (file == nullptr) continue;
+    const auto key = (*file)["path"].value<std::string>();
+    if (!key.has_value()) continue;
+
+    Record record;
+    record.size = static_cast<uintmax_t>((*file)["size"].value_or(int64_t{0}));
+    record.write_time = (*file)["write_time"].value_or(int64_t{0});
+    const auto hash = (*file)["hash"].value_or(std::string{});
+    uint64_t value = 0;
+    if (std::from_chars(hash.data(), hash.data() + hash.size(), value, 16).ec ==
+        std::errc{}) {
+      record.hash = value;
+    }
+    if (const auto* dependencies = (*file)["dependencies"].as_array()) {
+      for (const auto& dependency : *dependencies) {
+        if (const auto d = dependency.value<std::string>()) {
+          record.dependencies.push_back(*d);
+          dependents_[*d].insert(*key);
+        }
+      }
+    }
+    manifest_.insert_or_assign(*key, std::move(record));
+  }
+}
+
+void Database::index_directory(std::size_t root,
+                               const std::filesystem::path& dir) {
+  ZoneScoped;
+
+  std::error_code ec;
+  if (!std::filesystem::is_directory(dir, ec)) return;
+  watch(root, dir);
+
+  const auto cache_dir =
+      cache_dir_.has_value() ? normalize(*cache_dir_) : std::string{};
+
+  for (auto it = std::filesystem::recursive_directory_iterator(
+           dir, std::filesystem::directory_options::skip_permission_denied,
+           ec);
+       !ec && it != std::filesystem::recursive_directory_iterator();
+       it.increment(ec)) {
+    if (it->is_directory(ec)) {
+      // Writing artifacts shouldn't look like assets changing
+      if (!cache_dir.empty() && normalize(it->path()) == cache_dir) {
+        it.disable_recursion_pending();
+        continue;
+      }
+      watch(root, it->path());
+    } else if (it->is_regular_file(ec)) {
+      index_file(root, it->path());
+    }
+  }
+}
+
+void Database::index_file(std::size_t root,
+                          const std::filesystem::path& file) {
+  std::error_code ec;
+  if (!std::filesystem::is_regular_file(file, ec)) return;
+
+  const auto key = normalize(file);
+  auto& record = records_[key];
+  record.root = root;
+  record.size = std::filesystem::file_size(file, ec);
+  record.write_time = write_time(file);
+  record.hash.reset();
+
+  // Reuse the last run's hash while the file looks the same
+  if (const auto previous = manifest_.find(key); previous != manifest_.end()) {
+    if (previous->second.size == record.size &&
+        previous->second.write_time == record.write_time) {
+      record.hash = previous->second.hash;
+    }
+    for (const auto& dependency : previous->second.dependencies) {
+      if (std::ranges::find(record.dependencies, dependency) ==
+          record.dependencies.end()) {
+        record.dependencies.push_back(dependency);
+      }
+    }
+  }
+
+  for (auto& [lookup_key, priority] : keys(root, file)) {
+    auto& candidates = lookup_[lookup_key];
+    if (std::ranges::find(candidates, key, &Candidate::file) ==
+        candidates.end()) {
+      candidates.push_back({key, priority});
+    }
+  }
+}
+
+void Database::remove_file(const std::string& file) {
+  const auto record = records_.find(file);
+  if (record == records_.end()) return;
+
+  for (const auto& [lookup_key, _] : keys(record->second.root, file)) {
+    const auto candidates = lookup_.find(lookup_key);
+    if (candidates == lookup_.end()) continue;
+    std::erase_if(candidates->second,
+                  [&file](const Candidate& c) { return c.file == file; });
+    if (candidates->second.empty()) lookup_.erase(candidates);
+  }
+
+  records_.erase(record);
+}
+
+void Database::watch(std::size_t root, const std::filesystem::path& dir) {
+#ifdef WREN_ASSETS_HAS_INOTIFY
+  if (inotify_ < 0) return;
+
+  const int wd = inotify_add_watch(
+      inotify_, dir.c_str(),
+      IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+  if (wd >= 0) watches_.insert_or_assign(wd, std::pair{root, dir});
+#else
+  (void)root;
+  (void)dir;
+#endif
+}
+
+auto Database::keys(std::size_t root, const std::filesystem::path& file) const
+    -> std::vector<std::pair<std::string, uint64_t>> {
+  const auto relative =
+      std::filesystem::path{normalize(file)}.lexically_relative(
+          normalize(roots_.at(root)));
+
+  std::vector<std::filesystem::path> parts(relative.begin(), relative.end());
+  std::vector<std::pair<std::string, uint64_t>> keys;
+  keys.reserve(parts.size());
+
+  // A file is found relative to its root first, then relative to each
+  // directory below it, and the roots are searched in order
+  for (std::size_t depth = 0; depth < parts.size(); ++depth) {
+    std::filesystem::path key;
+    for (std::size_t i = depth; i < parts.size(); ++i) key /= parts[i];
+    keys.emplace_back(key.generic_string(), (root << 32U) | depth);
+  }
+
+  return keys;
+}
+
+}  // namespace wren::assets
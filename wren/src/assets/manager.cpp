@@ -1,30 +1,35 @@
 #include "assets/manager.hpp"
 
-#include <wren/utils/filesystem.hpp>
-
 namespace wren::assets {
 
-auto Manager::find_asset(const std::filesystem::path& asset_path) const
-    -> expected<std::filesystem::path> {
-  // Check the project directory first
+Manager::Manager(const std::vector<std::filesystem::path>& asset_paths,
+                 const std::optional<std::filesystem::path>& project_path)
+    : asset_paths_(asset_paths), project_path_(project_path) {
+  // The project directory is searched first
+  std::vector<std::filesystem::path> roots;
+  std::optional<std::filesystem::path> cache_dir;
   if (project_path_.has_value()) {
-    const auto res =
-        utils::fs::file_exists_in_dir(project_path_.value(), asset_path);
-    if (res.has_value()) {
-      return res.value();
-    }
+    roots.push_back(project_path_.value());
+    cache_dir = project_path_.value() / kCacheDirectory;
   }
+  roots.insert(roots.end(), asset_paths_.begin(), asset_paths_.end());
+
+  database_ = Database::create(roots, cache_dir);
+}
 
-  // Check the rest of the asset paths
-  for (const auto& asset_dir : asset_paths_) {
-    const auto res = utils::fs::file_exists_in_dir(asset_dir, asset_path);
-    if (res.has_value()) {
-      return res.value();
-    }
+auto Manager::find_asset(const std::filesystem::path& asset_path) const
+    -> expected<std::filesystem::path> {
+  if (database_ == nullptr) {
+    return std::unexpected(
+        std::make_error_code(std::errc::no_such_file_or_directory));
   }
 
-  return std::unexpected(
-      std::make_error_code(std::errc::no_such_file_or_directory));
+  return database_->find(asset_path);
+}
+
+auto Manager::poll() -> std::vector<std::filesystem::path> {
+  if (database_ == nullptr) return {};
+  return database_->poll();
 }
 
 }  // namespace wren::assets
@@ -0,0 +1,285 @@
+#include "wren/culling.hpp"
+
+#include <algorithm>
+#include <wren/math/geometry.hpp>
+#include <wren/utils/parallel.hpp>
+#include <wren/utils/result.hpp>
+
+#include "utils/tracy.hpp"  // IWYU pragma: export
+#include "wren/render_pass.hpp"
+#include "wren/shaders/cull.hpp"
+
+namespace wren {
+
+namespace {
+
+constexpr uint32_t kGroupSize = 64;
+
+}  // namespace
+
+void CpuCulling::begin(const math::Mat4f& view_proj) {
+  frustum_ = math::Frustum::from_matrix(view_proj);
+  spheres_.clear();
+}
+
+auto CpuCulling::add(const math::BoundingSphere& sphere) -> uint32_t {
+  spheres_.push_back(sphere);
+  return static_cast<uint32_t>(spheres_.size() - 1);
+}
+
+void CpuCulling::cull() {
+  ZoneScoped;
+
+  visible_.resize(spheres_.size());
+  utils::parallel_for(spheres_.size(), kParallelGrain,
+                      [this](std::size_t begin, std::size_t end) {
+                        math::cull_spheres(frustum_, spheres_, visible_,
+                                           begin, end);
+                      });
+}
+
+auto GpuCulling::create(const std::shared_ptr<Context>& ctx,
+                        uint32_t max_instances, uint32_t max_meshlets)
+    -> expected<std::shared_ptr<GpuCulling>> {
+  const auto& graphics = ctx->graphics_context;
+  // Draws find their instance's model matrix through the first instance
+  if (!graphics->Device().supports_draw_indirect_first_instance()) {
+    return std::unexpected(
+        make_error_code(::vk::Result::eErrorFeatureNotPresent));
+  }
+
+  auto culling = std::shared_ptr<GpuCulling>(
+      new GpuCulling(max_instances, max_meshlets));
+
+  TRY_RESULT(culling->shader_,
+             vk::Shader::create_compute(graphics->Device().get(),
+                                        std::string(shaders::kCullCompShader)));
+  TRY_RESULT(culling->meshlet_shader_,
+             vk::Shader::create_compute(
+                 graphics->Device().get(),
+                 std::string(shaders::kMeshletCullCompShader)));
+  culling->max_draw_count_ = graphics->Device().max_draw_indirect_count();
+  culling->draw_indirect_count_ =
+      graphics->Device().supports_draw_indirect_count();
+
+  // Written on the compute queue, read by draws on the graphics queue
+  const auto families = graphics->queue_families();
+
+  culling->instance_buffer_ = vk::Buffer::create(
+      graphics->allocator(), max_instances * sizeof(Instance),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+      graphics->deletion_queue(), families);
+  culling->model_buffer_ = vk::Buffer::create(
+      graphics->allocator(), max_instances * sizeof(math::Mat4f),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+      graphics->deletion_queue());
+
+  const auto draws_size =
+      max_instances * sizeof(::vk::DrawIndexedIndirectCommand);
+  culling->draws_ = vk::Buffer::create(
+      graphics->allocator(), draws_size,
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+      {}, graphics->deletion_queue(), families);
+  culling->visible_draws_ = vk::Buffer::create(
+      graphics->allocator(), draws_size,
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+      {}, graphics->deletion_queue(), families);
+  // At most one group per instance
+  culling->visible_counts_ = vk::Buffer::create(
+      graphics->allocator(), max_instances * sizeof(uint32_t),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+          VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      {}, graphics->deletion_queue(), families);
+
+  culling->meshlet_draws_ = vk::Buffer::create(
+      graphics->allocator(),
+      max_meshlets * sizeof(::vk::DrawIndexedIndirectCommand),
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+      {}, graphics->deletion_queue(), families);
+
+  culling->instances_.reserve(max_instances);
+  culling->models_.reserve(max_instances);
+
+  return culling;
+}
+
+void GpuCulling::begin(const math::Mat4f& view_proj,
+                       const math::Mat4f& view) {
+  view_proj_ = view_proj;
+  frustum_ = math::Frustum::from_matrix(view_proj);
+  instances_.clear();
+  models_.clear();
+  groups_.clear();
+  group_of_.clear();
+  meshlet_batches_.clear();
+  meshlet_draw_count_ = 0;
+
+  // The camera sits at the origin of view space
+  const auto camera = math::inverse_affine(view);
+  camera_ = {camera.at(3, 0), camera.at(3, 1), camera.at(3, 2)};
+}
+
+auto GpuCulling::add(const std::shared_ptr<Mesh>& mesh,
+                     const math::BoundingSphere& sphere,
+                     const math::Mat4f& model, uint32_t index_count,
+                     uint32_t first_index) -> bool {
+  if (instances_.size() >= max_instances_) return false;
+
+  const auto [it, inserted] = group_of_.try_emplace(
+      mesh.get(), static_cast<uint32_t>(groups_.size()));
+  if (inserted) groups_.push_back(Group{.mesh = mesh});
+  auto& group = groups_.at(it->second);
+
+  instances_.push_back(Instance{
+      .sphere = {sphere.center.x(), sphere.center.y(), sphere.center.z(),
+                 sphere.radius},
+      .index_count = index_count,
+      .first_index = first_index,
+      .group = it->second,
+      // The rank in the group until dispatch() knows where groups start
+      .draw = group.count,
+  });
+  models_.push_back(model);
+  ++group.count;
+
+  return true;
+}
+
+auto GpuCulling::add_meshlets(const Mesh& mesh, const math::Mat4f& model)
+    -> std::optional<uint32_t> {
+  const auto count = static_cast<uint32_t>(mesh.meshlets().size());
+  // The compute queue doesn't wait for the graphics queue's uploads, until
+  // they're done the mesh is culled as a whole
+  if (mesh.meshlet_buffer() == nullptr || !mesh.uploaded() || count == 0 ||
+      meshlet_draw_count_ + count > max_meshlets_) {
+    return std::nullopt;
+  }
+
+  // Planes pulled out of view_proj * model are already in model space, and
+  // normalised there the sphere test stays exact under any scale
+  auto view_proj = view_proj_;
+  const auto frustum = math::Frustum::from_matrix(view_proj * model);
+
+  auto inverse = math::inverse_affine(model);
+  const math::Vec4f camera = inverse * math::Vec4f{camera_, 1.0F};
+
+  const auto first_draw = meshlet_draw_count_;
+  meshlet_batches_.push_back(MeshletBatch{
+      .meshlets = mesh.meshlet_buffer(),
+      .constants = {.planes = frustum.planes,
+                    .camera = camera,
+                    .meshlet_count = count,
+                    .first_draw = first_draw},
+  });
+  meshlet_draw_count_ += count;
+
+  return first_draw;
+}
+
+void GpuCulling::dispatch(RenderPass& pass, const ::vk::CommandBuffer& cmd) {
+  if (!instances_.empty()) {
+    // Groups get consecutive ranges of the draw lists
+    uint32_t first_draw = 0;
+    for (auto& group : groups_) {
+      group.first_draw = first_draw;
+      first_draw += group.count;
+    }
+    for (auto& instance : instances_) {
+      instance.first_draw = groups_.at(instance.group).first_draw;
+      instance.draw += instance.first_draw;
+    }
+
+    instance_buffer_->set_data_raw<Instance>(instances_);
+    model_buffer_->set_data_raw<math::Mat4f>(models_);
+
+    // The compacted lists are appended to with atomics, start them from 0
+    cmd.fillBuffer(visible_counts_->get(), 0,
+                   groups_.size() * sizeof(uint32_t), 0);
+    const ::vk::MemoryBarrier reset(
+        ::vk::AccessFlagBits::eTransferWrite,
+        ::vk::AccessFlagBits::eShaderRead | ::vk::AccessFlagBits::eShaderWrite);
+    cmd.pipelineBarrier(::vk::PipelineStageFlagBits::eTransfer,
+                        ::vk::PipelineStageFlagBits::eComputeShader, {}, reset,
+                        {}, {});
+
+    pass.bind_pipeline(kShaderName);
+
+    const std::array buffers = {
+        ::vk::DescriptorBufferInfo{instance_buffer_->get(), 0,
+                                   ::vk::WholeSize},
+        ::vk::DescriptorBufferInfo{draws_->get(), 0, ::vk::WholeSize},
+        ::vk::DescriptorBufferInfo{visible_draws_->get(), 0, ::vk::WholeSize},
+        ::vk::DescriptorBufferInfo{visible_counts_->get(), 0, ::vk::WholeSize},
+    };
+    pass.push_storage_buffers(cmd, buffers);
+
+    pass.push_constants(cmd, Constants{.planes = frustum_.planes,
+                                       .instance_count = instance_count()});
+
+    cmd.dispatch((instance_count() + kGroupSize - 1) / kGroupSize, 1, 1);
+  }
+
+  if (!meshlet_batches_.empty()) {
+    pass.bind_pipeline(kMeshletShaderName);
+    for (const auto& batch : meshlet_batches_) {
+      const std::array buffers = {
+          ::vk::DescriptorBufferInfo{batch.meshlets->get(), 0,
+                                     ::vk::WholeSize},
+          ::vk::DescriptorBufferInfo{meshlet_draws_->get(), 0,
+                                     ::vk::WholeSize},
+      };
+      pass.push_storage_buffers(cmd, buffers);
+      pass.push_constants(cmd, batch.constants);
+
+      cmd.dispatch(
+          (batch.constants.meshlet_count + kGroupSize - 1) / kGroupSize, 1, 1);
+    }
+  }
+}
+
+void GpuCulling::draw_instances(RenderPass& pass,
+                                const ::vk::CommandBuffer& cmd) const {
+  if (groups_.empty()) return;
+
+  constexpr auto kStride = sizeof(::vk::DrawIndexedIndirectCommand);
+
+  const std::array models = {
+      ::vk::DescriptorBufferInfo{model_buffer_->get(), 0, ::vk::WholeSize}};
+  pass.push_storage_buffers(cmd, models, 1);
+
+  for (uint32_t g = 0; g < groups_.size(); ++g) {
+    const auto& group = groups_[g];
+    group.mesh->bind(cmd);
+    pass.push_constants(cmd, group.mesh->dequantization());
+
+    if (draw_indirect_count_) {
+      // Only the visible instances cost a draw
+      cmd.drawIndexedIndirectCountKHR(
+          visible_draws_->get(), group.first_draw * kStride,
+          visible_counts_->get(), g * sizeof(uint32_t), group.count, kStride);
+      continue;
+    }
+
+    // Culled instances are still drawn, with no instances
+    for (uint32_t drawn = 0; drawn < group.count; drawn += max_draw_count_) {
+      cmd.drawIndexedIndirect(draws_->get(),
+                              (group.first_draw + drawn) * kStride,
+                              std::min(group.count - drawn, max_draw_count_),
+                              kStride);
+    }
+  }
+}
+
+void GpuCulling::draw_meshlets(const ::vk::CommandBuffer& cmd,
+                               uint32_t first_draw, uint32_t count) const {
+  constexpr auto kStride = sizeof(::vk::DrawIndexedIndirectCommand);
+  for (uint32_t drawn = 0; drawn < count; drawn += max_draw_count_) {
+    cmd.drawIndexedIndirect(meshlet_draws_->get(),
+                            (first_draw + drawn) * kStride,
+                            std::min(count - drawn, max_draw_count_), kStride);
+  }
+}
+
+}  // namespace wren
@@ -1,5 +1,10 @@
 #include "wren/graph.hpp"
 
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <span>
+#include <unordered_map>
 #include <wren/utils/result.hpp>
 #include <wren/vk/image.hpp>
 
@@ -24,41 +29,422 @@ auto GraphBuilder::build() const -> expected<void> {
   return {};
 }
 
+namespace {
+
+struct AttachmentKind {
+  ::vk::PipelineStageFlags stage;
+  ::vk::AccessFlags write_access;
+  ::vk::AccessFlags read_write_access;
+  ::vk::ImageLayout attachment_layout;
+  ::vk::ImageLayout read_layout;
+};
+
+const AttachmentKind kColourAttachment{
+    ::vk::PipelineStageFlagBits::eColorAttachmentOutput,
+    ::vk::AccessFlagBits::eColorAttachmentWrite,
+    ::vk::AccessFlagBits::eColorAttachmentRead |
+        ::vk::AccessFlagBits::eColorAttachmentWrite,
+    ::vk::ImageLayout::eColorAttachmentOptimal,
+    ::vk::ImageLayout::eShaderReadOnlyOptimal};
+
+const AttachmentKind kDepthAttachment{
+    ::vk::PipelineStageFlagBits::eEarlyFragmentTests |
+        ::vk::PipelineStageFlagBits::eLateFragmentTests,
+    ::vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+    ::vk::AccessFlagBits::eDepthStencilAttachmentRead |
+        ::vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+    ::vk::ImageLayout::eDepthStencilAttachmentOptimal,
+    ::vk::ImageLayout::eDepthStencilReadOnlyOptimal};
+
+//! @brief Every pass touching a resource, in declaration order
+struct ResourceUsage {
+  std::vector<std::size_t> writers;
+  std::vector<std::size_t> readers;
+  //! @brief Null for resources the graph doesn't own, like storage buffers
+  const AttachmentKind *kind = &kColourAttachment;
+};
+
+using target_map_t =
+    std::unordered_map<std::string, std::shared_ptr<RenderTarget>>;
+
+auto has_lazily_allocated_memory(const ::vk::PhysicalDevice &physical_device)
+    -> bool {
+  const auto properties = physical_device.getMemoryProperties();
+  return std::ranges::any_of(
+      std::span(properties.memoryTypes.data(), properties.memoryTypeCount),
+      [](const ::vk::MemoryType &type) {
+        return static_cast<bool>(
+            type.propertyFlags &
+            ::vk::MemoryPropertyFlagBits::eLazilyAllocated);
+      });
+}
+
+//! @brief Create a target for every resource that's still in use. Resources
+//! whose lifetimes don't overlap share memory, resources that never leave
+//! their pass go in lazily allocated memory when the device has it.
+//! @param position Where each pass ended up in the execution order
+//! @param syncs Receives the dependencies between aliasing resources
+auto create_targets(
+    const std::shared_ptr<Context> &ctx,
+    const std::unordered_map<std::string, ResourceUsage> &resources,
+    const std::vector<bool> &used, const std::vector<std::size_t> &position,
+    std::vector<PassSync> &syncs) -> expected<target_map_t> {
+  struct Lifetime {
+    std::string name;
+    const AttachmentKind *kind = nullptr;
+    //! First and last position in the execution order
+    std::size_t first = 0;
+    std::size_t last = 0;
+    std::size_t first_writer = 0;
+    RenderTarget::Options options;
+    ::vk::MemoryRequirements requirements;
+  };
+
+  const auto by_position = [&position](auto a, auto b) {
+    return position.at(a) < position.at(b);
+  };
+  const auto is_used = [&used](auto pass) { return used.at(pass); };
+
+  std::vector<Lifetime> lifetimes;
+  for (const auto &[name, usage] : resources) {
+    if (name == PassResources::kSwapchainTarget) continue;
+    if (usage.kind == nullptr) continue;
+
+    std::vector<std::size_t> writers;
+    std::vector<std::size_t> readers;
+    std::ranges::copy_if(usage.writers, std::back_inserter(writers), is_used);
+    std::ranges::copy_if(usage.readers, std::back_inserter(readers), is_used);
+    if (writers.empty()) continue;
+
+    std::vector<std::size_t> passes = writers;
+    passes.insert(passes.end(), readers.begin(), readers.end());
+    const auto [first, last] = std::ranges::minmax(passes, by_position);
+
+    Lifetime lifetime{
+        .name = name,
+        .kind = usage.kind,
+        .first = position.at(first),
+        .last = position.at(last),
+        .first_writer = std::ranges::min(writers, by_position),
+        .options = {.sampled = !readers.empty(),
+                    .transient = readers.empty() && writers.size() == 1},
+    };
+
+    TRY_RESULT(lifetime.requirements,
+               RenderTarget::memory_requirements(
+                   ctx, usage.kind == &kDepthAttachment, lifetime.options));
+
+    lifetimes.push_back(std::move(lifetime));
+  }
+
+  std::ranges::sort(lifetimes, {}, &Lifetime::first);
+
+  const bool lazy_memory =
+      has_lazily_allocated_memory(ctx->graphics_context->PhysicalDevice());
+
+  // Greedy interval assignment, a resource moves into the first block whose
+  // previous occupant is done with it
+  struct Block {
+    std::size_t last = 0;
+    ::vk::MemoryRequirements requirements;
+    std::vector<std::size_t> members;
+  };
+  std::vector<Block> blocks;
+
+  for (std::size_t i = 0; i < lifetimes.size(); ++i) {
+    const auto &lifetime = lifetimes.at(i);
+    if (lifetime.options.transient && lazy_memory) continue;
+
+    const auto block = std::ranges::find_if(blocks, [&](const Block &block) {
+      return block.last < lifetime.first &&
+             (block.requirements.memoryTypeBits &
+              lifetime.requirements.memoryTypeBits) != 0;
+    });
+    if (block == blocks.end()) {
+      blocks.push_back({lifetime.last, lifetime.requirements, {i}});
+      continue;
+    }
+
+    // The previous occupant's last use has to finish before the first write
+    const auto &kind = *lifetime.kind;
+    syncs.at(lifetime.first_writer)
+        .dependencies.emplace_back(
+            VK_SUBPASS_EXTERNAL, 0,
+            kColourAttachment.stage | kDepthAttachment.stage |
+                ::vk::PipelineStageFlagBits::eFragmentShader,
+            kind.stage,
+            kColourAttachment.write_access | kDepthAttachment.write_access,
+            kind.read_write_access);
+
+    auto &requirements = block->requirements;
+    requirements.size = std::max(requirements.size, lifetime.requirements.size);
+    requirements.alignment =
+        std::max(requirements.alignment, lifetime.requirements.alignment);
+    requirements.memoryTypeBits &= lifetime.requirements.memoryTypeBits;
+    block->last = lifetime.last;
+    block->members.push_back(i);
+  }
+
+  const auto &allocator = ctx->graphics_context->allocator();
+  for (const auto &block : blocks) {
+    if (block.members.size() < 2) continue;
+
+    VmaAllocationCreateInfo alloc_info{};
+    alloc_info.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    const auto requirements =
+        static_cast<VkMemoryRequirements>(block.requirements);
+    VmaAllocation allocation{};
+    VK_CHECK_RESULT(static_cast<::vk::Result>(vmaAllocateMemory(
+        allocator, &requirements, &alloc_info, &allocation, nullptr)));
+
+    const SharedMemory memory(allocation, [allocator](VmaAllocation alloc) {
+      vmaFreeMemory(allocator, alloc);
+    });
+    for (const auto member : block.members) {
+      lifetimes.at(member).options.memory = memory;
+      spdlog::debug("{} aliases {} bytes shared by {} targets",
+                    lifetimes.at(member).name, block.requirements.size,
+                    block.members.size());
+    }
+  }
+
+  target_map_t targets;
+  for (const auto &lifetime : lifetimes) {
+    std::shared_ptr<RenderTarget> target;
+    if (lifetime.kind == &kDepthAttachment) {
+      TRY_RESULT(target, RenderTarget::create_depth(ctx, lifetime.options));
+    } else {
+      TRY_RESULT(target, RenderTarget::create(ctx, lifetime.options));
+    }
+    targets.emplace(lifetime.name, target);
+  }
+
+  return targets;
+}
+
+}  // namespace
+
 auto GraphBuilder::compile() const -> expected<Graph> {
+  const auto pass_count = passes_.size();
+  const std::string swapchain(PassResources::kSwapchainTarget);
+
+  std::unordered_map<std::string, ResourceUsage> resources;
+  for (std::size_t i = 0; i < pass_count; ++i) {
+    const auto &pass_resources = std::get<1>(passes_[i]);
+    if (const auto colour = pass_resources.colour_resource()) {
+      resources[*colour].writers.push_back(i);
+    }
+    if (const auto depth = pass_resources.depth_resource()) {
+      auto &usage = resources[*depth];
+      usage.writers.push_back(i);
+      usage.kind = &kDepthAttachment;
+    }
+    for (const auto &write : pass_resources.writes()) {
+      auto &usage = resources[write];
+      usage.writers.push_back(i);
+      usage.kind = nullptr;
+    }
+  }
+
+  // Readers see the final version of a resource, writers of the same
+  // resource run in declaration order
+  std::vector<std::set<std::size_t>> dependencies(pass_count);
+  for (std::size_t i = 0; i < pass_count; ++i) {
+    const auto &[name, pass_resources, _] = passes_[i];
+    for (const auto &read : pass_resources.reads()) {
+      const auto usage = resources.find(read);
+      if (usage == resources.end() || read == swapchain) {
+        spdlog::error("Pass {} reads {} which no pass writes", name, read);
+        return std::unexpected(
+            make_error_code(RenderGraphErrors::UnknownResource));
+      }
+      usage->second.readers.push_back(i);
+      dependencies.at(i).insert(usage->second.writers.back());
+    }
+  }
+  for (const auto &[_, usage] : resources) {
+    for (std::size_t w = 1; w < usage.writers.size(); ++w) {
+      dependencies.at(usage.writers.at(w)).insert(usage.writers.at(w - 1));
+    }
+  }
+
+  // Cull everything the swapchain doesn't depend on, a graph without a
+  // swapchain pass is kept as is
+  std::vector<bool> used(pass_count, !resources.contains(swapchain));
+  if (resources.contains(swapchain)) {
+    std::vector<std::size_t> stack = resources.at(swapchain).writers;
+    while (!stack.empty()) {
+      const auto pass = stack.back();
+      stack.pop_back();
+      if (used.at(pass)) continue;
+      used.at(pass) = true;
+      stack.insert(stack.end(), dependencies.at(pass).begin(),
+                   dependencies.at(pass).end());
+    }
+  }
+
+  for (std::size_t i = 0; i < pass_count; ++i) {
+    if (!used.at(i)) {
+      spdlog::debug("Culling pass {}", std::get<0>(passes_[i]));
+    }
+  }
+
+  TRY_RESULT(const auto order, sort_passes(dependencies, used));
+
+  // Work out loads, stores, final layouts and dependencies per attachment
+  std::vector<PassSync> syncs(pass_count);
+  for (const auto &[name, usage] : resources) {
+    if (usage.kind == nullptr) continue;
+    const auto &kind = *usage.kind;
+
+    std::vector<std::size_t> writers;
+    std::ranges::copy_if(usage.writers, std::back_inserter(writers),
+                         [&used](auto pass) { return used.at(pass); });
+    const bool read = std::ranges::any_of(
+        usage.readers, [&used](auto pass) { return used.at(pass); });
+
+    for (std::size_t w = 0; w < writers.size(); ++w) {
+      auto &sync = syncs.at(writers.at(w));
+      auto &attachment =
+          usage.kind == &kDepthAttachment ? sync.depth : sync.colour;
+
+      if (w == 0) {
+        attachment.load_op = ::vk::AttachmentLoadOp::eClear;
+        attachment.initial_layout = ::vk::ImageLayout::eUndefined;
+      } else {
+        // Keep what the previous writer left behind
+        attachment.load_op = ::vk::AttachmentLoadOp::eLoad;
+        attachment.initial_layout = kind.attachment_layout;
+        sync.dependencies.emplace_back(
+            VK_SUBPASS_EXTERNAL, 0, kind.stage, kind.stage, kind.write_access,
+            kind.read_write_access);
+      }
+
+      if (w + 1 < writers.size()) {
+        attachment.store_op = ::vk::AttachmentStoreOp::eStore;
+        attachment.final_layout = kind.attachment_layout;
+      } else if (name == swapchain) {
+        attachment.store_op = ::vk::AttachmentStoreOp::eStore;
+        attachment.final_layout = ::vk::ImageLayout::ePresentSrcKHR;
+      } else if (read) {
+        attachment.store_op = ::vk::AttachmentStoreOp::eStore;
+        attachment.final_layout = kind.read_layout;
+        sync.dependencies.emplace_back(
+            0, VK_SUBPASS_EXTERNAL, kind.stage,
+            ::vk::PipelineStageFlagBits::eFragmentShader, kind.write_access,
+            ::vk::AccessFlagBits::eShaderRead);
+      } else {
+        // Nothing reads it after this pass
+        attachment.store_op = ::vk::AttachmentStoreOp::eDontCare;
+        attachment.final_layout = kind.attachment_layout;
+      }
+
+      // Wait for the swapchain image to be acquired before writing it
+      if (w == 0 && name == swapchain) {
+        sync.dependencies.emplace_back(
+            VK_SUBPASS_EXTERNAL, 0,
+            ::vk::PipelineStageFlagBits::eColorAttachmentOutput,
+            ::vk::PipelineStageFlagBits::eColorAttachmentOutput,
+            ::vk::AccessFlags{}, ::vk::AccessFlagBits::eColorAttachmentWrite);
+      }
+    }
+  }
+
+  // Readers of anything a compute pass wrote need its shader writes
+  for (const auto &[_, usage] : resources) {
+    const bool compute_written =
+        std::ranges::any_of(usage.writers, [this](auto pass) {
+          return std::get<1>(passes_[pass]).is_compute();
+        });
+    if (!compute_written) continue;
+    for (const auto reader : usage.readers) {
+      syncs.at(reader).after_compute = true;
+    }
+  }
+
+  std::vector<std::size_t> position(pass_count);
+  for (std::size_t i = 0; i < order.size(); ++i) position.at(order.at(i)) = i;
+
+  TRY_RESULT(const auto targets,
+             create_targets(ctx_, resources, used, position, syncs));
+
   Graph graph;
+  std::vector<node_t> nodes(pass_count);
 
-  for (const auto &[name, resources, fn] : passes_) {
-    const auto &pass_resources = resources;
+  for (const auto index : order) {
+    const auto &[name, pass_resources, fn] = passes_[index];
+    const auto &sync = syncs.at(index);
 
     std::shared_ptr<RenderTarget> colour_target;
     std::shared_ptr<RenderTarget> depth_target;
 
-    if (pass_resources.target_prefix() == "swapchain_target") {
-      // Get the create targets from the renderer
-      // Resolve target names
-      colour_target =
-          ctx_->renderer->render_targets().at(pass_resources.target_prefix());
+    if (const auto colour = pass_resources.colour_resource()) {
+      colour_target = *colour == swapchain
+                          ? ctx_->renderer->render_targets().at(swapchain)
+                          : targets.at(*colour);
+      colour_target->final_layout(sync.colour.final_layout);
+    }
+
+    if (const auto depth = pass_resources.depth_resource()) {
+      depth_target = targets.at(*depth);
+      depth_target->final_layout(sync.depth.final_layout);
     }
 
-    const auto &targets = ctx_->renderer->render_targets();
+    TRY_RESULT(auto pass,
+               RenderPass::create(ctx_, name, pass_resources, colour_target,
+                                  depth_target, sync, fn));
+    nodes.at(index) = std::make_shared<Node>(name, pass);
 
-    if (colour_target == nullptr && pass_resources.has_colour_target()) {
-      TRY_RESULT(colour_target, RenderTarget::create(ctx_));
-      colour_target->final_layout(::vk::ImageLayout::eShaderReadOnlyOptimal);
+    graph.nodes.push_back(nodes.at(index));
+    for (const auto dependency : dependencies.at(index)) {
+      graph.edges.emplace_back(nodes.at(dependency), nodes.at(index));
     }
+  }
 
-    if (depth_target == nullptr && pass_resources.has_depth_target()) {
-      TRY_RESULT(depth_target, RenderTarget::create_depth(ctx_));
+  return graph;
+}
+
+auto GraphBuilder::sort_passes(
+    const std::vector<std::set<std::size_t>> &dependencies,
+    const std::vector<bool> &used) -> expected<std::vector<std::size_t>> {
+  const auto pass_count = dependencies.size();
+
+  std::vector<std::size_t> remaining(pass_count, 0);
+  std::vector<std::vector<std::size_t>> dependents(pass_count);
+  for (std::size_t i = 0; i < pass_count; ++i) {
+    if (!used.at(i)) continue;
+    remaining.at(i) = dependencies.at(i).size();
+    for (const auto dependency : dependencies.at(i)) {
+      dependents.at(dependency).push_back(i);
     }
+  }
+
+  // Kahn's algorithm, ties are broken by declaration order so independent
+  // passes keep the order they were added in
+  std::set<std::size_t> ready;
+  for (std::size_t i = 0; i < pass_count; ++i) {
+    if (used.at(i) && remaining.at(i) == 0) ready.insert(i);
+  }
 
-    TRY_RESULT(auto pass, RenderPass::create(ctx_, name, pass_resources,
-                                             colour_target, depth_target, fn));
-    node_t n = std::make_shared<Node>(name, pass);
+  std::vector<std::size_t> order;
+  while (!ready.empty()) {
+    const auto pass = *ready.begin();
+    ready.erase(ready.begin());
+    order.push_back(pass);
 
-    graph.nodes.push_back(n);
+    for (const auto dependent : dependents.at(pass)) {
+      if (--remaining.at(dependent) == 0) ready.insert(dependent);
+    }
   }
 
-  return graph;
+  const auto used_count =
+      static_cast<std::size_t>(std::ranges::count(used, true));
+  if (order.size() != used_count) {
+    return std::unexpected(make_error_code(RenderGraphErrors::Cycle));
+  }
+
+  return order;
 }
 
 }  // namespace wren
@@ -5,6 +5,7 @@
 #include <vk_mem_alloc.h>
 #include <vulkan/vulkan_core.h>
 
+#include <tuple>
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_enums.hpp>
 #include <vulkan/vulkan_handles.hpp>
@@ -46,7 +47,19 @@ auto GraphicsContext::Create(
   return graphics_context;
 }
 
-GraphicsContext::~GraphicsContext() { instance.destroy(); }
+GraphicsContext::~GraphicsContext() {
+  if (device.get()) {
+    // Shutting down is the one place waiting for the device is fine
+    std::ignore = device.get().waitIdle();
+    deletion_queue_->flush_all();
+  }
+
+  compute_queue_.reset();
+  graphics_queue_.reset();
+  bindless_.reset();
+  layout_cache_.clear();
+  instance.destroy();
+}
 
 auto GraphicsContext::CreateInstance(
     const std::string &application_name,
@@ -146,6 +159,25 @@ auto GraphicsContext::SetupDevice() -> expected<void> {
   create_info.pVulkanFunctions = &vma_functions;
   vmaCreateAllocator(&create_info, &allocator_);
 
+  layout_cache_ = vk::LayoutCache(device.get());
+
+  TRY_RESULT(const auto indices, FindQueueFamilyIndices());
+  TRY_RESULT(graphics_queue_,
+             vk::SubmitQueue::create(device.get(), device.get_graphics_queue(),
+                                     indices.graphics_index, deletion_queue_));
+  if (indices.compute_index.has_value()) {
+    TRY_RESULT(compute_queue_, vk::SubmitQueue::create(
+                                   device.get(), device.get_compute_queue(),
+                                   indices.compute_index.value()));
+  }
+
+  if (device.supports_bindless()) {
+    TRY_RESULT(bindless_,
+               vk::BindlessHeap::create(device.get(), physical_device));
+    layout_cache_.set_external_layout(vk::BindlessHeap::kSet,
+                                      bindless_->set_layout());
+  }
+
   return {};
 }
 
@@ -2,39 +2,161 @@
 
 #include <vulkan/vulkan.hpp>
 #include <wren/math/geometry.hpp>
+#include <wren/math/mesh_optimize.hpp>
+#include <wren/math/meshlet.hpp>
+#include <wren/math/simplify.hpp>
 #include <wren/math/vector.hpp>
 
 namespace wren {
 
-Mesh::Mesh(const vulkan::Device& device, VmaAllocator allocator)
+Mesh::Mesh(const vulkan::Device& device,
+           const std::shared_ptr<vk::SubmitQueue>& submit_queue,
+           VmaAllocator allocator, const vk::VertexLayout& layout)
     : vertices_(kQuadVertices.begin(), kQuadVertices.end()),
       indices_(kQuadIndices) {
-  load(device, allocator);
+  compute_bounds();
+  load(device, submit_queue, allocator, layout);
 }
 
 Mesh::Mesh(const std::vector<Vertex>& vertices,
-           const std::vector<uint16_t>& indices)
-    : vertices_(vertices), indices_(indices) {}
+           const std::vector<uint32_t>& indices)
+    : vertices_(vertices), indices_(indices) {
+  compute_bounds();
+}
 
-void Mesh::load(const vulkan::Device& device, VmaAllocator allocator) {
-  // ================ Vertex buffer =================== //
-  {
-    std::span data{vertices_.begin(), vertices_.end()};
-    auto staging_buffer = vk::Buffer::create(
-        allocator, data.size_bytes(),
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
-            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
+void Mesh::compute_bounds() {
+  aabb_ = {};
+  for (const auto& vertex : vertices_) aabb_.expand(vertex.pos);
+  bounding_sphere_ = math::BoundingSphere::from_aabb(aabb_);
 
-    staging_buffer->set_data_raw<Vertex>(data);
+  lods_ = {MeshLod{0, static_cast<uint32_t>(indices_.size()), 0}};
+}
 
-    vertex_buffer_ = vk::Buffer::create(
-        allocator, data.size_bytes(),
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+void Mesh::generate_lods(float reduction) {
+  // Start over from the original mesh
+  indices_.resize(lods_.front().index_count);
+  lods_.resize(1);
+
+  const auto positions = this->positions();
+
+  // Each level is simplified from the previous one, it's cheaper and keeps
+  // the chain consistent
+  std::vector<uint32_t> source(indices_);
+  while (lods_.size() < kMaxLods) {
+    const auto target =
+        static_cast<std::size_t>(static_cast<float>(source.size()) * reduction);
+    if (target < 3) break;
+
+    auto result = math::simplify(positions, source, target);
+
+    // Stop when the mesh can't be reduced meaningfully any more
+    if (result.indices.empty() ||
+        static_cast<float>(result.indices.size()) >
+            static_cast<float>(source.size()) * 0.9F) {
+      break;
+    }
+
+    const auto error = std::max(result.error, lods_.back().error);
+    lods_.push_back(MeshLod{static_cast<uint32_t>(indices_.size()),
+                            static_cast<uint32_t>(result.indices.size()),
+                            error});
+    indices_.insert(indices_.end(), result.indices.begin(),
+                    result.indices.end());
+    source = std::move(result.indices);
+  }
+}
 
-    vk::Buffer::copy_buffer(device.get(), device.get_graphics_queue(),
-                            device.command_pool(), staging_buffer,
-                            vertex_buffer_, data.size_bytes());
+void Mesh::optimize() {
+  const auto positions = this->positions();
+  for (const auto& lod : lods_) {
+    const std::span range{indices_.begin() + lod.first_index,
+                          lod.index_count};
+    math::optimize_vertex_cache(range, vertices_.size());
+    math::optimize_overdraw(range, positions);
+  }
+
+  // The finest level is first in the index buffer, so its vertices end up
+  // the most tightly packed
+  const auto remap = math::optimize_vertex_fetch(indices_, vertices_.size());
+  vertices_ = math::remap_vertices<Vertex>(vertices_, remap);
+}
+
+void Mesh::build_meshlets() {
+  const auto& lod = lods_.front();
+  const std::span source{indices_.begin() + lod.first_index, lod.index_count};
+
+  auto build = math::build_meshlets(positions(), source);
+  std::ranges::copy(build.indices, source.begin());
+  meshlets_ = std::move(build.meshlets);
+  for (auto& meshlet : meshlets_) meshlet.first_index += lod.first_index;
+
+  // Keep vertices in the order the regrouped index buffer reads them
+  const auto remap = math::optimize_vertex_fetch(indices_, vertices_.size());
+  vertices_ = math::remap_vertices<Vertex>(vertices_, remap);
+}
+
+auto Mesh::positions() const -> std::vector<math::Vec3f> {
+  std::vector<math::Vec3f> positions;
+  positions.reserve(vertices_.size());
+  for (const auto& vertex : vertices_) positions.push_back(vertex.pos);
+  return positions;
+}
+
+void Mesh::load(const vulkan::Device& device,
+                const std::shared_ptr<vk::SubmitQueue>& submit_queue,
+                VmaAllocator allocator, const vk::VertexLayout& layout,
+                const std::shared_ptr<utils::DeletionQueue>& deletion_queue,
+                std::span<const uint32_t> queue_families) {
+  if (loaded_) return;
+
+  // Copies are queued behind each other, the last one finishes them all
+  const auto copy = [&](const std::shared_ptr<vk::Buffer>& src,
+                        const std::shared_ptr<vk::Buffer>& dst,
+                        std::size_t size) {
+    const auto point =
+        vk::Buffer::copy_buffer(device.get(), *submit_queue,
+                                device.command_pool(), src, dst, size,
+                                deletion_queue);
+    if (point.has_value()) upload_value_ = point->value;
+  };
+  upload_queue_ = submit_queue;
+
+  // ================ Vertex buffers =================== //
+  {
+    std::vector<math::Vec3f> positions;
+    std::vector<math::Vec3f> normals;
+    std::vector<math::Vec4f> colours;
+    positions.reserve(vertices_.size());
+    normals.reserve(vertices_.size());
+    colours.reserve(vertices_.size());
+    for (const auto& vertex : vertices_) {
+      positions.push_back(vertex.pos);
+      normals.push_back(vertex.normal);
+      colours.push_back(vertex.colour);
+    }
+
+    auto encoded = layout.encode(positions, normals, colours);
+    dequantization_ = encoded.dequantization;
+
+    vertex_buffers_.clear();
+    for (const auto& stream : encoded.streams) {
+      std::span<const std::byte> data{stream};
+      auto staging_buffer = vk::Buffer::create(
+          allocator, data.size_bytes(),
+          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+              VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+          VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
+
+      staging_buffer->set_data_raw<std::byte>(data);
+
+      auto vertex_buffer = vk::Buffer::create(
+          allocator, data.size_bytes(),
+          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+          {}, deletion_queue);
+
+      copy(staging_buffer, vertex_buffer, data.size_bytes());
+      vertex_buffers_.push_back(vertex_buffer);
+    }
   }
 
   // ============== Index buffer ============== //
@@ -47,15 +169,46 @@ void Mesh::load(const vulkan::Device& device, VmaAllocator allocator) {
             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
         VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
 
-    staging_buffer->set_data_raw<uint16_t>(data);
+    staging_buffer->set_data_raw<uint32_t>(data);
 
     index_buffer_ = vk::Buffer::create(
         allocator, data.size_bytes(),
-        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        {}, deletion_queue);
 
-    vk::Buffer::copy_buffer(device.get(), device.get_graphics_queue(),
-                            device.command_pool(), staging_buffer,
-                            index_buffer_, data.size_bytes());
+    copy(staging_buffer, index_buffer_, data.size_bytes());
+  }
+
+  // ============== Meshlets ============== //
+  if (!meshlets_.empty()) {
+    std::vector<GpuMeshlet> meshlets;
+    meshlets.reserve(meshlets_.size());
+    for (const auto& meshlet : meshlets_) {
+      const auto& sphere = meshlet.sphere;
+      const auto& axis = meshlet.cone_axis;
+      meshlets.push_back(GpuMeshlet{
+          .sphere = {sphere.center.x(), sphere.center.y(), sphere.center.z(),
+                     sphere.radius},
+          .cone = {axis.x(), axis.y(), axis.z(), meshlet.cone_cutoff},
+          .first_index = meshlet.first_index,
+          .index_count = meshlet.index_count,
+          .padding = {},
+      });
+    }
+
+    std::span<const GpuMeshlet> data{meshlets};
+    auto staging_buffer = vk::Buffer::create(
+        allocator, data.size_bytes(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
+
+    staging_buffer->set_data_raw<GpuMeshlet>(data);
+
+    meshlet_buffer_ = vk::Buffer::create(
+        allocator, data.size_bytes(),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        {}, deletion_queue, queue_families);
+
+    copy(staging_buffer, meshlet_buffer_, data.size_bytes());
   }
 
   {
@@ -65,20 +218,31 @@ void Mesh::load(const vulkan::Device& device, VmaAllocator allocator) {
     uniform_buffer_ = vk::Buffer::create(
         allocator, size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
         VmaAllocationCreateFlagBits::
-            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+        deletion_queue);
     uniform_buffer_->set_data_raw(&ubo, size);
   }
 
+  // Drawing only needs the GPU copies, meshes shared by many renderers would
+  // otherwise keep their vertices resident for nothing
+  vertices_ = {};
+  indices_ = {};
+
   loaded_ = true;
 }
 
-void Mesh::draw(const ::vk::CommandBuffer& cmd) const {
-  cmd.drawIndexed(indices_.size(), 1, 0, 0, 0);
+void Mesh::draw(const ::vk::CommandBuffer& cmd, std::size_t lod) const {
+  const auto& range = lods_.at(std::min(lod, lods_.size() - 1));
+  cmd.drawIndexed(range.index_count, 1, range.first_index, 0, 0);
 }
 
 void Mesh::bind(const ::vk::CommandBuffer& cmd) const {
-  cmd.bindIndexBuffer(index_buffer_->get(), 0, ::vk::IndexType::eUint16);
-  cmd.bindVertexBuffers(0, vertex_buffer_->get(), ::vk::DeviceSize{0});
+  cmd.bindIndexBuffer(index_buffer_->get(), 0, ::vk::IndexType::eUint32);
+  std::vector<::vk::Buffer> buffers;
+  buffers.reserve(vertex_buffers_.size());
+  for (const auto& buffer : vertex_buffers_) buffers.push_back(buffer->get());
+  const std::vector<::vk::DeviceSize> offsets(buffers.size(), 0);
+  cmd.bindVertexBuffers(0, buffers, offsets);
 }
 
 }  // namespace wren
@@ -0,0 +1,120 @@
+#include "wren/mesh_cache.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <boost/container_hash/hash.hpp>
+#include <wren/mesh_file.hpp>
+
+#include "wren/utils/tracy.hpp"  // IWYU pragma: keep
+
+namespace wren {
+
+auto MeshCache::shared() -> const std::shared_ptr<MeshCache>& {
+  static const auto cache = std::make_shared<MeshCache>();
+  return cache;
+}
+
+namespace {
+
+auto hash_settings(const MeshImportSettings& settings) -> std::size_t {
+  std::size_t seed = 0;
+  boost::hash_combine(seed, settings.lod_reduction);
+  boost::hash_combine(seed, settings.meshlets);
+  return seed;
+}
+
+}  // namespace
+
+auto MeshCache::KeyHash::operator()(const Key& key) const -> std::size_t {
+  std::size_t seed = std::hash<std::string>{}(key.file);
+  boost::hash_combine(seed, hash_settings(key.settings));
+  return seed;
+}
+
+auto MeshCache::get(const std::filesystem::path& file,
+                    const MeshImportSettings& settings)
+    -> expected<std::shared_ptr<Mesh>> {
+  ZoneScoped;
+
+  Key key{.file = std::filesystem::absolute(file).lexically_normal().string(),
+          .settings = settings};
+
+  {
+    std::scoped_lock lock(mutex_);
+    if (const auto it = meshes_.find(key); it != meshes_.end()) {
+      if (auto mesh = it->second.lock()) return mesh;
+    }
+  }
+
+  // Imported without the lock so different files load in parallel
+  TRY_RESULT(auto imported, import(file, settings));
+  auto mesh = std::make_shared<Mesh>(std::move(imported));
+
+  std::scoped_lock lock(mutex_);
+  auto& cached = meshes_[std::move(key)];
+  // Another thread may have finished the same mesh first
+  if (auto existing = cached.lock()) return existing;
+  cached = mesh;
+
+  // Forget the meshes nothing uses any more, they're already freed
+  std::erase_if(meshes_,
+                [](const auto& entry) { return entry.second.expired(); });
+  return mesh;
+}
+
+auto MeshCache::import(const std::filesystem::path& file,
+                       const MeshImportSettings& settings) -> expected<Mesh> {
+  std::shared_ptr<assets::Database> database;
+  {
+    std::scoped_lock lock(mutex_);
+    database = database_;
+  }
+  if (database == nullptr) return load_mesh(file, settings);
+
+  // Meshes outside the database or without a cache directory aren't cached
+  const auto source_hash = database->hash(file);
+  // Different settings make different meshes out of the same source
+  const auto artifact = database->artifact(
+      file,
+      fmt::format("{:x}.{}", hash_settings(settings), kMeshFileExtension));
+  if (!source_hash.has_value() || !artifact.has_value()) {
+    return load_mesh(file, settings);
+  }
+
+  if (std::filesystem::exists(*artifact)) {
+    auto cached = read_mesh_file(*artifact, *source_hash);
+    if (cached.has_value()) return cached;
+    spdlog::warn("Ignoring mesh cache {}: {}", artifact->string(),
+                 cached.error());
+  }
+
+  TRY_RESULT(auto mesh, load_mesh(file, settings));
+  if (const auto written = write_mesh_file(mesh, *source_hash, *artifact);
+      !written.has_value()) {
+    spdlog::warn("Failed to cache mesh {}: {}", file.string(),
+                 written.error());
+  }
+  return mesh;
+}
+
+void MeshCache::database(std::shared_ptr<assets::Database> database) {
+  std::scoped_lock lock(mutex_);
+  database_ = std::move(database);
+}
+
+void MeshCache::invalidate(const std::filesystem::path& file) {
+  const auto path = std::filesystem::absolute(file).lexically_normal();
+  std::scoped_lock lock(mutex_);
+  std::erase_if(meshes_, [&](const auto& entry) {
+    return entry.first.file == path.string();
+  });
+}
+
+auto MeshCache::size() const -> std::size_t {
+  std::scoped_lock lock(mutex_);
+  return std::ranges::count_if(
+      meshes_, [](const auto& entry) { return !entry.second.expired(); });
+}
+
+}  // namespace wren
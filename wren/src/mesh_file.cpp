@@ -0,0 +1,194 @@
+#include "wren/mesh_file.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <wren/utils/mapped_file.hpp>
+
+#include "wren/utils/tracy.hpp"  // IWYU pragma: keep
+
+namespace wren {
+
+namespace {
+
+// Everything is copied between the file and Mesh without any conversion
+static_assert(std::is_trivially_copyable_v<Vertex>);
+static_assert(std::is_trivially_copyable_v<MeshLod>);
+static_assert(std::is_trivially_copyable_v<math::Meshlet>);
+
+constexpr std::array<char, 4> kMagic = {'W', 'M', 'S', 'H'};
+constexpr uint64_t kSectionAlignment = 16;
+
+struct Header {
+  std::array<char, 4> magic = kMagic;
+  uint32_t version = kMeshFileVersion;
+  uint64_t source_hash = 0;
+  uint32_t vertex_count = 0;
+  uint32_t index_count = 0;
+  uint32_t lod_count = 0;
+  uint32_t meshlet_count = 0;
+  math::AABB aabb;
+  math::BoundingSphere bounding_sphere;
+};
+static_assert(std::is_trivially_copyable_v<Header>);
+
+//! @brief Where each array starts, all follow from the header's counts
+struct Sections {
+  uint64_t vertices = 0;
+  uint64_t indices = 0;
+  uint64_t lods = 0;
+  uint64_t meshlets = 0;
+  uint64_t size = 0;
+};
+
+auto align_up(uint64_t offset) -> uint64_t {
+  return (offset + kSectionAlignment - 1) / kSectionAlignment *
+         kSectionAlignment;
+}
+
+auto sections(const Header& header) -> Sections {
+  Sections s;
+  s.vertices = align_up(sizeof(Header));
+  s.indices = align_up(s.vertices + header.vertex_count * sizeof(Vertex));
+  s.lods = align_up(s.indices + header.index_count * sizeof(uint32_t));
+  s.meshlets = align_up(s.lods + header.lod_count * sizeof(MeshLod));
+  s.size = s.meshlets + header.meshlet_count * sizeof(math::Meshlet);
+  return s;
+}
+
+template <typename T>
+auto read_array(std::span<const std::byte> file, uint64_t offset,
+                uint32_t count) -> std::vector<T> {
+  std::vector<T> values(count);
+  std::memcpy(values.data(), file.data() + offset, count * sizeof(T));
+  return values;
+}
+
+}  // namespace
+
+auto write_mesh_file(const Mesh& mesh, uint64_t source_hash,
+                     const std::filesystem::path& file) -> expected<void> {
+  ZoneScoped;
+
+  const Header header{
+      .source_hash = source_hash,
+      .vertex_count = static_cast<uint32_t>(mesh.vertices_.size()),
+      .index_count = static_cast<uint32_t>(mesh.indices_.size()),
+      .lod_count = static_cast<uint32_t>(mesh.lods_.size()),
+      .meshlet_count = static_cast<uint32_t>(mesh.meshlets_.size()),
+      .aabb = mesh.aabb_,
+      .bounding_sphere = mesh.bounding_sphere_,
+  };
+  const auto layout = sections(header);
+
+  std::vector<std::byte> bytes(layout.size);
+  const auto copy = [&bytes]<typename T>(uint64_t offset,
+                                         const std::vector<T>& values) {
+    std::memcpy(bytes.data() + offset, values.data(),
+                values.size() * sizeof(T));
+  };
+  std::memcpy(bytes.data(), &header, sizeof(header));
+  copy(layout.vertices, mesh.vertices_);
+  copy(layout.indices, mesh.indices_);
+  copy(layout.lods, mesh.lods_);
+  copy(layout.meshlets, mesh.meshlets_);
+
+  std::error_code ec;
+  std::filesystem::create_directories(file.parent_path(), ec);
+
+  // Written next to the destination and renamed over it, so a reader never
+  // sees half a file, even with the same mesh imported by two threads
+  auto temporary = file;
+  temporary += fmt::format(
+      ".{:x}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+  {
+    std::ofstream out(temporary, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(bytes.data()),
+              static_cast<std::streamsize>(bytes.size()));
+    if (!out) {
+      return std::unexpected(std::make_error_code(std::errc::io_error));
+    }
+  }
+
+  std::filesystem::rename(temporary, file, ec);
+  if (ec) {
+    std::filesystem::remove(temporary, ec);
+    return std::unexpected(std::make_error_code(std::errc::io_error));
+  }
+
+  return {};
+}
+
+auto read_mesh_file(const std::filesystem::path& file, uint64_t source_hash)
+    -> expected<Mesh> {
+  ZoneScoped;
+
+  auto mapped = utils::MappedFile::open(file);
+  if (!mapped.has_value()) return std::unexpected(mapped.error());
+  const auto bytes = mapped->data();
+
+  Header header;
+  if (bytes.size() < sizeof(header)) {
+    return std::unexpected(MeshFileErrors::NotAMeshFile);
+  }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (header.magic != kMagic) {
+    return std::unexpected(MeshFileErrors::NotAMeshFile);
+  }
+  if (header.version != kMeshFileVersion) {
+    return std::unexpected(MeshFileErrors::UnsupportedVersion);
+  }
+  if (header.source_hash != source_hash) {
+    return std::unexpected(MeshFileErrors::StaleSource);
+  }
+
+  const auto layout = sections(header);
+  if (bytes.size() < layout.size || header.lod_count == 0) {
+    return std::unexpected(MeshFileErrors::Corrupt);
+  }
+
+  Mesh mesh;
+  mesh.vertices_ =
+      read_array<Vertex>(bytes, layout.vertices, header.vertex_count);
+  mesh.indices_ =
+      read_array<uint32_t>(bytes, layout.indices, header.index_count);
+  mesh.lods_ = read_array<MeshLod>(bytes, layout.lods, header.lod_count);
+  mesh.meshlets_ =
+      read_array<math::Meshlet>(bytes, layout.meshlets, header.meshlet_count);
+  mesh.aabb_ = header.aabb;
+  mesh.bounding_sphere_ = header.bounding_sphere;
+
+  // Ranges are checked here so drawing never reads past the buffers
+  const auto in_range = [](uint64_t first, uint64_t count, uint64_t size) {
+    return first <= size && count <= size - first;
+  };
+  for (const auto& lod : mesh.lods_) {
+    if (!in_range(lod.first_index, lod.index_count, header.index_count)) {
+      return std::unexpected(MeshFileErrors::Corrupt);
+    }
+  }
+  const auto& finest = mesh.lods_.front();
+  for (const auto& meshlet : mesh.meshlets_) {
+    if (meshlet.first_index < finest.first_index ||
+        !in_range(meshlet.first_index, meshlet.index_count,
+                  finest.first_index + finest.index_count)) {
+      return std::unexpected(MeshFileErrors::Corrupt);
+    }
+  }
+  if (std::ranges::any_of(mesh.indices_, [&](uint32_t index) {
+        return index >= header.vertex_count;
+      })) {
+    return std::unexpected(MeshFileErrors::Corrupt);
+  }
+
+  return mesh;
+}
+
+}  // namespace wren
@@ -3,22 +3,47 @@
 #include <spdlog/spdlog.h>
 
 #include <boost/algorithm/string/split.hpp>
+#include <boost/container_hash/hash.hpp>
 #include <span>
+#include <unordered_map>
+#include <wren/gltf/gltf.hpp>
 #include <wren/utils/binray_reader.hpp>
 #include <wren/utils/filesystem.hpp>
 
 namespace wren {
 
-auto load_glb_mesh(const std::filesystem::path& glb_path) -> Mesh {
-  // gltf::load_mesh(glb_path);
+//! @brief Weld, simplify and optimize a freshly imported mesh
+void finish_import(Mesh& mesh, const MeshImportSettings& settings) {
+  mesh.generate_lods(settings.lod_reduction);
+  mesh.optimize();
+  if (settings.meshlets &&
+      mesh.index_count() / 3 >= Mesh::kMeshletMinTriangles) {
+    mesh.build_meshlets();
+  }
+}
+
+//! @brief Every triangle primitive placed by the file's default scene, baked
+//! into one mesh
+auto load_glb_mesh(const std::filesystem::path& glb_path,
+                   const MeshImportSettings& settings) -> expected<Mesh> {
+  const auto glb = gltf::Glb::open(glb_path);
+  if (!glb.has_value()) return std::unexpected(glb.error());
+  TRY_RESULT(const auto geometry, gltf::bake(*glb));
 
   std::vector<Vertex> vertices;
-  std::vector<uint16_t> indices;
+  vertices.reserve(geometry.positions.size());
+  for (std::size_t i = 0; i < geometry.positions.size(); ++i) {
+    vertices.emplace_back(geometry.positions[i], geometry.normals[i],
+                          geometry.colours[i]);
+  }
 
-  return Mesh{vertices, indices};
+  Mesh mesh{vertices, geometry.indices};
+  finish_import(mesh, settings);
+  return mesh;
 }
 
-auto load_stl_mesh(const std::filesystem::path& stl_path) -> Mesh {
+auto load_stl_mesh(const std::filesystem::path& stl_path,
+                   const MeshImportSettings& settings) -> Mesh {
   auto data = utils::fs::read_file_to_bin(stl_path);
   std::span s(data);
   utils::BinaryReader reader(s);
@@ -30,8 +55,14 @@ auto load_stl_mesh(const std::filesystem::path& stl_path) -> Mesh {
 
   std::vector<Vertex> vertices;
   vertices.reserve(triangles * 3);
-  std::vector<uint16_t> indices;
-  size_t newest_index = 0;
+  std::vector<uint32_t> indices;
+  indices.reserve(triangles * 3);
+
+  // STL repeats every vertex per triangle, vertices sharing a position and
+  // normal are merged
+  using VertexKey = std::array<float, 6>;
+  std::unordered_map<VertexKey, uint32_t, boost::hash<VertexKey>> unique;
+  unique.reserve(triangles * 3);
 
   for (auto i = 0; i < triangles; ++i) {
     const math::Vec3f normal{reader.read_list<float, 3>()};
@@ -43,35 +74,33 @@ auto load_stl_mesh(const std::filesystem::path& stl_path) -> Mesh {
     reader.skip(2);
 
     for (const auto& v : verts) {
-      auto it =
-          std::ranges::find_if(vertices, [vec = v, normal](const auto& v) {
-            return v.pos == math::Vec3f{vec} && v.normal == normal;
-          });
-
-      if (it == vertices.end()) {
-        // New vertex
+      const VertexKey key = {v[0],       v[1],       v[2],
+                             normal.x(), normal.y(), normal.z()};
+      const auto [it, inserted] =
+          unique.try_emplace(key, static_cast<uint32_t>(vertices.size()));
+      if (inserted) {
         vertices.emplace_back(math::Vec3f{v}, normal, math::Vec4f{1.0F});
-        indices.push_back(newest_index++);
-      } else {
-        // Old vertex
-        indices.push_back(std::ranges::distance(vertices.begin(), it));
       }
+      indices.push_back(it->second);
     }
   }
 
-  return Mesh{vertices, indices};
+  Mesh mesh{vertices, indices};
+  finish_import(mesh, settings);
+  return mesh;
 }
 
-auto load_mesh(const std::filesystem::path& mesh_path) -> expected<Mesh> {
+auto load_mesh(const std::filesystem::path& mesh_path,
+               const MeshImportSettings& settings) -> expected<Mesh> {
   spdlog::debug("Loading mesh: {}", mesh_path.string());
   auto ext = mesh_path.extension().string();
 
   if (ext.contains(".glb")) {
-    return load_glb_mesh(mesh_path);
+    return load_glb_mesh(mesh_path, settings);
   }
 
   if (ext.contains(".stl")) {
-    return load_stl_mesh(mesh_path);
+    return load_stl_mesh(mesh_path, settings);
   }
 
   return std::unexpected(
@@ -10,89 +10,90 @@
 
 namespace wren {
 
+namespace {
+
+//! @brief How an attachment is accessed while rendering to it
+struct AttachmentKind {
+  ::vk::ImageLayout layout;
+  ::vk::PipelineStageFlags stage;
+  ::vk::AccessFlags write_access;
+  ::vk::AccessFlags access;
+};
+
+const AttachmentKind kColourKind{
+    ::vk::ImageLayout::eColorAttachmentOptimal,
+    ::vk::PipelineStageFlagBits::eColorAttachmentOutput,
+    ::vk::AccessFlagBits::eColorAttachmentWrite,
+    ::vk::AccessFlagBits::eColorAttachmentRead |
+        ::vk::AccessFlagBits::eColorAttachmentWrite};
+
+const AttachmentKind kDepthKind{
+    ::vk::ImageLayout::eDepthStencilAttachmentOptimal,
+    ::vk::PipelineStageFlagBits::eEarlyFragmentTests |
+        ::vk::PipelineStageFlagBits::eLateFragmentTests,
+    ::vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+    ::vk::AccessFlagBits::eDepthStencilAttachmentRead |
+        ::vk::AccessFlagBits::eDepthStencilAttachmentWrite};
+
+}  // namespace
+
 auto RenderPass::create(const std::shared_ptr<Context>& ctx,
                         const std::string& name, const PassResources& resources,
                         const std::shared_ptr<RenderTarget>& colour_target,
                         const std::shared_ptr<RenderTarget>& depth_target,
-                        const execute_fn_t& fn)
+                        const PassSync& sync, const execute_fn_t& fn)
     -> expected<std::shared_ptr<RenderPass>> {
   auto pass = std::shared_ptr<RenderPass>(
       new RenderPass(ctx, name, resources, colour_target, depth_target, fn));
 
   const auto& device = ctx->graphics_context->Device();
-  const auto& swapchain_images = ctx->renderer->swapchain_images_views();
-
-  std::vector<::vk::AttachmentDescription> attachments;
-  std::vector<::vk::AttachmentReference> colour_attachments;
 
-  // Setup attachments
+  pass->sync_ = sync;
   if (colour_target != nullptr) {
-    ::vk::AttachmentDescription attachment(
-        {}, colour_target->format(), colour_target->sample_count(),
-        ::vk::AttachmentLoadOp::eClear, ::vk::AttachmentStoreOp::eStore,
-        ::vk::AttachmentLoadOp::eDontCare, ::vk::AttachmentStoreOp::eDontCare,
-        ::vk::ImageLayout::eUndefined, colour_target->final_layout());
-    attachments.push_back(attachment);
-    colour_attachments.emplace_back(0,
-                                    ::vk::ImageLayout::eColorAttachmentOptimal);
+    pass->pipeline_target_.colour_format = colour_target->format();
   }
-
-  ::vk::SubpassDescription subpass({}, ::vk::PipelineBindPoint::eGraphics, {},
-                                   colour_attachments, {});
-
   if (depth_target != nullptr) {
-    ::vk::AttachmentDescription depth_attachment(
-        {}, depth_target->format(), depth_target->sample_count(),
-        ::vk::AttachmentLoadOp::eClear, ::vk::AttachmentStoreOp::eStore,
-        ::vk::AttachmentLoadOp::eDontCare, ::vk::AttachmentStoreOp::eDontCare,
-        ::vk::ImageLayout::eUndefined, depth_target->final_layout());
-
-    const auto attachment_ref = ::vk::AttachmentReference{
-        1, ::vk::ImageLayout::eDepthStencilAttachmentOptimal};
-    subpass.setPDepthStencilAttachment(&attachment_ref);
-
-    attachments.push_back(depth_attachment);
+    pass->pipeline_target_.depth_format = depth_target->format();
   }
 
-  // Subpasses
-  ::vk::SubpassDependency dependency(VK_SUBPASS_EXTERNAL, 0);
-  if (colour_target != nullptr) {
-    dependency.srcStageMask |=
-        ::vk::PipelineStageFlagBits::eColorAttachmentOutput;
-    dependency.dstStageMask |=
-        ::vk::PipelineStageFlagBits::eColorAttachmentOutput;
-    dependency.dstAccessMask |= ::vk::AccessFlagBits::eColorAttachmentWrite;
+  // With dynamic rendering pipelines only need the formats, there's no render
+  // pass or framebuffer to recreate
+  if (!resources.is_compute() && !device.supports_dynamic_rendering()) {
+    TRY_RESULT(pass->create_render_pass(device.get()));
+    pass->pipeline_target_.render_pass = pass->render_pass_;
   }
 
-  if (depth_target != nullptr) {
-    dependency.srcStageMask |= ::vk::PipelineStageFlagBits::eEarlyFragmentTests;
-    dependency.dstStageMask |= ::vk::PipelineStageFlagBits::eEarlyFragmentTests;
-    dependency.dstAccessMask |=
-        ::vk::AccessFlagBits::eDepthStencilAttachmentWrite;
-  }
-
-  VK_TIE_RESULT(
-      pass->render_pass_,
-      device.get().createRenderPass({{}, attachments, subpass, dependency}));
-
   math::Vec2f size{512, 512};
   pass->size_ = size;
 
   // ===== create pipelines
   for (const auto& [_, shader] : resources.shaders()) {
+    if (shader->is_compute()) {
+      TRY_RESULT(shader->create_compute_pipeline(
+          device.get(), ctx->graphics_context->layout_cache(),
+          *ctx->graphics_context->deletion_queue()));
+      continue;
+    }
+
+    if (resources.is_compute()) continue;
     TRY_RESULT(shader->create_graphics_pipeline(
-        device.get(), pass->render_pass_, size, depth_target != nullptr));
+        device.get(), ctx->graphics_context->layout_cache(),
+        *ctx->graphics_context->deletion_queue(), pass->pipeline_target_,
+        size, &ctx->graphics_context->vertex_layout()));
   }
 
   pass->recreate_framebuffers(device.get());
 
   // ===== Command buffers
+  // Compute passes record for the async compute queue when there is one
+  const auto& compute_queue = ctx->graphics_context->compute_queue();
+  const auto family = resources.is_compute() && compute_queue != nullptr
+                          ? compute_queue->family()
+                          : ctx->graphics_context->graphics_queue()->family();
   VK_TIE_RESULT(pass->command_pool_,
                 device.get().createCommandPool(::vk::CommandPoolCreateInfo{
                     ::vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
-                    ctx->graphics_context->FindQueueFamilyIndices()
-                        .value()
-                        .graphics_index}));
+                    family}));
 
   VK_TIE_RESULT(
       pass->command_buffers_,
@@ -102,18 +103,71 @@ auto RenderPass::create(const std::shared_ptr<Context>& ctx,
   return pass;
 }
 
+auto RenderPass::create_render_pass(const ::vk::Device& device)
+    -> expected<void> {
+  std::vector<::vk::AttachmentDescription> attachments;
+  std::vector<::vk::AttachmentReference> colour_attachments;
+
+  // Setup attachments
+  if (colour_target_ != nullptr) {
+    ::vk::AttachmentDescription attachment(
+        {}, colour_target_->format(), colour_target_->sample_count(),
+        sync_.colour.load_op, sync_.colour.store_op,
+        ::vk::AttachmentLoadOp::eDontCare, ::vk::AttachmentStoreOp::eDontCare,
+        sync_.colour.initial_layout, sync_.colour.final_layout);
+    colour_attachments.emplace_back(attachments.size(),
+                                    ::vk::ImageLayout::eColorAttachmentOptimal);
+    attachments.push_back(attachment);
+  }
+
+  ::vk::SubpassDescription subpass({}, ::vk::PipelineBindPoint::eGraphics, {},
+                                   colour_attachments, {});
+
+  ::vk::AttachmentReference depth_attachment_ref;
+  if (depth_target_ != nullptr) {
+    ::vk::AttachmentDescription depth_attachment(
+        {}, depth_target_->format(), depth_target_->sample_count(),
+        sync_.depth.load_op, sync_.depth.store_op, sync_.depth.load_op,
+        sync_.depth.store_op, sync_.depth.initial_layout,
+        sync_.depth.final_layout);
+
+    depth_attachment_ref = ::vk::AttachmentReference{
+        static_cast<uint32_t>(attachments.size()),
+        ::vk::ImageLayout::eDepthStencilAttachmentOptimal};
+    subpass.setPDepthStencilAttachment(&depth_attachment_ref);
+
+    attachments.push_back(depth_attachment);
+  }
+
+  VK_TIE_RESULT(render_pass_,
+                device.createRenderPass(
+                    {{}, attachments, subpass, sync_.dependencies}));
+
+  return {};
+}
+
 auto RenderPass::resize_target(const math::Vec2f& new_size) -> expected<void> {
   size_ = new_size;
 
+  const auto extent = [](const auto& target) {
+    return target != nullptr ? target->extent() : math::Vec2f{};
+  };
+  const auto colour_extent = extent(colour_target_);
+  const auto depth_extent = extent(depth_target_);
+
   if (colour_target_ != nullptr) {
-    colour_target_->resize(ctx_, new_size);
+    TRY_RESULT(colour_target_->resize(ctx_, new_size));
   }
 
   if (depth_target_ != nullptr) {
-    depth_target_->resize(ctx_, new_size);
+    TRY_RESULT(depth_target_->resize(ctx_, new_size));
   }
 
-  recreate_framebuffers(ctx_->graphics_context->Device().get());
+  // Targets are over-allocated, the framebuffer only changes when they do
+  if (colour_extent != extent(colour_target_) ||
+      depth_extent != extent(depth_target_)) {
+    recreate_framebuffers(ctx_->graphics_context->Device().get());
+  }
 
   return {};
 }
@@ -126,14 +180,17 @@ void RenderPass::recreate_framebuffers(const ::vk::Device& device) {
   // Framebuffers here are created using the imageless framebuffer extension
   // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VK_KHR_imageless_framebuffer.html
 
+  // Dynamic rendering passes don't have one
+  if (!render_pass_) return;
+
   if (colour_target_ != nullptr) {
     auto col_format = colour_target_->format();
     std::vector<::vk::FramebufferAttachmentImageInfo> infos = {
         ::vk::FramebufferAttachmentImageInfo{
             {},
             colour_target_->usage(),
-            static_cast<uint32_t>(colour_target_->size().x()),
-            static_cast<uint32_t>(colour_target_->size().y()),
+            static_cast<uint32_t>(colour_target_->extent().x()),
+            static_cast<uint32_t>(colour_target_->extent().y()),
             1,
             col_format}};
     if (depth_target_ != nullptr) {
@@ -142,8 +199,8 @@ void RenderPass::recreate_framebuffers(const ::vk::Device& device) {
       infos.push_back(::vk::FramebufferAttachmentImageInfo{
           {},
           depth_target_->usage(),
-          static_cast<uint32_t>(depth_target_->size().x()),
-          static_cast<uint32_t>(depth_target_->size().y()),
+          static_cast<uint32_t>(depth_target_->extent().x()),
+          static_cast<uint32_t>(depth_target_->extent().y()),
           1,
           depth_format});
     }
@@ -152,14 +209,20 @@ void RenderPass::recreate_framebuffers(const ::vk::Device& device) {
 
     ::vk::FramebufferCreateInfo create_info(
         ::vk::FramebufferCreateFlagBits::eImageless, render_pass_, infos.size(),
-        {}, static_cast<uint32_t>(colour_target_->size().x()),
-        static_cast<uint32_t>(colour_target_->size().y()), 1, &attachements);
+        {}, static_cast<uint32_t>(colour_target_->extent().x()),
+        static_cast<uint32_t>(colour_target_->extent().y()), 1, &attachements);
 
     auto [res, fb] = device.createFramebuffer(create_info);
     if (res != ::vk::Result::eSuccess) {
       throw std::runtime_error("Failed to create framebuffer");
     }
 
+    if (framebuffer_) {
+      ctx_->graphics_context->deletion_queue()->push(
+          [device, framebuffer = framebuffer_]() {
+            device.destroyFramebuffer(framebuffer);
+          });
+    }
     framebuffer_ = fb;
   }
 }
@@ -170,6 +233,40 @@ void RenderPass::execute() {
   auto res = cmd.begin(::vk::CommandBufferBeginInfo{});
   if (res != ::vk::Result::eSuccess) return;
 
+  last_bound_shader_.reset();
+
+  // Make storage written by compute passes visible, a no-op cost wise when
+  // the semaphore between queues already did
+  if (sync_.after_compute) {
+    const ::vk::MemoryBarrier barrier(
+        ::vk::AccessFlagBits::eShaderWrite,
+        ::vk::AccessFlagBits::eShaderRead |
+            ::vk::AccessFlagBits::eIndirectCommandRead |
+            ::vk::AccessFlagBits::eVertexAttributeRead |
+            ::vk::AccessFlagBits::eIndexRead);
+    cmd.pipelineBarrier(::vk::PipelineStageFlagBits::eComputeShader,
+                        ::vk::PipelineStageFlagBits::eDrawIndirect |
+                            ::vk::PipelineStageFlagBits::eVertexInput |
+                            ::vk::PipelineStageFlagBits::eVertexShader |
+                            ::vk::PipelineStageFlagBits::eFragmentShader |
+                            ::vk::PipelineStageFlagBits::eComputeShader,
+                        {}, barrier, {}, {});
+  }
+
+  if (is_compute()) {
+    if (execute_fn_) execute_fn_(*this, cmd);
+  } else {
+    record_rendering(cmd);
+  }
+
+  res = cmd.end();
+  if (res != ::vk::Result::eSuccess) {
+    spdlog::error("Failed to record command buffer {}",
+                  make_error_code(res).message());
+  }
+}
+
+void RenderPass::record_rendering(::vk::CommandBuffer& cmd) {
   std::vector<::vk::ClearValue> clears = {
       ::vk::ClearValue(
           ::vk::ClearColorValue{std::array<float, 4>{0.0, 0.0, 0.0, 1.0}}),
@@ -178,7 +275,9 @@ void RenderPass::execute() {
   const auto extent = ::vk::Extent2D{static_cast<uint32_t>(output_size().x()),
                                      static_cast<uint32_t>(output_size().y())};
 
-  if (colour_target_ != nullptr) {
+  if (colour_target_ != nullptr && !render_pass_) {
+    begin_rendering(cmd, extent);
+  } else if (colour_target_ != nullptr) {
     std::vector<::vk::ImageView> views{colour_target_->view()};
     if (depth_target_ != nullptr) {
       views.push_back(depth_target_->view());
@@ -190,7 +289,9 @@ void RenderPass::execute() {
                                        clears, &attachment_begin);
 
     cmd.beginRenderPass(rp_begin, ::vk::SubpassContents::eInline);
+  }
 
+  if (colour_target_ != nullptr) {
     cmd.setViewport(
         0, ::vk::Viewport{0, 0, static_cast<float>(extent.width),
                           static_cast<float>(extent.height), 0.0, 1.0});
@@ -198,13 +299,103 @@ void RenderPass::execute() {
 
     if (execute_fn_) execute_fn_(*this, cmd);
 
-    cmd.endRenderPass();
+    if (render_pass_) {
+      cmd.endRenderPass();
+    } else {
+      end_rendering(cmd);
+    }
   }
+}
 
-  res = cmd.end();
-  if (res != ::vk::Result::eSuccess) {
-    spdlog::error("Failed to record command buffer {}",
-                  make_error_code(res).message());
+void RenderPass::begin_rendering(const ::vk::CommandBuffer& cmd,
+                                 const ::vk::Extent2D& extent) {
+  // Without a render pass the layout transitions and dependencies the graph
+  // worked out become barriers around the rendering
+  std::vector<::vk::ImageMemoryBarrier> barriers;
+  ::vk::PipelineStageFlags src_stages;
+  ::vk::PipelineStageFlags dst_stages;
+
+  const auto transition_in = [&](const RenderTarget& target,
+                                 const AttachmentUsage& usage,
+                                 const AttachmentKind& kind) {
+    // Wait for earlier writes when loading and earlier reads either way
+    src_stages |= kind.stage | ::vk::PipelineStageFlagBits::eFragmentShader;
+    dst_stages |= kind.stage;
+    barriers.emplace_back(
+        usage.load_op == ::vk::AttachmentLoadOp::eLoad ? kind.write_access
+                                                       : ::vk::AccessFlags{},
+        kind.access, usage.initial_layout, kind.layout,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, target.image(),
+        ::vk::ImageSubresourceRange(target.aspect(), 0, 1, 0, 1));
+  };
+
+  transition_in(*colour_target_, sync_.colour, kColourKind);
+  if (depth_target_ != nullptr) {
+    transition_in(*depth_target_, sync_.depth, kDepthKind);
+  }
+
+  cmd.pipelineBarrier(src_stages, dst_stages, {}, {}, {}, barriers);
+
+  const ::vk::RenderingAttachmentInfo colour(
+      colour_target_->view(), kColourKind.layout,
+      ::vk::ResolveModeFlagBits::eNone, {}, ::vk::ImageLayout::eUndefined,
+      sync_.colour.load_op, sync_.colour.store_op,
+      ::vk::ClearColorValue{std::array<float, 4>{0.0, 0.0, 0.0, 1.0}});
+
+  ::vk::RenderingInfo rendering_info({}, {{}, extent}, 1, 0, colour);
+
+  ::vk::RenderingAttachmentInfo depth;
+  if (depth_target_ != nullptr) {
+    depth = ::vk::RenderingAttachmentInfo(
+        depth_target_->view(), kDepthKind.layout,
+        ::vk::ResolveModeFlagBits::eNone, {}, ::vk::ImageLayout::eUndefined,
+        sync_.depth.load_op, sync_.depth.store_op,
+        ::vk::ClearDepthStencilValue{0.0, 0});
+    rendering_info.setPDepthAttachment(&depth);
+    if (depth_target_->aspect() & ::vk::ImageAspectFlagBits::eStencil) {
+      rendering_info.setPStencilAttachment(&depth);
+    }
+  }
+
+  cmd.beginRenderingKHR(rendering_info);
+}
+
+void RenderPass::end_rendering(const ::vk::CommandBuffer& cmd) {
+  cmd.endRenderingKHR();
+
+  std::vector<::vk::ImageMemoryBarrier> barriers;
+  ::vk::PipelineStageFlags src_stages;
+  ::vk::PipelineStageFlags dst_stages;
+
+  const auto transition_out = [&](const RenderTarget& target,
+                                  const AttachmentUsage& usage,
+                                  const AttachmentKind& kind) {
+    if (usage.final_layout == kind.layout ||
+        usage.final_layout == ::vk::ImageLayout::eUndefined) {
+      return;
+    }
+
+    // Presenting waits on a semaphore, anything else is sampled next
+    const bool present =
+        usage.final_layout == ::vk::ImageLayout::ePresentSrcKHR;
+    src_stages |= kind.stage;
+    dst_stages |= present ? ::vk::PipelineStageFlagBits::eBottomOfPipe
+                          : ::vk::PipelineStageFlagBits::eFragmentShader;
+    barriers.emplace_back(
+        kind.write_access,
+        present ? ::vk::AccessFlags{} : ::vk::AccessFlagBits::eShaderRead,
+        kind.layout, usage.final_layout, VK_QUEUE_FAMILY_IGNORED,
+        VK_QUEUE_FAMILY_IGNORED, target.image(),
+        ::vk::ImageSubresourceRange(target.aspect(), 0, 1, 0, 1));
+  };
+
+  transition_out(*colour_target_, sync_.colour, kColourKind);
+  if (depth_target_ != nullptr) {
+    transition_out(*depth_target_, sync_.depth, kDepthKind);
+  }
+
+  if (!barriers.empty()) {
+    cmd.pipelineBarrier(src_stages, dst_stages, {}, {}, {}, barriers);
   }
 }
 
@@ -214,18 +405,46 @@ auto RenderPass::get_scratch_buffer(uint32_t set, uint32_t binding, size_t size)
       ctx_->graphics_context->allocator(), size,
       VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
       VmaAllocationCreateFlagBits::
-          VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+          VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+      ctx_->graphics_context->deletion_queue());
 
   return buf->map();
 }
 
+void RenderPass::push_storage_buffers(
+    const ::vk::CommandBuffer& cmd,
+    std::span<const ::vk::DescriptorBufferInfo> buffers,
+    uint32_t first_binding) {
+  std::vector<::vk::WriteDescriptorSet> writes;
+  writes.reserve(buffers.size());
+  for (std::size_t i = 0; i < buffers.size(); ++i) {
+    writes.emplace_back(::vk::DescriptorSet{}, first_binding + i, 0, 1,
+                        ::vk::DescriptorType::eStorageBuffer, nullptr,
+                        &buffers[i]);
+  }
+
+  cmd.pushDescriptorSetKHR(last_bound_shader_->bind_point(),
+                           last_bound_shader_->pipeline_layout(), 0, writes);
+}
+
 void RenderPass::bind_pipeline(const std::string& pipeline_name) {
   auto cmd = command_buffers_.front();
 
-  const auto pipeline = resources_.shaders().at(pipeline_name)->get_pipeline();
+  const auto& shader = resources_.shaders().at(pipeline_name);
+  if (shader == last_bound_shader_) return;
+
+  // Layouts come from the shared cache, so switching between shaders with the
+  // same interface keeps any descriptors that were already pushed
+  cmd.bindPipeline(shader->bind_point(), shader->get_pipeline());
+  last_bound_shader_ = shader;
 
-  cmd.bindPipeline(::vk::PipelineBindPoint::eGraphics, pipeline);
-  last_bound_shader_ = resources_.shaders().at(pipeline_name);
+  // The push descriptor set in front of it can differ between shaders, which
+  // disturbs the bindless set, so bind it again with every pipeline
+  const auto& bindless = ctx_->graphics_context->bindless();
+  if (bindless != nullptr &&
+      shader->layout_description().has_set(vk::BindlessHeap::kSet)) {
+    bindless->bind(cmd, shader->bind_point(), shader->pipeline_layout());
+  }
 }
 
 RenderPass::RenderPass(const std::shared_ptr<Context>& ctx, std::string name,
@@ -1,113 +1,67 @@
 #include "render_target.hpp"
 
+#include <spdlog/spdlog.h>
+
+#include <cmath>
+
 #include "renderer.hpp"
 
 namespace wren {
 
-auto RenderTarget::create(const std::shared_ptr<Context> &ctx)
+namespace {
+
+constexpr auto kColourFormat = ::vk::Format::eB8G8R8A8Srgb;
+constexpr auto kDepthFormat = ::vk::Format::eD32SfloatS8Uint;
+
+const math::Vec2f kDefaultSize{512, 512};
+
+// Allocations are rounded up to this many pixels so dragging a panel doesn't
+// reallocate every frame
+constexpr float kSizeBucket = 128;
+
+auto bucket(const math::Vec2f &size) {
+  return math::Vec2f{std::ceil(size.x() / kSizeBucket) * kSizeBucket,
+                     std::ceil(size.y() / kSizeBucket) * kSizeBucket};
+}
+
+}  // namespace
+
+auto RenderTarget::create(const std::shared_ptr<Context> &ctx,
+                          const Options &options)
     -> expected<std::shared_ptr<RenderTarget>> {
   auto target =
       std::shared_ptr<wren::RenderTarget>(new RenderTarget());  // NOLINT
 
-  target->size_ = {512, 512};
+  target->options_ = options;
+  target->size_ = kDefaultSize;
+  target->extent_ = kDefaultSize;
   target->sample_count_ = ::vk::SampleCountFlagBits::e1;
-  target->format_ = ::vk::Format::eB8G8R8A8Srgb;
-  target->image_usage_ = ::vk::ImageUsageFlagBits::eColorAttachment |
-                         ::vk::ImageUsageFlagBits::eSampled;
+  target->format_ = kColourFormat;
+  target->image_usage_ = colour_usage(options);
   target->aspect_ = ::vk::ImageAspectFlagBits::eColor;
 
-  TRY_RESULT(
-      target->image_,
-      vk::Image::create(ctx->graphics_context->Device().get(),
-                        ctx->graphics_context->allocator(), target->format_,
-                        target->size_, target->image_usage_));
-
-  target->transition_fn_ = [&target, ctx]() -> expected<void> {
-    // transition image
-    if (target->image_.has_value()) {
-      TRY_RESULT(ctx->renderer->submit_command_buffer(
-          [&image = target->image_](const ::vk::CommandBuffer &cmd_buf) {
-            ::vk::ImageMemoryBarrier barrier(
-                ::vk::AccessFlagBits::eTransferRead,
-                ::vk::AccessFlagBits::eMemoryRead,
-                ::vk::ImageLayout::eUndefined,
-                ::vk::ImageLayout::eShaderReadOnlyOptimal,
-                VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image->get(),
-                ::vk::ImageSubresourceRange(::vk::ImageAspectFlagBits::eColor,
-                                            0, 1, 0, 1));
-
-            cmd_buf.pipelineBarrier(::vk::PipelineStageFlagBits::eTransfer,
-                                    ::vk::PipelineStageFlagBits::eTransfer,
-                                    ::vk::DependencyFlags(), {}, {}, barrier);
-          }));
-    }
-
-    return {};
-  };
-
-  target->transition_fn_();
-
-  ::vk::ImageViewCreateInfo image_view_info(
-      {}, target->image_->get(), ::vk::ImageViewType::e2D, target->format_, {},
-      ::vk::ImageSubresourceRange(target->aspect_, 0, 1, 0, 1));
-  VK_TIE_RESULT(
-      target->view_,
-      ctx->graphics_context->Device().get().createImageView(image_view_info));
+  TRY_RESULT(target->create_image(ctx));
 
   return target;
 }
 
-auto RenderTarget::create_depth(const std::shared_ptr<Context> &ctx)
+auto RenderTarget::create_depth(const std::shared_ptr<Context> &ctx,
+                                const Options &options)
     -> expected<std::shared_ptr<RenderTarget>> {
   auto target =
       std::shared_ptr<wren::RenderTarget>(new RenderTarget());  // NOLINT
 
-  target->size_ = {512, 512};
+  target->options_ = options;
+  target->size_ = kDefaultSize;
+  target->extent_ = kDefaultSize;
   target->sample_count_ = ::vk::SampleCountFlagBits::e1;
-  target->format_ = ::vk::Format::eD32SfloatS8Uint;
-  target->image_usage_ = ::vk::ImageUsageFlagBits::eDepthStencilAttachment;
+  target->format_ = kDepthFormat;
+  target->image_usage_ = depth_usage(options);
   target->final_layout_ = ::vk::ImageLayout::eDepthStencilAttachmentOptimal;
   target->aspect_ =
       ::vk::ImageAspectFlagBits::eDepth | ::vk::ImageAspectFlagBits::eStencil;
 
-  TRY_RESULT(
-      target->image_,
-      vk::Image::create(ctx->graphics_context->Device().get(),
-                        ctx->graphics_context->allocator(), target->format_,
-                        target->size_, target->image_usage_));
-
-  target->transition_fn_ = [target = target.get(), ctx]() -> expected<void> {
-    // transition image
-    if (target->image_.has_value()) {
-      TRY_RESULT(ctx->renderer->submit_command_buffer(
-          [target](const ::vk::CommandBuffer &cmd_buf) {
-            ::vk::ImageMemoryBarrier barrier(
-                ::vk::AccessFlagBits::eNone,
-                ::vk::AccessFlagBits::eDepthStencilAttachmentRead |
-                    ::vk::AccessFlagBits::eDepthStencilAttachmentWrite,
-                ::vk::ImageLayout::eUndefined,
-                ::vk::ImageLayout::eDepthStencilAttachmentOptimal,
-                VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-                target->image_->get(),
-                ::vk::ImageSubresourceRange(target->aspect_, 0, 1, 0, 1));
-
-            cmd_buf.pipelineBarrier(
-                ::vk::PipelineStageFlagBits::eTopOfPipe,
-                ::vk::PipelineStageFlagBits::eEarlyFragmentTests,
-                ::vk::DependencyFlags(), {}, {}, barrier);
-          }));
-    }
-    return {};
-  };
-
-  target->transition_fn_();
-
-  ::vk::ImageViewCreateInfo image_view_info(
-      {}, target->image_->get(), ::vk::ImageViewType::e2D, target->format_, {},
-      ::vk::ImageSubresourceRange(target->aspect_, 0, 1, 0, 1));
-  VK_TIE_RESULT(
-      target->view_,
-      ctx->graphics_context->Device().get().createImageView(image_view_info));
+  TRY_RESULT(target->create_image(ctx));
 
   return target;
 }
@@ -120,35 +74,117 @@ auto RenderTarget::create(const math::Vec2f &size, ::vk::Format format,
   auto target = std::shared_ptr<wren::RenderTarget>(new RenderTarget());
 
   target->size_ = size;
+  target->extent_ = size;
   target->sample_count_ = sample_count;
   target->format_ = format;
   target->image_usage_ = image_usage;
+  target->view_ = image_view;
 
   return target;
 }
 
-auto RenderTarget::resize(const std::shared_ptr<Context> &ctx,
-                          const math::Vec2f &new_size) -> expected<void> {
-  size_ = new_size;
+auto RenderTarget::memory_requirements(const std::shared_ptr<Context> &ctx,
+                                       bool depth, const Options &options)
+    -> expected<::vk::MemoryRequirements> {
+  return vk::Image::memory_requirements(
+      ctx->graphics_context->Device().get(),
+      depth ? kDepthFormat : kColourFormat, kDefaultSize,
+      depth ? depth_usage(options) : colour_usage(options));
+}
+
+auto RenderTarget::colour_usage(const Options &options)
+    -> ::vk::ImageUsageFlags {
+  ::vk::ImageUsageFlags usage = ::vk::ImageUsageFlagBits::eColorAttachment;
+  if (options.sampled) usage |= ::vk::ImageUsageFlagBits::eSampled;
+  if (options.transient) {
+    usage |= ::vk::ImageUsageFlagBits::eTransientAttachment;
+  }
+  return usage;
+}
+
+auto RenderTarget::depth_usage(const Options &options)
+    -> ::vk::ImageUsageFlags {
+  ::vk::ImageUsageFlags usage =
+      ::vk::ImageUsageFlagBits::eDepthStencilAttachment;
+  if (options.sampled) usage |= ::vk::ImageUsageFlagBits::eSampled;
+  if (options.transient) {
+    usage |= ::vk::ImageUsageFlagBits::eTransientAttachment;
+  }
+  return usage;
+}
+
+auto RenderTarget::create_image(const std::shared_ptr<Context> &ctx)
+    -> expected<void> {
+  const auto &device = ctx->graphics_context->Device().get();
+  const auto &allocator = ctx->graphics_context->allocator();
 
   if (image_.has_value()) {
-    // @todo  Delete image
+    ctx->graphics_context->deletion_queue()->push(
+        [device, allocator, image = *image_, view = view_]() {
+          device.destroyImageView(view);
+          image.destroy(device, allocator);
+        });
+  }
 
-    // Create a new image
-    TRY_RESULT(image_, vk::Image::create(ctx->graphics_context->Device().get(),
-                                         ctx->graphics_context->allocator(),
-                                         format_, size_, image_usage_));
+  // Aliased memory is sized for the target's size when the graph was
+  // compiled, a target outgrowing it gets its own memory again
+  if (options_.memory != nullptr) {
+    VmaAllocationInfo info{};
+    vmaGetAllocationInfo(allocator, options_.memory.get(), &info);
+    TRY_RESULT(const auto requirements,
+               vk::Image::memory_requirements(device, format_, extent_,
+                                              image_usage_));
+    if (requirements.size > info.size) options_.memory.reset();
+  }
 
-    TRY_RESULT(transition_fn_());
+  if (options_.memory != nullptr) {
+    TRY_RESULT(image_, vk::Image::create_aliasing(allocator,
+                                                  options_.memory.get(),
+                                                  format_, extent_,
+                                                  image_usage_));
+  } else if (options_.transient) {
+    // Lazily allocated memory only exists on tiled GPUs, fall back to
+    // regular device memory elsewhere
+    auto image = vk::Image::create(device, allocator, format_, extent_,
+                                   image_usage_,
+                                   VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED);
+    if (!image.has_value()) {
+      image = vk::Image::create(device, allocator, format_, extent_,
+                                image_usage_);
+    }
+    TRY_RESULT(image_, image);
+  } else {
+    TRY_RESULT(image_, vk::Image::create(device, allocator, format_, extent_,
+                                         image_usage_));
+  }
 
-    ::vk::ImageViewCreateInfo image_view_info(
-        {}, image_->get(), ::vk::ImageViewType::e2D, format_, {},
-        ::vk::ImageSubresourceRange(aspect_, 0, 1, 0, 1));
+  ::vk::ImageViewCreateInfo image_view_info(
+      {}, image_->get(), ::vk::ImageViewType::e2D, format_, {},
+      ::vk::ImageSubresourceRange(aspect_, 0, 1, 0, 1));
+  VK_TIE_RESULT(view_, device.createImageView(image_view_info));
+
+  return {};
+}
 
-    VK_TIE_RESULT(view_, ctx->graphics_context->Device().get().createImageView(
-                             image_view_info));
+auto RenderTarget::resize(const std::shared_ptr<Context> &ctx,
+                          const math::Vec2f &new_size) -> expected<void> {
+  size_ = new_size;
+
+  if (!image_.has_value()) {
+    extent_ = new_size;
+    return {};
   }
 
+  // Grow as soon as it doesn't fit, shrink once most of it would be unused
+  const auto needed = bucket(new_size);
+  const bool fits = needed.x() <= extent_.x() && needed.y() <= extent_.y();
+  const bool wasteful =
+      needed.x() * needed.y() * 4 < extent_.x() * extent_.y();
+  if (fits && !wasteful) return {};
+
+  extent_ = needed;
+  TRY_RESULT(create_image(ctx));
+
   return {};
 }
 
@@ -2,7 +2,11 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <utility>
 #include <vulkan/vulkan_enums.hpp>
 #include <vulkan/vulkan_handles.hpp>
 #include <vulkan/vulkan_structs.hpp>
@@ -29,13 +33,16 @@ auto Renderer::begin_frame() -> expected<uint32_t> {
   ::vk::Result res = ::vk::Result::eSuccess;
 
   const auto &device = ctx_->graphics_context->Device().get();
+  const auto &graphics = ctx_->graphics_context->graphics_queue();
   {
-    ZoneScopedN("device.waitForFences()");  // NOLINT
-    VK_ERR_PROP_VOID(
-        device.waitForFences(in_flight_fence, VK_TRUE, UINT64_MAX));
-    device.resetFences(in_flight_fence);
+    ZoneScopedN("graphics->wait()");  // NOLINT
+    TRY_RESULT(graphics->wait(frame_done_.value));
   }
 
+  // One-off submits may have finished since as well
+  TRY_RESULT(const auto completed, graphics->completed());
+  ctx_->graphics_context->deletion_queue()->flush(completed);
+
   uint32_t image_index = -1;
 
   {
@@ -48,35 +55,91 @@ auto Renderer::begin_frame() -> expected<uint32_t> {
     }
   }
 
-  render_targets_.at(kSwapchainRendertargetName.data())
-      ->view(swapchain_image_views_.at(image_index));
+  const auto &target = render_targets_.at(kSwapchainRendertargetName.data());
+  target->view(swapchain_image_views_.at(image_index));
+  target->image(swapchain_images_.at(image_index));
 
   return image_index;
 }
 
 void Renderer::end_frame(uint32_t image_index) {
-  ::vk::PipelineStageFlags wait_dst_stage_mask =
-      ::vk::PipelineStageFlagBits::eColorAttachmentOutput;
-
-  std::vector<::vk::CommandBuffer> cmd_bufs;
-  for (auto g : render_graph_) {
+  const auto &graphics = ctx_->graphics_context->graphics_queue();
+  const auto &compute = ctx_->graphics_context->compute_queue();
+
+  // Consecutive passes on the same queue share a submit. A batch is split
+  // where it has to wait for the other queue, so the passes before that
+  // point can overlap with the other queue's work.
+  struct Batch {
+    std::shared_ptr<vk::SubmitQueue> queue;
+    vk::Submission submission;
+    std::set<std::size_t> waits;
+  };
+  std::vector<Batch> batches;
+  std::unordered_map<const Node *, std::size_t> batch_of;
+
+  for (const auto &node : render_graph_) {
     ZoneScopedN("render_pass->execute()");
-    g->render_pass->execute();
-    const auto bufs = g->render_pass->get_command_buffers();
-    cmd_bufs.insert(cmd_bufs.end(), bufs.begin(), bufs.end());
+    node->render_pass->execute();
+
+    const auto &queue =
+        node->render_pass->is_compute() && compute != nullptr ? compute
+                                                              : graphics;
+
+    std::set<std::size_t> waits;
+    for (const auto &[producer, consumer] : render_graph_.edges) {
+      if (consumer != node) continue;
+      const auto batch = batch_of.at(producer.get());
+      if (batches.at(batch).queue != queue) waits.insert(batch);
+    }
+
+    if (batches.empty() || batches.back().queue != queue || !waits.empty()) {
+      batches.push_back({.queue = queue});
+    }
+
+    auto &batch = batches.back();
+    batch.waits.insert(waits.begin(), waits.end());
+    const auto bufs = node->render_pass->get_command_buffers();
+    batch.submission.command_buffers.insert(
+        batch.submission.command_buffers.end(), bufs.begin(), bufs.end());
+    batch_of.emplace(node.get(), batches.size() - 1);
   }
 
-  ::vk::SubmitInfo submit_info(image_available, wait_dst_stage_mask, cmd_bufs,
-                               render_finished);
-  ::vk::Result res =
-      ctx_->graphics_context->Device().get_graphics_queue().submit(
-          submit_info, in_flight_fence);
-  if (res != ::vk::Result::eSuccess) {
-    spdlog::warn("{}", ::vk::to_string(res));
+  // The swapchain image is only waited on and signalled by graphics work
+  const auto is_graphics = [&graphics](const Batch &batch) {
+    return batch.queue == graphics;
+  };
+  if (const auto first = std::ranges::find_if(batches, is_graphics);
+      first != batches.end()) {
+    first->submission.binary_waits.emplace_back(
+        image_available, ::vk::PipelineStageFlagBits::eColorAttachmentOutput);
+  }
+  if (const auto last =
+          std::ranges::find_if(batches.rbegin(), batches.rend(), is_graphics);
+      last != batches.rend()) {
+    last->submission.binary_signals.push_back(render_finished);
+  }
+
+  std::vector<vk::TimelinePoint> points;
+  for (auto &batch : batches) {
+    for (const auto wait : batch.waits) {
+      batch.submission.waits.emplace_back(
+          points.at(wait), ::vk::PipelineStageFlagBits::eAllCommands);
+    }
+
+    const auto point = batch.queue->submit(batch.submission);
+    if (!point.has_value()) {
+      spdlog::warn("{}", point.error().message());
+      return;
+    }
+    points.push_back(point.value());
+
+    // Compute batches are always waited on by a later graphics batch, so
+    // the last graphics submit covers the whole frame
+    if (batch.queue == graphics) frame_done_ = point.value();
   }
 
   ::vk::PresentInfoKHR present_info{render_finished, swapchain_, image_index};
-  res = ctx_->graphics_context->Device().get_present_queue().presentKHR(
+  auto res = ctx_->graphics_context->Device().get_present_queue().presentKHR(
       present_info);
   if (res == ::vk::Result::eErrorOutOfDateKHR ||
       res == ::vk::Result::eSuboptimalKHR) {
@@ -91,24 +154,35 @@ void Renderer::end_frame(uint32_t image_index) {
 
 auto Renderer::submit_command_buffer(
     const std::function<void(::vk::CommandBuffer &)> &cmd_buf)
-    -> expected<void> {
-  if (!cmd_buf) return {};
+    -> expected<vk::TimelinePoint> {
+  const auto &graphics = ctx_->graphics_context->graphics_queue();
+  if (!cmd_buf) return graphics->last_submitted();
 
-  VK_CHECK_RESULT(one_time_cmd_buffer.begin(::vk::CommandBufferBeginInfo(
+  const auto &device = ctx_->graphics_context->Device().get();
+
+  VK_TRY_RESULT(bufs, device.allocateCommandBuffers(
+                          {command_pool_, ::vk::CommandBufferLevel::ePrimary,
+                           1}));
+  auto cmd = bufs.front();
+
+  VK_CHECK_RESULT(cmd.begin(::vk::CommandBufferBeginInfo(
       ::vk::CommandBufferUsageFlagBits::eOneTimeSubmit)));
 
-  cmd_buf(one_time_cmd_buffer);
+  cmd_buf(cmd);
 
-  VK_CHECK_RESULT(one_time_cmd_buffer.end());
+  VK_CHECK_RESULT(cmd.end());
 
-  ::vk::SubmitInfo submit_info({}, {}, one_time_cmd_buffer);
-  VK_CHECK_RESULT(ctx_->graphics_context->Device().get_graphics_queue().submit(
-      submit_info));
+  vk::Submission submission;
+  submission.command_buffers.push_back(cmd);
+  TRY_RESULT(const auto point, graphics->submit(submission));
 
-  VK_CHECK_RESULT(
-      ctx_->graphics_context->Device().get_graphics_queue().waitIdle());
+  // The command buffer is freed once the submit has finished
+  ctx_->graphics_context->deletion_queue()->push(
+      point.value, [device, pool = command_pool_, cmd]() {
+        device.freeCommandBuffers(pool, cmd);
+      });
 
-  return {};
+  return point;
 }
 
 Renderer::Renderer(const std::shared_ptr<Context> &ctx)
@@ -141,11 +215,6 @@ auto Renderer::create(const std::shared_ptr<Context> &ctx)
   if (!res.has_value()) return std::unexpected(res.error());
 
   ::vk::Result vres = ::vk::Result::eSuccess;
-  std::tie(vres, renderer->in_flight_fence) = device.get().createFence(
-      ::vk::FenceCreateInfo{::vk::FenceCreateFlagBits::eSignaled});
-  if (vres != ::vk::Result::eSuccess)
-    return std::unexpected(make_error_code(vres));
-
   std::tie(vres, renderer->image_available) =
       device.get().createSemaphore(::vk::SemaphoreCreateInfo{});
   if (vres != ::vk::Result::eSuccess)
@@ -163,15 +232,6 @@ auto Renderer::create(const std::shared_ptr<Context> &ctx)
                         .value()
                         .graphics_index}));
 
-  ::vk::CommandBufferAllocateInfo alloc_info(
-      renderer->command_pool_, ::vk::CommandBufferLevel::ePrimary, 1);
-
-  VK_TRY_RESULT(
-      bufs,
-      ctx->graphics_context->Device().get().allocateCommandBuffers(alloc_info));
-
-  renderer->one_time_cmd_buffer = bufs.front();
-
   return renderer;
 }
 
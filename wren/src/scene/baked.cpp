@@ -0,0 +1,592 @@
+#include "scene/baked.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <wren/utils/mapped_file.hpp>
+
+#include "scene/components/mesh.hpp"
+#include "scene/components/transform.hpp"
+#include "scene/deserialization.hpp"
+#include "scene/serialization.hpp"
+#include "wren/utils/tracy.hpp"  // IWYU pragma: keep
+
+namespace wren::scene {
+
+namespace {
+
+// Transforms are copied between the file and flecs without any conversion
+static_assert(std::is_trivially_copyable_v<components::Transform>);
+static_assert(sizeof(components::Transform) == 9 * sizeof(float));
+
+constexpr std::array<char, 4> kMagic = {'W', 'S', 'C', 'N'};
+constexpr uint64_t kColumnAlignment = 16;
+
+//! @brief What a column holds, every column has one row per entity except
+//! for sparse components which start with the entity index of each row
+enum class Column : uint32_t {
+  //! @brief Null terminated strings
+  Name = 0,
+  //! @brief components::Transform as is
+  Transform = 1,
+  //! @brief Entity indices followed by the mesh paths as strings
+  MeshRenderer = 2,
+};
+
+struct Header {
+  std::array<char, 4> magic = kMagic;
+  uint32_t version = kBakedSceneVersion;
+  uint32_t entity_count = 0;
+  uint32_t column_count = 0;
+};
+
+struct ColumnHeader {
+  Column column;
+  uint32_t count;
+  //! @brief From the start of the file, a multiple of kColumnAlignment
+  uint64_t offset;
+  uint64_t size;
+};
+
+//! @brief An owning copy of a scene's components, what's written
+struct SceneData {
+  std::vector<std::string> names;
+  std::vector<components::Transform> transforms;
+  //! @brief Entity index of each mesh renderer
+  std::vector<uint32_t> mesh_entities;
+  std::vector<std::string> mesh_paths;
+};
+
+//! @brief Strings stored as count + 1 offsets followed by the characters
+struct Strings {
+  std::span<const uint32_t> offsets;
+  const char* chars = nullptr;
+
+  [[nodiscard]] auto size() const {
+    return offsets.empty() ? 0 : offsets.size() - 1;
+  }
+  [[nodiscard]] auto c_str(std::size_t i) const { return chars + offsets[i]; }
+  [[nodiscard]] auto view(std::size_t i) const -> std::string_view {
+    return {chars + offsets[i], offsets[i + 1] - offsets[i] - 1};
+  }
+};
+
+//! @brief A baked scene still in its mapping
+struct BakedView {
+  uint32_t entity_count = 0;
+  Strings names;
+  components::Transform* transforms = nullptr;
+  std::span<const uint32_t> mesh_entities;
+  Strings mesh_paths;
+};
+
+auto align_up(uint64_t offset) -> uint64_t {
+  return (offset + kColumnAlignment - 1) / kColumnAlignment *
+         kColumnAlignment;
+}
+
+template <typename T>
+void append(std::vector<std::byte>& out, std::span<const T> values) {
+  const auto bytes = std::as_bytes(values);
+  out.insert(out.end(), bytes.begin(), bytes.end());
+}
+
+//! @brief Strings keep their terminator so names can go to flecs straight out
+//! of the mapping
+void append_strings(std::vector<std::byte>& out,
+                    std::span<const std::string> strings) {
+  std::vector<uint32_t> offsets;
+  offsets.reserve(strings.size() + 1);
+  uint32_t offset = 0;
+  for (const auto& string : strings) {
+    offsets.push_back(offset);
+    offset += static_cast<uint32_t>(string.size() + 1);
+  }
+  offsets.push_back(offset);
+
+  append(out, std::span<const uint32_t>(offsets));
+  for (const auto& string : strings) {
+    append(out, std::span<const char>(string.c_str(), string.size() + 1));
+  }
+}
+
+auto read_strings(std::span<const std::byte> bytes, std::size_t count)
+    -> expected<Strings> {
+  const auto offsets_size = (count + 1) * sizeof(uint32_t);
+  if (bytes.size() < offsets_size) {
+    return std::unexpected(BakedSceneErrors::Corrupt);
+  }
+
+  const Strings strings{
+      {reinterpret_cast<const uint32_t*>(bytes.data()), count + 1},
+      reinterpret_cast<const char*>(bytes.data() + offsets_size)};
+  const auto chars_size = bytes.size() - offsets_size;
+
+  if (strings.offsets.front() != 0 || strings.offsets.back() > chars_size) {
+    return std::unexpected(BakedSceneErrors::Corrupt);
+  }
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto begin = strings.offsets[i];
+    const auto end = strings.offsets[i + 1];
+    if (end <= begin || end > chars_size || strings.chars[end - 1] != '\0') {
+      return std::unexpected(BakedSceneErrors::Corrupt);
+    }
+  }
+
+  return strings;
+}
+
+auto parse(std::span<std::byte> file) -> expected<BakedView> {
+  Header header;
+  if (file.size() < sizeof(header)) {
+    return std::unexpected(BakedSceneErrors::NotABakedScene);
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (header.magic != kMagic) {
+    return std::unexpected(BakedSceneErrors::NotABakedScene);
+  }
+  if (header.version != kBakedSceneVersion) {
+    return std::unexpected(BakedSceneErrors::UnsupportedVersion);
+  }
+
+  const auto columns_size =
+      static_cast<uint64_t>(header.column_count) * sizeof(ColumnHeader);
+  if (file.size() - sizeof(header) < columns_size) {
+    return std::unexpected(BakedSceneErrors::Corrupt);
+  }
+
+  BakedView view{.entity_count = header.entity_count};
+  bool has_names = false;
+  bool has_transforms = false;
+
+  for (uint32_t c = 0; c < header.column_count; ++c) {
+    ColumnHeader column{};
+    std::memcpy(&column, file.data() + sizeof(header) + c * sizeof(column),
+                sizeof(column));
+    if (column.offset % kColumnAlignment != 0 || column.offset > file.size() ||
+        column.size > file.size() - column.offset) {
+      return std::unexpected(BakedSceneErrors::Corrupt);
+    }
+    const auto bytes = file.subspan(column.offset, column.size);
+
+    if (column.column == Column::Name) {
+      if (column.count != view.entity_count) {
+        return std::unexpected(BakedSceneErrors::Corrupt);
+      }
+      TRY_RESULT(view.names, read_strings(bytes, column.count));
+      has_names = true;
+    } else if (column.column == Column::Transform) {
+      if (column.count != view.entity_count ||
+          column.size != column.count * sizeof(components::Transform)) {
+        return std::unexpected(BakedSceneErrors::Corrupt);
+      }
+      view.transforms = reinterpret_cast<components::Transform*>(bytes.data());
+      has_transforms = true;
+    } else if (column.column == Column::MeshRenderer) {
+      const auto entities_size = column.count * sizeof(uint32_t);
+      if (column.size < entities_size) {
+        return std::unexpected(BakedSceneErrors::Corrupt);
+      }
+      view.mesh_entities = {reinterpret_cast<const uint32_t*>(bytes.data()),
+                            column.count};
+      // Streaming relies on them being in entity order
+      if (!std::ranges::is_sorted(view.mesh_entities) ||
+          (!view.mesh_entities.empty() &&
+           view.mesh_entities.back() >= view.entity_count)) {
+        return std::unexpected(BakedSceneErrors::Corrupt);
+      }
+      TRY_RESULT(view.mesh_paths,
+                 read_strings(bytes.subspan(entities_size), column.count));
+    }
+    // Anything else is a column this version doesn't know about, skip it
+  }
+
+  if (view.entity_count > 0 && (!has_names || !has_transforms)) {
+    return std::unexpected(BakedSceneErrors::Corrupt);
+  }
+
+  return view;
+}
+
+//! @brief Names have to be unique within the file and unused in the world,
+//! checked for every entity before any is created so a conflict never leaves
+//! a half loaded scene
+auto check_names(const flecs::world& world, const Strings& names)
+    -> expected<void> {
+  std::unordered_set<std::string_view> seen;
+  seen.reserve(names.size());
+  for (std::size_t i = 0; i < names.size(); ++i) {
+    // Up to the first terminator, what flecs is given as the name
+    const std::string_view name = names.c_str(i);
+    if (name.empty()) continue;
+    if (!seen.insert(name).second ||
+        ecs_lookup_child(world, 0, name.data()) != 0) {
+      return std::unexpected(BakedSceneErrors::NameConflict);
+    }
+  }
+  return {};
+}
+
+auto write(const SceneData& data, const std::filesystem::path& out_file)
+    -> expected<void> {
+  struct Payload {
+    Column column;
+    uint32_t count;
+    std::vector<std::byte> bytes;
+  };
+
+  std::array<Payload, 3> payloads = {
+      Payload{Column::Name, static_cast<uint32_t>(data.names.size()), {}},
+      Payload{Column::Transform, static_cast<uint32_t>(data.transforms.size()),
+              {}},
+      Payload{Column::MeshRenderer,
+              static_cast<uint32_t>(data.mesh_entities.size()),
+              {}},
+  };
+  append_strings(payloads[0].bytes, data.names);
+  append(payloads[1].bytes, std::span(data.transforms));
+  append(payloads[2].bytes, std::span(data.mesh_entities));
+  append_strings(payloads[2].bytes, data.mesh_paths);
+
+  const Header header{.entity_count = static_cast<uint32_t>(data.names.size()),
+                      .column_count = static_cast<uint32_t>(payloads.size())};
+
+  std::vector<ColumnHeader> columns;
+  uint64_t offset =
+      align_up(sizeof(header) + payloads.size() * sizeof(ColumnHeader));
+  for (const auto& payload : payloads) {
+    columns.push_back(
+        {payload.column, payload.count, offset, payload.bytes.size()});
+    offset = align_up(offset + payload.bytes.size());
+  }
+
+  std::ofstream out(out_file, std::ios::binary);
+  if (!out) return std::unexpected(std::make_error_code(std::errc::io_error));
+
+  const auto write_bytes = [&out](std::span<const std::byte> bytes) {
+    out.write(reinterpret_cast<const char*>(bytes.data()),
+              static_cast<std::streamsize>(bytes.size()));
+  };
+  const auto pad_to = [&out](uint64_t position) {
+    static constexpr std::array<char, kColumnAlignment> kZeros{};
+    const auto current = static_cast<uint64_t>(out.tellp());
+    out.write(kZeros.data(), static_cast<std::streamsize>(position - current));
+  };
+
+  write_bytes(std::as_bytes(std::span(&header, 1)));
+  write_bytes(std::as_bytes(std::span(columns)));
+  for (std::size_t i = 0; i < payloads.size(); ++i) {
+    pad_to(columns[i].offset);
+    write_bytes(payloads.at(i).bytes);
+  }
+
+  if (!out) return std::unexpected(std::make_error_code(std::errc::io_error));
+  return {};
+}
+
+auto extract(const std::shared_ptr<Scene>& scene) -> expected<SceneData> {
+  SceneData data;
+
+  // Saving to TOML goes through the registry, anything registered without a
+  // column here would be dropped from the baked copy
+  const std::array stored = {
+      scene->world().component<components::Transform>().id(),
+      scene->world().component<components::MeshRenderer>().id(),
+  };
+  const ComponentType* unsupported = nullptr;
+
+  const auto& registry = scene->components();
+  auto q = scene->world().query_builder<components::Transform>().build();
+  q.each([&](const flecs::entity& entity,
+             const components::Transform& transform) {
+    if (unsupported != nullptr) return;
+    entity.each([&](const flecs::id& id) {
+      const auto* type = registry.find(id.raw_id());
+      if (type != nullptr &&
+          std::ranges::find(stored, type->id) == stored.end()) {
+        unsupported = type;
+      }
+    });
+
+    const auto index = static_cast<uint32_t>(data.names.size());
+    data.names.emplace_back(entity.name().c_str());
+    data.transforms.push_back(transform);
+
+    if (const auto* mesh_renderer = entity.get<components::MeshRenderer>();
+        mesh_renderer != nullptr) {
+      data.mesh_entities.push_back(index);
+      data.mesh_paths.push_back(mesh_renderer->mesh_file().string());
+    }
+  });
+
+  if (unsupported != nullptr) {
+    spdlog::warn("Baked scenes can't store {} components", unsupported->name);
+    return std::unexpected(BakedSceneErrors::UnsupportedComponent);
+  }
+  return data;
+}
+
+}  // namespace
+
+auto serialize_baked(const std::shared_ptr<Scene>& scene,
+                     const std::filesystem::path& out_file) -> expected<void> {
+  ZoneScoped;
+  const auto data = extract(scene);
+  if (!data.has_value()) return std::unexpected(data.error());
+  return write(*data, out_file);
+}
+
+struct SceneLoader::Stream {
+  struct MeshLoad {
+    std::string path;
+    std::future<expected<std::shared_ptr<Mesh>>> mesh;
+  };
+
+  std::filesystem::path project_root;
+  std::shared_ptr<Scene> scene;
+  bool load_assets = true;
+
+  utils::MappedFile file;
+  BakedView view;
+
+  std::size_t next_entity = 0;
+  std::size_t next_mesh = 0;
+
+  //! @brief Entities waiting for each mesh, loaded once however many use it
+  std::unordered_map<std::string, std::vector<flecs::entity_t>> mesh_waiters;
+  std::deque<std::string> queued_meshes;
+  std::vector<MeshLoad> mesh_loads;
+
+  auto instantiate_batch() -> expected<void>;
+  void start_mesh_loads();
+  void finish_mesh_loads(bool wait);
+};
+
+auto SceneLoader::Stream::instantiate_batch() -> expected<void> {
+  ZoneScoped;
+
+  auto& world = scene->world();
+  const auto begin = next_entity;
+  const auto count =
+      std::min<std::size_t>(SceneLoader::kBatchSize, view.entity_count - begin);
+
+  // Names were checked on open, this only catches entities created since
+  bool all_named = true;
+  for (std::size_t i = begin; i < begin + count; ++i) {
+    const char* name = view.names.c_str(i);
+    if (*name == '\0') {
+      all_named = false;
+    } else if (ecs_lookup_child(world, 0, name) != 0) {
+      return std::unexpected(BakedSceneErrors::NameConflict);
+    }
+  }
+
+  // One table for the whole batch, the transforms are copied out of the
+  // mapping column by column. The name is added empty up front so naming an
+  // entity afterwards doesn't move it to another table.
+  ecs_bulk_desc_t desc{};
+  desc.count = static_cast<int32_t>(count);
+  desc.ids[0] = world.component<components::Transform>().id();
+  std::array<void*, 2> data = {view.transforms + begin, nullptr};
+  if (all_named) desc.ids[1] = ecs_pair(ecs_id(EcsIdentifier), EcsName);
+  desc.data = data.data();
+
+  const auto* created = ecs_bulk_init(world, &desc);
+  // Only valid until the next bulk operation
+  const std::vector<flecs::entity_t> entities(created, created + count);
+
+  for (std::size_t i = 0; i < count; ++i) {
+    const char* name = view.names.c_str(begin + i);
+    if (*name != '\0') flecs::entity(world, entities[i]).set_name(name);
+  }
+
+  // Mesh renderers are stored in entity order
+  while (next_mesh < view.mesh_entities.size() &&
+         view.mesh_entities[next_mesh] < begin + count) {
+    const auto entity = entities[view.mesh_entities[next_mesh] - begin];
+    const auto path = view.mesh_paths.view(next_mesh);
+    ++next_mesh;
+
+    flecs::entity(world, entity)
+        .set(components::MeshRenderer{std::filesystem::path{path}});
+    if (!load_assets) continue;
+
+    auto [waiters, inserted] = mesh_waiters.try_emplace(std::string{path});
+    waiters->second.push_back(entity);
+    if (inserted) queued_meshes.push_back(waiters->first);
+  }
+
+  next_entity = begin + count;
+  return {};
+}
+
+void SceneLoader::Stream::start_mesh_loads() {
+  const std::size_t max_loads =
+      std::max(std::thread::hardware_concurrency(), 2U) - 1;
+
+  while (!queued_meshes.empty() && mesh_loads.size() < max_loads) {
+    auto path = std::move(queued_meshes.front());
+    queued_meshes.pop_front();
+
+    auto mesh = std::async(std::launch::async,
+                           [file = project_root / path]() {
+                             return MeshCache::shared()->get(file);
+                           });
+    mesh_loads.push_back({std::move(path), std::move(mesh)});
+  }
+}
+
+void SceneLoader::Stream::finish_mesh_loads(bool wait) {
+  auto& world = scene->world();
+
+  std::erase_if(mesh_loads, [&](MeshLoad& load) {
+    if (!wait && load.mesh.wait_for(std::chrono::seconds(0)) !=
+                     std::future_status::ready) {
+      return false;
+    }
+
+    const auto mesh = load.mesh.get();
+    const auto waiters = mesh_waiters.extract(load.path);
+    if (!mesh.has_value()) {
+      spdlog::warn("Failed to load mesh {}: {}", load.path, mesh.error());
+      return true;
+    }
+
+    for (const auto entity : waiters.mapped()) {
+      if (!world.is_alive(entity)) continue;
+
+      flecs::entity e(world, entity);
+      auto* mesh_renderer = e.get_mut<components::MeshRenderer>();
+      // The mesh may have been swapped while this one was loading
+      if (mesh_renderer == nullptr ||
+          mesh_renderer->mesh_file() != load.path) {
+        continue;
+      }
+      mesh_renderer->set_mesh(mesh.value());
+      e.modified<components::MeshRenderer>();
+    }
+    return true;
+  });
+}
+
+auto SceneLoader::open(const std::filesystem::path& project_root,
+                       const std::filesystem::path& file,
+                       const std::shared_ptr<Scene>& scene, bool load_assets)
+    -> expected<std::shared_ptr<SceneLoader>> {
+  ZoneScoped;
+
+  auto mapped = utils::MappedFile::open(project_root / file);
+  if (!mapped.has_value()) return std::unexpected(mapped.error());
+  TRY_RESULT(const auto view, parse(mapped->mutable_data()));
+  TRY_RESULT(check_names(scene->world(), view.names));
+
+  auto stream = std::make_unique<Stream>();
+  stream->project_root = project_root;
+  stream->scene = scene;
+  stream->load_assets = load_assets;
+  // The view points into the mapping, which doesn't move with the file
+  stream->file = std::move(mapped.value());
+  stream->view = view;
+
+  return std::shared_ptr<SceneLoader>(new SceneLoader(std::move(stream)));
+}
+
+SceneLoader::SceneLoader(std::unique_ptr<Stream> stream)
+    : stream_(std::move(stream)) {}
+
+SceneLoader::~SceneLoader() = default;
+
+auto SceneLoader::update(std::chrono::microseconds budget) -> expected<void> {
+  ZoneScoped;
+
+  const auto deadline = std::chrono::steady_clock::now() + budget;
+  // At least one batch per call, however small the budget
+  do {
+    if (entities_done()) break;
+    TRY_RESULT(stream_->instantiate_batch());
+  } while (std::chrono::steady_clock::now() < deadline);
+
+  stream_->finish_mesh_loads(false);
+  stream_->start_mesh_loads();
+
+  return {};
+}
+
+auto SceneLoader::finish() -> expected<void> {
+  ZoneScoped;
+
+  while (!entities_done()) {
+    TRY_RESULT(stream_->instantiate_batch());
+  }
+
+  while (!done()) {
+    stream_->start_mesh_loads();
+    stream_->finish_mesh_loads(true);
+  }
+
+  return {};
+}
+
+auto SceneLoader::entities_done() const -> bool {
+  return stream_->next_entity >= stream_->view.entity_count;
+}
+
+auto SceneLoader::done() const -> bool {
+  return entities_done() && stream_->queued_meshes.empty() &&
+         stream_->mesh_loads.empty();
+}
+
+auto SceneLoader::entity_count() const -> std::size_t {
+  return stream_->view.entity_count;
+}
+
+auto SceneLoader::loaded_entities() const -> std::size_t {
+  return stream_->next_entity;
+}
+
+auto deserialize_baked(const std::filesystem::path& project_root,
+                       const std::filesystem::path& file,
+                       const std::shared_ptr<Scene>& scene, bool load_assets)
+    -> expected<void> {
+  ZoneScoped;
+
+  TRY_RESULT(const auto loader,
+             SceneLoader::open(project_root, file, scene, load_assets));
+  return loader->finish();
+}
+
+auto bake_scene(const std::filesystem::path& toml_file,
+                const std::filesystem::path& baked_file) -> expected<void> {
+  ZoneScoped;
+
+  const auto scene = Scene::create();
+  TRY_RESULT(deserialize(toml_file.parent_path(), toml_file.filename(), scene,
+                         false));
+  return serialize_baked(scene, baked_file);
+}
+
+auto unbake_scene(const std::filesystem::path& baked_file,
+                  const std::filesystem::path& toml_file) -> expected<void> {
+  ZoneScoped;
+
+  const auto scene = Scene::create();
+  TRY_RESULT(deserialize_baked(baked_file.parent_path(), baked_file.filename(),
+                               scene, false));
+  return serialize(scene, toml_file);
+}
+
+}  // namespace wren::scene
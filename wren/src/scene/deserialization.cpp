@@ -4,60 +4,64 @@
 
 #include <toml++/toml.hpp>
 
-#include "scene/components/mesh.hpp"
-#include "scene/components/transform.hpp"
 #include "scene/entity.hpp"
+#include "scene/registry.hpp"
 
 namespace wren::scene {
 
-void deserialize(const toml::table& table, components::Transform& transform);
-void deserialize(const toml::table& table,
-                 const std::filesystem::path& project_root,
-                 components::MeshRenderer& mesh_renderer);
-void deserialize(const toml::table& table, math::Vec3f& vec);
-
 auto deserialize(const std::filesystem::path& project_root,
                  const std::filesystem::path& file,
-                 const std::shared_ptr<Scene>& scene) -> expected<void> {
-  const auto table = toml::parse_file((project_root / file).string());
-
-  toml::array entities = *table["entities"].as_array();
-
-  for (const auto& e : entities) {
-    const auto& entity_table = *e.as_table();
-    auto entity = scene->create_entity(entity_table["name"].as_string()->get());
-
-    for (const auto& [key, val] : entity_table) {
-      if (key.str() == "transform") {
-        auto& t = entity.get_component<components::Transform>();
-        deserialize(*val.as_table(), t);
-      } else if (key.str() == "mesh_renderer") {
-        components::MeshRenderer mesh_renderer{};
-        deserialize(*val.as_table(), project_root, mesh_renderer);
-        entity.add_component<components::MeshRenderer>(mesh_renderer);
-      }
-    }
+                 const std::shared_ptr<Scene>& scene, bool load_assets)
+    -> expected<void> {
+  toml::table table;
+  try {
+    table = toml::parse_file((project_root / file).string());
+  } catch (const toml::parse_error& error) {
+    spdlog::error("Failed to parse {}: {}", file.string(),
+                  error.description());
+    return std::unexpected(SceneErrors::InvalidScene);
   }
 
-  return {};
-}
+  const auto* entities = table["entities"].as_array();
+  if (entities == nullptr) return std::unexpected(SceneErrors::InvalidScene);
 
-void deserialize(const toml::table& table, components::Transform& transform) {
-  deserialize(*table["position"].as_table(), transform.position);
-  deserialize(*table["rotation"].as_table(), transform.rotation);
-  deserialize(*table["scale"].as_table(), transform.scale);
-}
+  const auto& registry = scene->components();
+  auto& world = scene->world();
 
-void deserialize(const toml::table& table,
-                 const std::filesystem::path& project_root,
-                 components::MeshRenderer& mesh_renderer) {
-  mesh_renderer.update_mesh(project_root, *table["path"].value<std::string>());
-}
+  for (const auto& e : *entities) {
+    const auto* entity_table = e.as_table();
+    if (entity_table == nullptr) continue;
+
+    const auto entity =
+        scene
+            ->create_entity((*entity_table)["name"].value_or(std::string{}))
+            .handle();
 
-void deserialize(const toml::table& table, math::Vec3f& vec) {
-  vec.x(*table["x"].value<float>());
-  vec.y(*table["y"].value<float>());
-  vec.z(*table["z"].value<float>());
+    for (const auto& [key, val] : *entity_table) {
+      if (key.str() == "name") continue;
+
+      const auto* type = registry.find(key.str());
+      const auto* component_table = val.as_table();
+      if (type == nullptr || component_table == nullptr) {
+        spdlog::warn("Skipping unknown component {}", key.str());
+        continue;
+      }
+
+      // Adds the component default constructed if the entity doesn't have it
+      void* component = ecs_ensure_id(world, entity, type->id);
+      type->from_toml(*component_table, component);
+      if (load_assets && type->load_assets != nullptr) {
+        if (const auto result = type->load_assets(project_root, component);
+            !result.has_value()) {
+          spdlog::warn("Failed to load {} of {}: {}", type->name,
+                       entity.name().c_str(), result.error());
+        }
+      }
+      ecs_modified_id(world, entity, type->id);
+    }
+  }
+
+  return {};
 }
 
 }  // namespace wren::scene
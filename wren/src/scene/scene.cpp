@@ -1,11 +1,17 @@
 #include "scene/scene.hpp"
 
+#include "scene/components/mesh.hpp"
 #include "scene/components/tag.hpp"
 #include "scene/components/transform.hpp"
 #include "scene/entity.hpp"
 
 namespace wren::scene {
 
+Scene::Scene() {
+  components_.add<components::Transform>(ecs_, "transform");
+  components_.add<components::MeshRenderer>(ecs_, "mesh_renderer");
+}
+
 auto Scene::create_entity(const std::string& name) -> Entity {
   auto entity = ecs_.entity(name.c_str());
 
@@ -0,0 +1,420 @@
+#include "wren/texture.hpp"
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <boost/container_hash/hash.hpp>
+#include <cstring>
+#include <wren/math/texture.hpp>
+#include <wren/utils/scope_guard.hpp>
+#include <wren/vk/buffer.hpp>
+#include <wren/vk/result.hpp>
+
+#include "wren/utils/tracy.hpp"  // IWYU pragma: keep
+
+namespace wren {
+
+namespace {
+
+auto hash_settings(const TextureImportSettings& settings) -> std::size_t {
+  std::size_t seed = 0;
+  boost::hash_combine(seed, settings.compress);
+  boost::hash_combine(seed, settings.srgb);
+  return seed;
+}
+
+auto image_format(TextureFormat format, bool srgb, bool decompress)
+    -> ::vk::Format {
+  if (format == TextureFormat::Bc1 && !decompress) {
+    return srgb ? ::vk::Format::eBc1RgbaSrgbBlock
+                : ::vk::Format::eBc1RgbaUnormBlock;
+  }
+  return srgb ? ::vk::Format::eR8G8B8A8Srgb : ::vk::Format::eR8G8B8A8Unorm;
+}
+
+}  // namespace
+
+Texture::~Texture() { retire(); }
+
+auto Texture::resident_bytes() const -> std::size_t {
+  return image_.has_value() ? bytes_from(resident_mip_) : 0;
+}
+
+auto Texture::bytes_from(uint32_t first_mip) const -> std::size_t {
+  // BC1 is decoded before upload on devices that can't sample it
+  const bool decompress = file_.format() == TextureFormat::Bc1 &&
+                          !graphics_context_->Device().supports_bc_textures();
+  std::size_t size = 0;
+  for (uint32_t level = first_mip; level < file_.mip_count(); ++level) {
+    size += file_.mip_size(level, decompress);
+  }
+  return size;
+}
+
+auto Texture::make_resident(uint32_t first_mip, const ::vk::Sampler& sampler)
+    -> expected<void> {
+  ZoneScoped;
+
+  const auto& device = graphics_context_->Device();
+  const auto allocator = graphics_context_->allocator();
+  const bool decompress = file_.format() == TextureFormat::Bc1 &&
+                          !device.supports_bc_textures();
+  const auto format = image_format(file_.format(), file_.srgb(), decompress);
+  const auto levels = file_.mip_count() - first_mip;
+  const auto width = math::mip_extent(file_.width(), first_mip);
+  const auto height = math::mip_extent(file_.height(), first_mip);
+
+  // Every mip goes through one staging buffer and one copy
+  std::vector<std::byte> texels;
+  texels.reserve(bytes_from(first_mip));
+  std::vector<::vk::BufferImageCopy> regions;
+  for (uint32_t level = first_mip; level < file_.mip_count(); ++level) {
+    const auto mip_width = math::mip_extent(file_.width(), level);
+    const auto mip_height = math::mip_extent(file_.height(), level);
+    regions.emplace_back(
+        texels.size(), 0, 0,
+        ::vk::ImageSubresourceLayers(::vk::ImageAspectFlagBits::eColor,
+                                     level - first_mip, 0, 1),
+        ::vk::Offset3D{}, ::vk::Extent3D(mip_width, mip_height, 1));
+
+    const auto mip = file_.mip(level);
+    if (decompress) {
+      const auto pixels = math::decode_bc1(mip, mip_width, mip_height);
+      const auto* bytes = reinterpret_cast<const std::byte*>(pixels.data());
+      texels.insert(texels.end(), bytes, bytes + pixels.size());
+    } else {
+      texels.insert(texels.end(), mip.begin(), mip.end());
+    }
+  }
+
+  auto staging_buffer = vk::Buffer::create(
+      allocator, texels.size(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+      graphics_context_->deletion_queue());
+  TRY_RESULT(staging_buffer->set_data_raw(texels.data(), texels.size()));
+
+  TRY_RESULT(const auto image,
+             vk::Image::create(device.get(), allocator, format,
+                               math::Vec2f{static_cast<float>(width),
+                                           static_cast<float>(height)},
+                               ::vk::ImageUsageFlagBits::eSampled |
+                                   ::vk::ImageUsageFlagBits::eTransferDst,
+                               VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE, levels));
+
+  // Until the texture takes them over, returning early destroys them the way
+  // retire() does
+  ::vk::ImageView view;
+  std::optional<uint32_t> bindless_index;
+  utils::ScopeGuard destroy_image(
+      [&]() { destroy_later(image, view, bindless_index); });
+
+  const ::vk::ImageSubresourceRange range(::vk::ImageAspectFlagBits::eColor, 0,
+                                          levels, 0, 1);
+  VK_TIE_RESULT(view, device.get().createImageView(::vk::ImageViewCreateInfo(
+                          {}, image.get(), ::vk::ImageViewType::e2D, format,
+                          {}, range)));
+
+  if (const auto bindless = graphics_context_->bindless(); bindless) {
+    TRY_RESULT(bindless_index, bindless->add_image(view, sampler));
+  }
+
+  VK_TRY_RESULT(bufs, device.get().allocateCommandBuffers(
+                          {device.command_pool(),
+                           ::vk::CommandBufferLevel::ePrimary, 1}));
+  auto cmd = bufs.front();
+  // Never submitted when anything below fails, it can go right away
+  utils::ScopeGuard free_cmd([&]() {
+    device.get().freeCommandBuffers(device.command_pool(), cmd);
+  });
+  VK_CHECK_RESULT(cmd.begin(::vk::CommandBufferBeginInfo(
+      ::vk::CommandBufferUsageFlagBits::eOneTimeSubmit)));
+
+  const ::vk::ImageMemoryBarrier to_transfer(
+      {}, ::vk::AccessFlagBits::eTransferWrite, ::vk::ImageLayout::eUndefined,
+      ::vk::ImageLayout::eTransferDstOptimal, VK_QUEUE_FAMILY_IGNORED,
+      VK_QUEUE_FAMILY_IGNORED, image.get(), range);
+  cmd.pipelineBarrier(::vk::PipelineStageFlagBits::eTopOfPipe,
+                      ::vk::PipelineStageFlagBits::eTransfer, {}, {}, {},
+                      to_transfer);
+
+  cmd.copyBufferToImage(staging_buffer->get(), image.get(),
+                        ::vk::ImageLayout::eTransferDstOptimal, regions);
+
+  const ::vk::ImageMemoryBarrier to_shader(
+      ::vk::AccessFlagBits::eTransferWrite, ::vk::AccessFlagBits::eShaderRead,
+      ::vk::ImageLayout::eTransferDstOptimal,
+      ::vk::ImageLayout::eShaderReadOnlyOptimal, VK_QUEUE_FAMILY_IGNORED,
+      VK_QUEUE_FAMILY_IGNORED, image.get(), range);
+  cmd.pipelineBarrier(::vk::PipelineStageFlagBits::eTransfer,
+                      ::vk::PipelineStageFlagBits::eAllCommands, {}, {}, {},
+                      to_shader);
+
+  VK_CHECK_RESULT(cmd.end());
+
+  // Frames submitted after this wait for the copy through the barrier, the
+  // upload never blocks the CPU. The staging buffer is retired with it.
+  vk::Submission submission;
+  submission.command_buffers.push_back(cmd);
+  TRY_RESULT(const auto point,
+             graphics_context_->graphics_queue()->submit(submission));
+  free_cmd.dismiss();
+  graphics_context_->deletion_queue()->push(
+      point.value,
+      [device = device.get(), pool = device.command_pool(), cmd]() {
+        device.freeCommandBuffers(pool, cmd);
+      });
+
+  destroy_image.dismiss();
+  retire();
+  image_ = image;
+  view_ = view;
+  bindless_index_ = bindless_index;
+  resident_mip_ = first_mip;
+
+  return {};
+}
+
+void Texture::retire() {
+  if (!image_.has_value()) return;
+
+  destroy_later(*image_, view_, bindless_index_);
+
+  image_.reset();
+  view_ = nullptr;
+  bindless_index_.reset();
+}
+
+void Texture::destroy_later(const vk::Image& image, ::vk::ImageView view,
+                            std::optional<uint32_t> bindless_index) const {
+  // In flight frames may still sample the image or its heap slot
+  graphics_context_->deletion_queue()->push(
+      [device = graphics_context_->Device().get(),
+       allocator = graphics_context_->allocator(),
+       bindless = graphics_context_->bindless(), image, view,
+       index = bindless_index]() {
+        if (bindless && index.has_value()) bindless->remove_image(*index);
+        if (view) device.destroyImageView(view);
+        image.destroy(device, allocator);
+      });
+}
+
+auto TextureStreamer::create(
+    const std::shared_ptr<GraphicsContext>& graphics_context,
+    const Options& options) -> expected<std::shared_ptr<TextureStreamer>> {
+  std::shared_ptr<TextureStreamer> streamer(
+      new TextureStreamer(graphics_context, options));
+
+  // Images only hold their resident mips, so the whole chain of the image
+  // is always valid to sample
+  ::vk::SamplerCreateInfo sampler_info(
+      {}, ::vk::Filter::eLinear, ::vk::Filter::eLinear,
+      ::vk::SamplerMipmapMode::eLinear, ::vk::SamplerAddressMode::eRepeat,
+      ::vk::SamplerAddressMode::eRepeat, ::vk::SamplerAddressMode::eRepeat);
+  sampler_info.setMaxLod(VK_LOD_CLAMP_NONE);
+  VK_TIE_RESULT(streamer->sampler_,
+                graphics_context->Device().get().createSampler(sampler_info));
+
+  return streamer;
+}
+
+TextureStreamer::~TextureStreamer() {
+  graphics_context_->deletion_queue()->push(
+      [device = graphics_context_->Device().get(), sampler = sampler_]() {
+        device.destroySampler(sampler);
+      });
+}
+
+void TextureStreamer::database(std::shared_ptr<assets::Database> database) {
+  std::scoped_lock lock(mutex_);
+  database_ = std::move(database);
+}
+
+auto TextureStreamer::load(const std::filesystem::path& file,
+                           const TextureImportSettings& settings)
+    -> expected<std::shared_ptr<Texture>> {
+  ZoneScoped;
+
+  auto imported = import(file, settings);
+  if (!imported.has_value()) return std::unexpected(imported.error());
+
+  std::shared_ptr<Texture> texture(
+      new Texture(graphics_context_, std::move(*imported)));
+  TRY_RESULT(texture->make_resident(tail_mip(*texture), sampler_));
+
+  std::scoped_lock lock(mutex_);
+  textures_.push_back(texture);
+  return texture;
+}
+
+auto TextureStreamer::import(const std::filesystem::path& file,
+                             const TextureImportSettings& settings)
+    -> expected<TextureFile> {
+  std::shared_ptr<assets::Database> database;
+  {
+    std::scoped_lock lock(mutex_);
+    database = database_;
+  }
+
+  // Different settings make different textures out of the same source
+  const auto kind = [&settings](std::size_t seed) {
+    boost::hash_combine(seed, hash_settings(settings));
+    return fmt::format("{:x}.{}", seed, kTextureFileExtension);
+  };
+
+  std::optional<uint64_t> source_hash;
+  std::optional<std::filesystem::path> artifact;
+  if (database != nullptr) {
+    const auto hash = database->hash(file);
+    const auto path = database->artifact(file, kind(0));
+    if (hash.has_value() && path.has_value()) {
+      source_hash = *hash;
+      artifact = *path;
+    }
+  }
+  if (!artifact.has_value()) {
+    // Without a database the source is identified by its path and write
+    // time instead of its contents
+    std::error_code ec;
+    const auto write_time = std::filesystem::last_write_time(file, ec);
+    if (ec) return std::unexpected(ec);
+    std::size_t seed = std::hash<std::string>{}(
+        std::filesystem::absolute(file).lexically_normal().string());
+    boost::hash_combine(seed, write_time.time_since_epoch().count());
+    source_hash = seed;
+    artifact =
+        std::filesystem::temp_directory_path() / "wren" / "textures" /
+        kind(seed);
+  }
+
+  if (std::filesystem::exists(*artifact)) {
+    auto cached = TextureFile::open(*artifact, *source_hash);
+    if (cached.has_value()) return cached;
+    spdlog::warn("Ignoring texture cache {}: {}", artifact->string(),
+                 cached.error());
+  }
+
+  TRY_RESULT(const auto image, load_tga(file));
+  TRY_RESULT(write_texture_file(image, settings, *source_hash, *artifact));
+  return TextureFile::open(*artifact, *source_hash);
+}
+
+void TextureStreamer::request(const std::shared_ptr<Texture>& texture,
+                              float screen_pixels) {
+  const auto mip = math::mip_for_screen_size(
+      std::max(texture->width(), texture->height()), screen_pixels,
+      texture->mip_count());
+
+  std::scoped_lock lock(mutex_);
+  if (texture->requested_update_ != update_) {
+    texture->requested_update_ = update_;
+    texture->wanted_mip_ = mip;
+  } else {
+    texture->wanted_mip_ = std::min(texture->wanted_mip_, mip);
+  }
+}
+
+auto TextureStreamer::update() -> expected<void> {
+  ZoneScoped;
+
+  std::scoped_lock lock(mutex_);
+
+  std::vector<std::shared_ptr<Texture>> textures;
+  std::erase_if(textures_, [&textures](const auto& weak) {
+    auto texture = weak.lock();
+    if (texture == nullptr) return true;
+    textures.push_back(std::move(texture));
+    return false;
+  });
+
+  // Requested textures go to the mip they asked for, the rest keep theirs
+  // for a while and then fall back to the tail
+  const auto target = [this](const Texture& texture) {
+    const auto tail = tail_mip(texture);
+    if (texture.requested_update_ == update_) {
+      return std::min(texture.wanted_mip_, tail);
+    }
+    if (update_ - texture.requested_update_ <= options_.keep_updates) {
+      return std::min(texture.resident_mip_, tail);
+    }
+    return tail;
+  };
+
+  std::vector<std::shared_ptr<Texture>> missing;
+  std::vector<std::shared_ptr<Texture>> surplus;
+  std::size_t resident = 0;
+  for (const auto& texture : textures) {
+    resident += texture->resident_bytes();
+    const auto mip = target(*texture);
+    if (mip < texture->resident_mip_) missing.push_back(texture);
+    if (mip > texture->resident_mip_) surplus.push_back(texture);
+  }
+
+  // The blurriest first, and room is made by dropping mips from the
+  // textures requested least recently
+  std::ranges::sort(missing, std::greater{}, [&](const auto& texture) {
+    return texture->resident_mip_ - target(*texture);
+  });
+  std::ranges::sort(surplus, std::less{}, [](const auto& texture) {
+    return texture->requested_update_;
+  });
+
+  std::size_t uploaded = 0;
+  auto next_surplus = surplus.begin();
+  const auto fits = [&](const Texture& texture, uint32_t mip) {
+    return resident - texture.resident_bytes() + texture.bytes_from(mip) <=
+           options_.budget;
+  };
+  const auto make_resident = [&](Texture& texture,
+                                 uint32_t mip) -> expected<void> {
+    const auto before = texture.resident_bytes();
+    TRY_RESULT(texture.make_resident(mip, sampler_));
+    resident = resident - before + texture.resident_bytes();
+    uploaded += texture.resident_bytes();
+    return {};
+  };
+
+  for (const auto& texture : missing) {
+    auto mip = target(*texture);
+    if (uploaded > 0 &&
+        uploaded + texture->bytes_from(mip) > options_.upload_budget) {
+      break;
+    }
+
+    while (!fits(*texture, mip) && next_surplus != surplus.end()) {
+      const auto& victim = *next_surplus++;
+      TRY_RESULT(make_resident(*victim, target(*victim)));
+    }
+
+    // What still doesn't fit is streamed in as fine as it can be
+    while (mip < texture->resident_mip_ && !fits(*texture, mip)) ++mip;
+    if (mip < texture->resident_mip_) {
+      TRY_RESULT(make_resident(*texture, mip));
+    }
+  }
+
+  ++update_;
+  return {};
+}
+
+auto TextureStreamer::resident_bytes() const -> std::size_t {
+  std::scoped_lock lock(mutex_);
+  std::size_t bytes = 0;
+  for (const auto& weak : textures_) {
+    if (const auto texture = weak.lock()) bytes += texture->resident_bytes();
+  }
+  return bytes;
+}
+
+auto TextureStreamer::tail_mip(const Texture& texture) const -> uint32_t {
+  uint32_t mip = 0;
+  while (mip + 1 < texture.mip_count() &&
+         std::max(math::mip_extent(texture.width(), mip),
+                  math::mip_extent(texture.height(), mip)) >
+             options_.tail_size) {
+    ++mip;
+  }
+  return mip;
+}
+
+}  // namespace wren
@@ -0,0 +1,302 @@
+#include "wren/texture_file.hpp"
+
+#include <fmt/format.h>
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <type_traits>
+#include <wren/math/texture.hpp>
+
+#include "wren/utils/tracy.hpp"  // IWYU pragma: keep
+
+namespace wren {
+
+namespace {
+
+constexpr std::array<char, 4> kMagic = {'W', 'T', 'E', 'X'};
+constexpr uint64_t kSectionAlignment = 16;
+
+struct Header {
+  std::array<char, 4> magic = kMagic;
+  uint32_t version = kTextureFileVersion;
+  uint64_t source_hash = 0;
+  TextureFormat format = TextureFormat::Rgba8;
+  uint32_t srgb = 0;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t mip_count = 0;
+  uint32_t padding = 0;
+};
+static_assert(std::is_trivially_copyable_v<Header>);
+
+//! @brief Follows the header, one per mip
+struct MipEntry {
+  uint64_t offset = 0;
+  uint64_t size = 0;
+};
+
+auto align_up(uint64_t offset) -> uint64_t {
+  return (offset + kSectionAlignment - 1) / kSectionAlignment *
+         kSectionAlignment;
+}
+
+auto mip_bytes(TextureFormat format, uint32_t width, uint32_t height)
+    -> uint64_t {
+  return format == TextureFormat::Bc1
+             ? math::bc1_size(width, height)
+             : static_cast<uint64_t>(width) * height * 4;
+}
+
+//! @brief Run length encoded TGAs repeat or copy up to 128 pixels per packet
+auto decode_rle(std::span<const uint8_t> data, std::size_t pixel_size,
+                std::size_t pixel_count) -> std::vector<uint8_t> {
+  std::vector<uint8_t> out;
+  out.reserve(pixel_count * pixel_size);
+  std::size_t i = 0;
+  while (out.size() < pixel_count * pixel_size && i < data.size()) {
+    const auto packet = data[i++];
+    const std::size_t count = (packet & 0x7FU) + 1;
+    const bool repeat = (packet & 0x80U) != 0;
+    const auto bytes = repeat ? pixel_size : count * pixel_size;
+    if (data.size() - i < bytes) break;
+
+    for (std::size_t p = 0; p < count; ++p) {
+      const auto* pixel = &data[i + (repeat ? 0 : p * pixel_size)];
+      out.insert(out.end(), pixel, pixel + pixel_size);
+    }
+    i += bytes;
+  }
+  out.resize(pixel_count * pixel_size);
+  return out;
+}
+
+}  // namespace
+
+auto load_tga(const std::filesystem::path& file) -> expected<RgbaImage> {
+  ZoneScoped;
+
+  auto mapped = utils::MappedFile::open(file);
+  if (!mapped.has_value()) return std::unexpected(mapped.error());
+  const auto bytes = mapped->data();
+
+  constexpr std::size_t kHeaderSize = 18;
+  if (bytes.size() < kHeaderSize) {
+    return std::unexpected(TextureFileErrors::UnsupportedImage);
+  }
+  const std::span data(reinterpret_cast<const uint8_t*>(bytes.data()),
+                       bytes.size());
+
+  const auto id_length = data[0];
+  const auto colour_map_type = data[1];
+  const auto image_type = data[2];
+  const uint32_t width = data[12] | (data[13] << 8U);
+  const uint32_t height = data[14] | (data[15] << 8U);
+  const auto bits = data[16];
+  const auto descriptor = data[17];
+
+  // 2 and 3 are true colour and greyscale, 10 and 11 the same run length
+  // encoded. Colour mapped images aren't supported.
+  const bool rle = image_type == 10 || image_type == 11;
+  const bool grey = image_type == 3 || image_type == 11;
+  const bool valid_bits = grey ? bits == 8 : bits == 24 || bits == 32;
+  if (colour_map_type != 0 || (image_type & ~8U) < 2 ||
+      (image_type & ~8U) > 3 || !valid_bits || width == 0 || height == 0) {
+    return std::unexpected(TextureFileErrors::UnsupportedImage);
+  }
+
+  const std::size_t pixel_size = bits / 8;
+  const std::size_t pixel_count = static_cast<std::size_t>(width) * height;
+  const auto body = data.subspan(std::min(kHeaderSize + id_length,
+                                          data.size()));
+  std::vector<uint8_t> raw;
+  if (rle) {
+    raw = decode_rle(body, pixel_size, pixel_count);
+  } else {
+    if (body.size() < pixel_count * pixel_size) {
+      return std::unexpected(TextureFileErrors::UnsupportedImage);
+    }
+    raw.assign(body.begin(), body.begin() + pixel_count * pixel_size);
+  }
+
+  // Rows are stored from the bottom unless the descriptor says otherwise
+  const bool top_down = (descriptor & 0x20U) != 0;
+  RgbaImage image{.width = width,
+                  .height = height,
+                  .pixels = std::vector<uint8_t>(pixel_count * 4)};
+  for (uint32_t y = 0; y < height; ++y) {
+    const auto row = top_down ? y : height - 1 - y;
+    for (uint32_t x = 0; x < width; ++x) {
+      const auto* in = &raw[(static_cast<std::size_t>(row) * width + x) *
+                            pixel_size];
+      auto* out = &image.pixels[(static_cast<std::size_t>(y) * width + x) * 4];
+      if (grey) {
+        out[0] = out[1] = out[2] = in[0];
+        out[3] = 255;
+      } else {
+        // Stored as BGR(A)
+        out[0] = in[2];
+        out[1] = in[1];
+        out[2] = in[0];
+        out[3] = pixel_size == 4 ? in[3] : 255;
+      }
+    }
+  }
+  return image;
+}
+
+auto write_texture_file(const RgbaImage& image,
+                        const TextureImportSettings& settings,
+                        uint64_t source_hash,
+                        const std::filesystem::path& file) -> expected<void> {
+  ZoneScoped;
+
+  if (image.width == 0 || image.height == 0 ||
+      image.pixels.size() !=
+          static_cast<std::size_t>(image.width) * image.height * 4) {
+    return std::unexpected(TextureFileErrors::UnsupportedImage);
+  }
+
+  const auto format =
+      settings.compress ? TextureFormat::Bc1 : TextureFormat::Rgba8;
+  const Header header{
+      .source_hash = source_hash,
+      .format = format,
+      .srgb = settings.srgb ? 1U : 0U,
+      .width = image.width,
+      .height = image.height,
+      .mip_count = math::mip_count(image.width, image.height),
+  };
+
+  std::vector<MipEntry> entries(header.mip_count);
+  std::vector<std::byte> bytes(
+      align_up(sizeof(Header) + entries.size() * sizeof(MipEntry)));
+
+  // Each level is filtered from the one above it
+  std::vector<uint8_t> pixels = image.pixels;
+  for (uint32_t level = 0; level < header.mip_count; ++level) {
+    const auto width = math::mip_extent(image.width, level);
+    const auto height = math::mip_extent(image.height, level);
+    if (level > 0) {
+      pixels = math::downsample_rgba8(
+          pixels, math::mip_extent(image.width, level - 1),
+          math::mip_extent(image.height, level - 1), settings.srgb);
+    }
+
+    auto& entry = entries.at(level);
+    entry.offset = bytes.size();
+    entry.size = mip_bytes(format, width, height);
+    if (format == TextureFormat::Bc1) {
+      const auto blocks = math::encode_bc1(pixels, width, height);
+      bytes.insert(bytes.end(), blocks.begin(), blocks.end());
+    } else {
+      const auto* texels = reinterpret_cast<const std::byte*>(pixels.data());
+      bytes.insert(bytes.end(), texels, texels + pixels.size());
+    }
+    bytes.resize(align_up(bytes.size()));
+  }
+
+  std::memcpy(bytes.data(), &header, sizeof(header));
+  std::memcpy(bytes.data() + sizeof(header), entries.data(),
+              entries.size() * sizeof(MipEntry));
+
+  std::error_code ec;
+  std::filesystem::create_directories(file.parent_path(), ec);
+
+  // Renamed over the destination like mesh files, readers never see half a
+  // file
+  auto temporary = file;
+  temporary += fmt::format(
+      ".{:x}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+  {
+    std::ofstream out(temporary, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(bytes.data()),
+              static_cast<std::streamsize>(bytes.size()));
+    if (!out) {
+      return std::unexpected(std::make_error_code(std::errc::io_error));
+    }
+  }
+
+  std::filesystem::rename(temporary, file, ec);
+  if (ec) {
+    std::filesystem::remove(temporary, ec);
+    return std::unexpected(std::make_error_code(std::errc::io_error));
+  }
+
+  return {};
+}
+
+auto TextureFile::open(const std::filesystem::path& file, uint64_t source_hash)
+    -> expected<TextureFile> {
+  ZoneScoped;
+
+  auto mapped = utils::MappedFile::open(file);
+  if (!mapped.has_value()) return std::unexpected(mapped.error());
+  const auto bytes = mapped->data();
+
+  Header header;
+  if (bytes.size() < sizeof(header)) {
+    return std::unexpected(TextureFileErrors::NotATextureFile);
+  }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (header.magic != kMagic) {
+    return std::unexpected(TextureFileErrors::NotATextureFile);
+  }
+  if (header.version != kTextureFileVersion) {
+    return std::unexpected(TextureFileErrors::UnsupportedVersion);
+  }
+  if (header.source_hash != source_hash) {
+    return std::unexpected(TextureFileErrors::StaleSource);
+  }
+
+  if ((header.format != TextureFormat::Rgba8 &&
+       header.format != TextureFormat::Bc1) ||
+      header.width == 0 || header.height == 0 ||
+      header.mip_count != math::mip_count(header.width, header.height) ||
+      bytes.size() <
+          sizeof(Header) + header.mip_count * sizeof(MipEntry)) {
+    return std::unexpected(TextureFileErrors::Corrupt);
+  }
+
+  std::vector<MipEntry> entries(header.mip_count);
+  std::memcpy(entries.data(), bytes.data() + sizeof(Header),
+              entries.size() * sizeof(MipEntry));
+
+  TextureFile texture(std::move(*mapped));
+  texture.format_ = header.format;
+  texture.srgb_ = header.srgb != 0;
+  texture.width_ = header.width;
+  texture.height_ = header.height;
+
+  // Checked once here so uploads never read past the mapping
+  for (uint32_t level = 0; level < header.mip_count; ++level) {
+    const auto& entry = entries.at(level);
+    const auto expected_size =
+        mip_bytes(header.format, math::mip_extent(header.width, level),
+                  math::mip_extent(header.height, level));
+    if (entry.size != expected_size || entry.offset > bytes.size() ||
+        entry.size > bytes.size() - entry.offset) {
+      return std::unexpected(TextureFileErrors::Corrupt);
+    }
+    texture.mips_.push_back({.offset = entry.offset, .size = entry.size});
+  }
+
+  return texture;
+}
+
+auto TextureFile::mip(uint32_t level) const -> std::span<const std::byte> {
+  const auto& entry = mips_.at(level);
+  return file_.data().subspan(entry.offset, entry.size);
+}
+
+auto TextureFile::mip_size(uint32_t level, bool decompress) const
+    -> std::size_t {
+  if (format_ == TextureFormat::Bc1 && decompress) {
+    return static_cast<std::size_t>(math::mip_extent(width_, level)) *
+           math::mip_extent(height_, level) * 4;
+  }
+  return mips_.at(level).size;
+}
+
+}  // namespace wren
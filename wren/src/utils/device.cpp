@@ -3,11 +3,14 @@
 #include <spdlog/spdlog.h>
 #include <vulkan/vulkan_core.h>
 
+#include <set>
 #include <vulkan/vulkan_enums.hpp>
 #include <vulkan/vulkan_structs.hpp>
+#include <wren/vk/bindless.hpp>
 #include <wren/vk/result.hpp>
 
 #include "wren/utils/queue.hpp"
+#include "wren/utils/vulkan.hpp"
 
 namespace wren::vulkan {
 
@@ -28,20 +31,98 @@ auto Device::create_device(const ::vk::Instance &instance,
   const auto indices =
       Queue::find_queue_family_indices(physical_device, surface);
 
+  // One queue per distinct family
   float queue_prio = 0.0f;
-  ::vk::DeviceQueueCreateInfo queue_create_info({}, indices->graphics_index, 1,
-                                                &queue_prio);
-  std::array extensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-                           VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME};
+  std::set<uint32_t> families = {indices->graphics_index,
+                                 indices->present_index};
+  if (indices->compute_index.has_value()) {
+    families.insert(indices->compute_index.value());
+  }
+
+  std::vector<::vk::DeviceQueueCreateInfo> queue_create_infos;
+  for (const auto family : families) {
+    queue_create_infos.emplace_back(::vk::DeviceQueueCreateFlags{}, family, 1,
+                                    &queue_prio);
+  }
+  std::vector<const char *> extensions = {
+      VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME};
 
   {
     auto features2 =
         physical_device
             .getFeatures2< ::vk::PhysicalDeviceFeatures2,
-                           ::vk::PhysicalDeviceImagelessFramebufferFeatures>();
+                           ::vk::PhysicalDeviceImagelessFramebufferFeatures,
+                           ::vk::PhysicalDeviceDescriptorIndexingFeatures,
+                           ::vk::PhysicalDeviceDynamicRenderingFeatures,
+                           ::vk::PhysicalDeviceTimelineSemaphoreFeatures>();
+
+    // Core in 1.2, every submit is tracked with them
+    if (!features2.get< ::vk::PhysicalDeviceTimelineSemaphoreFeatures>()
+             .timelineSemaphore) {
+      return std::unexpected(
+          make_error_code(::vk::Result::eErrorFeatureNotPresent));
+    }
+
+    // Descriptor indexing is core in 1.2 but the extension still has to be
+    // enabled on drivers that only expose it that way
+    bindless_ = vk::BindlessHeap::is_supported(
+        features2.get< ::vk::PhysicalDeviceDescriptorIndexingFeatures>());
+    if (bindless_ && is_device_extension_supported(
+                         VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
+                         physical_device)) {
+      extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+    }
+    spdlog::debug("Bindless descriptors {}",
+                  bindless_ ? "supported" : "not supported");
+
+    // Dynamic rendering is an extension on 1.2, without it passes fall back
+    // to render pass and framebuffer objects
+    dynamic_rendering_ =
+        features2.get< ::vk::PhysicalDeviceDynamicRenderingFeatures>()
+            .dynamicRendering &&
+        is_device_extension_supported(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
+                                      physical_device);
+    if (dynamic_rendering_) {
+      extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+    } else {
+      features2.unlink< ::vk::PhysicalDeviceDynamicRenderingFeatures>();
+    }
+    spdlog::debug("Dynamic rendering {}",
+                  dynamic_rendering_ ? "supported" : "not supported");
 
-    ::vk::DeviceCreateInfo create_info({}, queue_create_info, {}, extensions,
-                                       {}, &features2);
+    // Without it textures are decompressed before upload
+    bc_textures_ = features2.get< ::vk::PhysicalDeviceFeatures2>()
+                       .features.textureCompressionBC;
+    spdlog::debug("BC textures {}",
+                  bc_textures_ ? "supported" : "not supported");
+
+    if (features2.get< ::vk::PhysicalDeviceFeatures2>()
+            .features.multiDrawIndirect) {
+      max_draw_indirect_count_ =
+          physical_device.getProperties().limits.maxDrawIndirectCount;
+    }
+    draw_indirect_first_instance_ =
+        features2.get< ::vk::PhysicalDeviceFeatures2>()
+            .features.drawIndirectFirstInstance;
+
+    // Draw counts read from a buffer, without it GPU culling draws every
+    // instance and culled ones with an instance count of 0
+    draw_indirect_count_ = is_device_extension_supported(
+        VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME, physical_device);
+    if (draw_indirect_count_) {
+      extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    }
+    spdlog::debug("Draw indirect count {}",
+                  draw_indirect_count_ ? "supported" : "not supported");
+
+    // Everything supported gets enabled, except bounds checking on every
+    // buffer access
+    features2.get< ::vk::PhysicalDeviceFeatures2>()
+        .features.robustBufferAccess = ::vk::False;
+
+    ::vk::DeviceCreateInfo create_info(
+        {}, queue_create_infos, {}, extensions, {},
+        &features2.get< ::vk::PhysicalDeviceFeatures2>());
     auto res = physical_device.createDevice(create_info);
     if (res.result != ::vk::Result::eSuccess)
       return std::unexpected(make_error_code(res.result));
@@ -51,6 +132,11 @@ auto Device::create_device(const ::vk::Instance &instance,
 
   graphics_queue_ = device_.getQueue(indices->graphics_index, 0);
   present_queue_ = device_.getQueue(indices->present_index, 0);
+  if (indices->compute_index.has_value()) {
+    compute_queue_ = device_.getQueue(indices->compute_index.value(), 0);
+    spdlog::debug("Async compute on queue family {}",
+                  indices->compute_index.value());
+  }
 
   {
     const ::vk::CommandPoolCreateInfo create_info({}, indices->graphics_index);
@@ -17,10 +17,17 @@ auto Queue::find_queue_family_indices(
 
   std::optional<uint32_t> graphics_family;
   std::optional<uint32_t> present_family;
+  std::optional<uint32_t> compute_family;
   uint32_t i = 0;
   for (const auto &f : queue_families) {
     if (f.queueFlags & ::vk::QueueFlagBits::eGraphics) graphics_family = i;
 
+    if (!compute_family.has_value() &&
+        (f.queueFlags & ::vk::QueueFlagBits::eCompute) &&
+        !(f.queueFlags & ::vk::QueueFlagBits::eGraphics)) {
+      compute_family = i;
+    }
+
     if (surface.has_value()) {
       auto res = physical_device.getSurfaceSupportKHR(i, surface.value());
       if (res.result != ::vk::Result::eSuccess)
@@ -43,7 +50,11 @@ auto Queue::find_queue_family_indices(
       return std::unexpected(
           make_error_code(VulkanErrors::QueueFamilyNotSupported));
 
-  return QueueFamilyIndices{.graphics_index = graphics_family.value()};
+  return QueueFamilyIndices{
+      .graphics_index = graphics_family.value(),
+      .present_index = present_family.value_or(graphics_family.value()),
+      .compute_index = compute_family,
+  };
 }
 
 }  // namespace wren::vulkan
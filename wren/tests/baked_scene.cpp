@@ -0,0 +1,238 @@
+#include <boost/describe.hpp>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <wren/scene/baked.hpp>
+#include <wren/scene/components/mesh.hpp>
+#include <wren/scene/components/transform.hpp>
+#include <wren/scene/entity.hpp>
+#include <wren/scene/scene.hpp>
+
+namespace {
+
+namespace components = wren::scene::components;
+
+//! @brief A registered component the baked format has no column for
+struct Health {
+  int32_t value = 100;
+};
+BOOST_DESCRIBE_STRUCT(Health, (), (value))
+
+// Layout of version 1 baked scenes, the names are the first column
+constexpr std::size_t kHeaderSize = 16;
+constexpr std::size_t kEntityCountOffset = 8;
+constexpr std::size_t kColumnOffsetOffset = kHeaderSize + 8;
+constexpr std::size_t kColumnSizeOffset = kHeaderSize + 16;
+
+auto temp_dir() {
+  const auto dir = std::filesystem::temp_directory_path() / "wren_baked_scene";
+  std::filesystem::create_directories(dir);
+  return dir;
+}
+
+auto read_file(const std::filesystem::path& file) -> std::vector<char> {
+  std::ifstream in(file, std::ios::binary);
+  return {std::istreambuf_iterator<char>(in), {}};
+}
+
+void write_file(const std::filesystem::path& file,
+                const std::vector<char>& bytes) {
+  std::ofstream out(file, std::ios::binary);
+  out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+template <typename T>
+auto read_at(const std::vector<char>& bytes, std::size_t offset) -> T {
+  T value{};
+  std::memcpy(&value, bytes.data() + offset, sizeof(T));
+  return value;
+}
+
+template <typename T>
+void write_at(std::vector<char>& bytes, std::size_t offset, T value) {
+  std::memcpy(bytes.data() + offset, &value, sizeof(T));
+}
+
+//! @brief Two entities, one with a mesh renderer, baked to scene.wscene
+auto bake_test_scene() -> std::filesystem::path {
+  const auto scene = wren::scene::Scene::create();
+
+  auto cube = scene->create_entity("cube");
+  cube.get_component<components::Transform>().position = {1, 2, 3};
+  cube.add_component<components::MeshRenderer>(
+      std::filesystem::path{"meshes/cube.stl"});
+
+  auto empty = scene->create_entity("empty");
+  empty.get_component<components::Transform>().rotation = {0, 1.5F, 0};
+
+  const auto file = temp_dir() / "scene.wscene";
+  BOOST_REQUIRE(wren::scene::serialize_baked(scene, file).has_value());
+  return file;
+}
+
+//! @brief Load a patched copy of file, which has to fail with error
+void check_rejected(const std::filesystem::path& file,
+                    const std::vector<char>& bytes,
+                    wren::scene::BakedSceneErrors error) {
+  const auto patched = file.parent_path() / "patched.wscene";
+  write_file(patched, bytes);
+
+  const auto scene = wren::scene::Scene::create();
+  const auto result = wren::scene::deserialize_baked(
+      patched.parent_path(), patched.filename(), scene, false);
+  BOOST_REQUIRE(!result.has_value());
+  BOOST_TEST((result.error().error() == make_error_code(error)));
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(baked_scene)
+
+BOOST_AUTO_TEST_CASE(RoundTrips) {
+  const auto file = bake_test_scene();
+
+  const auto scene = wren::scene::Scene::create();
+  BOOST_REQUIRE(wren::scene::deserialize_baked(file.parent_path(),
+                                               file.filename(), scene, false)
+                    .has_value());
+
+  const auto cube = scene->world().lookup("cube");
+  BOOST_REQUIRE(cube.is_valid());
+  const auto* transform = cube.get<components::Transform>();
+  BOOST_REQUIRE(transform != nullptr);
+  BOOST_TEST(transform->position.x() == 1.0F);
+  BOOST_TEST(transform->position.y() == 2.0F);
+  BOOST_TEST(transform->position.z() == 3.0F);
+  const auto* mesh_renderer = cube.get<components::MeshRenderer>();
+  BOOST_REQUIRE(mesh_renderer != nullptr);
+  BOOST_TEST(mesh_renderer->mesh_file() == "meshes/cube.stl");
+
+  const auto empty = scene->world().lookup("empty");
+  BOOST_REQUIRE(empty.is_valid());
+  BOOST_TEST(empty.get<components::Transform>()->rotation.y() == 1.5F);
+  BOOST_TEST(!empty.has<components::MeshRenderer>());
+
+  std::filesystem::remove_all(file.parent_path());
+}
+
+BOOST_AUTO_TEST_CASE(RefusesComponentsWithoutAColumn) {
+  const auto scene = wren::scene::Scene::create();
+  scene->components().add<Health>(scene->world(), "health");
+  scene->create_entity("player").add_component<Health>();
+
+  const auto file = temp_dir() / "unsupported.wscene";
+  const auto result = wren::scene::serialize_baked(scene, file);
+  BOOST_REQUIRE(!result.has_value());
+  BOOST_TEST((result.error().error() ==
+              make_error_code(
+                  wren::scene::BakedSceneErrors::UnsupportedComponent)));
+  BOOST_TEST(!std::filesystem::exists(file));
+
+  std::filesystem::remove_all(file.parent_path());
+}
+
+BOOST_AUTO_TEST_CASE(RejectsBadHeaders) {
+  const auto file = bake_test_scene();
+  const auto bytes = read_file(file);
+
+  auto magic = bytes;
+  magic[0] = 'X';
+  check_rejected(file, magic, wren::scene::BakedSceneErrors::NotABakedScene);
+
+  auto version = bytes;
+  write_at<uint32_t>(version, 4, wren::scene::kBakedSceneVersion + 1);
+  check_rejected(file, version,
+                 wren::scene::BakedSceneErrors::UnsupportedVersion);
+
+  // More columns than the file has room for
+  auto columns = bytes;
+  write_at<uint32_t>(columns, 12, 1U << 24U);
+  check_rejected(file, columns, wren::scene::BakedSceneErrors::Corrupt);
+
+  std::filesystem::remove_all(file.parent_path());
+}
+
+BOOST_AUTO_TEST_CASE(RejectsCorruptOffsets) {
+  const auto file = bake_test_scene();
+  const auto bytes = read_file(file);
+  const auto offset = read_at<uint64_t>(bytes, kColumnOffsetOffset);
+
+  auto past_end = bytes;
+  write_at<uint64_t>(past_end, kColumnOffsetOffset,
+                     (bytes.size() + 16) / 16 * 16);
+  check_rejected(file, past_end, wren::scene::BakedSceneErrors::Corrupt);
+
+  auto unaligned = bytes;
+  write_at<uint64_t>(unaligned, kColumnOffsetOffset, offset + 1);
+  check_rejected(file, unaligned, wren::scene::BakedSceneErrors::Corrupt);
+
+  auto too_long = bytes;
+  write_at<uint64_t>(too_long, kColumnSizeOffset, bytes.size());
+  check_rejected(file, too_long, wren::scene::BakedSceneErrors::Corrupt);
+
+  std::filesystem::remove_all(file.parent_path());
+}
+
+BOOST_AUTO_TEST_CASE(RejectsCorruptStrings) {
+  const auto file = bake_test_scene();
+  const auto bytes = read_file(file);
+  const auto offset = read_at<uint64_t>(bytes, kColumnOffsetOffset);
+  const auto size = read_at<uint64_t>(bytes, kColumnSizeOffset);
+  const auto entity_count = read_at<uint32_t>(bytes, kEntityCountOffset);
+  BOOST_REQUIRE(entity_count == 2);
+
+  // A name that isn't terminated would run into the next column
+  auto unterminated = bytes;
+  unterminated[offset + size - 1] = 'x';
+  check_rejected(file, unterminated, wren::scene::BakedSceneErrors::Corrupt);
+
+  // Every offset has to stay within the characters, not only the last
+  auto past_end = bytes;
+  write_at<uint32_t>(past_end, offset + sizeof(uint32_t), 1000000);
+  check_rejected(file, past_end, wren::scene::BakedSceneErrors::Corrupt);
+
+  // Strings have to start where the previous one ends
+  auto backwards = bytes;
+  write_at<uint32_t>(backwards, offset + sizeof(uint32_t), 0);
+  check_rejected(file, backwards, wren::scene::BakedSceneErrors::Corrupt);
+
+  // The last offset is the size of the characters
+  auto overrun = bytes;
+  write_at<uint32_t>(overrun, offset + entity_count * sizeof(uint32_t),
+                     static_cast<uint32_t>(size));
+  check_rejected(file, overrun, wren::scene::BakedSceneErrors::Corrupt);
+
+  std::filesystem::remove_all(file.parent_path());
+}
+
+BOOST_AUTO_TEST_CASE(RejectsNameConflictsBeforeCreatingAnything) {
+  const auto file = bake_test_scene();
+  const auto bytes = read_file(file);
+  const auto offset = read_at<uint64_t>(bytes, kColumnOffsetOffset);
+  const auto entity_count = read_at<uint32_t>(bytes, kEntityCountOffset);
+
+  // The same name twice in one file, "empty" overwritten with "cube" and a
+  // second terminator
+  auto duplicate = bytes;
+  const auto chars = offset + (entity_count + 1) * sizeof(uint32_t);
+  std::memcpy(duplicate.data() + chars + 5, "cube", 5);
+  check_rejected(file, duplicate,
+                 wren::scene::BakedSceneErrors::NameConflict);
+
+  // A name already in the scene fails before the other entities are created
+  const auto scene = wren::scene::Scene::create();
+  scene->create_entity("empty");
+  const auto result = wren::scene::deserialize_baked(
+      file.parent_path(), file.filename(), scene, false);
+  BOOST_REQUIRE(!result.has_value());
+  BOOST_TEST((result.error().error() ==
+              make_error_code(wren::scene::BakedSceneErrors::NameConflict)));
+  BOOST_TEST(!scene->world().lookup("cube").is_valid());
+
+  std::filesystem::remove_all(file.parent_path());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <wren/assets/database.hpp>
+#include <wren/utils/filesystem.hpp>
+
+namespace {
+
+//! @brief A fresh directory under the temporary directory, removed with it
+struct TempDir {
+  explicit TempDir(const std::string& name)
+      : path(std::filesystem::temp_directory_path() / name) {
+    std::filesystem::remove_all(path);
+    std::filesystem::create_directories(path);
+  }
+  TempDir(const TempDir&) = delete;
+  TempDir(TempDir&&) = delete;
+  auto operator=(const TempDir&) = delete;
+  auto operator=(TempDir&&) = delete;
+  ~TempDir() { std::filesystem::remove_all(path); }
+
+  std::filesystem::path path;
+};
+
+void write(const std::filesystem::path& file, const std::string& contents) {
+  std::filesystem::create_directories(file.parent_path());
+  std::ofstream out(file, std::ios::binary);
+  out << contents;
+}
+
+auto contains(const std::vector<std::filesystem::path>& changed,
+              const std::filesystem::path& file) -> bool {
+  const auto normal = std::filesystem::absolute(file).lexically_normal();
+  return std::ranges::find(changed, normal) != changed.end();
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(database)
+
+BOOST_AUTO_TEST_CASE(FindsLikeTheDirectoryWalk) {
+  const TempDir root("wren_database_find");
+  const TempDir other("wren_database_find_other");
+  write(root.path / "meshes/cube.stl", "cube");
+  write(root.path / "meshes/old/cube.stl", "old cube");
+  write(root.path / "shaders/mesh.wren_shader", "shader");
+  write(other.path / "shaders/mesh.wren_shader", "other shader");
+  write(other.path / "only_here.txt", "other");
+
+  const auto database =
+      wren::assets::Database::create({root.path, other.path}, std::nullopt);
+
+  // Every path the walk resolves resolves to the same file
+  for (const auto* asset : {"meshes/cube.stl", "cube.stl", "old/cube.stl",
+                            "mesh.wren_shader", "shaders/mesh.wren_shader"}) {
+    const auto walked = wren::utils::fs::file_exists_in_dir(root.path, asset);
+    const auto found = database->find(asset);
+    BOOST_REQUIRE(walked.has_value());
+    BOOST_REQUIRE(found.has_value());
+    BOOST_TEST(std::filesystem::equivalent(*walked, *found), asset);
+  }
+
+  // The copy closest to its root wins, and earlier roots win over later ones
+  BOOST_TEST(*database->find("cube.stl") ==
+             std::filesystem::absolute(root.path / "meshes/cube.stl"));
+  BOOST_TEST(*database->find("mesh.wren_shader") ==
+             std::filesystem::absolute(root.path / "shaders/mesh.wren_shader"));
+  BOOST_TEST(*database->find("only_here.txt") ==
+             std::filesystem::absolute(other.path / "only_here.txt"));
+
+  BOOST_TEST(!database->find("missing.stl").has_value());
+  BOOST_TEST(!wren::utils::fs::file_exists_in_dir(root.path, "missing.stl")
+                  .has_value());
+}
+
+BOOST_AUTO_TEST_CASE(ReusesManifestHashes) {
+  const TempDir root("wren_database_manifest");
+  const TempDir cache("wren_database_manifest_cache");
+  const auto file = root.path / "mesh.stl";
+  write(file, "aaaa");
+
+  uint64_t first = 0;
+  {
+    const auto database = wren::assets::Database::create({root.path},
+                                                         cache.path);
+    const auto hash = database->hash(file);
+    BOOST_REQUIRE(hash.has_value());
+    first = *hash;
+  }
+
+  // Same size and write time, the manifest's hash is trusted without reading
+  // the file
+  const auto time = std::filesystem::last_write_time(file);
+  write(file, "bbbb");
+  std::filesystem::last_write_time(file, time);
+  {
+    const auto database = wren::assets::Database::create({root.path},
+                                                         cache.path);
+    BOOST_TEST(*database->hash(file) == first);
+  }
+
+  // Once the write time moves the file is hashed again
+  std::filesystem::last_write_time(file, time + std::chrono::seconds(1));
+  {
+    const auto database = wren::assets::Database::create({root.path},
+                                                         cache.path);
+    BOOST_TEST(*database->hash(file) != first);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(PollsWritesAndDeletes) {
+  const TempDir root("wren_database_poll");
+  const auto file = root.path / "mesh.stl";
+  write(file, "mesh");
+
+  const auto database = wren::assets::Database::create({root.path},
+                                                       std::nullopt);
+  BOOST_TEST(database->poll().empty());
+
+  write(file, "changed");
+  BOOST_TEST(contains(database->poll(), file));
+  BOOST_TEST(database->poll().empty());
+
+  const auto created = root.path / "new/created.stl";
+  write(created, "created");
+  BOOST_TEST(contains(database->poll(), created));
+  BOOST_TEST(database->find("created.stl").has_value());
+
+  std::filesystem::remove(file);
+  BOOST_TEST(contains(database->poll(), file));
+  BOOST_TEST(!database->find("mesh.stl").has_value());
+}
+
+BOOST_AUTO_TEST_CASE(PollsDirectoryMoves) {
+  const TempDir root("wren_database_move");
+  const TempDir outside("wren_database_move_outside");
+  const auto file = root.path / "meshes/nested/cube.stl";
+  write(file, "cube");
+
+  const auto database = wren::assets::Database::create({root.path},
+                                                       std::nullopt);
+  BOOST_REQUIRE(database->find("cube.stl").has_value());
+
+  // Files moved with their directory get no events of their own
+  std::filesystem::rename(root.path / "meshes", root.path / "models");
+  auto changed = database->poll();
+  BOOST_TEST(contains(changed, file));
+  BOOST_TEST(contains(changed, root.path / "models/nested/cube.stl"));
+  BOOST_TEST(*database->find("cube.stl") ==
+             std::filesystem::absolute(root.path / "models/nested/cube.stl"));
+  BOOST_TEST(!database->find("meshes/nested/cube.stl").has_value());
+
+  std::filesystem::rename(root.path / "models", outside.path / "models");
+  changed = database->poll();
+  BOOST_TEST(contains(changed, root.path / "models/nested/cube.stl"));
+  BOOST_TEST(!database->find("cube.stl").has_value());
+  BOOST_TEST(database->size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(PropagatesToDependents) {
+  const TempDir root("wren_database_dependents");
+  const TempDir cache("wren_database_dependents_cache");
+  const auto scene = root.path / "scene.toml";
+  const auto mesh = root.path / "mesh.gltf";
+  const auto buffer = root.path / "mesh.bin";
+  write(scene, "scene");
+  write(mesh, "gltf");
+  write(buffer, "bin");
+
+  const auto database = wren::assets::Database::create({root.path},
+                                                       cache.path);
+  database->add_dependency(scene, mesh);
+  database->add_dependency(mesh, buffer);
+  const auto before = database->artifact(scene, "wscene");
+  BOOST_REQUIRE(before.has_value());
+  BOOST_TEST(before->extension() == ".wscene");
+
+  // Changing the buffer changes everything reading it, directly or not
+  write(buffer, "new bin");
+  const auto changed = database->poll();
+  BOOST_TEST(changed.size() == 3);
+  BOOST_TEST(contains(changed, buffer));
+  BOOST_TEST(contains(changed, mesh));
+  BOOST_TEST(contains(changed, scene));
+
+  const auto after = database->artifact(scene, "wscene");
+  BOOST_REQUIRE(after.has_value());
+  BOOST_TEST(*after != *before);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
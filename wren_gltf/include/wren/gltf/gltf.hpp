@@ -1,9 +1,124 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include <wren/math/matrix.hpp>
+#include <wren/utils/mapped_file.hpp>
+#include <wren/utils/result.hpp>
 
 namespace wren::gltf {
 
-auto load_mesh(const std::filesystem::path& path) -> void;
+DEFINE_ERROR("GLTF", GltfErrors, NotAGlb, UnsupportedVersion, Corrupt,
+             ExternalBuffer, UnsupportedAccessor)
 
-}
+enum class ComponentType : uint32_t {
+  Byte = 5120,
+  UnsignedByte = 5121,
+  Short = 5122,
+  UnsignedShort = 5123,
+  UnsignedInt = 5125,
+  Float = 5126,
+};
+
+//! @brief A typed view of a buffer view, pointing straight into the BIN chunk
+//! of the mapped file
+struct Accessor {
+  //! @brief From the first element to the end of the last
+  std::span<const std::byte> data;
+  std::size_t count = 0;
+  //! @brief Bytes between the starts of two elements
+  std::size_t stride = 0;
+  //! @brief 1 for SCALAR up to 4 for VEC4
+  std::size_t components = 0;
+  ComponentType component_type = ComponentType::Float;
+  //! @brief Integers map to [0, 1] or [-1, 1]
+  bool normalized = false;
+
+  //! @brief Component of an element converted to float
+  [[nodiscard]] auto read_float(std::size_t element,
+                                std::size_t component) const -> float;
+
+  //! @brief An element of an index accessor
+  [[nodiscard]] auto read_index(std::size_t element) const -> uint32_t;
+};
+
+enum class PrimitiveMode : uint32_t {
+  Points = 0,
+  Lines = 1,
+  LineLoop = 2,
+  LineStrip = 3,
+  Triangles = 4,
+  TriangleStrip = 5,
+  TriangleFan = 6,
+};
+
+struct Primitive {
+  std::optional<Accessor> positions;
+  std::optional<Accessor> normals;
+  std::optional<Accessor> colours;
+  //! @brief Without, vertices are drawn in order
+  std::optional<Accessor> indices;
+  PrimitiveMode mode = PrimitiveMode::Triangles;
+};
+
+struct Mesh {
+  std::string name;
+  std::vector<Primitive> primitives;
+};
+
+//! @brief A mesh placed by a node of the default scene, transform includes
+//! the node's parents
+struct MeshInstance {
+  std::size_t mesh = 0;
+  math::Mat4f transform = math::Mat4f::identity();
+};
+
+//! @brief A binary glTF file. The file is mapped and only the JSON chunk is
+//! parsed, accessors reference the BIN chunk in place, so they're valid as
+//! long as the Glb is.
+class Glb {
+ public:
+  static auto open(const std::filesystem::path& path) -> expected<Glb>;
+
+  [[nodiscard]] auto meshes() const -> const std::vector<Mesh>& {
+    return meshes_;
+  }
+
+  //! @brief Every mesh placed by the default scene, or each mesh once in
+  //! place for files without scenes
+  [[nodiscard]] auto instances() const -> const std::vector<MeshInstance>& {
+    return instances_;
+  }
+
+ private:
+  explicit Glb(utils::MappedFile file) : file_(std::move(file)) {}
+
+  //! @brief The mapping doesn't move with the file, moving a Glb keeps its
+  //! accessors valid
+  utils::MappedFile file_;
+  std::vector<Mesh> meshes_;
+  std::vector<MeshInstance> instances_;
+};
+
+//! @brief Triangles of every mesh a file places, in world space, with one
+//! vertex per element of each primitive
+struct SceneGeometry {
+  std::vector<math::Vec3f> positions;
+  //! @brief Unit length, smooth ones weighted by area for primitives
+  //! without normals
+  std::vector<math::Vec3f> normals;
+  std::vector<math::Vec4f> colours;
+  std::vector<uint32_t> indices;
+};
+
+//! @brief Bake every triangle primitive of glb's instances into one set of
+//! triangles. Instances mirrored by their transform get their winding
+//! reversed, front faces stay counter clockwise like the spec requires.
+auto bake(const Glb& glb) -> expected<SceneGeometry>;
+
+}  // namespace wren::gltf
@@ -0,0 +1,128 @@
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <utility>
+
+#include "gltf.hpp"
+
+namespace wren::gltf {
+
+namespace {
+
+//! @brief The upper 3x3 as columns
+auto basis(const math::Mat4f& m) -> std::array<math::Vec3f, 3> {
+  return {math::Vec3f{m.at(0, 0), m.at(0, 1), m.at(0, 2)},
+          math::Vec3f{m.at(1, 0), m.at(1, 1), m.at(1, 2)},
+          math::Vec3f{m.at(2, 0), m.at(2, 1), m.at(2, 2)}};
+}
+
+//! @brief The matrix normals are transformed by, as columns. The cofactor
+//! matrix of the upper 3x3 is the inverse transpose scaled by the
+//! determinant: the scale goes away once the normals are normalized, the
+//! sign doesn't and is taken out for mirroring transforms.
+auto normal_matrix(const std::array<math::Vec3f, 3>& c, bool mirrored)
+    -> std::array<math::Vec3f, 3> {
+  std::array<math::Vec3f, 3> cofactor = {
+      math::Vec3f{c[1] % c[2]}, math::Vec3f{c[2] % c[0]},
+      math::Vec3f{c[0] % c[1]}};
+  if (mirrored) {
+    for (auto& column : cofactor) column = math::Vec3f{column * -1.0F};
+  }
+  return cofactor;
+}
+
+}  // namespace
+
+auto bake(const Glb& glb) -> expected<SceneGeometry> {
+  SceneGeometry geometry;
+
+  for (const auto& instance : glb.instances()) {
+    auto transform = instance.transform;
+    const auto columns = basis(transform);
+    // A negative determinant mirrors
+    const bool mirrored =
+        columns[0].dot(math::Vec3f{columns[1] % columns[2]}) < 0;
+    const auto normals = normal_matrix(columns, mirrored);
+
+    for (const auto& primitive : glb.meshes().at(instance.mesh).primitives) {
+      if (primitive.mode != PrimitiveMode::Triangles ||
+          !primitive.positions.has_value()) {
+        spdlog::debug("Skipping a primitive that isn't triangles");
+        continue;
+      }
+
+      const auto& positions = *primitive.positions;
+      const auto base = static_cast<uint32_t>(geometry.positions.size());
+      for (std::size_t i = 0; i < positions.count; ++i) {
+        const math::Vec4f pos{positions.read_float(i, 0),
+                              positions.read_float(i, 1),
+                              positions.read_float(i, 2), 1.0F};
+        geometry.positions.emplace_back((transform * pos).xyz());
+
+        math::Vec3f normal{};
+        if (primitive.normals.has_value()) {
+          for (std::size_t c = 0; c < 3; ++c) {
+            normal += normals.at(c) * primitive.normals->read_float(i, c);
+          }
+          if (normal.length() > 0) normal = normal.normalized();
+        }
+        geometry.normals.push_back(normal);
+
+        math::Vec4f colour{1.0F};
+        if (primitive.colours.has_value()) {
+          for (std::size_t c = 0; c < primitive.colours->components; ++c) {
+            colour.at(c) = primitive.colours->read_float(i, c);
+          }
+        }
+        geometry.colours.push_back(colour);
+      }
+
+      auto& indices = geometry.indices;
+      const auto first_index = indices.size();
+      if (primitive.indices.has_value()) {
+        for (std::size_t i = 0; i < primitive.indices->count; ++i) {
+          const auto index = primitive.indices->read_index(i);
+          if (index >= positions.count) {
+            return std::unexpected(GltfErrors::Corrupt);
+          }
+          indices.push_back(base + index);
+        }
+      } else {
+        for (std::size_t i = 0; i < positions.count; ++i) {
+          indices.push_back(base + static_cast<uint32_t>(i));
+        }
+      }
+      if ((indices.size() - first_index) % 3 != 0) {
+        return std::unexpected(GltfErrors::Corrupt);
+      }
+
+      // A mirror turns counter clockwise triangles clockwise
+      if (mirrored) {
+        for (auto i = first_index; i < indices.size(); i += 3) {
+          std::swap(indices[i + 1], indices[i + 2]);
+        }
+      }
+
+      // Primitives without normals get smooth ones, weighted by area
+      if (!primitive.normals.has_value()) {
+        for (auto i = first_index; i < indices.size(); i += 3) {
+          const auto& a = geometry.positions.at(indices[i]);
+          const auto& b = geometry.positions.at(indices[i + 1]);
+          const auto& c = geometry.positions.at(indices[i + 2]);
+          const math::Vec3f face = math::Vec3f{b - a} % math::Vec3f{c - a};
+          for (std::size_t v = 0; v < 3; ++v) {
+            geometry.normals.at(indices[i + v]) += face;
+          }
+        }
+        for (auto v = base; v < geometry.normals.size(); ++v) {
+          auto& normal = geometry.normals.at(v);
+          if (normal.length() > 0) normal = normal.normalized();
+        }
+      }
+    }
+  }
+
+  return geometry;
+}
+
+}  // namespace wren::gltf
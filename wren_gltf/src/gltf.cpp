@@ -2,79 +2,377 @@
 
 #include <spdlog/spdlog.h>
 
-#include <cassert>
-#include <fstream>
-#include <iostream>
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <nlohmann/json.hpp>
-#include <span>
-#include <vector>
+#include <wren/math/geometry.hpp>
 
 namespace wren::gltf {
 
-enum class ChunkType {
+namespace {
+
+constexpr uint32_t kMagic = 0x46546C67;  // "glTF"
+constexpr uint32_t kVersion = 2;
+
+enum class ChunkType : uint32_t {
   kJson = 0x4E4F534A,
   kBin = 0x004E4942,
 };
 
-auto load_json_chunk() {}
+struct Header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t length;
+};
+
+struct ChunkHeader {
+  uint32_t length;
+  ChunkType type;
+};
 
-auto load_chunk() {}
+auto component_size(ComponentType type) -> std::size_t {
+  switch (type) {
+    case ComponentType::Byte:
+    case ComponentType::UnsignedByte:
+      return 1;
+    case ComponentType::Short:
+    case ComponentType::UnsignedShort:
+      return 2;
+    case ComponentType::UnsignedInt:
+    case ComponentType::Float:
+      return 4;
+  }
+  return 0;
+}
 
-auto load_mesh(const std::filesystem::path& path) -> void {
-  // ==== Read file
-  std::ifstream file(path, std::ios::binary);
+auto component_count(const std::string& type) -> std::size_t {
+  if (type == "SCALAR") return 1;
+  if (type == "VEC2") return 2;
+  if (type == "VEC3") return 3;
+  if (type == "VEC4") return 4;
+  // Matrices have padding rules vertex attributes never need
+  return 0;
+}
 
-  std::streampos size;
-  file.seekg(0, std::ios::end);
-  size = file.tellg();
-  file.seekg(0, std::ios::beg);
+template <typename T>
+auto read(const std::byte* ptr) -> T {
+  T value;
+  std::memcpy(&value, ptr, sizeof(T));
+  return value;
+}
 
-  std::vector<uint8_t> buf;
-  buf.reserve(size);
+//! @brief What the JSON references, resolved against the file
+struct Document {
+  const nlohmann::json& json;
+  //! @brief Empty for buffers outside the file
+  std::vector<std::optional<std::span<const std::byte>>> buffers;
+};
 
-  buf.insert(buf.begin(), std::istreambuf_iterator<char>(file),
-             std::istreambuf_iterator<char>());
+auto buffer_view(const Document& doc, std::size_t index)
+    -> expected<std::span<const std::byte>> {
+  const auto& view = doc.json.at("bufferViews").at(index);
+  const auto buffer = view.at("buffer").get<std::size_t>();
+  if (buffer >= doc.buffers.size()) {
+    return std::unexpected(GltfErrors::Corrupt);
+  }
+  if (!doc.buffers[buffer].has_value()) {
+    return std::unexpected(GltfErrors::ExternalBuffer);
+  }
 
-  // ===========================================
+  const auto data = *doc.buffers[buffer];
+  const auto offset = view.value("byteOffset", std::size_t{0});
+  const auto length = view.at("byteLength").get<std::size_t>();
+  if (offset > data.size() || length > data.size() - offset) {
+    return std::unexpected(GltfErrors::Corrupt);
+  }
+  return data.subspan(offset, length);
+}
 
-  std::span<uint32_t> data(reinterpret_cast<uint32_t*>(buf.data()),
-                           buf.size() / sizeof(uint32_t));
-  auto it = data.begin();
+auto read_accessor(const Document& doc, std::size_t index)
+    -> expected<Accessor> {
+  const auto& json = doc.json.at("accessors").at(index);
+  // Accessors without a buffer view are all zeros, sparse ones patch theirs,
+  // neither can be referenced in place
+  if (!json.contains("bufferView") || json.contains("sparse")) {
+    return std::unexpected(GltfErrors::UnsupportedAccessor);
+  }
 
-  const auto magic_number = *(it);
-  ++it;
-  assert(magic_number == 0x46546C67);
+  const auto view_index = json.at("bufferView").get<std::size_t>();
+  TRY_RESULT(const auto view, buffer_view(doc, view_index));
 
-  const auto version = *it;
-  ++it;
-  const auto length = *it;
-  ++it;
-  spdlog::info("gltf version: {}, length: {}", version, length);
+  Accessor accessor{
+      .count = json.at("count").get<std::size_t>(),
+      .components = component_count(json.at("type").get<std::string>()),
+      .component_type =
+          static_cast<ComponentType>(json.at("componentType").get<uint32_t>()),
+      .normalized = json.value("normalized", false),
+  };
+  const auto element_size =
+      accessor.components * component_size(accessor.component_type);
+  if (element_size == 0) {
+    return std::unexpected(GltfErrors::UnsupportedAccessor);
+  }
 
-  while (it != data.end()) {
-    const std::span<uint32_t> data(reinterpret_cast<uint32_t*>(buf.data()),
-                                   buf.size() / sizeof(uint32_t));
-    auto it = data.begin();
+  const auto& view_json = doc.json.at("bufferViews").at(view_index);
+  accessor.stride = view_json.value("byteStride", element_size);
+  if (accessor.stride < element_size) {
+    return std::unexpected(GltfErrors::Corrupt);
+  }
 
-    const auto chunk_length = *it;
-    ++it;
-    const auto chunk_type = static_cast<ChunkType>(*it);
-    ++it;
+  const auto offset = json.value("byteOffset", std::size_t{0});
+  const auto size = accessor.count == 0
+                        ? 0
+                        : (accessor.count - 1) * accessor.stride + element_size;
+  if (offset > view.size() || size > view.size() - offset) {
+    return std::unexpected(GltfErrors::Corrupt);
+  }
+  accessor.data = view.subspan(offset, size);
+  return accessor;
+}
 
-    auto chunk_start = std::distance(data.begin(), it) * sizeof(uint32_t);
+auto attribute(const Document& doc, const nlohmann::json& attributes,
+               const char* name) -> expected<std::optional<Accessor>> {
+  if (!attributes.contains(name)) return std::nullopt;
+  TRY_RESULT(auto found,
+             read_accessor(doc, attributes.at(name).get<std::size_t>()));
+  return found;
+}
 
-    std::span<uint8_t> chunk_data(buf.begin() + chunk_start, chunk_length);
-    if (chunk_type == ChunkType::kBin) {
-      spdlog::debug("Chunk is binary data");
-    } else if (chunk_type == ChunkType::kJson) {
-      spdlog::debug("Chunk is json");
+auto parse_mesh(const Document& doc, const nlohmann::json& json)
+    -> expected<Mesh> {
+  Mesh mesh{.name = json.value("name", std::string{})};
 
-      auto json = nlohmann::json::parse(chunk_data.begin(), chunk_data.end());
-      auto mesh_json = json["meshes"][0];
+  for (const auto& primitive_json : json.at("primitives")) {
+    Primitive primitive{
+        .mode = static_cast<PrimitiveMode>(primitive_json.value("mode", 4U)),
+    };
 
-      std::cout << json.dump(4) << std::endl;
+    const auto& attributes = primitive_json.at("attributes");
+    TRY_RESULT(primitive.positions, attribute(doc, attributes, "POSITION"));
+    TRY_RESULT(primitive.normals, attribute(doc, attributes, "NORMAL"));
+    TRY_RESULT(primitive.colours, attribute(doc, attributes, "COLOR_0"));
+    if (primitive_json.contains("indices")) {
+      const auto indices = primitive_json.at("indices").get<std::size_t>();
+      TRY_RESULT(primitive.indices, read_accessor(doc, indices));
+      const auto type = primitive.indices->component_type;
+      if (primitive.indices->components != 1 ||
+          (type != ComponentType::UnsignedByte &&
+           type != ComponentType::UnsignedShort &&
+           type != ComponentType::UnsignedInt)) {
+        return std::unexpected(GltfErrors::Corrupt);
+      }
     }
+
+    mesh.primitives.push_back(std::move(primitive));
+  }
+
+  return mesh;
+}
+
+//! @brief Rotation by a unit quaternion stored x, y, z, w
+auto rotation_matrix(const std::array<float, 4>& q) -> math::Mat4f {
+  const auto [x, y, z, w] = q;
+  auto m = math::Mat4f::identity();
+  m.at(0, 0) = 1 - 2 * (y * y + z * z);
+  m.at(0, 1) = 2 * (x * y + w * z);
+  m.at(0, 2) = 2 * (x * z - w * y);
+  m.at(1, 0) = 2 * (x * y - w * z);
+  m.at(1, 1) = 1 - 2 * (x * x + z * z);
+  m.at(1, 2) = 2 * (y * z + w * x);
+  m.at(2, 0) = 2 * (x * z + w * y);
+  m.at(2, 1) = 2 * (y * z - w * x);
+  m.at(2, 2) = 1 - 2 * (x * x + y * y);
+  return m;
+}
+
+//! @brief A node's matrix, or its translation * rotation * scale
+auto local_transform(const nlohmann::json& node) -> math::Mat4f {
+  if (node.contains("matrix")) {
+    // Column major like Mat4f
+    return math::Mat4f{node.at("matrix").get<std::array<float, 16>>()};
+  }
+
+  const auto t = node.value("translation", std::array<float, 3>{0, 0, 0});
+  const auto r = node.value("rotation", std::array<float, 4>{0, 0, 0, 1});
+  const auto s = node.value("scale", std::array<float, 3>{1, 1, 1});
+
+  auto rotation = rotation_matrix(r);
+  for (std::size_t col = 0; col < 3; ++col) {
+    for (std::size_t row = 0; row < 3; ++row) rotation.at(col, row) *= s[col];
   }
+  return math::translate(math::Mat4f::identity(),
+                         math::Vec3f{t[0], t[1], t[2]}) *
+         rotation;
+}
+
+auto collect_instances(const nlohmann::json& json)
+    -> expected<std::vector<MeshInstance>> {
+  std::vector<MeshInstance> instances;
+
+  const auto& meshes = json.value("meshes", nlohmann::json::array());
+  if (!json.contains("scenes") || json.at("scenes").empty()) {
+    for (std::size_t mesh = 0; mesh < meshes.size(); ++mesh) {
+      instances.push_back({.mesh = mesh});
+    }
+    return instances;
+  }
+
+  const auto& nodes = json.value("nodes", nlohmann::json::array());
+  const auto& scene = json.at("scenes").at(json.value("scene", 0U));
+
+  std::vector<std::pair<std::size_t, math::Mat4f>> pending;
+  for (const auto& root : scene.value("nodes", nlohmann::json::array())) {
+    pending.emplace_back(root.get<std::size_t>(), math::Mat4f::identity());
+  }
+
+  // Nodes form a forest, visiting more than there are means a cycle
+  std::size_t visited = 0;
+  while (!pending.empty()) {
+    auto [index, parent] = std::move(pending.back());
+    pending.pop_back();
+    if (index >= nodes.size() || ++visited > nodes.size()) {
+      return std::unexpected(GltfErrors::Corrupt);
+    }
+
+    const auto& node = nodes.at(index);
+    const math::Mat4f transform = parent * local_transform(node);
+    if (node.contains("mesh")) {
+      const auto mesh = node.at("mesh").get<std::size_t>();
+      if (mesh >= meshes.size()) return std::unexpected(GltfErrors::Corrupt);
+      instances.push_back({.mesh = mesh, .transform = transform});
+    }
+    for (const auto& child : node.value("children", nlohmann::json::array())) {
+      pending.emplace_back(child.get<std::size_t>(), transform);
+    }
+  }
+
+  return instances;
+}
+
+}  // namespace
+
+auto Accessor::read_float(std::size_t element, std::size_t component) const
+    -> float {
+  const auto* ptr = data.data() + element * stride +
+                    component * component_size(component_type);
+
+  switch (component_type) {
+    case ComponentType::Float:
+      return read<float>(ptr);
+    case ComponentType::Byte: {
+      const auto v = static_cast<float>(read<int8_t>(ptr));
+      return normalized ? std::max(v / 127.0F, -1.0F) : v;
+    }
+    case ComponentType::UnsignedByte: {
+      const auto v = static_cast<float>(read<uint8_t>(ptr));
+      return normalized ? v / 255.0F : v;
+    }
+    case ComponentType::Short: {
+      const auto v = static_cast<float>(read<int16_t>(ptr));
+      return normalized ? std::max(v / 32767.0F, -1.0F) : v;
+    }
+    case ComponentType::UnsignedShort: {
+      const auto v = static_cast<float>(read<uint16_t>(ptr));
+      return normalized ? v / 65535.0F : v;
+    }
+    case ComponentType::UnsignedInt:
+      return static_cast<float>(read<uint32_t>(ptr));
+  }
+  return 0;
+}
+
+auto Accessor::read_index(std::size_t element) const -> uint32_t {
+  const auto* ptr = data.data() + element * stride;
+
+  switch (component_type) {
+    case ComponentType::UnsignedByte:
+      return read<uint8_t>(ptr);
+    case ComponentType::UnsignedShort:
+      return read<uint16_t>(ptr);
+    case ComponentType::UnsignedInt:
+      return read<uint32_t>(ptr);
+    default:
+      return 0;
+  }
+}
+
+auto Glb::open(const std::filesystem::path& path) -> expected<Glb> {
+  auto mapped = utils::MappedFile::open(path);
+  if (!mapped.has_value()) return std::unexpected(mapped.error());
+  Glb glb{std::move(mapped.value())};
+
+  const auto file = glb.file_.data();
+  if (file.size() < sizeof(Header)) {
+    return std::unexpected(GltfErrors::NotAGlb);
+  }
+  const auto header = read<Header>(file.data());
+  if (header.magic != kMagic) return std::unexpected(GltfErrors::NotAGlb);
+  if (header.version != kVersion) {
+    return std::unexpected(GltfErrors::UnsupportedVersion);
+  }
+  if (header.length > file.size()) {
+    return std::unexpected(GltfErrors::Corrupt);
+  }
+
+  // The JSON chunk comes first, an optional BIN chunk second, later chunks
+  // are extensions
+  std::optional<std::span<const std::byte>> json_chunk;
+  std::optional<std::span<const std::byte>> bin_chunk;
+  std::size_t offset = sizeof(Header);
+  while (offset + sizeof(ChunkHeader) <= header.length) {
+    const auto chunk = read<ChunkHeader>(file.data() + offset);
+    offset += sizeof(ChunkHeader);
+    if (chunk.length > header.length - offset) {
+      return std::unexpected(GltfErrors::Corrupt);
+    }
+
+    const auto data = file.subspan(offset, chunk.length);
+    if (chunk.type == ChunkType::kJson && !json_chunk.has_value()) {
+      json_chunk = data;
+    } else if (chunk.type == ChunkType::kBin && !bin_chunk.has_value()) {
+      bin_chunk = data;
+    }
+    // Chunks are padded to 4 bytes
+    offset += (chunk.length + 3) / 4 * 4;
+  }
+  if (!json_chunk.has_value()) return std::unexpected(GltfErrors::Corrupt);
+
+  const auto* chars = reinterpret_cast<const char*>(json_chunk->data());
+  const auto json =
+      nlohmann::json::parse(chars, chars + json_chunk->size(), nullptr, false);
+  if (json.is_discarded() || !json.is_object()) {
+    return std::unexpected(GltfErrors::Corrupt);
+  }
+
+  // Missing keys and wrong types in the JSON throw, they all mean the same
+  try {
+    Document doc{.json = json, .buffers = {}};
+    const auto& buffers = json.value("buffers", nlohmann::json::array());
+    for (std::size_t i = 0; i < buffers.size(); ++i) {
+      // Only the first buffer may live in the BIN chunk, and then has no uri
+      if (i == 0 && !buffers[i].contains("uri") && bin_chunk.has_value()) {
+        const auto length = buffers[i].at("byteLength").get<std::size_t>();
+        if (length > bin_chunk->size()) {
+          return std::unexpected(GltfErrors::Corrupt);
+        }
+        doc.buffers.emplace_back(bin_chunk->first(length));
+      } else {
+        doc.buffers.emplace_back(std::nullopt);
+      }
+    }
+
+    for (const auto& mesh : json.value("meshes", nlohmann::json::array())) {
+      TRY_RESULT(auto parsed, parse_mesh(doc, mesh));
+      glb.meshes_.push_back(std::move(parsed));
+    }
+    TRY_RESULT(glb.instances_, collect_instances(json));
+  } catch (const nlohmann::json::exception& e) {
+    spdlog::warn("Invalid glTF {}: {}", path.string(), e.what());
+    return std::unexpected(GltfErrors::Corrupt);
+  }
+
+  return glb;
 }
 
 }  // namespace wren::gltf
@@ -0,0 +1,189 @@
+#include <array>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <wren/gltf/gltf.hpp>
+
+namespace {
+
+//! @brief A GLB with a JSON and a BIN chunk, both padded to 4 bytes
+auto write_glb(const std::filesystem::path& path, std::string json,
+               std::vector<std::byte> bin) {
+  while (json.size() % 4 != 0) json.push_back(' ');
+  while (bin.size() % 4 != 0) bin.push_back(std::byte{0});
+
+  const auto chunk = [](std::ofstream& out, uint32_t type, const void* data,
+                        std::size_t size) {
+    const auto length = static_cast<uint32_t>(size);
+    out.write(reinterpret_cast<const char*>(&length), 4);
+    out.write(reinterpret_cast<const char*>(&type), 4);
+    out.write(static_cast<const char*>(data),
+              static_cast<std::streamsize>(size));
+  };
+
+  std::ofstream out(path, std::ios::binary);
+  const std::array<uint32_t, 3> header = {
+      0x46546C67, 2,
+      static_cast<uint32_t>(12 + 8 + json.size() + 8 + bin.size())};
+  out.write(reinterpret_cast<const char*>(header.data()), 12);
+  chunk(out, 0x4E4F534A, json.data(), json.size());
+  chunk(out, 0x004E4942, bin.data(), bin.size());
+}
+
+template <typename T>
+void append(std::vector<std::byte>& bytes, const std::vector<T>& values) {
+  const auto offset = bytes.size();
+  bytes.resize(offset + values.size() * sizeof(T));
+  std::memcpy(bytes.data() + offset, values.data(), values.size() * sizeof(T));
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(glb)
+
+BOOST_AUTO_TEST_CASE(ReadsMeshesInPlace) {
+  const auto path = std::filesystem::temp_directory_path() / "wren_glb.glb";
+
+  // One triangle with 16 bit indices, placed by a child of a rotated node
+  std::vector<std::byte> bin;
+  append(bin, std::vector<float>{0, 0, 0, 1, 0, 0, 0, 1, 0});
+  append(bin, std::vector<uint16_t>{0, 1, 2});
+  write_glb(path, R"({
+    "asset": {"version": "2.0"},
+    "buffers": [{"byteLength": 42}],
+    "bufferViews": [
+      {"buffer": 0, "byteOffset": 0, "byteLength": 36},
+      {"buffer": 0, "byteOffset": 36, "byteLength": 6}
+    ],
+    "accessors": [
+      {"bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3"},
+      {"bufferView": 1, "componentType": 5123, "count": 3, "type": "SCALAR"}
+    ],
+    "meshes": [{"name": "triangle", "primitives": [
+      {"attributes": {"POSITION": 0}, "indices": 1}
+    ]}],
+    "nodes": [
+      {"translation": [1, 2, 3], "rotation": [0, 0, 0.7071068, 0.7071068],
+       "children": [1]},
+      {"mesh": 0, "scale": [2, 2, 2]}
+    ],
+    "scenes": [{"nodes": [0]}],
+    "scene": 0
+  })",
+            bin);
+
+  const auto glb = wren::gltf::Glb::open(path);
+  BOOST_REQUIRE(glb.has_value());
+  BOOST_REQUIRE(glb->meshes().size() == 1);
+
+  const auto& mesh = glb->meshes().front();
+  BOOST_TEST(mesh.name == "triangle");
+  BOOST_REQUIRE(mesh.primitives.size() == 1);
+
+  const auto& primitive = mesh.primitives.front();
+  BOOST_REQUIRE(primitive.positions.has_value());
+  BOOST_REQUIRE(primitive.indices.has_value());
+  BOOST_TEST(!primitive.normals.has_value());
+  BOOST_TEST(primitive.positions->count == 3);
+  BOOST_TEST(primitive.positions->read_float(1, 0) == 1.0F);
+  BOOST_TEST(primitive.positions->read_float(2, 1) == 1.0F);
+  BOOST_TEST(primitive.indices->read_index(2) == 2);
+
+  BOOST_REQUIRE(glb->instances().size() == 1);
+  const auto& transform = glb->instances().front().transform;
+  // Scaled by 2 and turned a quarter around z, x ends up along y
+  BOOST_TEST(transform.at(0, 0) == 0.0F, boost::test_tools::tolerance(1e-5F));
+  BOOST_TEST(transform.at(0, 1) == 2.0F, boost::test_tools::tolerance(1e-5F));
+  BOOST_TEST(transform.at(3, 0) == 1.0F);
+  BOOST_TEST(transform.at(3, 1) == 2.0F);
+  BOOST_TEST(transform.at(3, 2) == 3.0F);
+
+  std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(MirroredNodesKeepTheirWinding) {
+  const auto path =
+      std::filesystem::temp_directory_path() / "wren_glb_mirrored.glb";
+
+  // A triangle facing +z, once with normals and once without, mirrored in x
+  std::vector<std::byte> bin;
+  append(bin, std::vector<float>{0, 0, 0, 1, 0, 0, 0, 1, 0});
+  append(bin, std::vector<float>{0, 0, 1, 0, 0, 1, 0, 0, 1});
+  write_glb(path, R"({
+    "buffers": [{"byteLength": 72}],
+    "bufferViews": [
+      {"buffer": 0, "byteOffset": 0, "byteLength": 36},
+      {"buffer": 0, "byteOffset": 36, "byteLength": 36}
+    ],
+    "accessors": [
+      {"bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3"},
+      {"bufferView": 1, "componentType": 5126, "count": 3, "type": "VEC3"}
+    ],
+    "meshes": [{"primitives": [
+      {"attributes": {"POSITION": 0, "NORMAL": 1}},
+      {"attributes": {"POSITION": 0}}
+    ]}],
+    "nodes": [{"mesh": 0, "scale": [-1, 1, 1]}],
+    "scenes": [{"nodes": [0]}]
+  })",
+            bin);
+
+  const auto glb = wren::gltf::Glb::open(path);
+  BOOST_REQUIRE(glb.has_value());
+  const auto geometry = wren::gltf::bake(*glb);
+  BOOST_REQUIRE(geometry.has_value());
+  BOOST_REQUIRE(geometry->indices.size() == 6);
+
+  const auto& positions = geometry->positions;
+  BOOST_TEST(positions.at(1).x() == -1.0F);
+
+  for (std::size_t t = 0; t < 2; ++t) {
+    const auto* triangle = &geometry->indices.at(t * 3);
+    const auto& a = positions.at(triangle[0]);
+    const wren::math::Vec3f ab{positions.at(triangle[1]) - a};
+    const wren::math::Vec3f ac{positions.at(triangle[2]) - a};
+    // Still counter clockwise seen from +z, and the normals agree
+    BOOST_TEST(wren::math::Vec3f{ab % ac}.z() > 0.0F);
+    for (std::size_t v = 0; v < 3; ++v) {
+      const auto& normal = geometry->normals.at(triangle[v]);
+      BOOST_TEST(normal.z() == 1.0F, boost::test_tools::tolerance(1e-5F));
+    }
+  }
+
+  std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(RejectsOutOfRangeAccessors) {
+  const auto path = std::filesystem::temp_directory_path() / "wren_glb_bad.glb";
+
+  std::vector<std::byte> bin;
+  append(bin, std::vector<float>{0, 0, 0});
+  write_glb(path, R"({
+    "buffers": [{"byteLength": 12}],
+    "bufferViews": [{"buffer": 0, "byteLength": 12}],
+    "accessors": [
+      {"bufferView": 0, "componentType": 5126, "count": 2, "type": "VEC3"}
+    ],
+    "meshes": [{"primitives": [{"attributes": {"POSITION": 0}}]}]
+  })",
+            bin);
+
+  BOOST_TEST(!wren::gltf::Glb::open(path).has_value());
+  std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(NotAGlb) {
+  const auto path = std::filesystem::temp_directory_path() / "wren_not_glb";
+  {
+    std::ofstream out(path, std::ios::binary);
+    out << "solid stl file";
+  }
+
+  BOOST_TEST(!wren::gltf::Glb::open(path).has_value());
+  std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
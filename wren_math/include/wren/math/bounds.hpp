@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <limits>
+#include <span>
+
+#include "matrix.hpp"
+#include "vector.hpp"
+
+namespace wren::math {
+
+//! @brief Axis aligned bounding box, empty until a point is added
+struct AABB {
+  Vec3f min{std::numeric_limits<float>::max(),
+            std::numeric_limits<float>::max(),
+            std::numeric_limits<float>::max()};
+  Vec3f max{std::numeric_limits<float>::lowest(),
+            std::numeric_limits<float>::lowest(),
+            std::numeric_limits<float>::lowest()};
+
+  static auto from_points(std::span<const Vec3f> points) -> AABB;
+
+  void expand(const Vec3f& point);
+
+  [[nodiscard]] auto empty() const -> bool;
+  [[nodiscard]] auto center() const -> Vec3f;
+  //! @brief Half the size of the box along each axis
+  [[nodiscard]] auto extent() const -> Vec3f;
+};
+
+struct BoundingSphere {
+  Vec3f center;
+  float radius = 0;
+
+  //! @brief The sphere enclosing a box, looser than the tightest sphere of
+  //! the points but stable and cheap to compute
+  static auto from_aabb(const AABB& aabb) -> BoundingSphere;
+
+  //! @brief Move the sphere into the space of a model matrix, the radius is
+  //! scaled by the largest axis scale so it stays conservative
+  [[nodiscard]] auto transformed(const Mat4f& model) const -> BoundingSphere;
+};
+
+//! @brief The six clip planes of a view projection matrix. Normals point
+//! inwards and are normalized so a plane's distance is in world units.
+struct Frustum {
+  //! @brief (normal.x, normal.y, normal.z, distance)
+  std::array<Vec4f, 6> planes;
+
+  //! @brief Extract the planes of a Vulkan clip space, x and y within +-w and
+  //! z between 0 and w. Works for reverse depth, near and far just swap.
+  static auto from_matrix(const Mat4f& view_proj) -> Frustum;
+
+  //! @brief Whether any part of the sphere may be inside, spheres crossing a
+  //! corner outside every plane still pass
+  [[nodiscard]] auto intersects(const BoundingSphere& sphere) const -> bool;
+};
+
+}  // namespace wren::math
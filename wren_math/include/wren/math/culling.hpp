@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "bounds.hpp"
+
+namespace wren::math {
+
+//! @brief Bounding spheres stored as a structure of arrays, so the plane
+//! tests can load the same component of several spheres at once
+class SphereSet {
+ public:
+  //! @brief Spheres tested per SIMD iteration
+  static constexpr std::size_t kLanes = 8;
+
+  void reserve(std::size_t count);
+  void clear();
+  void push_back(const BoundingSphere& sphere);
+
+  [[nodiscard]] auto size() const { return radius_.size(); }
+  [[nodiscard]] auto empty() const { return radius_.empty(); }
+
+  [[nodiscard]] auto x() const -> const float* { return x_.data(); }
+  [[nodiscard]] auto y() const -> const float* { return y_.data(); }
+  [[nodiscard]] auto z() const -> const float* { return z_.data(); }
+  [[nodiscard]] auto radius() const -> const float* { return radius_.data(); }
+
+ private:
+  std::vector<float> x_;
+  std::vector<float> y_;
+  std::vector<float> z_;
+  std::vector<float> radius_;
+};
+
+//! @brief Test spheres [begin, end) against a frustum, visible[i] is set to 1
+//! when sphere i may be visible and 0 otherwise. Uses AVX when the CPU
+//! supports it. Disjoint ranges can be culled from different threads.
+void cull_spheres(const Frustum& frustum, const SphereSet& spheres,
+                  std::span<uint8_t> visible, std::size_t begin,
+                  std::size_t end);
+
+inline void cull_spheres(const Frustum& frustum, const SphereSet& spheres,
+                         std::span<uint8_t> visible) {
+  cull_spheres(frustum, spheres, visible, 0, spheres.size());
+}
+
+//! @brief The same test one sphere at a time, what cull_spheres falls back to
+void cull_spheres_scalar(const Frustum& frustum, const SphereSet& spheres,
+                         std::span<uint8_t> visible, std::size_t begin,
+                         std::size_t end);
+
+}  // namespace wren::math
@@ -23,6 +23,10 @@ auto look_at(const Vec3f& position, const Vec3f& target, const Vec3f& world_up)
 
 auto rotate(const Mat4f& matrix, float rotation, const Vec3f& axis) -> Mat4f;
 
+//! @brief Invert a matrix whose last row is (0, 0, 0, 1), like model and view
+//! matrices. Singular matrices give a matrix of zeros.
+auto inverse_affine(const Mat4f& matrix) -> Mat4f;
+
 template <typename T>
 inline auto ortho(T left, T right, T bottom, T top) {
   Mat4f res = Mat4f::identity();
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "vector.hpp"
+
+namespace wren::math {
+
+//! @brief Average cache misses per triangle (ACMR) of a triangle list run
+//! through a FIFO post-transform cache. 3 is every vertex shaded for every
+//! triangle, around 0.6 is about as low as regular meshes get.
+auto vertex_cache_miss_ratio(std::span<const uint32_t> indices,
+                             std::size_t vertex_count,
+                             std::size_t cache_size = 16) -> float;
+
+//! @brief Reorder triangles so vertices are reused while they're still in
+//! the post-transform cache, with Tom Forsyth's linear speed vertex cache
+//! optimisation. Triangles keep their winding.
+void optimize_vertex_cache(std::span<uint32_t> indices,
+                           std::size_t vertex_count);
+
+//! @brief Reorder clusters of triangles so the ones facing away from the
+//! mesh's centre are drawn first, they tend to occlude the rest and the depth
+//! test then rejects more fragments (Sander et al., "Fast Triangle Reordering
+//! for Vertex Locality and Reduced Overdraw"). Run after
+//! optimize_vertex_cache, clusters only break where that order already
+//! restarts with a cold cache so cache efficiency is mostly kept.
+void optimize_overdraw(std::span<uint32_t> indices,
+                       std::span<const Vec3f> positions);
+
+//! @brief Map every vertex to the first vertex with the same position.
+//! Flat shaded meshes split vertices per normal, welding them recovers which
+//! triangles are connected.
+auto weld_positions(std::span<const Vec3f> positions) -> std::vector<uint32_t>;
+
+//! @brief Where optimize_vertex_fetch puts vertices no triangle uses
+constexpr uint32_t kUnusedVertex = ~0U;
+
+//! @brief Renumber vertices in the order the indices first use them, so
+//! vertex fetches walk the vertex buffer forwards. indices are rewritten in
+//! place.
+//! @returns The new index of every vertex, vertices no index uses get
+//! kUnusedVertex and can be dropped
+auto optimize_vertex_fetch(std::span<uint32_t> indices,
+                           std::size_t vertex_count) -> std::vector<uint32_t>;
+
+//! @brief Move vertices to the places an optimize_vertex_fetch remap gives
+//! them, dropping unused ones
+template <typename T>
+auto remap_vertices(std::span<const T> vertices,
+                    std::span<const uint32_t> remap) -> std::vector<T> {
+  std::size_t count = 0;
+  for (const auto index : remap) {
+    if (index != kUnusedVertex) ++count;
+  }
+
+  std::vector<T> result(count);
+  for (std::size_t i = 0; i < vertices.size(); ++i) {
+    if (remap[i] != kUnusedVertex) result[remap[i]] = vertices[i];
+  }
+  return result;
+}
+
+}  // namespace wren::math
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "bounds.hpp"
+#include "vector.hpp"
+
+namespace wren::math {
+
+//! @brief A small cluster of a mesh's triangles, culled on its own
+struct Meshlet {
+  //! @brief Range of MeshletBuild::indices
+  uint32_t first_index = 0;
+  uint32_t index_count = 0;
+
+  BoundingSphere sphere{};
+
+  //! @brief Every triangle's normal is within a cone around cone_axis, see
+  //! meshlet_backfacing(). A cutoff of 1 or more never culls.
+  Vec3f cone_axis{};
+  float cone_cutoff = 1;
+};
+
+struct MeshletBuild {
+  //! @brief The input triangles regrouped so each meshlet is a contiguous
+  //! range, with the triangles of a meshlet ordered for the vertex cache
+  std::vector<uint32_t> indices;
+  std::vector<Meshlet> meshlets;
+};
+
+//! @brief Split a triangle list into meshlets. Clusters are grown from a seed
+//! triangle through its neighbours, preferring triangles that add the fewest
+//! vertices and face the same way, which keeps the bounds tight and the
+//! normal cones narrow.
+//! @param max_vertices Distinct vertices per meshlet at most
+//! @param max_triangles Triangles per meshlet at most
+auto build_meshlets(std::span<const Vec3f> positions,
+                    std::span<const uint32_t> indices,
+                    std::size_t max_vertices = 64,
+                    std::size_t max_triangles = 124) -> MeshletBuild;
+
+//! @brief Whether every triangle of the meshlet faces away from a camera at
+//! camera_position, given in the same space as the meshlet
+auto meshlet_backfacing(const Meshlet& meshlet, const Vec3f& camera_position)
+    -> bool;
+
+}  // namespace wren::math
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+
+#include "vector.hpp"
+
+namespace wren::math {
+
+//! @brief Convert to an IEEE half float, rounding to nearest even. Values too
+//! large for a half become infinity.
+auto quantize_half(float value) -> uint16_t;
+auto dequantize_half(uint16_t half) -> float;
+
+//! @brief Map [-1, 1] onto a signed normalized integer the way the GPU reads
+//! it back (Vulkan's *_SNORM formats), values outside are clamped
+template <std::signed_integral T>
+auto quantize_snorm(float value) -> T {
+  constexpr auto kMax = static_cast<float>(std::numeric_limits<T>::max());
+  return static_cast<T>(std::round(std::clamp(value, -1.0F, 1.0F) * kMax));
+}
+
+template <std::signed_integral T>
+auto dequantize_snorm(T value) -> float {
+  constexpr auto kMax = static_cast<float>(std::numeric_limits<T>::max());
+  return std::max(static_cast<float>(value) / kMax, -1.0F);
+}
+
+//! @brief Map [0, 1] onto an unsigned normalized integer (*_UNORM formats)
+template <std::unsigned_integral T>
+auto quantize_unorm(float value) -> T {
+  constexpr auto kMax = static_cast<float>(std::numeric_limits<T>::max());
+  return static_cast<T>(std::round(std::clamp(value, 0.0F, 1.0F) * kMax));
+}
+
+template <std::unsigned_integral T>
+auto dequantize_unorm(T value) -> float {
+  constexpr auto kMax = static_cast<float>(std::numeric_limits<T>::max());
+  return static_cast<float>(value) / kMax;
+}
+
+//! @brief Fold a unit vector onto an octahedron and unwrap it into the
+//! [-1, 1] square, two components instead of three with an even error over
+//! the sphere. The shader side decode is the same as octahedral_decode.
+auto octahedral_encode(const Vec3f& normal) -> Vec2f;
+//! @brief The inverse of octahedral_encode, the result is normalized
+auto octahedral_decode(const Vec2f& encoded) -> Vec3f;
+
+}  // namespace wren::math
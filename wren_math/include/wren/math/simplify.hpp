@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "matrix.hpp"
+#include "vector.hpp"
+
+namespace wren::math {
+
+struct SimplifyResult {
+  std::vector<uint32_t> indices;
+  //! @brief Roughly the largest distance the surface moved, in the units of
+  //! the positions (the square root of the largest quadric error)
+  float error = 0;
+};
+
+//! @brief Simplify a triangle list with quadric error metrics (Garland &
+//! Heckbert). Edges are collapsed onto one of their existing vertices so the
+//! result indexes the same vertex buffer, only a new index list is needed per
+//! level of detail.
+//!
+//! Vertices sharing a position (flat shaded meshes split them per normal) are
+//! welded while simplifying, the result uses the first of them. Open
+//! boundaries are kept in place and collapses that would flip a triangle are
+//! skipped.
+//! @param target_index_count Stop once the mesh has this many indices or less
+//! @param max_error Never move the surface further than this
+auto simplify(std::span<const Vec3f> positions,
+              std::span<const uint32_t> indices,
+              std::size_t target_index_count,
+              float max_error = std::numeric_limits<float>::max())
+    -> SimplifyResult;
+
+//! @brief Converts world space lengths into pixels on screen
+struct ScreenProjection {
+  Mat4f view = Mat4f::identity();
+  //! @brief Pixels covered by one unit at a distance of one unit
+  float scale = 1;
+
+  //! @param projection A perspective matrix, its y focal length is used
+  //! @param viewport_height In pixels
+  static auto from_camera(const Mat4f& view, const Mat4f& projection,
+                          float viewport_height) -> ScreenProjection;
+
+  //! @brief Pixels per world unit at a world space position
+  [[nodiscard]] auto pixels_per_unit(const Vec3f& position) const -> float;
+
+  //! @brief False until the viewport has a size, every error is then 0
+  //! pixels and select_lod() would pick the coarsest level
+  [[nodiscard]] auto valid() const -> bool { return scale > 0; }
+};
+
+//! @brief Pick a level of detail, the coarsest one whose error is at most
+//! threshold pixels on screen. Switching to a coarser level needs the error to
+//! be below threshold * (1 - hysteresis) so objects sitting right at a
+//! switching distance don't flicker between levels every frame.
+//! @param errors Error of each level, finest first and increasing. Any
+//! random access range works, a view over the levels avoids a copy.
+//! @param current The level picked last frame
+template <std::ranges::random_access_range Errors>
+  requires std::ranges::sized_range<Errors> &&
+           std::convertible_to<std::ranges::range_value_t<Errors>, float>
+auto select_lod(const Errors& errors, float pixels_per_unit,
+                std::size_t current, float threshold = 1.0F,
+                float hysteresis = 0.25F) -> std::size_t {
+  const auto count = static_cast<std::size_t>(std::ranges::size(errors));
+  if (count == 0) return 0;
+
+  const auto error = [&errors](std::size_t lod) -> float {
+    return std::ranges::begin(errors)[static_cast<
+        std::ranges::range_difference_t<const Errors>>(lod)];
+  };
+
+  auto lod = std::min(current, count - 1);
+
+  // Refine as soon as the current level is visibly wrong
+  while (lod > 0 && error(lod) * pixels_per_unit > threshold) --lod;
+
+  // Only coarsen with some margin
+  const auto coarsen_threshold = threshold * (1.0F - hysteresis);
+  while (lod + 1 < count &&
+         error(lod + 1) * pixels_per_unit <= coarsen_threshold) {
+    ++lod;
+  }
+
+  return lod;
+}
+
+}  // namespace wren::math
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace wren::math {
+
+//! @brief Bytes of a 4x4 block of BC1 texels
+constexpr std::size_t kBc1BlockSize = 8;
+
+//! @brief Levels of a full mip chain down to 1x1
+auto mip_count(uint32_t width, uint32_t height) -> uint32_t;
+
+//! @brief Size of a mip level, never below 1
+constexpr auto mip_extent(uint32_t extent, uint32_t mip) -> uint32_t {
+  const auto scaled = extent >> mip;
+  return scaled == 0 ? 1 : scaled;
+}
+
+//! @brief The finest mip worth having on the GPU for a texture texels wide
+//! that covers pixels on screen, finer levels would be minified away
+auto mip_for_screen_size(uint32_t texels, float pixels, uint32_t mip_count)
+    -> uint32_t;
+
+//! @brief Halve an RGBA8 image with a box filter. Colour is averaged in
+//! linear space when srgb is set, alpha always is linear. Odd sizes drop
+//! their last row or column.
+auto downsample_rgba8(std::span<const uint8_t> pixels, uint32_t width,
+                      uint32_t height, bool srgb) -> std::vector<uint8_t>;
+
+//! @brief Bytes of an image compressed to BC1
+constexpr auto bc1_size(uint32_t width, uint32_t height) -> std::size_t {
+  return static_cast<std::size_t>((width + 3) / 4) * ((height + 3) / 4) *
+         kBc1BlockSize;
+}
+
+//! @brief Compress an RGBA8 image to BC1, blocks in rows left to right.
+//! Endpoints are the corners of each block's colour bounding box along its
+//! main diagonal, inset a little, and every texel takes the closest of the
+//! four colours. Blocks with texels under half alpha use the three colour
+//! mode with those texels transparent.
+auto encode_bc1(std::span<const uint8_t> pixels, uint32_t width,
+                uint32_t height) -> std::vector<std::byte>;
+
+//! @brief Decompress BC1 blocks back into RGBA8, for devices without BC
+//! support
+auto decode_bc1(std::span<const std::byte> blocks, uint32_t width,
+                uint32_t height) -> std::vector<uint8_t>;
+
+}  // namespace wren::math
@@ -0,0 +1,85 @@
+#include "bounds.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace wren::math {
+
+auto AABB::from_points(std::span<const Vec3f> points) -> AABB {
+  AABB aabb;
+  for (const auto& point : points) aabb.expand(point);
+  return aabb;
+}
+
+void AABB::expand(const Vec3f& point) {
+  for (std::size_t i = 0; i < 3; ++i) {
+    min.at(i) = std::min(min.at(i), point.at(i));
+    max.at(i) = std::max(max.at(i), point.at(i));
+  }
+}
+
+auto AABB::empty() const -> bool {
+  return min.x() > max.x() || min.y() > max.y() || min.z() > max.z();
+}
+
+auto AABB::center() const -> Vec3f { return (min + max) * 0.5f; }
+
+auto AABB::extent() const -> Vec3f { return (max - min) * 0.5f; }
+
+auto BoundingSphere::from_aabb(const AABB& aabb) -> BoundingSphere {
+  if (aabb.empty()) return {};
+  return {aabb.center(), aabb.extent().length()};
+}
+
+auto BoundingSphere::transformed(const Mat4f& model) const -> BoundingSphere {
+  Vec3f position;
+  for (std::size_t row = 0; row < 3; ++row) {
+    position.at(row) = model.at(0, row) * center.x() +
+                       model.at(1, row) * center.y() +
+                       model.at(2, row) * center.z() + model.at(3, row);
+  }
+
+  float scale = 0;
+  for (std::size_t col = 0; col < 3; ++col) {
+    const Vec3f axis{model.at(col, 0), model.at(col, 1), model.at(col, 2)};
+    scale = std::max(scale, axis.length());
+  }
+
+  return {position, radius * scale};
+}
+
+auto Frustum::from_matrix(const Mat4f& view_proj) -> Frustum {
+  // Each clip space inequality is a dot product with a row of the matrix
+  const auto row = [&view_proj](std::size_t r) {
+    return Vec4f{view_proj.at(0, r), view_proj.at(1, r), view_proj.at(2, r),
+                 view_proj.at(3, r)};
+  };
+  const auto r0 = row(0);
+  const auto r1 = row(1);
+  const auto r2 = row(2);
+  const auto r3 = row(3);
+
+  Frustum frustum{{
+      r3 + r0,  // left
+      r3 - r0,  // right
+      r3 + r1,  // bottom
+      r3 - r1,  // top
+      r2,       // z >= 0, far with reverse depth
+      r3 - r2,  // z <= w, near with reverse depth
+  }};
+
+  for (auto& plane : frustum.planes) {
+    const auto length = plane.xyz().length();
+    if (length > 0) plane = plane / length;
+  }
+
+  return frustum;
+}
+
+auto Frustum::intersects(const BoundingSphere& sphere) const -> bool {
+  return std::ranges::all_of(planes, [&sphere](const Vec4f& plane) {
+    return plane.xyz().dot(sphere.center) + plane.w() >= -sphere.radius;
+  });
+}
+
+}  // namespace wren::math
@@ -0,0 +1,130 @@
+#include "culling.hpp"
+
+#include <array>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define WREN_MATH_HAS_AVX_KERNEL
+#include <immintrin.h>
+#endif
+
+namespace wren::math {
+
+namespace {
+
+#ifdef WREN_MATH_HAS_AVX_KERNEL
+// Compiled for AVX regardless of the build's target, only called once the CPU
+// is known to support it
+__attribute__((target("avx"))) void cull_spheres_avx(
+    const Frustum& frustum, const SphereSet& spheres,
+    std::span<uint8_t> visible, std::size_t begin, std::size_t end) {
+  struct PlaneLanes {
+    __m256 x;
+    __m256 y;
+    __m256 z;
+    __m256 w;
+  };
+
+  std::array<PlaneLanes, 6> planes{};
+  for (std::size_t p = 0; p < planes.size(); ++p) {
+    const auto& plane = frustum.planes.at(p);
+    planes.at(p) = {_mm256_set1_ps(plane.x()), _mm256_set1_ps(plane.y()),
+                    _mm256_set1_ps(plane.z()), _mm256_set1_ps(plane.w())};
+  }
+
+  const __m256 zero = _mm256_setzero_ps();
+
+  std::size_t i = begin;
+  for (; i + SphereSet::kLanes <= end; i += SphereSet::kLanes) {
+    const __m256 x = _mm256_loadu_ps(spheres.x() + i);
+    const __m256 y = _mm256_loadu_ps(spheres.y() + i);
+    const __m256 z = _mm256_loadu_ps(spheres.z() + i);
+    const __m256 neg_radius =
+        _mm256_sub_ps(zero, _mm256_loadu_ps(spheres.radius() + i));
+
+    // Same order of operations as the scalar path so both agree exactly
+    __m256 inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+    for (const auto& plane : planes) {
+      __m256 dist = _mm256_mul_ps(plane.x, x);
+      dist = _mm256_add_ps(dist, _mm256_mul_ps(plane.y, y));
+      dist = _mm256_add_ps(dist, _mm256_mul_ps(plane.z, z));
+      dist = _mm256_add_ps(dist, plane.w);
+      inside = _mm256_and_ps(inside,
+                             _mm256_cmp_ps(dist, neg_radius, _CMP_GE_OQ));
+    }
+
+    // Narrow the all ones / all zeros lanes down to one 0 or 1 byte each
+    const __m256i lanes = _mm256_castps_si256(inside);
+    const __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(lanes),
+                                          _mm256_extractf128_si256(lanes, 1));
+    const __m128i bytes =
+        _mm_and_si128(_mm_packs_epi16(words, words), _mm_set1_epi8(1));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(visible.data() + i), bytes);
+  }
+
+  cull_spheres_scalar(frustum, spheres, visible, i, end);
+}
+
+auto has_avx() -> bool {
+  static const bool supported = __builtin_cpu_supports("avx") != 0;
+  return supported;
+}
+#endif
+
+}  // namespace
+
+void SphereSet::reserve(std::size_t count) {
+  x_.reserve(count);
+  y_.reserve(count);
+  z_.reserve(count);
+  radius_.reserve(count);
+}
+
+void SphereSet::clear() {
+  x_.clear();
+  y_.clear();
+  z_.clear();
+  radius_.clear();
+}
+
+void SphereSet::push_back(const BoundingSphere& sphere) {
+  x_.push_back(sphere.center.x());
+  y_.push_back(sphere.center.y());
+  z_.push_back(sphere.center.z());
+  radius_.push_back(sphere.radius);
+}
+
+void cull_spheres(const Frustum& frustum, const SphereSet& spheres,
+                  std::span<uint8_t> visible, std::size_t begin,
+                  std::size_t end) {
+#ifdef WREN_MATH_HAS_AVX_KERNEL
+  if (has_avx()) {
+    cull_spheres_avx(frustum, spheres, visible, begin, end);
+    return;
+  }
+#endif
+  cull_spheres_scalar(frustum, spheres, visible, begin, end);
+}
+
+void cull_spheres_scalar(const Frustum& frustum, const SphereSet& spheres,
+                         std::span<uint8_t> visible, std::size_t begin,
+                         std::size_t end) {
+  for (std::size_t i = begin; i < end; ++i) {
+    const float x = spheres.x()[i];
+    const float y = spheres.y()[i];
+    const float z = spheres.z()[i];
+    const float neg_radius = -spheres.radius()[i];
+
+    bool inside = true;
+    for (const auto& plane : frustum.planes) {
+      float dist = plane.x() * x;
+      dist += plane.y() * y;
+      dist += plane.z() * z;
+      dist += plane.w();
+      inside = inside && dist >= neg_radius;
+    }
+
+    visible[i] = inside ? 1 : 0;
+  }
+}
+
+}  // namespace wren::math
@@ -1,5 +1,6 @@
 #include "geometry.hpp"
 
+#include <array>
 #include <cmath>
 
 #include "matrix.hpp"
@@ -86,4 +87,41 @@ auto rotate(const Mat4f& matrix, float angle, const Vec3f& axis) -> Mat4f {
   return mat;
 }
 
+auto inverse_affine(const Mat4f& matrix) -> Mat4f {
+  const auto m = [&](std::size_t row, std::size_t col) {
+    return matrix.at(col, row);
+  };
+
+  // Inverse of the upper 3x3 from its cofactors
+  const float c00 = m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1);
+  const float c01 = m(1, 2) * m(2, 0) - m(1, 0) * m(2, 2);
+  const float c02 = m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0);
+  const float determinant = m(0, 0) * c00 + m(0, 1) * c01 + m(0, 2) * c02;
+
+  Mat4f inverse{};
+  if (determinant == 0) return inverse;
+  const float inv = 1.0F / determinant;
+
+  const std::array<std::array<float, 3>, 3> linear = {{
+      {c00 * inv, (m(0, 2) * m(2, 1) - m(0, 1) * m(2, 2)) * inv,
+       (m(0, 1) * m(1, 2) - m(0, 2) * m(1, 1)) * inv},
+      {c01 * inv, (m(0, 0) * m(2, 2) - m(0, 2) * m(2, 0)) * inv,
+       (m(0, 2) * m(1, 0) - m(0, 0) * m(1, 2)) * inv},
+      {c02 * inv, (m(0, 1) * m(2, 0) - m(0, 0) * m(2, 1)) * inv,
+       (m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0)) * inv},
+  }};
+
+  for (std::size_t row = 0; row < 3; ++row) {
+    float translation = 0;
+    for (std::size_t col = 0; col < 3; ++col) {
+      inverse.at(col, row) = linear.at(row).at(col);
+      translation -= linear.at(row).at(col) * m(col, 3);
+    }
+    inverse.at(3, row) = translation;
+  }
+  inverse.at(3, 3) = 1;
+
+  return inverse;
+}
+
 }  // namespace wren::math
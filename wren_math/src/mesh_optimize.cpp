@@ -0,0 +1,286 @@
+#include "mesh_optimize.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <numeric>
+
+namespace wren::math {
+
+namespace {
+
+// Tuning from Forsyth's "Linear-Speed Vertex Cache Optimisation"
+constexpr std::size_t kCacheSize = 32;
+constexpr float kCacheDecayPower = 1.5F;
+constexpr float kLastTriangleScore = 0.75F;
+constexpr float kValenceBoostScale = 2.0F;
+constexpr float kValenceBoostPower = 0.5F;
+
+auto vertex_score(int cache_position, uint32_t remaining_triangles) -> float {
+  // Nothing left to draw with this vertex
+  if (remaining_triangles == 0) return -1.0F;
+
+  float score = 0;
+  if (cache_position >= 0) {
+    if (cache_position < 3) {
+      // Just used by the last triangle, a fixed score so the algorithm
+      // doesn't just keep stripping
+      score = kLastTriangleScore;
+    } else {
+      const float scale = 1.0F / static_cast<float>(kCacheSize - 3);
+      score = std::pow(
+          1.0F - static_cast<float>(cache_position - 3) * scale,
+          kCacheDecayPower);
+    }
+  }
+
+  // Vertices with few triangles left are finished off first
+  score += kValenceBoostScale *
+           std::pow(static_cast<float>(remaining_triangles),
+                    -kValenceBoostPower);
+  return score;
+}
+
+}  // namespace
+
+auto vertex_cache_miss_ratio(std::span<const uint32_t> indices,
+                             std::size_t vertex_count, std::size_t cache_size)
+    -> float {
+  if (indices.size() < 3) return 0;
+
+  // Timestamps make the FIFO test O(1), a vertex is cached if it was pushed
+  // within the last cache_size misses
+  std::vector<std::size_t> pushed(vertex_count, 0);
+  std::size_t time = cache_size + 1;
+  std::size_t misses = 0;
+  for (const auto index : indices) {
+    if (time - pushed[index] > cache_size) {
+      pushed[index] = time++;
+      ++misses;
+    }
+  }
+
+  return static_cast<float>(misses) /
+         static_cast<float>(indices.size() / 3);
+}
+
+void optimize_vertex_cache(std::span<uint32_t> indices,
+                           std::size_t vertex_count) {
+  const std::size_t triangle_count = indices.size() / 3;
+  if (triangle_count == 0) return;
+
+  // Triangles using each vertex, packed into one array. The live part of a
+  // vertex's range shrinks as its triangles are emitted.
+  std::vector<uint32_t> remaining(vertex_count, 0);
+  for (const auto index : indices) ++remaining[index];
+
+  std::vector<uint32_t> offsets(vertex_count + 1, 0);
+  std::partial_sum(remaining.begin(), remaining.end(), offsets.begin() + 1);
+
+  std::vector<uint32_t> vertex_triangles(offsets.back());
+  {
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (uint32_t t = 0; t < triangle_count; ++t) {
+      for (std::size_t k = 0; k < 3; ++k) {
+        vertex_triangles[fill[indices[t * 3 + k]]++] = t;
+      }
+    }
+  }
+
+  std::vector<int> cache_position(vertex_count, -1);
+  std::vector<float> score(vertex_count);
+  for (std::size_t v = 0; v < vertex_count; ++v) {
+    score[v] = vertex_score(-1, remaining[v]);
+  }
+
+  std::vector<float> triangle_score(triangle_count);
+  std::vector<bool> emitted(triangle_count, false);
+  for (std::size_t t = 0; t < triangle_count; ++t) {
+    triangle_score[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] +
+                        score[indices[t * 3 + 2]];
+  }
+
+  // Room for the 3 vertices pushed in front of a full cache
+  std::vector<uint32_t> cache;
+  std::vector<uint32_t> next_cache;
+  cache.reserve(kCacheSize + 3);
+  next_cache.reserve(kCacheSize + 3);
+
+  std::vector<uint32_t> result;
+  result.reserve(triangle_count * 3);
+
+  std::size_t best = 0;
+  for (std::size_t t = 1; t < triangle_count; ++t) {
+    if (triangle_score[t] > triangle_score[best]) best = t;
+  }
+
+  // Where to look for an unemitted triangle when nothing in the cache has
+  // one, Forsyth's full rescan would make the whole thing quadratic
+  std::size_t cursor = 0;
+
+  while (result.size() < triangle_count * 3) {
+    const std::array triangle = {indices[best * 3], indices[best * 3 + 1],
+                                 indices[best * 3 + 2]};
+    result.insert(result.end(), triangle.begin(), triangle.end());
+    emitted[best] = true;
+
+    for (const auto v : triangle) {
+      const auto begin = vertex_triangles.begin() + offsets[v];
+      const auto end = begin + remaining[v];
+      std::iter_swap(std::find(begin, end, best), end - 1);
+      --remaining[v];
+    }
+
+    // The triangle's vertices move to the front of the LRU cache
+    next_cache.assign(triangle.begin(), triangle.end());
+    for (const auto v : cache) {
+      if (std::ranges::find(triangle, v) == triangle.end()) {
+        next_cache.push_back(v);
+      }
+    }
+    std::swap(cache, next_cache);
+
+    for (std::size_t i = 0; i < cache.size(); ++i) {
+      const auto v = cache[i];
+      cache_position[v] = i < kCacheSize ? static_cast<int>(i) : -1;
+      score[v] = vertex_score(cache_position[v], remaining[v]);
+    }
+    // Anything pushed out of the cache was rescored as uncached above
+    if (cache.size() > kCacheSize) cache.resize(kCacheSize);
+
+    // Only triangles around cached vertices changed score
+    float best_score = -1;
+    bool found = false;
+    for (const auto v : cache) {
+      const auto begin = vertex_triangles.begin() + offsets[v];
+      for (auto it = begin; it != begin + remaining[v]; ++it) {
+        const auto t = *it;
+        triangle_score[t] = score[indices[t * 3]] +
+                            score[indices[t * 3 + 1]] +
+                            score[indices[t * 3 + 2]];
+        if (triangle_score[t] > best_score) {
+          best_score = triangle_score[t];
+          best = t;
+          found = true;
+        }
+      }
+    }
+
+    if (!found) {
+      while (cursor < triangle_count && emitted[cursor]) ++cursor;
+      if (cursor == triangle_count) break;
+      best = cursor;
+    }
+  }
+
+  std::ranges::copy(result, indices.begin());
+}
+
+void optimize_overdraw(std::span<uint32_t> indices,
+                       std::span<const Vec3f> positions) {
+  const std::size_t triangle_count = indices.size() / 3;
+  if (triangle_count == 0) return;
+
+  // A triangle missing the cache on all 3 vertices restarts the strip, that
+  // is where the order can be cut without costing cache misses
+  constexpr std::size_t kFifoSize = 16;
+  std::vector<std::size_t> pushed(positions.size(), 0);
+  std::size_t time = kFifoSize + 1;
+
+  std::vector<std::size_t> cluster_starts;
+  for (std::size_t t = 0; t < triangle_count; ++t) {
+    std::size_t misses = 0;
+    for (std::size_t k = 0; k < 3; ++k) {
+      const auto v = indices[t * 3 + k];
+      if (time - pushed[v] > kFifoSize) {
+        pushed[v] = time++;
+        ++misses;
+      }
+    }
+    if (t == 0 || misses == 3) cluster_starts.push_back(t);
+  }
+  if (cluster_starts.size() < 2) return;
+
+  Vec3f mesh_centre;
+  float mesh_area = 0;
+
+  struct Cluster {
+    std::size_t first;
+    std::size_t count;
+    Vec3f centroid{};
+    Vec3f normal{};
+    float sort_key = 0;
+  };
+  std::vector<Cluster> clusters;
+  clusters.reserve(cluster_starts.size());
+
+  for (std::size_t c = 0; c < cluster_starts.size(); ++c) {
+    const auto first = cluster_starts[c];
+    const auto last =
+        c + 1 < cluster_starts.size() ? cluster_starts[c + 1] : triangle_count;
+
+    Cluster cluster{first, last - first};
+    float area = 0;
+    for (std::size_t t = first; t < last; ++t) {
+      const auto& p0 = positions[indices[t * 3]];
+      const auto& p1 = positions[indices[t * 3 + 1]];
+      const auto& p2 = positions[indices[t * 3 + 2]];
+
+      // Twice the area weighted normal
+      const Vec3f normal = Vec3f{p1 - p0} % Vec3f{p2 - p0};
+      const auto triangle_area = normal.length();
+      cluster.normal = cluster.normal + normal;
+      cluster.centroid =
+          cluster.centroid + Vec3f{p0 + p1 + p2} * (triangle_area / 3.0F);
+      area += triangle_area;
+    }
+
+    if (area > 0) cluster.centroid = cluster.centroid / area;
+    mesh_centre = mesh_centre + cluster.centroid * area;
+    mesh_area += area;
+    clusters.push_back(cluster);
+  }
+  if (mesh_area > 0) mesh_centre = mesh_centre / mesh_area;
+
+  // Clusters further out along their facing direction are drawn first
+  for (auto& cluster : clusters) {
+    const auto length = cluster.normal.length();
+    if (length == 0) continue;
+    cluster.sort_key =
+        Vec3f{cluster.centroid - mesh_centre}.dot(cluster.normal / length);
+  }
+  std::ranges::stable_sort(clusters, std::greater<>{}, &Cluster::sort_key);
+
+  std::vector<uint32_t> result;
+  result.reserve(indices.size());
+  for (const auto& cluster : clusters) {
+    const auto begin = indices.begin() + cluster.first * 3;
+    result.insert(result.end(), begin, begin + cluster.count * 3);
+  }
+  std::ranges::copy(result, indices.begin());
+}
+
+auto weld_positions(std::span<const Vec3f> positions)
+    -> std::vector<uint32_t> {
+  std::map<std::array<float, 3>, uint32_t> first;
+  std::vector<uint32_t> remap(positions.size());
+  for (uint32_t i = 0; i < positions.size(); ++i) {
+    const auto& p = positions[i];
+    remap[i] = first.try_emplace({p.x(), p.y(), p.z()}, i).first->second;
+  }
+  return remap;
+}
+
+auto optimize_vertex_fetch(std::span<uint32_t> indices,
+                           std::size_t vertex_count) -> std::vector<uint32_t> {
+  std::vector<uint32_t> remap(vertex_count, kUnusedVertex);
+  uint32_t next = 0;
+  for (auto& index : indices) {
+    if (remap[index] == kUnusedVertex) remap[index] = next++;
+    index = remap[index];
+  }
+  return remap;
+}
+
+}  // namespace wren::math
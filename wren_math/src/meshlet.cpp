@@ -0,0 +1,247 @@
+#include "meshlet.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "mesh_optimize.hpp"
+
+namespace wren::math {
+
+namespace {
+
+constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+//! @brief Cones spreading wider than this (about 84 degrees from the axis)
+//! are almost never culled, they're disabled instead
+constexpr float kMinConeDot = 0.1F;
+
+auto triangle_normal(std::span<const Vec3f> positions,
+                     std::span<const uint32_t> indices, std::size_t triangle)
+    -> Vec3f {
+  const auto& a = positions[indices[triangle * 3]];
+  const auto& b = positions[indices[triangle * 3 + 1]];
+  const auto& c = positions[indices[triangle * 3 + 2]];
+  const Vec3f normal = Vec3f{b - a} % Vec3f{c - a};
+  const auto length = normal.length();
+  return length > 0 ? Vec3f{normal / length} : Vec3f{};
+}
+
+//! @brief Bounds and normal cone of a finished meshlet
+void compute_bounds(Meshlet& meshlet, std::span<const Vec3f> positions,
+                    std::span<const uint32_t> indices) {
+  const auto triangles = std::span(indices).subspan(meshlet.first_index,
+                                                    meshlet.index_count);
+
+  AABB aabb;
+  for (const auto index : triangles) aabb.expand(positions[index]);
+  meshlet.sphere = BoundingSphere::from_aabb(aabb);
+  // The box's sphere can be much looser than the distance to the furthest
+  // vertex, use whichever is smaller
+  float radius = 0;
+  for (const auto index : triangles) {
+    radius = std::max(
+        radius, Vec3f{positions[index] - meshlet.sphere.center}.length());
+  }
+  meshlet.sphere.radius = std::min(meshlet.sphere.radius, radius);
+
+  Vec3f axis;
+  for (std::size_t t = 0; t < triangles.size() / 3; ++t) {
+    axis = axis + triangle_normal(positions, triangles, t);
+  }
+  const auto length = axis.length();
+  if (length == 0) return;
+  axis = axis / length;
+
+  float min_dot = 1;
+  for (std::size_t t = 0; t < triangles.size() / 3; ++t) {
+    min_dot = std::min(min_dot,
+                       triangle_normal(positions, triangles, t).dot(axis));
+  }
+  if (min_dot < kMinConeDot) return;
+
+  meshlet.cone_axis = axis;
+  // Sine of the cone's half angle, the camera has to be this far behind the
+  // cluster's plane (relative to its distance) for every triangle to face away
+  meshlet.cone_cutoff = std::sqrt(1.0F - min_dot * min_dot);
+}
+
+}  // namespace
+
+auto build_meshlets(std::span<const Vec3f> positions,
+                    std::span<const uint32_t> indices,
+                    std::size_t max_vertices, std::size_t max_triangles)
+    -> MeshletBuild {
+  const std::size_t triangle_count = indices.size() / 3;
+  MeshletBuild build;
+  build.indices.reserve(triangle_count * 3);
+
+  // Adjacency over welded positions, flat shaded meshes don't share vertices
+  // across edges
+  const auto weld = weld_positions(positions);
+  std::vector<uint32_t> offsets(positions.size() + 1, 0);
+  for (std::size_t i = 0; i < triangle_count * 3; ++i) {
+    ++offsets[weld[indices[i]] + 1];
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+  std::vector<uint32_t> adjacency(offsets.back());
+  {
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (std::size_t i = 0; i < triangle_count * 3; ++i) {
+      adjacency[fill[weld[indices[i]]]++] = static_cast<uint32_t>(i / 3);
+    }
+  }
+
+  std::vector<Vec3f> normals(triangle_count);
+  std::vector<Vec3f> centroids(triangle_count);
+  for (std::size_t t = 0; t < triangle_count; ++t) {
+    normals[t] = triangle_normal(positions, indices, t);
+    centroids[t] = Vec3f{positions[indices[t * 3]] +
+                         positions[indices[t * 3 + 1]] +
+                         positions[indices[t * 3 + 2]]} /
+                   3.0F;
+  }
+
+  std::vector<bool> emitted(triangle_count, false);
+  // Which meshlet a vertex or candidate triangle was last added to
+  std::vector<uint32_t> vertex_meshlet(positions.size(), kNone);
+  std::vector<uint32_t> candidate_meshlet(triangle_count, kNone);
+
+  std::vector<uint32_t> candidates;
+  std::size_t cursor = 0;
+
+  while (true) {
+    while (cursor < triangle_count && emitted[cursor]) ++cursor;
+    if (cursor == triangle_count) break;
+
+    const auto id = static_cast<uint32_t>(build.meshlets.size());
+    Meshlet meshlet{.first_index = static_cast<uint32_t>(build.indices.size())};
+    std::size_t vertex_count = 0;
+    std::size_t triangles = 0;
+    Vec3f normal_sum;
+    Vec3f centroid_sum;
+    float radius = 0;
+
+    candidates.clear();
+
+    const auto new_vertices = [&](uint32_t t) {
+      std::size_t count = 0;
+      for (std::size_t k = 0; k < 3; ++k) {
+        const auto v = indices[t * 3 + k];
+        // Repeated indices within the triangle only count once
+        bool repeated = false;
+        for (std::size_t j = 0; j < k; ++j) {
+          repeated = repeated || indices[t * 3 + j] == v;
+        }
+        if (!repeated && vertex_meshlet[v] != id) ++count;
+      }
+      return count;
+    };
+
+    const auto add = [&](uint32_t t) {
+      emitted[t] = true;
+      ++triangles;
+      normal_sum = normal_sum + normals[t];
+      centroid_sum = centroid_sum + centroids[t];
+
+      for (std::size_t k = 0; k < 3; ++k) {
+        const auto v = indices[t * 3 + k];
+        build.indices.push_back(v);
+        if (vertex_meshlet[v] != id) {
+          vertex_meshlet[v] = id;
+          ++vertex_count;
+        }
+
+        const auto w = weld[v];
+        for (auto i = offsets[w]; i < offsets[w + 1]; ++i) {
+          const auto neighbour = adjacency[i];
+          if (emitted[neighbour] || candidate_meshlet[neighbour] == id) {
+            continue;
+          }
+          candidate_meshlet[neighbour] = id;
+          candidates.push_back(neighbour);
+        }
+      }
+
+      const Vec3f centre = centroid_sum / static_cast<float>(triangles);
+      radius = std::max(radius, Vec3f{centroids[t] - centre}.length());
+    };
+
+    add(static_cast<uint32_t>(cursor));
+
+    while (triangles < max_triangles) {
+      const Vec3f centre = centroid_sum / static_cast<float>(triangles);
+      const auto normal_length = normal_sum.length();
+      const Vec3f normal =
+          normal_length > 0 ? Vec3f{normal_sum / normal_length} : Vec3f{};
+      const float scale = 1.0F / std::max(radius, 1e-6F);
+
+      uint32_t best = kNone;
+      float best_score = std::numeric_limits<float>::max();
+      std::size_t live = 0;
+      for (const auto t : candidates) {
+        if (emitted[t]) continue;
+        const auto added = new_vertices(t);
+        if (vertex_count + added > max_vertices) continue;
+        candidates[live++] = t;
+
+        // Shared vertices first, then triangles that keep the cone narrow
+        // and the cluster round
+        const float score =
+            static_cast<float>(added) + (1.0F - normals[t].dot(normal)) +
+            0.5F * Vec3f{centroids[t] - centre}.length() * scale;
+        if (score < best_score) {
+          best_score = score;
+          best = t;
+        }
+      }
+      candidates.resize(live);
+
+      if (best == kNone) break;
+      add(best);
+    }
+
+    meshlet.index_count =
+        static_cast<uint32_t>(build.indices.size()) - meshlet.first_index;
+    build.meshlets.push_back(meshlet);
+  }
+
+  // Cache order within each meshlet, on indices local to it so the optimiser
+  // only sizes its tables for the meshlet's own vertices
+  std::vector<uint32_t> local_to_global;
+  std::ranges::fill(vertex_meshlet, kNone);
+  for (uint32_t id = 0; id < build.meshlets.size(); ++id) {
+    auto& meshlet = build.meshlets[id];
+    auto range = std::span(build.indices)
+                     .subspan(meshlet.first_index, meshlet.index_count);
+
+    local_to_global.clear();
+    for (auto& index : range) {
+      if (vertex_meshlet[index] != id) {
+        vertex_meshlet[index] = id;
+        local_to_global.push_back(index);
+      }
+    }
+    for (auto& index : range) {
+      index = static_cast<uint32_t>(
+          std::ranges::find(local_to_global, index) - local_to_global.begin());
+    }
+
+    optimize_vertex_cache(range, local_to_global.size());
+    for (auto& index : range) index = local_to_global[index];
+
+    compute_bounds(meshlet, positions, build.indices);
+  }
+
+  return build;
+}
+
+auto meshlet_backfacing(const Meshlet& meshlet, const Vec3f& camera_position)
+    -> bool {
+  const Vec3f to_centre = meshlet.sphere.center - camera_position;
+  return to_centre.dot(meshlet.cone_axis) >=
+         meshlet.cone_cutoff * to_centre.length() + meshlet.sphere.radius;
+}
+
+}  // namespace wren::math
@@ -0,0 +1,94 @@
+#include "quantize.hpp"
+
+#include <bit>
+
+namespace wren::math {
+
+namespace {
+
+auto sign_not_zero(float value) -> float { return value >= 0 ? 1.0F : -1.0F; }
+
+}  // namespace
+
+auto quantize_half(float value) -> uint16_t {
+  const auto bits = std::bit_cast<uint32_t>(value);
+  const uint32_t sign = (bits >> 16U) & 0x8000U;
+  const uint32_t exponent = (bits >> 23U) & 0xffU;
+  uint32_t mantissa = bits & 0x7fffffU;
+
+  // Infinity and NaN, NaNs keep a mantissa bit so they stay NaNs
+  if (exponent == 0xffU) {
+    return static_cast<uint16_t>(sign | 0x7c00U | (mantissa != 0 ? 0x200U : 0));
+  }
+
+  const int half_exponent = static_cast<int>(exponent) - 127 + 15;
+  if (half_exponent >= 31) return static_cast<uint16_t>(sign | 0x7c00U);
+
+  if (half_exponent <= 0) {
+    // Too small even for a subnormal half
+    if (half_exponent < -10) return static_cast<uint16_t>(sign);
+
+    mantissa |= 0x800000U;
+    const auto shift = static_cast<uint32_t>(14 - half_exponent);
+    uint32_t half_mantissa = mantissa >> shift;
+    const uint32_t remainder = mantissa & ((1U << shift) - 1U);
+    const uint32_t halfway = 1U << (shift - 1U);
+    if (remainder > halfway ||
+        (remainder == halfway && (half_mantissa & 1U) != 0)) {
+      ++half_mantissa;
+    }
+    return static_cast<uint16_t>(sign | half_mantissa);
+  }
+
+  uint32_t half = sign | (static_cast<uint32_t>(half_exponent) << 10U) |
+                  (mantissa >> 13U);
+  // Rounding up can carry into the exponent, which is still the right answer
+  const uint32_t remainder = mantissa & 0x1fffU;
+  if (remainder > 0x1000U || (remainder == 0x1000U && (half & 1U) != 0)) {
+    ++half;
+  }
+  return static_cast<uint16_t>(half);
+}
+
+auto dequantize_half(uint16_t half) -> float {
+  const uint32_t sign = static_cast<uint32_t>(half & 0x8000U) << 16U;
+  const uint32_t exponent = (half >> 10U) & 0x1fU;
+  const uint32_t mantissa = half & 0x3ffU;
+
+  if (exponent == 0) {
+    const auto magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+    return sign != 0 ? -magnitude : magnitude;
+  }
+
+  if (exponent == 31) {
+    return std::bit_cast<float>(sign | 0x7f800000U | (mantissa << 13U));
+  }
+
+  return std::bit_cast<float>(sign | ((exponent - 15 + 127) << 23U) |
+                              (mantissa << 13U));
+}
+
+auto octahedral_encode(const Vec3f& normal) -> Vec2f {
+  const auto l1 =
+      std::abs(normal.x()) + std::abs(normal.y()) + std::abs(normal.z());
+  if (l1 == 0) return {0, 0};
+
+  const float x = normal.x() / l1;
+  const float y = normal.y() / l1;
+  if (normal.z() >= 0) return {x, y};
+
+  // The lower half folds over the diagonals of the square
+  return {(1.0F - std::abs(y)) * sign_not_zero(x),
+          (1.0F - std::abs(x)) * sign_not_zero(y)};
+}
+
+auto octahedral_decode(const Vec2f& encoded) -> Vec3f {
+  Vec3f normal{encoded.x(), encoded.y(),
+               1.0F - std::abs(encoded.x()) - std::abs(encoded.y())};
+  const float t = std::max(-normal.z(), 0.0F);
+  normal.at(0) += normal.x() >= 0 ? -t : t;
+  normal.at(1) += normal.y() >= 0 ? -t : t;
+  return normal.normalized();
+}
+
+}  // namespace wren::math
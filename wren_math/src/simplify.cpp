@@ -0,0 +1,259 @@
+#include "simplify.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <queue>
+#include <unordered_map>
+
+#include "mesh_optimize.hpp"
+
+namespace wren::math {
+
+namespace {
+
+//! @brief Symmetric 4x4 matrix summing squared distances to planes
+struct Quadric {
+  // a², ab, ac, ad, b², bc, bd, c², cd, d²
+  std::array<double, 10> q{};
+
+  static auto from_plane(double a, double b, double c, double d,
+                         double weight) -> Quadric {
+    return {{a * a * weight, a * b * weight, a * c * weight, a * d * weight,
+             b * b * weight, b * c * weight, b * d * weight, c * c * weight,
+             c * d * weight, d * d * weight}};
+  }
+
+  void operator+=(const Quadric& other) {
+    for (std::size_t i = 0; i < q.size(); ++i) q.at(i) += other.q.at(i);
+  }
+
+  [[nodiscard]] auto evaluate(const Vec3f& p) const -> double {
+    const double x = p.x();
+    const double y = p.y();
+    const double z = p.z();
+    const double error = q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z +
+                         2 * q[3] * x + q[4] * y * y + 2 * q[5] * y * z +
+                         2 * q[6] * y + q[7] * z * z + 2 * q[8] * z + q[9];
+    return std::max(error, 0.0);
+  }
+};
+
+//! @brief Planes at open edges are weighted up so boundaries stay put
+constexpr double kBoundaryWeight = 100.0;
+
+struct Collapse {
+  double cost;
+  uint32_t from;
+  uint32_t to;
+  uint32_t from_version;
+  uint32_t to_version;
+
+  auto operator>(const Collapse& other) const { return cost > other.cost; }
+};
+
+auto edge_key(uint32_t v0, uint32_t v1) -> uint64_t {
+  const auto [low, high] = std::minmax(v0, v1);
+  return (static_cast<uint64_t>(low) << 32U) | high;
+}
+
+auto triangle_normal(const Vec3f& a, const Vec3f& b, const Vec3f& c)
+    -> Vec3f {
+  return Vec3f{b - a} % Vec3f{c - a};
+}
+
+}  // namespace
+
+auto simplify(std::span<const Vec3f> positions,
+              std::span<const uint32_t> indices,
+              std::size_t target_index_count, float max_error)
+    -> SimplifyResult {
+  const auto remap = weld_positions(positions);
+
+  std::vector<std::array<uint32_t, 3>> triangles;
+  triangles.reserve(indices.size() / 3);
+  for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+    const std::array triangle = {remap[indices[i]], remap[indices[i + 1]],
+                                 remap[indices[i + 2]]};
+    if (triangle[0] == triangle[1] || triangle[1] == triangle[2] ||
+        triangle[0] == triangle[2]) {
+      continue;
+    }
+    triangles.push_back(triangle);
+  }
+
+  std::vector<bool> triangle_alive(triangles.size(), true);
+  std::size_t alive_count = triangles.size();
+
+  std::vector<std::vector<uint32_t>> vertex_triangles(positions.size());
+  std::vector<Quadric> quadrics(positions.size());
+  std::unordered_map<uint64_t, uint32_t> edge_uses;
+
+  for (uint32_t t = 0; t < triangles.size(); ++t) {
+    const auto& [a, b, c] = triangles[t];
+    const auto normal =
+        triangle_normal(positions[a], positions[b], positions[c]);
+    const auto length = normal.length();
+    if (length > 0) {
+      const Vec3f n = normal / length;
+      const auto plane =
+          Quadric::from_plane(n.x(), n.y(), n.z(), -n.dot(positions[a]), 1.0);
+      for (const auto v : triangles[t]) quadrics[v] += plane;
+    }
+
+    for (std::size_t e = 0; e < 3; ++e) {
+      const auto v0 = triangles[t].at(e);
+      const auto v1 = triangles[t].at((e + 1) % 3);
+      vertex_triangles[v0].push_back(t);
+      ++edge_uses[edge_key(v0, v1)];
+    }
+  }
+
+  // An edge used by one triangle is on a boundary, add a plane through it
+  // perpendicular to the triangle so moving off the edge costs something
+  for (const auto& triangle : triangles) {
+    const auto normal = triangle_normal(
+        positions[triangle[0]], positions[triangle[1]], positions[triangle[2]]);
+    for (std::size_t e = 0; e < 3; ++e) {
+      const auto v0 = triangle.at(e);
+      const auto v1 = triangle.at((e + 1) % 3);
+      if (edge_uses[edge_key(v0, v1)] != 1) continue;
+
+      const Vec3f edge = positions[v1] - positions[v0];
+      const Vec3f side = edge % normal;
+      const auto length = side.length();
+      if (length == 0) continue;
+
+      const Vec3f n = side / length;
+      const auto plane = Quadric::from_plane(
+          n.x(), n.y(), n.z(), -n.dot(positions[v0]), kBoundaryWeight);
+      quadrics[v0] += plane;
+      quadrics[v1] += plane;
+    }
+  }
+
+  std::vector<uint32_t> version(positions.size(), 0);
+  std::vector<bool> removed(positions.size(), false);
+
+  std::priority_queue<Collapse, std::vector<Collapse>, std::greater<>> queue;
+  const auto push_collapse = [&](uint32_t from, uint32_t to) {
+    auto quadric = quadrics[from];
+    quadric += quadrics[to];
+    queue.push({quadric.evaluate(positions[to]), from, to, version[from],
+                version[to]});
+  };
+
+  for (const auto& [edge, _] : edge_uses) {
+    const auto v0 = static_cast<uint32_t>(edge >> 32U);
+    const auto v1 = static_cast<uint32_t>(edge);
+    push_collapse(v0, v1);
+    push_collapse(v1, v0);
+  }
+
+  const double max_cost = static_cast<double>(max_error) * max_error;
+  double error = 0;
+
+  // Would moving from onto to flip any of from's remaining triangles
+  const auto flips = [&](uint32_t from, uint32_t to) {
+    for (const auto t : vertex_triangles[from]) {
+      if (!triangle_alive[t]) continue;
+      const auto& triangle = triangles[t];
+      if (std::ranges::find(triangle, to) != triangle.end()) continue;
+
+      std::array<Vec3f, 3> moved = {positions[triangle[0]],
+                                    positions[triangle[1]],
+                                    positions[triangle[2]]};
+      const auto before = triangle_normal(moved[0], moved[1], moved[2]);
+      for (std::size_t i = 0; i < 3; ++i) {
+        if (triangle.at(i) == from) moved.at(i) = positions[to];
+      }
+      const auto after = triangle_normal(moved[0], moved[1], moved[2]);
+      if (before.dot(after) <= 0) return true;
+    }
+    return false;
+  };
+
+  while (alive_count * 3 > target_index_count && !queue.empty()) {
+    const auto collapse = queue.top();
+    queue.pop();
+
+    if (removed[collapse.from] || removed[collapse.to] ||
+        version[collapse.from] != collapse.from_version ||
+        version[collapse.to] != collapse.to_version) {
+      continue;
+    }
+
+    if (collapse.cost > max_cost) break;
+    if (flips(collapse.from, collapse.to)) continue;
+
+    error = std::max(error, collapse.cost);
+
+    // Triangles on the edge disappear, the rest move over to `to`
+    std::vector<uint32_t> neighbours;
+    for (const auto t : vertex_triangles[collapse.from]) {
+      if (!triangle_alive[t]) continue;
+      auto& triangle = triangles[t];
+      if (std::ranges::find(triangle, collapse.to) != triangle.end()) {
+        triangle_alive[t] = false;
+        --alive_count;
+        continue;
+      }
+
+      std::ranges::replace(triangle, collapse.from, collapse.to);
+      vertex_triangles[collapse.to].push_back(t);
+    }
+
+    quadrics[collapse.to] += quadrics[collapse.from];
+    removed[collapse.from] = true;
+    vertex_triangles[collapse.from].clear();
+    ++version[collapse.to];
+
+    // Every edge around `to` now has a different cost, the version bump above
+    // invalidates the queued ones
+    std::erase_if(vertex_triangles[collapse.to],
+                  [&](uint32_t t) { return !triangle_alive[t]; });
+    for (const auto t : vertex_triangles[collapse.to]) {
+      for (const auto v : triangles[t]) {
+        if (v != collapse.to) neighbours.push_back(v);
+      }
+    }
+    std::ranges::sort(neighbours);
+    const auto [first, last] = std::ranges::unique(neighbours);
+    neighbours.erase(first, last);
+
+    for (const auto v : neighbours) {
+      push_collapse(collapse.to, v);
+      push_collapse(v, collapse.to);
+    }
+  }
+
+  SimplifyResult result;
+  result.error = static_cast<float>(std::sqrt(error));
+  result.indices.reserve(alive_count * 3);
+  for (std::size_t t = 0; t < triangles.size(); ++t) {
+    if (!triangle_alive[t]) continue;
+    result.indices.insert(result.indices.end(), triangles[t].begin(),
+                          triangles[t].end());
+  }
+
+  return result;
+}
+
+auto ScreenProjection::from_camera(const Mat4f& view, const Mat4f& projection,
+                                   float viewport_height) -> ScreenProjection {
+  return {view, std::abs(projection.at(1, 1)) * viewport_height * 0.5F};
+}
+
+auto ScreenProjection::pixels_per_unit(const Vec3f& position) const -> float {
+  Vec3f view_position;
+  for (std::size_t row = 0; row < 3; ++row) {
+    view_position.at(row) = view.at(0, row) * position.x() +
+                            view.at(1, row) * position.y() +
+                            view.at(2, row) * position.z() + view.at(3, row);
+  }
+
+  constexpr float kMinDistance = 1e-4F;
+  return scale / std::max(view_position.length(), kMinDistance);
+}
+
+}  // namespace wren::math
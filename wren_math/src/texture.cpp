@@ -0,0 +1,267 @@
+#include "texture.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace wren::math {
+
+namespace {
+
+using Rgba = std::array<int32_t, 4>;
+
+auto srgb_to_linear_table() -> const std::array<float, 256>& {
+  static const auto table = [] {
+    std::array<float, 256> t{};
+    for (std::size_t i = 0; i < t.size(); ++i) {
+      const auto c = static_cast<float>(i) / 255.0F;
+      t.at(i) = c <= 0.04045F ? c / 12.92F
+                              : std::pow((c + 0.055F) / 1.055F, 2.4F);
+    }
+    return t;
+  }();
+  return table;
+}
+
+auto linear_to_srgb(float c) -> uint8_t {
+  c = std::clamp(c, 0.0F, 1.0F);
+  const auto s = c <= 0.0031308F ? c * 12.92F
+                                 : 1.055F * std::pow(c, 1.0F / 2.4F) - 0.055F;
+  return static_cast<uint8_t>(std::lround(s * 255.0F));
+}
+
+auto to_565(const Rgba& c) -> uint16_t {
+  const auto r = (c[0] * 31 + 127) / 255;
+  const auto g = (c[1] * 63 + 127) / 255;
+  const auto b = (c[2] * 31 + 127) / 255;
+  return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+auto from_565(uint16_t c) -> Rgba {
+  const int32_t r = (c >> 11) & 31;
+  const int32_t g = (c >> 5) & 63;
+  const int32_t b = c & 31;
+  // Replicate the top bits so 0 and the maximum map to 0 and 255
+  return {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255};
+}
+
+//! @brief The four colours a block's endpoints select between, the fourth is
+//! transparent black in three colour mode (c0 <= c1)
+auto palette(uint16_t c0, uint16_t c1) -> std::array<Rgba, 4> {
+  const auto a = from_565(c0);
+  const auto b = from_565(c1);
+  std::array<Rgba, 4> colours = {a, b, Rgba{}, Rgba{}};
+  for (std::size_t i = 0; i < 3; ++i) {
+    if (c0 > c1) {
+      colours[2][i] = (2 * a[i] + b[i]) / 3;
+      colours[3][i] = (a[i] + 2 * b[i]) / 3;
+    } else {
+      colours[2][i] = (a[i] + b[i]) / 2;
+    }
+  }
+  colours[2][3] = 255;
+  colours[3][3] = c0 > c1 ? 255 : 0;
+  return colours;
+}
+
+auto distance(const Rgba& a, const Rgba& b) -> int32_t {
+  int32_t d = 0;
+  for (std::size_t i = 0; i < 3; ++i) d += (a[i] - b[i]) * (a[i] - b[i]);
+  return d;
+}
+
+auto encode_block(const std::array<Rgba, 16>& texels)
+    -> std::array<std::byte, kBc1BlockSize> {
+  bool transparent = false;
+  Rgba lo{255, 255, 255, 0};
+  Rgba hi{0, 0, 0, 0};
+  Rgba sum{};
+  int32_t opaque = 0;
+  for (const auto& t : texels) {
+    if (t[3] < 128) {
+      transparent = true;
+      continue;
+    }
+    for (std::size_t i = 0; i < 3; ++i) {
+      lo[i] = std::min(lo[i], t[i]);
+      hi[i] = std::max(hi[i], t[i]);
+      sum[i] += t[i];
+    }
+    ++opaque;
+  }
+
+  uint16_t c0 = 0;
+  uint16_t c1 = 0;
+  if (opaque > 0) {
+    // The box has four diagonals, take the one green and blue vary along
+    // with red on, by the sign of their covariance with red
+    std::array<int64_t, 3> covariance{};
+    for (const auto& t : texels) {
+      if (t[3] < 128) continue;
+      const auto r = int64_t{t[0]} * opaque - sum[0];
+      for (std::size_t i = 1; i < 3; ++i) {
+        covariance.at(i) += r * (int64_t{t[i]} * opaque - sum[i]);
+      }
+    }
+    for (std::size_t i = 1; i < 3; ++i) {
+      if (covariance.at(i) < 0) std::swap(lo[i], hi[i]);
+    }
+
+    // Pulling the endpoints in a sixteenth of the range lowers the error of
+    // the texels between them more than it costs the extremes
+    for (std::size_t i = 0; i < 3; ++i) {
+      const auto inset = (hi[i] - lo[i]) / 16;
+      lo[i] += inset;
+      hi[i] -= inset;
+    }
+
+    c0 = to_565(hi);
+    c1 = to_565(lo);
+  }
+
+  // Four colour mode needs c0 > c1, three colour mode c0 <= c1
+  if (transparent ? c0 > c1 : c0 < c1) std::swap(c0, c1);
+
+  const auto colours = palette(c0, c1);
+  const std::size_t choices = transparent || c0 == c1 ? 3 : 4;
+
+  uint32_t indices = 0;
+  for (std::size_t t = 0; t < texels.size(); ++t) {
+    uint32_t best = 3;
+    if (texels.at(t)[3] >= 128) {
+      best = 0;
+      auto best_distance = std::numeric_limits<int32_t>::max();
+      for (uint32_t i = 0; i < choices; ++i) {
+        const auto d = distance(texels.at(t), colours.at(i));
+        if (d < best_distance) {
+          best = i;
+          best_distance = d;
+        }
+      }
+    }
+    indices |= best << (2 * t);
+  }
+
+  std::array<std::byte, kBc1BlockSize> block{};
+  std::memcpy(block.data(), &c0, 2);
+  std::memcpy(block.data() + 2, &c1, 2);
+  std::memcpy(block.data() + 4, &indices, 4);
+  return block;
+}
+
+}  // namespace
+
+auto mip_count(uint32_t width, uint32_t height) -> uint32_t {
+  return std::bit_width(std::max({width, height, 1U}));
+}
+
+auto mip_for_screen_size(uint32_t texels, float pixels, uint32_t mip_count)
+    -> uint32_t {
+  if (mip_count == 0) return 0;
+  if (!(pixels >= 1.0F)) return mip_count - 1;
+
+  const auto ratio = static_cast<float>(texels) / pixels;
+  if (ratio <= 1.0F) return 0;
+  // Rounded down, a level too fine beats a blurry one
+  const auto mip = static_cast<uint32_t>(std::floor(std::log2(ratio)));
+  return std::min(mip, mip_count - 1);
+}
+
+auto downsample_rgba8(std::span<const uint8_t> pixels, uint32_t width,
+                      uint32_t height, bool srgb) -> std::vector<uint8_t> {
+  const auto out_width = std::max(width / 2, 1U);
+  const auto out_height = std::max(height / 2, 1U);
+  const auto& to_linear = srgb_to_linear_table();
+
+  std::vector<uint8_t> out(static_cast<std::size_t>(out_width) * out_height *
+                           4);
+  for (uint32_t y = 0; y < out_height; ++y) {
+    for (uint32_t x = 0; x < out_width; ++x) {
+      std::array<float, 4> sum{};
+      for (uint32_t dy = 0; dy < 2; ++dy) {
+        for (uint32_t dx = 0; dx < 2; ++dx) {
+          const auto sx = std::min(x * 2 + dx, width - 1);
+          const auto sy = std::min(y * 2 + dy, height - 1);
+          const auto* p = &pixels[(static_cast<std::size_t>(sy) * width + sx) *
+                                  4];
+          for (std::size_t c = 0; c < 3; ++c) {
+            sum.at(c) += srgb ? to_linear.at(p[c]) : p[c] / 255.0F;
+          }
+          sum[3] += p[3] / 255.0F;
+        }
+      }
+
+      auto* o = &out[(static_cast<std::size_t>(y) * out_width + x) * 4];
+      for (std::size_t c = 0; c < 4; ++c) {
+        const auto average = sum.at(c) / 4.0F;
+        o[c] = srgb && c < 3
+                   ? linear_to_srgb(average)
+                   : static_cast<uint8_t>(std::lround(average * 255.0F));
+      }
+    }
+  }
+  return out;
+}
+
+auto encode_bc1(std::span<const uint8_t> pixels, uint32_t width,
+                uint32_t height) -> std::vector<std::byte> {
+  std::vector<std::byte> out;
+  out.reserve(bc1_size(width, height));
+
+  for (uint32_t by = 0; by < height; by += 4) {
+    for (uint32_t bx = 0; bx < width; bx += 4) {
+      // Blocks hanging over the edge repeat the last row and column
+      std::array<Rgba, 16> texels{};
+      for (uint32_t y = 0; y < 4; ++y) {
+        for (uint32_t x = 0; x < 4; ++x) {
+          const auto sx = std::min(bx + x, width - 1);
+          const auto sy = std::min(by + y, height - 1);
+          const auto* p =
+              &pixels[(static_cast<std::size_t>(sy) * width + sx) * 4];
+          texels.at(y * 4 + x) = {p[0], p[1], p[2], p[3]};
+        }
+      }
+
+      const auto block = encode_block(texels);
+      out.insert(out.end(), block.begin(), block.end());
+    }
+  }
+  return out;
+}
+
+auto decode_bc1(std::span<const std::byte> blocks, uint32_t width,
+                uint32_t height) -> std::vector<uint8_t> {
+  std::vector<uint8_t> out(static_cast<std::size_t>(width) * height * 4);
+  if (blocks.size() < bc1_size(width, height)) return out;
+
+  const auto* block = blocks.data();
+  for (uint32_t by = 0; by < height; by += 4) {
+    for (uint32_t bx = 0; bx < width; bx += 4) {
+      uint16_t c0 = 0;
+      uint16_t c1 = 0;
+      uint32_t indices = 0;
+      std::memcpy(&c0, block, 2);
+      std::memcpy(&c1, block + 2, 2);
+      std::memcpy(&indices, block + 4, 4);
+      block += kBc1BlockSize;
+
+      const auto colours = palette(c0, c1);
+      for (uint32_t y = 0; y < 4 && by + y < height; ++y) {
+        for (uint32_t x = 0; x < 4 && bx + x < width; ++x) {
+          const auto& c = colours.at((indices >> (2 * (y * 4 + x))) & 3);
+          auto* o =
+              &out[(static_cast<std::size_t>(by + y) * width + bx + x) * 4];
+          for (std::size_t i = 0; i < 4; ++i) {
+            o[i] = static_cast<uint8_t>(c.at(i));
+          }
+        }
+      }
+    }
+  }
+  return out;
+}
+
+}  // namespace wren::math
@@ -0,0 +1,64 @@
+#include <boost/test/unit_test.hpp>
+#include <wren/math/bounds.hpp>
+#include <wren/math/geometry.hpp>
+#include <wren/math/matrix.hpp>
+#include <wren/math/vector.hpp>
+
+BOOST_AUTO_TEST_SUITE(BOUNDS)
+
+BOOST_AUTO_TEST_CASE(AabbFromPoints) {
+  const std::array<wren::math::Vec3f, 3> points = {
+      wren::math::Vec3f{-1, 0, 2},
+      wren::math::Vec3f{3, -2, 0},
+      wren::math::Vec3f{1, 4, 1},
+  };
+
+  const auto aabb = wren::math::AABB::from_points(points);
+  BOOST_TEST(!aabb.empty());
+  BOOST_TEST((aabb.min == wren::math::Vec3f{-1, -2, 0}));
+  BOOST_TEST((aabb.max == wren::math::Vec3f{3, 4, 2}));
+  BOOST_TEST((aabb.center() == wren::math::Vec3f{1, 1, 1}));
+
+  BOOST_TEST(wren::math::AABB{}.empty());
+}
+
+BOOST_AUTO_TEST_CASE(SphereTransform) {
+  const wren::math::BoundingSphere sphere{{1, 0, 0}, 1};
+
+  auto model = wren::math::Mat4f::identity();
+  model.at(0, 0) = 2;
+  model.at(1, 1) = 3;
+  model.at(3, 2) = 5;
+
+  const auto moved = sphere.transformed(model);
+  BOOST_TEST((moved.center == wren::math::Vec3f{2, 0, 5}));
+  BOOST_TEST(moved.radius == 3);
+}
+
+BOOST_AUTO_TEST_CASE(FrustumSpheres) {
+  // Camera at the origin looking down -z
+  const auto proj = wren::math::perspective(wren::math::radians(90.0F), 1.0F,
+                                            0.1F, 100.0F);
+  const auto frustum = wren::math::Frustum::from_matrix(proj);
+
+  struct Test {
+    wren::math::BoundingSphere sphere;
+    bool visible;
+  };
+
+  const std::array tests = {
+      Test{{{0, 0, -10}, 1}, true},
+      Test{{{0, 0, 10}, 1}, false},
+      Test{{{50, 0, -10}, 1}, false},
+      Test{{{10.5, 0, -10}, 1}, true},
+      Test{{{0, -50, -10}, 1}, false},
+      Test{{{0, 0, -200}, 1}, false},
+      Test{{{0, 0, -100.5}, 1}, true},
+  };
+
+  for (const auto &test : tests) {
+    BOOST_TEST(frustum.intersects(test.sphere) == test.visible);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,84 @@
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include <vector>
+#include <wren/math/bounds.hpp>
+#include <wren/math/culling.hpp>
+#include <wren/math/geometry.hpp>
+
+namespace {
+
+auto make_frustum() {
+  const auto proj = wren::math::perspective(wren::math::radians(60.0F),
+                                            16.0F / 9.0F, 0.1F, 500.0F);
+  return wren::math::Frustum::from_matrix(proj);
+}
+
+auto random_spheres(std::size_t count) {
+  std::mt19937 rng(42);  // NOLINT
+  std::uniform_real_distribution<float> position(-600.0F, 600.0F);
+  std::uniform_real_distribution<float> radius(0.1F, 20.0F);
+
+  wren::math::SphereSet spheres;
+  spheres.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    spheres.push_back(
+        {{position(rng), position(rng), position(rng)}, radius(rng)});
+  }
+  return spheres;
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(CULLING)
+
+BOOST_AUTO_TEST_CASE(MatchesSphereTest) {
+  const auto frustum = make_frustum();
+  // Not a multiple of the lane count so the tail is covered too
+  const auto spheres = random_spheres(1003);
+
+  std::vector<uint8_t> visible(spheres.size(), 2);
+  wren::math::cull_spheres(frustum, spheres, visible);
+
+  std::size_t visible_count = 0;
+  for (std::size_t i = 0; i < spheres.size(); ++i) {
+    const wren::math::BoundingSphere sphere{
+        {spheres.x()[i], spheres.y()[i], spheres.z()[i]},
+        spheres.radius()[i]};
+    BOOST_TEST(visible[i] == (frustum.intersects(sphere) ? 1 : 0));
+    visible_count += visible[i];
+  }
+
+  BOOST_TEST(visible_count > 0);
+  BOOST_TEST(visible_count < spheres.size());
+}
+
+BOOST_AUTO_TEST_CASE(SubRange) {
+  const auto frustum = make_frustum();
+  const auto spheres = random_spheres(100);
+
+  std::vector<uint8_t> expected(spheres.size(), 2);
+  wren::math::cull_spheres_scalar(frustum, spheres, expected, 0,
+                                  spheres.size());
+
+  // Unaligned range, everything outside it is left alone
+  std::vector<uint8_t> visible(spheres.size(), 2);
+  wren::math::cull_spheres(frustum, spheres, visible, 3, 61);
+  for (std::size_t i = 0; i < spheres.size(); ++i) {
+    BOOST_TEST(visible[i] == (i >= 3 && i < 61 ? expected[i] : 2));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(MatchesScalar) {
+  const auto frustum = make_frustum();
+  const auto spheres = random_spheres((1 << 16) + 5);
+
+  std::vector<uint8_t> expected(spheres.size());
+  wren::math::cull_spheres_scalar(frustum, spheres, expected, 0,
+                                  spheres.size());
+
+  std::vector<uint8_t> visible(spheres.size());
+  wren::math::cull_spheres(frustum, spheres, visible);
+  BOOST_TEST(visible == expected, boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
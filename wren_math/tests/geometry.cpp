@@ -34,4 +34,28 @@ BOOST_AUTO_TEST_CASE(TRANSLATE) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(INVERSE_AFFINE) {
+  auto model = wren::math::rotate(wren::math::Mat4f::identity(), 0.7F,
+                                  wren::math::Vec3f{1, 2, 3}.normalized());
+  model.at(0, 0) *= 2;
+  model.at(1, 2) += 0.5F;
+  model.at(3, 0) = 4;
+  model.at(3, 1) = -1;
+  model.at(3, 2) = 2;
+  model.at(3, 3) = 1;
+
+  auto inverse = wren::math::inverse_affine(model);
+  const auto product = inverse * model;
+  const auto identity = wren::math::Mat4f::identity();
+  for (std::size_t col = 0; col < 4; ++col) {
+    for (std::size_t row = 0; row < 4; ++row) {
+      BOOST_TEST(product.at(col, row) == identity.at(col, row),
+                 boost::test_tools::tolerance(1e-5F));
+    }
+  }
+
+  wren::math::Mat4f singular{};
+  BOOST_TEST((wren::math::inverse_affine(singular) == wren::math::Mat4f{}));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
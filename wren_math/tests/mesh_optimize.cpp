@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <array>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <wren/math/mesh_optimize.hpp>
+#include <wren/math/vector.hpp>
+
+namespace {
+
+struct Grid {
+  std::vector<wren::math::Vec3f> positions;
+  std::vector<uint32_t> indices;
+};
+
+//! @brief A size x size grid of quads with its triangles shuffled, like the
+//! file order of an STL
+auto make_shuffled_grid(uint32_t size) {
+  Grid grid;
+  for (uint32_t y = 0; y <= size; ++y) {
+    for (uint32_t x = 0; x <= size; ++x) {
+      grid.positions.emplace_back(static_cast<float>(x),
+                                  static_cast<float>(y), 0.0F);
+    }
+  }
+
+  std::vector<std::array<uint32_t, 3>> triangles;
+  for (uint32_t y = 0; y < size; ++y) {
+    for (uint32_t x = 0; x < size; ++x) {
+      const auto i = y * (size + 1) + x;
+      triangles.push_back({i, i + 1, i + size + 1});
+      triangles.push_back({i + 1, i + size + 2, i + size + 1});
+    }
+  }
+
+  std::mt19937 rng(7);
+  std::ranges::shuffle(triangles, rng);
+  for (const auto& triangle : triangles) {
+    grid.indices.insert(grid.indices.end(), triangle.begin(), triangle.end());
+  }
+
+  return grid;
+}
+
+//! @brief Triangles rotated to start at their smallest index and sorted, equal
+//! for two lists drawing the same triangles with the same winding
+auto canonical(const std::vector<uint32_t>& indices) {
+  std::vector<std::array<uint32_t, 3>> triangles;
+  for (std::size_t i = 0; i < indices.size(); i += 3) {
+    std::array triangle = {indices[i], indices[i + 1], indices[i + 2]};
+    std::ranges::rotate(triangle, std::ranges::min_element(triangle));
+    triangles.push_back(triangle);
+  }
+  std::ranges::sort(triangles);
+  return triangles;
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(MESH_OPTIMIZE)
+
+BOOST_AUTO_TEST_CASE(MissRatio) {
+  // Two triangles sharing an edge miss 4 vertices
+  const std::vector<uint32_t> quad = {0, 1, 2, 2, 1, 3};
+  BOOST_TEST(wren::math::vertex_cache_miss_ratio(quad, 4) == 2.0F);
+
+  // A cache of 3 keeps nothing across these two
+  const std::vector<uint32_t> apart = {0, 1, 2, 3, 4, 5, 0, 1, 2};
+  BOOST_TEST(wren::math::vertex_cache_miss_ratio(apart, 6, 3) == 3.0F);
+}
+
+BOOST_AUTO_TEST_CASE(VertexCache) {
+  auto grid = make_shuffled_grid(64);
+  const auto before = wren::math::vertex_cache_miss_ratio(
+      grid.indices, grid.positions.size());
+
+  auto optimized = grid.indices;
+  wren::math::optimize_vertex_cache(optimized, grid.positions.size());
+  const auto after =
+      wren::math::vertex_cache_miss_ratio(optimized, grid.positions.size());
+
+  BOOST_TEST_MESSAGE("ACMR " << before << " -> " << after);
+  BOOST_TEST(before > 2.0F);
+  // A regular grid can get close to 0.5 with a cache of 16
+  BOOST_TEST(after < 0.8F);
+  BOOST_TEST((canonical(optimized) == canonical(grid.indices)));
+}
+
+BOOST_AUTO_TEST_CASE(Overdraw) {
+  // A closed box around the origin, every face its own cluster once cache
+  // optimised. Faces facing out are all equally far from the centre, what
+  // matters is that the triangles survive and the cache isn't hurt much. The
+  // order itself is checked by OverdrawDrawsOuterClustersFirst.
+  const std::vector<wren::math::Vec3f> positions = {
+      {-1, -1, -1}, {1, -1, -1}, {1, 1, -1}, {-1, 1, -1},
+      {-1, -1, 1},  {1, -1, 1},  {1, 1, 1},  {-1, 1, 1},
+  };
+  std::vector<uint32_t> indices = {
+      0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4,
+      3, 6, 2, 3, 7, 6, 0, 4, 7, 0, 7, 3, 1, 2, 6, 1, 6, 5,
+  };
+  const auto original = indices;
+
+  wren::math::optimize_vertex_cache(indices, positions.size());
+  const auto cached =
+      wren::math::vertex_cache_miss_ratio(indices, positions.size());
+  wren::math::optimize_overdraw(indices, positions);
+
+  BOOST_TEST((canonical(indices) == canonical(original)));
+  BOOST_TEST(wren::math::vertex_cache_miss_ratio(indices, positions.size()) <=
+             cached * 1.05F);
+
+  auto grid = make_shuffled_grid(32);
+  wren::math::optimize_vertex_cache(grid.indices, grid.positions.size());
+  const auto grid_cached =
+      wren::math::vertex_cache_miss_ratio(grid.indices, grid.positions.size());
+  const auto grid_triangles = canonical(grid.indices);
+  wren::math::optimize_overdraw(grid.indices, grid.positions);
+
+  BOOST_TEST((canonical(grid.indices) == grid_triangles));
+  BOOST_TEST(wren::math::vertex_cache_miss_ratio(
+                 grid.indices, grid.positions.size()) <= grid_cached * 1.05F);
+}
+
+BOOST_AUTO_TEST_CASE(OverdrawDrawsOuterClustersFirst) {
+  // Three quads that share no vertices, so each is its own cluster: an
+  // interior one at x = 1 facing in towards the centre, and two caps facing
+  // out, the one at z = 4 further out than the one at z = -2. The mesh's
+  // centre is (1/3, 0, 2/3), the caps are 3.33 and 2.67 out along their
+  // normals and the interior quad 0.67 in.
+  const std::vector<wren::math::Vec3f> positions = {
+      {1, -1, -1},  {1, -1, 1},  {1, 1, 1},   {1, 1, -1},
+      {-1, -1, -2}, {-1, 1, -2}, {1, 1, -2},  {1, -1, -2},
+      {-1, -1, 4},  {1, -1, 4},  {1, 1, 4},   {-1, 1, 4},
+  };
+  const std::vector<uint32_t> interior = {0, 1, 2, 0, 2, 3};
+  const std::vector<uint32_t> near_cap = {4, 5, 6, 4, 6, 7};
+  const std::vector<uint32_t> far_cap = {8, 9, 10, 8, 10, 11};
+
+  std::vector<uint32_t> indices;
+  for (const auto* cluster : {&interior, &near_cap, &far_cap}) {
+    indices.insert(indices.end(), cluster->begin(), cluster->end());
+  }
+
+  wren::math::optimize_overdraw(indices, positions);
+
+  std::vector<uint32_t> expected;
+  for (const auto* cluster : {&far_cap, &near_cap, &interior}) {
+    expected.insert(expected.end(), cluster->begin(), cluster->end());
+  }
+  BOOST_TEST(indices == expected, boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(VertexFetch) {
+  // Vertex 1 is unused
+  std::vector<uint32_t> indices = {4, 2, 0, 0, 2, 3};
+  const std::vector<float> vertices = {10, 11, 12, 13, 14};
+
+  const auto remap = wren::math::optimize_vertex_fetch(indices, 5);
+  BOOST_TEST((indices == std::vector<uint32_t>{0, 1, 2, 2, 1, 3}));
+  BOOST_TEST(remap[1] == wren::math::kUnusedVertex);
+
+  const auto remapped =
+      wren::math::remap_vertices<float>(vertices, remap);
+  BOOST_TEST((remapped == std::vector<float>{14, 12, 10, 13}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <array>
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <set>
+#include <vector>
+#include <wren/math/meshlet.hpp>
+#include <wren/math/vector.hpp>
+
+namespace {
+
+struct Sphere {
+  std::vector<wren::math::Vec3f> positions;
+  std::vector<uint32_t> indices;
+};
+
+//! @brief A UV sphere of radius 1 wound counter clockwise from outside
+auto make_sphere(uint32_t rings, uint32_t segments) {
+  Sphere sphere;
+  for (uint32_t r = 0; r <= rings; ++r) {
+    const float phi = std::numbers::pi_v<float> * static_cast<float>(r) /
+                      static_cast<float>(rings);
+    for (uint32_t s = 0; s < segments; ++s) {
+      const float theta = 2 * std::numbers::pi_v<float> *
+                          static_cast<float>(s) /
+                          static_cast<float>(segments);
+      sphere.positions.emplace_back(std::sin(phi) * std::cos(theta),
+                                    std::sin(phi) * std::sin(theta),
+                                    std::cos(phi));
+    }
+  }
+
+  for (uint32_t r = 0; r < rings; ++r) {
+    for (uint32_t s = 0; s < segments; ++s) {
+      const auto a = r * segments + s;
+      const auto b = r * segments + (s + 1) % segments;
+      const auto c = a + segments;
+      const auto d = b + segments;
+      if (r != 0) sphere.indices.insert(sphere.indices.end(), {a, c, b});
+      if (r + 1 != rings) {
+        sphere.indices.insert(sphere.indices.end(), {b, c, d});
+      }
+    }
+  }
+
+  return sphere;
+}
+
+auto normal(const Sphere& sphere, const uint32_t* triangle) {
+  const auto& a = sphere.positions[triangle[0]];
+  const auto& b = sphere.positions[triangle[1]];
+  const auto& c = sphere.positions[triangle[2]];
+  return wren::math::Vec3f{wren::math::Vec3f{b - a} %
+                           wren::math::Vec3f{c - a}};
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(MESHLET)
+
+BOOST_AUTO_TEST_CASE(Limits) {
+  const auto sphere = make_sphere(48, 64);
+  const auto build =
+      wren::math::build_meshlets(sphere.positions, sphere.indices, 64, 124);
+
+  BOOST_TEST(build.indices.size() == sphere.indices.size());
+
+  std::multiset<std::array<uint32_t, 3>> before;
+  std::multiset<std::array<uint32_t, 3>> after;
+  for (std::size_t i = 0; i < sphere.indices.size(); i += 3) {
+    std::array triangle = {sphere.indices[i], sphere.indices[i + 1],
+                           sphere.indices[i + 2]};
+    std::ranges::rotate(triangle, std::ranges::min_element(triangle));
+    before.insert(triangle);
+
+    triangle = {build.indices[i], build.indices[i + 1], build.indices[i + 2]};
+    std::ranges::rotate(triangle, std::ranges::min_element(triangle));
+    after.insert(triangle);
+  }
+  BOOST_TEST((before == after));
+
+  uint32_t next = 0;
+  for (const auto& meshlet : build.meshlets) {
+    BOOST_TEST(meshlet.first_index == next);
+    next += meshlet.index_count;
+
+    BOOST_TEST(meshlet.index_count <= 124 * 3);
+    const std::set<uint32_t> vertices(
+        build.indices.begin() + meshlet.first_index,
+        build.indices.begin() + meshlet.first_index + meshlet.index_count);
+    BOOST_TEST(vertices.size() <= 64);
+
+    for (const auto v : vertices) {
+      const auto distance =
+          wren::math::Vec3f{sphere.positions[v] - meshlet.sphere.center}
+              .length();
+      BOOST_TEST(distance <= meshlet.sphere.radius * 1.0001F);
+    }
+  }
+  BOOST_TEST(next == build.indices.size());
+
+  // Mostly full meshlets
+  const auto triangles = sphere.indices.size() / 3;
+  BOOST_TEST(build.meshlets.size() < triangles / 124 * 2);
+}
+
+BOOST_AUTO_TEST_CASE(ConeCulling) {
+  const auto sphere = make_sphere(32, 48);
+  const auto build = wren::math::build_meshlets(sphere.positions,
+                                                sphere.indices);
+
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> coordinate(-4, 4);
+
+  std::size_t culled = 0;
+  std::size_t tested = 0;
+  for (int i = 0; i < 64; ++i) {
+    const wren::math::Vec3f camera{coordinate(rng), coordinate(rng),
+                                   coordinate(rng)};
+    if (camera.length() < 1.5F) continue;
+
+    for (const auto& meshlet : build.meshlets) {
+      ++tested;
+      if (!wren::math::meshlet_backfacing(meshlet, camera)) continue;
+      ++culled;
+
+      // Culled meshlets must only have triangles facing away
+      for (uint32_t t = 0; t < meshlet.index_count; t += 3) {
+        const auto* triangle = &build.indices[meshlet.first_index + t];
+        const wren::math::Vec3f to_triangle =
+            sphere.positions[triangle[0]] - camera;
+        BOOST_TEST(normal(sphere, triangle).dot(to_triangle) >= 0);
+      }
+    }
+  }
+
+  // Seen from outside roughly half a sphere faces away, the cones should
+  // find a good part of it
+  BOOST_TEST_MESSAGE("culled " << culled << " of " << tested);
+  BOOST_TEST(culled > tested / 5);
+}
+
+BOOST_AUTO_TEST_CASE(FlatCone) {
+  // A flat grid facing +z is culled from below and kept from above
+  std::vector<wren::math::Vec3f> positions;
+  std::vector<uint32_t> indices;
+  for (uint32_t y = 0; y <= 4; ++y) {
+    for (uint32_t x = 0; x <= 4; ++x) {
+      positions.emplace_back(static_cast<float>(x), static_cast<float>(y),
+                             0.0F);
+    }
+  }
+  for (uint32_t y = 0; y < 4; ++y) {
+    for (uint32_t x = 0; x < 4; ++x) {
+      const auto i = y * 5 + x;
+      indices.insert(indices.end(), {i, i + 1, i + 5, i + 1, i + 6, i + 5});
+    }
+  }
+
+  const auto build = wren::math::build_meshlets(positions, indices);
+  BOOST_TEST(build.meshlets.size() == 1);
+
+  const auto& meshlet = build.meshlets.front();
+  BOOST_TEST(meshlet.cone_cutoff < 0.001F);
+  BOOST_TEST(wren::math::meshlet_backfacing(meshlet, {2, 2, -10}));
+  BOOST_TEST(!wren::math::meshlet_backfacing(meshlet, {2, 2, 10}));
+  // Level with the plane some triangles could be seen edge on
+  BOOST_TEST(!wren::math::meshlet_backfacing(meshlet, {-10, 2, 0}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
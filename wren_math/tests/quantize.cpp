@@ -0,0 +1,99 @@
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <limits>
+#include <wren/math/quantize.hpp>
+#include <wren/math/vector.hpp>
+
+BOOST_AUTO_TEST_SUITE(QUANTIZE)
+
+BOOST_AUTO_TEST_CASE(HalfExactValues) {
+  BOOST_TEST(wren::math::quantize_half(0.0F) == 0x0000);
+  BOOST_TEST(wren::math::quantize_half(-0.0F) == 0x8000);
+  BOOST_TEST(wren::math::quantize_half(1.0F) == 0x3c00);
+  BOOST_TEST(wren::math::quantize_half(-2.0F) == 0xc000);
+  BOOST_TEST(wren::math::quantize_half(65504.0F) == 0x7bff);
+  BOOST_TEST(wren::math::quantize_half(1e6F) == 0x7c00);
+  BOOST_TEST(wren::math::quantize_half(
+                 std::numeric_limits<float>::infinity()) == 0x7c00);
+  // Smallest subnormal
+  BOOST_TEST(wren::math::quantize_half(std::ldexp(1.0F, -24)) == 0x0001);
+
+  BOOST_TEST(wren::math::dequantize_half(0x3c00) == 1.0F);
+  BOOST_TEST(wren::math::dequantize_half(0x0001) == std::ldexp(1.0F, -24));
+  BOOST_TEST(std::isnan(wren::math::dequantize_half(
+      wren::math::quantize_half(std::numeric_limits<float>::quiet_NaN()))));
+}
+
+BOOST_AUTO_TEST_CASE(HalfRoundTrip) {
+  // Every finite half survives a round trip through float
+  for (uint32_t bits = 0; bits < 0x10000; ++bits) {
+    const auto half = static_cast<uint16_t>(bits);
+    if ((half & 0x7c00) == 0x7c00) continue;
+    BOOST_TEST(wren::math::quantize_half(wren::math::dequantize_half(half)) ==
+               half);
+  }
+
+  // And floats land within half a step, 11 bits of precision
+  for (float value = -100.0F; value < 100.0F; value += 0.37F) {
+    const auto decoded =
+        wren::math::dequantize_half(wren::math::quantize_half(value));
+    BOOST_TEST(std::abs(decoded - value) <= std::abs(value) / 2048.0F);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(NormalizedIntegers) {
+  BOOST_TEST(wren::math::quantize_snorm<int16_t>(1.0F) == 32767);
+  BOOST_TEST(wren::math::quantize_snorm<int16_t>(-1.0F) == -32767);
+  BOOST_TEST(wren::math::quantize_snorm<int16_t>(2.0F) == 32767);
+  BOOST_TEST(wren::math::quantize_snorm<int16_t>(0.0F) == 0);
+  BOOST_TEST(wren::math::dequantize_snorm<int16_t>(-32768) == -1.0F);
+
+  BOOST_TEST(wren::math::quantize_unorm<uint8_t>(1.0F) == 255);
+  BOOST_TEST(wren::math::quantize_unorm<uint8_t>(0.5F) == 128);
+  BOOST_TEST(wren::math::quantize_unorm<uint8_t>(-1.0F) == 0);
+
+  for (float value = -1.0F; value <= 1.0F; value += 0.01F) {
+    const auto decoded = wren::math::dequantize_snorm(
+        wren::math::quantize_snorm<int16_t>(value));
+    BOOST_TEST(std::abs(decoded - value) <= 0.5F / 32767.0F);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(OctahedralNormals) {
+  // Axes, including the folded lower hemisphere and its seams
+  const std::array<wren::math::Vec3f, 6> axes = {
+      wren::math::Vec3f{1, 0, 0},  wren::math::Vec3f{-1, 0, 0},
+      wren::math::Vec3f{0, 1, 0},  wren::math::Vec3f{0, -1, 0},
+      wren::math::Vec3f{0, 0, 1},  wren::math::Vec3f{0, 0, -1},
+  };
+  for (const auto& axis : axes) {
+    const auto decoded =
+        wren::math::octahedral_decode(wren::math::octahedral_encode(axis));
+    BOOST_TEST(decoded.dot(axis) > 0.9999F);
+  }
+
+  // Quantized to 16 bits per component the direction stays within a tenth of
+  // a degree
+  float worst = 1;
+  for (int i = 0; i < 64; ++i) {
+    for (int j = 0; j < 32; ++j) {
+      const float theta = static_cast<float>(i) * 0.0982F;
+      const float phi = static_cast<float>(j) * 0.0982F;
+      const wren::math::Vec3f normal{std::sin(phi) * std::cos(theta),
+                                     std::sin(phi) * std::sin(theta),
+                                     std::cos(phi)};
+
+      const auto encoded = wren::math::octahedral_encode(normal);
+      const wren::math::Vec2f quantized{
+          wren::math::dequantize_snorm(
+              wren::math::quantize_snorm<int16_t>(encoded.x())),
+          wren::math::dequantize_snorm(
+              wren::math::quantize_snorm<int16_t>(encoded.y()))};
+      worst = std::min(
+          worst, wren::math::octahedral_decode(quantized).dot(normal));
+    }
+  }
+  BOOST_TEST(worst > 0.9999985F);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
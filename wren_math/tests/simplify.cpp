@@ -0,0 +1,137 @@
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <vector>
+#include <wren/math/geometry.hpp>
+#include <wren/math/simplify.hpp>
+#include <wren/math/vector.hpp>
+
+namespace {
+
+struct Grid {
+  std::vector<wren::math::Vec3f> positions;
+  std::vector<uint32_t> indices;
+};
+
+//! @brief A size x size grid of quads over [0, 1], with heights from fn
+auto make_grid(uint32_t size, auto fn) {
+  Grid grid;
+  for (uint32_t y = 0; y <= size; ++y) {
+    for (uint32_t x = 0; x <= size; ++x) {
+      const auto fx = static_cast<float>(x) / size;
+      const auto fy = static_cast<float>(y) / size;
+      grid.positions.emplace_back(fx, fy, fn(fx, fy));
+    }
+  }
+
+  for (uint32_t y = 0; y < size; ++y) {
+    for (uint32_t x = 0; x < size; ++x) {
+      const auto i = y * (size + 1) + x;
+      grid.indices.insert(grid.indices.end(), {i, i + 1, i + size + 1,
+                                               i + 1, i + size + 2,
+                                               i + size + 1});
+    }
+  }
+
+  return grid;
+}
+
+auto area(const Grid& grid, const std::vector<uint32_t>& indices) {
+  float total = 0;
+  for (std::size_t i = 0; i < indices.size(); i += 3) {
+    const wren::math::Vec3f a = grid.positions[indices[i]];
+    const wren::math::Vec3f b = grid.positions[indices[i + 1]];
+    const wren::math::Vec3f c = grid.positions[indices[i + 2]];
+    total += wren::math::Vec3f{b - a}.operator%(c - a).length() / 2;
+  }
+  return total;
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(SIMPLIFY)
+
+BOOST_AUTO_TEST_CASE(FlatGridCollapses) {
+  const auto grid = make_grid(10, [](float, float) { return 0.0F; });
+
+  const auto result = wren::math::simplify(grid.positions, grid.indices, 6);
+
+  // A plane with its boundary kept in place loses no area
+  BOOST_TEST(result.indices.size() < grid.indices.size() / 4);
+  BOOST_TEST(result.error < 1e-3F);
+  BOOST_TEST(std::abs(area(grid, result.indices) - 1.0F) < 1e-4F);
+}
+
+BOOST_AUTO_TEST_CASE(ErrorGrowsWithReduction) {
+  const auto grid = make_grid(32, [](float x, float y) {
+    return 0.1F * std::sin(x * 6.0F) * std::cos(y * 6.0F);
+  });
+
+  float last_error = 0;
+  std::size_t last_count = grid.indices.size();
+  for (const auto ratio : {0.5F, 0.25F, 0.1F}) {
+    const auto target =
+        static_cast<std::size_t>(grid.indices.size() * ratio);
+    const auto result =
+        wren::math::simplify(grid.positions, grid.indices, target);
+
+    BOOST_TEST(result.indices.size() <= target);
+    BOOST_TEST(result.indices.size() < last_count);
+    BOOST_TEST(result.error >= last_error);
+    last_error = result.error;
+    last_count = result.indices.size();
+  }
+}
+
+BOOST_AUTO_TEST_CASE(MaxErrorStops) {
+  const auto grid = make_grid(16, [](float x, float y) {
+    return 0.2F * std::sin(x * 8.0F) * std::cos(y * 8.0F);
+  });
+
+  const auto result =
+      wren::math::simplify(grid.positions, grid.indices, 0, 0.001F);
+  BOOST_TEST(result.error <= 0.001F);
+  BOOST_TEST(!result.indices.empty());
+}
+
+BOOST_AUTO_TEST_CASE(LodHysteresis) {
+  const std::array<float, 3> errors = {0.0F, 0.01F, 0.1F};
+
+  // Far away everything is small, the coarsest level wins
+  BOOST_TEST(wren::math::select_lod(errors, 1.0F, 0) == 2);
+  // Close up the finest level is needed
+  BOOST_TEST(wren::math::select_lod(errors, 1000.0F, 2) == 0);
+
+  // Level 1 is at 0.9 pixels, fine to keep but not enough margin to switch to
+  BOOST_TEST(wren::math::select_lod(errors, 90.0F, 1) == 1);
+  BOOST_TEST(wren::math::select_lod(errors, 90.0F, 0) == 0);
+  // Well below the threshold it switches
+  BOOST_TEST(wren::math::select_lod(errors, 50.0F, 0) == 1);
+}
+
+BOOST_AUTO_TEST_CASE(ScreenScale) {
+  const auto proj = wren::math::perspective(wren::math::radians(90.0F), 1.0F,
+                                            0.1F, 100.0F);
+  const auto projection = wren::math::ScreenProjection::from_camera(
+      wren::math::Mat4f::identity(), proj, 1000.0F);
+
+  // With a 90 degree fov a unit at distance 1 spans half the viewport
+  BOOST_TEST(std::abs(projection.pixels_per_unit({0, 0, -1}) - 500.0F) <
+             1e-2F);
+  BOOST_TEST(std::abs(projection.pixels_per_unit({0, 0, -10}) - 50.0F) <
+             1e-2F);
+}
+
+BOOST_AUTO_TEST_CASE(ScreenProjectionBeforeLayout) {
+  const auto proj = wren::math::perspective(wren::math::radians(90.0F), 1.0F,
+                                            0.1F, 100.0F);
+
+  BOOST_TEST(wren::math::ScreenProjection::from_camera(
+                 wren::math::Mat4f::identity(), proj, 1000.0F)
+                 .valid());
+  // The viewport has no size until the first layout
+  BOOST_TEST(!wren::math::ScreenProjection::from_camera(
+                  wren::math::Mat4f::identity(), proj, 0.0F)
+                  .valid());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,93 @@
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include <vector>
+#include <wren/math/texture.hpp>
+
+BOOST_AUTO_TEST_SUITE(TEXTURE)
+
+BOOST_AUTO_TEST_CASE(MipCounts) {
+  BOOST_TEST(wren::math::mip_count(1, 1) == 1);
+  BOOST_TEST(wren::math::mip_count(256, 64) == 9);
+  BOOST_TEST(wren::math::mip_count(300, 20) == 9);
+
+  BOOST_TEST(wren::math::mip_extent(256, 3) == 32);
+  BOOST_TEST(wren::math::mip_extent(64, 8) == 1);
+}
+
+BOOST_AUTO_TEST_CASE(MipForScreenSize) {
+  BOOST_TEST(wren::math::mip_for_screen_size(1024, 2048.0F, 11) == 0);
+  BOOST_TEST(wren::math::mip_for_screen_size(1024, 256.0F, 11) == 2);
+  // Between two levels the finer one wins
+  BOOST_TEST(wren::math::mip_for_screen_size(1024, 300.0F, 11) == 1);
+  // Off screen only the smallest level is needed
+  BOOST_TEST(wren::math::mip_for_screen_size(1024, 0.0F, 11) == 10);
+}
+
+BOOST_AUTO_TEST_CASE(DownsampleAveragesInLinearSpace) {
+  // Black and white next to each other
+  const std::vector<uint8_t> pixels = {
+      0,   0,   0,   255, 255, 255, 255, 255,  //
+      0,   0,   0,   255, 255, 255, 255, 255,  //
+  };
+
+  const auto linear = wren::math::downsample_rgba8(pixels, 2, 2, false);
+  BOOST_REQUIRE(linear.size() == 4);
+  BOOST_TEST(linear[0] == 128);
+  BOOST_TEST(linear[3] == 255);
+
+  // Half the light of white is brighter than 128 once encoded as sRGB
+  const auto srgb = wren::math::downsample_rgba8(pixels, 2, 2, true);
+  BOOST_TEST(srgb[0] == 188);
+  BOOST_TEST(srgb[3] == 255);
+}
+
+BOOST_AUTO_TEST_CASE(Bc1SolidColourIsExact) {
+  // Representable in 565, so nothing is lost
+  std::vector<uint8_t> pixels;
+  for (int i = 0; i < 6 * 5; ++i) {
+    pixels.insert(pixels.end(), {255, 0, 255, 255});
+  }
+
+  const auto blocks = wren::math::encode_bc1(pixels, 6, 5);
+  BOOST_TEST(blocks.size() == wren::math::bc1_size(6, 5));
+  BOOST_TEST(blocks.size() == 4 * wren::math::kBc1BlockSize);
+
+  const auto decoded = wren::math::decode_bc1(blocks, 6, 5);
+  BOOST_TEST(decoded == pixels);
+}
+
+BOOST_AUTO_TEST_CASE(Bc1GradientStaysClose) {
+  // Colours along a line through RGB, what BC1 blocks represent best
+  std::vector<uint8_t> pixels;
+  for (int y = 0; y < 8; ++y) {
+    for (int x = 0; x < 8; ++x) {
+      const auto v = static_cast<uint8_t>(x * 32);
+      pixels.insert(pixels.end(), {v, static_cast<uint8_t>(255 - v),
+                                   static_cast<uint8_t>(v / 2), 255});
+    }
+  }
+
+  const auto decoded =
+      wren::math::decode_bc1(wren::math::encode_bc1(pixels, 8, 8), 8, 8);
+  BOOST_REQUIRE(decoded.size() == pixels.size());
+  for (std::size_t i = 0; i < pixels.size(); ++i) {
+    BOOST_TEST(std::abs(decoded[i] - pixels[i]) <= 12);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Bc1KeepsCutoutAlpha) {
+  std::vector<uint8_t> pixels;
+  for (int i = 0; i < 16; ++i) {
+    const uint8_t alpha = i % 2 == 0 ? 255 : 0;
+    pixels.insert(pixels.end(), {200, 100, 50, alpha});
+  }
+
+  const auto decoded =
+      wren::math::decode_bc1(wren::math::encode_bc1(pixels, 4, 4), 4, 4);
+  for (std::size_t i = 0; i < 16; ++i) {
+    BOOST_TEST(decoded[i * 4 + 3] == pixels[i * 4 + 3]);
+  }
+  BOOST_TEST(std::abs(decoded[0] - 200) <= 8);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
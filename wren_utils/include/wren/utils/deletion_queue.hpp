@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+
+namespace wren::utils {
+
+//! @brief Defers destroying objects until the GPU has moved past their last
+//! use. Progress is tracked as a monotonically increasing value, a frame
+//! number or a timeline semaphore value.
+class DeletionQueue {
+ public:
+  //! @brief Run fn once the current pending value has been completed
+  void push(std::function<void()> fn);
+
+  //! @brief Run fn once value has been completed
+  void push(uint64_t value, std::function<void()> fn);
+
+  //! @brief Set the value that work recorded from now on completes with
+  void pending_value(uint64_t value);
+  [[nodiscard]] auto pending_value() const -> uint64_t;
+
+  //! @brief Run everything queued for a value up to and including completed
+  void flush(uint64_t completed);
+
+  //! @brief Run everything, only safe once the device is idle
+  void flush_all();
+
+  [[nodiscard]] auto size() const -> std::size_t;
+
+ private:
+  mutable std::mutex mutex_;
+  uint64_t pending_value_ = 1;
+  std::multimap<uint64_t, std::function<void()>> queue_;
+};
+
+}  // namespace wren::utils
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace wren::utils {
+
+constexpr uint64_t kFnv1aOffset = 0xcbf29ce484222325ULL;
+constexpr uint64_t kFnv1aPrime = 0x100000001b3ULL;
+
+//! @brief 64 bit FNV-1a. Unlike std::hash it's the same on every run and
+//! platform, so it can be stored in files. Pass a previous result as seed to
+//! hash several buffers as one.
+constexpr auto fnv1a(std::span<const std::byte> bytes,
+                     uint64_t seed = kFnv1aOffset) -> uint64_t {
+  uint64_t hash = seed;
+  for (const auto byte : bytes) {
+    hash ^= static_cast<uint64_t>(byte);
+    hash *= kFnv1aPrime;
+  }
+  return hash;
+}
+
+constexpr auto fnv1a(std::string_view string, uint64_t seed = kFnv1aOffset)
+    -> uint64_t {
+  uint64_t hash = seed;
+  for (const auto c : string) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= kFnv1aPrime;
+  }
+  return hash;
+}
+
+}  // namespace wren::utils
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+#include "result.hpp"
+
+namespace wren::utils {
+
+//! @brief A file mapped into memory, read only from the outside but mapped
+//! copy on write so the pages can be handed to APIs taking non const
+//! pointers without touching the file
+class MappedFile {
+ public:
+  static auto open(const std::filesystem::path& path) -> expected<MappedFile>;
+
+  MappedFile() = default;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  auto operator=(const MappedFile&) -> MappedFile& = delete;
+  auto operator=(MappedFile&& other) noexcept -> MappedFile&;
+  ~MappedFile();
+
+  [[nodiscard]] auto data() const -> std::span<const std::byte> {
+    return {data_, size_};
+  }
+  [[nodiscard]] auto mutable_data() const -> std::span<std::byte> {
+    return {data_, size_};
+  }
+  [[nodiscard]] auto size() const { return size_; }
+
+ private:
+  MappedFile(std::byte* data, std::size_t size) : data_(data), size_(size) {}
+
+  std::byte* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+}  // namespace wren::utils
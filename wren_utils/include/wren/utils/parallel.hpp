@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace wren::utils {
+
+//! @brief Threads started once and kept waiting for work, so splitting a
+//! loop costs a wake up instead of a thread per chunk.
+//!
+//! run() may be called from any thread, workers included. The caller always
+//! helps with its own tasks, so nested calls finish even when every worker
+//! is busy. A task that throws stops the tasks of its call that haven't
+//! started yet, and run() rethrows the first exception once the ones
+//! already running are done.
+class WorkerPool {
+ public:
+  //! @brief One worker per hardware thread besides the caller's
+  static auto shared() -> WorkerPool&;
+
+  explicit WorkerPool(std::size_t workers);
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool(WorkerPool&&) = delete;
+  auto operator=(const WorkerPool&) -> WorkerPool& = delete;
+  auto operator=(WorkerPool&&) -> WorkerPool& = delete;
+  //! @brief Lets the workers finish what they're running and joins them
+  ~WorkerPool();
+
+  [[nodiscard]] auto size() const { return workers_.size(); }
+
+  //! @brief Run task(i) for every i in [0, count) on the workers and the
+  //! calling thread, returning once all of them are done
+  template <typename Fn>
+  void run(std::size_t count, Fn&& task) {
+    using Task = std::remove_reference_t<Fn>;
+    // Type erased without allocating, task outlives the call
+    run(count, const_cast<void*>(static_cast<const void*>(&task)),
+        [](void* context, std::size_t index) {
+          (*static_cast<Task*>(context))(index);
+        });
+  }
+
+ private:
+  using Call = void (*)(void*, std::size_t);
+
+  struct Job {
+    void* context = nullptr;
+    Call call = nullptr;
+    std::size_t count = 0;
+    std::atomic<std::size_t> next = 0;
+    //! @brief Set once a task threw, the remaining ones are skipped
+    std::atomic<bool> failed = false;
+    //! @brief Guarded by the pool's mutex
+    std::size_t finished = 0;
+    //! @brief The first exception thrown, guarded by the pool's mutex
+    std::exception_ptr error;
+  };
+
+  void run(std::size_t count, void* context, Call call);
+  //! @brief Claim and run tasks of job until none are left
+  void work(Job& job);
+  void worker_loop();
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable finished_;
+  std::deque<std::shared_ptr<Job>> jobs_;
+  bool stopping_ = false;
+
+  std::vector<std::jthread> workers_;
+};
+
+//! @brief Split [0, count) into chunks and run fn(begin, end) on each, one
+//! chunk per thread of WorkerPool::shared() with the calling thread taking
+//! part. Chunks are multiples of grain items, so small counts run inline and
+//! SIMD loops over the chunks stay aligned to their lane count.
+//! @param threads Upper bound on the threads used, 0 for all of the pool's
+template <typename Fn>
+void parallel_for(std::size_t count, std::size_t grain, Fn&& fn,
+                  std::size_t threads = 0) {
+  if (count == 0) return;
+  grain = std::max<std::size_t>(grain, 1);
+
+  auto& pool = WorkerPool::shared();
+  if (threads == 0) threads = pool.size() + 1;
+  const std::size_t grains = (count + grain - 1) / grain;
+  const std::size_t chunks = std::min(threads, grains);
+  if (chunks <= 1) {
+    fn(std::size_t{0}, count);
+    return;
+  }
+
+  const std::size_t chunk_size = ((grains + chunks - 1) / chunks) * grain;
+
+  pool.run((count + chunk_size - 1) / chunk_size,
+           [&fn, chunk_size, count](std::size_t chunk) {
+             const auto begin = chunk * chunk_size;
+             fn(begin, std::min(begin + chunk_size, count));
+           });
+}
+
+}  // namespace wren::utils
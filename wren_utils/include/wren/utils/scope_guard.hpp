@@ -0,0 +1,31 @@
+#pragma once
+
+#include <utility>
+
+namespace wren::utils {
+
+//! @brief Runs fn when it goes out of scope unless dismissed, for undoing
+//! partial work on every early return of a function
+template <typename Fn>
+class ScopeGuard {
+ public:
+  explicit ScopeGuard(Fn fn) : fn_(std::move(fn)) {}
+
+  ScopeGuard(const ScopeGuard&) = delete;
+  ScopeGuard(ScopeGuard&&) = delete;
+  auto operator=(const ScopeGuard&) -> ScopeGuard& = delete;
+  auto operator=(ScopeGuard&&) -> ScopeGuard& = delete;
+
+  ~ScopeGuard() {
+    if (active_) fn_();
+  }
+
+  //! @brief The work went through, don't undo it
+  void dismiss() { active_ = false; }
+
+ private:
+  Fn fn_;
+  bool active_ = true;
+};
+
+}  // namespace wren::utils
@@ -0,0 +1,54 @@
+#include "deletion_queue.hpp"
+
+#include <vector>
+
+namespace wren::utils {
+
+void DeletionQueue::push(std::function<void()> fn) {
+  std::scoped_lock lock(mutex_);
+  queue_.emplace(pending_value_, std::move(fn));
+}
+
+void DeletionQueue::push(uint64_t value, std::function<void()> fn) {
+  std::scoped_lock lock(mutex_);
+  queue_.emplace(value, std::move(fn));
+}
+
+void DeletionQueue::pending_value(uint64_t value) {
+  std::scoped_lock lock(mutex_);
+  pending_value_ = value;
+}
+
+auto DeletionQueue::pending_value() const -> uint64_t {
+  std::scoped_lock lock(mutex_);
+  return pending_value_;
+}
+
+void DeletionQueue::flush(uint64_t completed) {
+  std::vector<std::function<void()>> ready;
+
+  {
+    std::scoped_lock lock(mutex_);
+    const auto end = queue_.upper_bound(completed);
+    for (auto it = queue_.begin(); it != end; ++it) {
+      ready.push_back(std::move(it->second));
+    }
+    queue_.erase(queue_.begin(), end);
+  }
+
+  // Run outside the lock, destroying something can retire something else
+  for (const auto &fn : ready) fn();
+}
+
+void DeletionQueue::flush_all() {
+  while (size() > 0) {
+    flush(UINT64_MAX);
+  }
+}
+
+auto DeletionQueue::size() const -> std::size_t {
+  std::scoped_lock lock(mutex_);
+  return queue_.size();
+}
+
+}  // namespace wren::utils
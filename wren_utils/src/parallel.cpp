@@ -0,0 +1,100 @@
+#include "parallel.hpp"
+
+namespace wren::utils {
+
+auto WorkerPool::shared() -> WorkerPool& {
+  static WorkerPool pool(
+      std::max(std::thread::hardware_concurrency(), 1U) - 1);
+  return pool;
+}
+
+WorkerPool::WorkerPool(std::size_t workers) {
+  workers_.reserve(workers);
+  for (std::size_t i = 0; i < workers; ++i) {
+    workers_.emplace_back([this]() { worker_loop(); });
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::scoped_lock lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  workers_.clear();
+}
+
+void WorkerPool::run(std::size_t count, void* context, Call call) {
+  if (count == 0) return;
+  if (count == 1 || workers_.empty()) {
+    for (std::size_t i = 0; i < count; ++i) call(context, i);
+    return;
+  }
+
+  auto job = std::make_shared<Job>();
+  job->context = context;
+  job->call = call;
+  job->count = count;
+  {
+    std::scoped_lock lock(mutex_);
+    jobs_.push_back(job);
+  }
+  wake_.notify_all();
+
+  work(*job);
+
+  {
+    // Workers may still be running tasks they claimed
+    std::unique_lock lock(mutex_);
+    std::erase(jobs_, job);
+    finished_.wait(lock, [&job]() { return job->finished == job->count; });
+  }
+
+  if (job->error) std::rethrow_exception(job->error);
+}
+
+void WorkerPool::work(Job& job) {
+  std::size_t finished = 0;
+  std::exception_ptr error;
+  for (auto i = job.next.fetch_add(1); i < job.count;
+       i = job.next.fetch_add(1)) {
+    // Tasks are still claimed after a failure so the job can finish, letting
+    // an exception escape a worker would terminate and hang the caller
+    if (!job.failed.load(std::memory_order_relaxed)) {
+      try {
+        job.call(job.context, i);
+      } catch (...) {
+        if (!error) error = std::current_exception();
+        job.failed.store(true, std::memory_order_relaxed);
+      }
+    }
+    ++finished;
+  }
+  if (finished == 0) return;
+
+  std::scoped_lock lock(mutex_);
+  if (error && !job.error) job.error = std::move(error);
+  job.finished += finished;
+  if (job.finished == job.count) finished_.notify_all();
+}
+
+void WorkerPool::worker_loop() {
+  while (true) {
+    std::shared_ptr<Job> job;
+    {
+      std::unique_lock lock(mutex_);
+      wake_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+      if (stopping_) return;
+
+      job = jobs_.front();
+      // Every task is claimed, whoever runs the last one finishes the job
+      if (job->next.load() >= job->count) {
+        jobs_.pop_front();
+        continue;
+      }
+    }
+    work(*job);
+  }
+}
+
+}  // namespace wren::utils
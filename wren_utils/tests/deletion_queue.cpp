@@ -0,0 +1,45 @@
+#include <boost/test/unit_test.hpp>
+#include <wren/utils/deletion_queue.hpp>
+
+BOOST_AUTO_TEST_SUITE(deletion_queue)
+
+BOOST_AUTO_TEST_CASE(FlushesCompletedValues) {
+  wren::utils::DeletionQueue queue;
+
+  std::vector<int> destroyed;
+  queue.pending_value(1);
+  queue.push([&destroyed]() { destroyed.push_back(1); });
+  queue.pending_value(2);
+  queue.push([&destroyed]() { destroyed.push_back(2); });
+  queue.push(1, [&destroyed]() { destroyed.push_back(3); });
+
+  queue.flush(0);
+  BOOST_TEST(destroyed.empty());
+
+  queue.flush(1);
+  BOOST_TEST(destroyed == std::vector<int>({1, 3}));
+  BOOST_TEST(queue.size() == 1);
+
+  queue.flush(5);
+  BOOST_TEST(destroyed == std::vector<int>({1, 3, 2}));
+  BOOST_TEST(queue.size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(RetireWhileFlushing) {
+  wren::utils::DeletionQueue queue;
+
+  int destroyed = 0;
+  queue.push(1, [&]() {
+    ++destroyed;
+    queue.push(2, [&]() { ++destroyed; });
+  });
+
+  queue.flush(1);
+  BOOST_TEST(destroyed == 1);
+  BOOST_TEST(queue.size() == 1);
+
+  queue.flush_all();
+  BOOST_TEST(destroyed == 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
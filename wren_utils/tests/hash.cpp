@@ -0,0 +1,20 @@
+#include <boost/test/unit_test.hpp>
+#include <wren/utils/hash.hpp>
+
+BOOST_AUTO_TEST_SUITE(hash)
+
+BOOST_AUTO_TEST_CASE(KnownValues) {
+  static_assert(wren::utils::fnv1a("") == 0xcbf29ce484222325ULL);
+  BOOST_TEST(wren::utils::fnv1a("a") == 0xaf63dc4c8601ec8cULL);
+  BOOST_TEST(wren::utils::fnv1a("foobar") == 0x85944171f73967e8ULL);
+}
+
+BOOST_AUTO_TEST_CASE(Chained) {
+  const auto whole = wren::utils::fnv1a("foobar");
+  BOOST_TEST(wren::utils::fnv1a("bar", wren::utils::fnv1a("foo")) == whole);
+
+  const std::string_view text = "foobar";
+  BOOST_TEST(wren::utils::fnv1a(std::as_bytes(std::span(text))) == whole);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,41 @@
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+#include <fstream>
+#include <wren/utils/mapped_file.hpp>
+
+BOOST_AUTO_TEST_SUITE(mapped_file)
+
+BOOST_AUTO_TEST_CASE(MapsContents) {
+  const auto path =
+      std::filesystem::temp_directory_path() / "wren_mapped_file_test.bin";
+  {
+    std::ofstream out(path, std::ios::binary);
+    out << "wren";
+  }
+
+  auto file = wren::utils::MappedFile::open(path);
+  BOOST_REQUIRE(file.has_value());
+  BOOST_TEST(file->size() == 4);
+  BOOST_TEST(static_cast<char>(file->data()[0]) == 'w');
+  BOOST_TEST(static_cast<char>(file->data()[3]) == 'n');
+
+  // Writes stay private to the mapping
+  file->mutable_data()[0] = std::byte{'W'};
+  auto moved = std::move(*file);
+  BOOST_TEST(file->size() == 0);
+  BOOST_TEST(static_cast<char>(moved.data()[0]) == 'W');
+
+  auto again = wren::utils::MappedFile::open(path);
+  BOOST_REQUIRE(again.has_value());
+  BOOST_TEST(static_cast<char>(again->data()[0]) == 'w');
+
+  std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(MissingFile) {
+  const auto file =
+      wren::utils::MappedFile::open("/nonexistent/wren_mapped_file_test.bin");
+  BOOST_TEST(!file.has_value());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
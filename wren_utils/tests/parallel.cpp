@@ -0,0 +1,102 @@
+#include <atomic>
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <wren/utils/parallel.hpp>
+
+BOOST_AUTO_TEST_SUITE(parallel)
+
+BOOST_AUTO_TEST_CASE(CoversEveryIndexOnce) {
+  for (const std::size_t count : {0, 1, 7, 8, 1000, 100003}) {
+    std::vector<std::atomic<int>> hits(count);
+
+    wren::utils::parallel_for(
+        count, 8,
+        [&hits](std::size_t begin, std::size_t end) {
+          for (auto i = begin; i < end; ++i) hits[i].fetch_add(1);
+        },
+        4);
+
+    for (const auto& hit : hits) BOOST_TEST(hit.load() == 1);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ChunksAreMultiplesOfGrain) {
+  std::atomic<bool> aligned = true;
+
+  wren::utils::parallel_for(
+      10000, 64,
+      [&aligned](std::size_t begin, std::size_t /*end*/) {
+        if (begin % 64 != 0) aligned = false;
+      },
+      4);
+
+  BOOST_TEST(aligned.load());
+}
+
+BOOST_AUTO_TEST_CASE(ReusesItsThreads) {
+  wren::utils::WorkerPool pool(3);
+
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  for (int call = 0; call < 50; ++call) {
+    pool.run(16, [&](std::size_t /*index*/) {
+      std::scoped_lock lock(mutex);
+      threads.insert(std::this_thread::get_id());
+    });
+  }
+
+  // The workers and the caller, never a thread per call
+  BOOST_TEST(threads.size() <= pool.size() + 1);
+}
+
+BOOST_AUTO_TEST_CASE(NestedCallsFinish) {
+  // More outer tasks than workers, each waiting on an inner loop
+  wren::utils::WorkerPool pool(2);
+  std::vector<std::atomic<int>> hits(8 * 100);
+
+  pool.run(8, [&](std::size_t outer) {
+    pool.run(100, [&](std::size_t inner) {
+      hits[outer * 100 + inner].fetch_add(1);
+    });
+  });
+
+  for (const auto& hit : hits) BOOST_TEST(hit.load() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(PropagatesExceptions) {
+  wren::utils::WorkerPool pool(3);
+  std::atomic<int> ran = 0;
+
+  BOOST_CHECK_THROW(pool.run(1000,
+                             [&ran](std::size_t index) {
+                               ran.fetch_add(1);
+                               if (index == 0) {
+                                 throw std::runtime_error("task failed");
+                               }
+                               std::this_thread::sleep_for(
+                                   std::chrono::microseconds(100));
+                             }),
+                    std::runtime_error);
+  // Tasks not started when it threw are skipped
+  BOOST_TEST(ran.load() < 1000);
+
+  // The pool is still usable afterwards
+  std::atomic<int> hits = 0;
+  pool.run(100, [&hits](std::size_t /*index*/) { hits.fetch_add(1); });
+  BOOST_TEST(hits.load() == 100);
+
+  BOOST_CHECK_THROW(wren::utils::parallel_for(
+                        10000, 8,
+                        [](std::size_t begin, std::size_t /*end*/) {
+                          if (begin == 0) throw std::runtime_error("chunk");
+                        },
+                        4),
+                    std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
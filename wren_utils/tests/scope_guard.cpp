@@ -0,0 +1,28 @@
+#include <boost/test/unit_test.hpp>
+#include <wren/utils/scope_guard.hpp>
+
+BOOST_AUTO_TEST_SUITE(scope_guard)
+
+BOOST_AUTO_TEST_CASE(RunsOnEveryExit) {
+  int runs = 0;
+  const auto early_return = [&runs](bool fail) {
+    wren::utils::ScopeGuard guard([&runs]() { ++runs; });
+    if (fail) return false;
+    return true;
+  };
+
+  early_return(true);
+  early_return(false);
+  BOOST_TEST(runs == 2);
+}
+
+BOOST_AUTO_TEST_CASE(Dismissed) {
+  int runs = 0;
+  {
+    wren::utils::ScopeGuard guard([&runs]() { ++runs; });
+    guard.dismiss();
+  }
+  BOOST_TEST(runs == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include <wren/utils/result.hpp>
+
+#include "shader.hpp"
+
+namespace wren::vk {
+
+DEFINE_ERROR("BindlessError", BindlessErrors, HeapFull)
+
+//! @brief A single global descriptor set holding large arrays of storage
+//! buffers and sampled images. Resources are registered once and addressed by
+//! index from shaders, so a draw only needs to push the indices it uses.
+//!
+//! Shaders opt in by declaring the arrays in set kSet:
+//! @code
+//! layout(set = 1, binding = 0) readonly buffer Buffers { ... } buffers[];
+//! layout(set = 1, binding = 1) uniform sampler2D textures[];
+//! @endcode
+class BindlessHeap {
+ public:
+  static constexpr uint32_t kSet = 1;
+  static constexpr uint32_t kStorageBufferBinding = 0;
+  static constexpr uint32_t kSampledImageBinding = 1;
+
+  static constexpr uint32_t kMaxStorageBuffers = 1U << 16U;
+  static constexpr uint32_t kMaxSampledImages = 1U << 14U;
+
+  //! @brief Check the descriptor indexing features the heap relies on
+  static auto is_supported(
+      const ::vk::PhysicalDeviceDescriptorIndexingFeatures &features) -> bool;
+
+  //! @brief Create the heap, array sizes are clamped to the device limits
+  static auto create(const ::vk::Device &device,
+                     const ::vk::PhysicalDevice &physical_device)
+      -> expected<std::shared_ptr<BindlessHeap>>;
+
+  BindlessHeap(const BindlessHeap &) = delete;
+  BindlessHeap(BindlessHeap &&) = delete;
+  auto operator=(const BindlessHeap &) = delete;
+  auto operator=(BindlessHeap &&) = delete;
+  ~BindlessHeap();
+
+  //! @brief Register a storage buffer range
+  //! @returns The index of the buffer in the heap's buffer array
+  auto add_buffer(const ::vk::Buffer &buffer, ::vk::DeviceSize offset = 0,
+                  ::vk::DeviceSize range = ::vk::WholeSize)
+      -> expected<uint32_t>;
+
+  //! @brief Register an image for sampling
+  //! @returns The index of the image in the heap's texture array
+  auto add_image(const ::vk::ImageView &view, const ::vk::Sampler &sampler,
+                 ::vk::ImageLayout layout =
+                     ::vk::ImageLayout::eShaderReadOnlyOptimal)
+      -> expected<uint32_t>;
+
+  //! @brief Release an index for reuse. The slot is left partially bound so
+  //! the caller must make sure in flight work no longer reads it.
+  void remove_buffer(uint32_t index);
+  void remove_image(uint32_t index);
+
+  //! @brief Bind the global set to a pipeline layout that includes kSet
+  void bind(const ::vk::CommandBuffer &cmd,
+            const ::vk::PipelineBindPoint &bind_point,
+            const ::vk::PipelineLayout &layout) const;
+
+  [[nodiscard]] auto set_layout() const { return set_layout_; }
+  [[nodiscard]] auto set() const { return set_; }
+
+  [[nodiscard]] auto buffer_capacity() const { return buffers_.capacity; }
+  [[nodiscard]] auto image_capacity() const { return images_.capacity; }
+
+ private:
+  //! @brief Free list over the slots of one array binding
+  struct Slots {
+    uint32_t capacity = 0;
+    uint32_t next = 0;
+    std::vector<uint32_t> free;
+
+    auto acquire() -> expected<uint32_t>;
+    void release(uint32_t index);
+  };
+
+  explicit BindlessHeap(const ::vk::Device &device) : device_(device) {}
+
+  ::vk::Device device_;
+  ::vk::DescriptorPool pool_;
+  ::vk::DescriptorSetLayout set_layout_;
+  ::vk::DescriptorSet set_;
+
+  Slots buffers_;
+  Slots images_;
+};
+
+}  // namespace wren::vk
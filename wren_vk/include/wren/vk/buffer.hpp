@@ -6,23 +6,36 @@
 #include <memory>
 #include <span>
 #include <vulkan/vulkan.hpp>
+#include <wren/utils/deletion_queue.hpp>
 #include <wren/vk/result.hpp>
+#include <wren/vk/submit_queue.hpp>
 
 namespace wren::vk {
 
 class Buffer {
  public:
-  static auto create(const VmaAllocator &allocator, size_t size,
-                     VkBufferUsageFlags usage,
-                     const std::optional<VmaAllocationCreateFlags> &flags = {})
+  //! @brief Create a buffer, when a deletion queue is given destroying the
+  //! buffer is deferred until the GPU has finished the work using it. Buffers
+  //! used from more than one queue family are created with concurrent
+  //! sharing between the given (distinct) families.
+  static auto create(
+      const VmaAllocator &allocator, size_t size, VkBufferUsageFlags usage,
+      const std::optional<VmaAllocationCreateFlags> &flags = {},
+      const std::shared_ptr<utils::DeletionQueue> &deletion_queue = nullptr,
+      std::span<const uint32_t> queue_families = {})
       -> std::shared_ptr<Buffer>;
 
-  static auto copy_buffer(const ::vk::Device &device,
-                          const ::vk::Queue &submit_queue,
-                          const ::vk::CommandPool &command_pool,
-                          const std::shared_ptr<Buffer> &src,
-                          const std::shared_ptr<Buffer> &dst, size_t size)
-      -> expected<void>;
+  //! @brief Copy size bytes from src to dst without waiting for the GPU.
+  //! Work submitted to submit_queue afterwards sees dst written, other queues
+  //! have to wait for the returned point. The command buffer and src are
+  //! released through deletion_queue once the copy is done, without one the
+  //! copy is waited for.
+  static auto copy_buffer(
+      const ::vk::Device &device, SubmitQueue &submit_queue,
+      const ::vk::CommandPool &command_pool, const std::shared_ptr<Buffer> &src,
+      const std::shared_ptr<Buffer> &dst, size_t size,
+      const std::shared_ptr<utils::DeletionQueue> &deletion_queue = nullptr)
+      -> expected<TimelinePoint>;
 
   Buffer(const VmaAllocator &allocator) : allocator_(allocator) {}
   ~Buffer();
@@ -54,6 +67,7 @@ class Buffer {
   ::vk::Buffer buffer_{};
   VmaAllocator allocator_ = nullptr;
   VmaAllocation allocation_{};
+  std::shared_ptr<utils::DeletionQueue> deletion_queue_;
 
   void *mapped_ptr_ = nullptr;
 };
@@ -10,9 +10,32 @@ namespace wren::vk {
 
 class Image {
  public:
-  static auto create(const ::vk::Device& device, const VmaAllocator& allocator,
-                     const ::vk::Format& format, const math::Vec2f& size,
-                     const ::vk::ImageUsageFlags& usage) -> expected<Image>;
+  static auto create(
+      const ::vk::Device& device, const VmaAllocator& allocator,
+      const ::vk::Format& format, const math::Vec2f& size,
+      const ::vk::ImageUsageFlags& usage,
+      VmaMemoryUsage memory_usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+      uint32_t mip_levels = 1) -> expected<Image>;
+
+  //! @brief Create an image bound to memory it shares with other images. The
+  //! image doesn't own the memory, only one of the images sharing it may be
+  //! in use at a time.
+  static auto create_aliasing(const VmaAllocator& allocator,
+                              const VmaAllocation& memory,
+                              const ::vk::Format& format,
+                              const math::Vec2f& size,
+                              const ::vk::ImageUsageFlags& usage)
+      -> expected<Image>;
+
+  //! @brief Memory an image with these parameters would need
+  static auto memory_requirements(const ::vk::Device& device,
+                                  const ::vk::Format& format,
+                                  const math::Vec2f& size,
+                                  const ::vk::ImageUsageFlags& usage)
+      -> expected<::vk::MemoryRequirements>;
+
+  //! @brief Destroy the image, and its memory unless it's aliased
+  void destroy(const ::vk::Device& device, const VmaAllocator& allocator) const;
 
   [[nodiscard]] auto get() const { return image_; }
 
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include <wren/utils/result.hpp>
+
+#include "shader.hpp"
+
+namespace wren::vk {
+
+//! @brief Deduplicates descriptor set layouts and pipeline layouts by their
+//! reflected description. The cache owns every layout it hands out, they stay
+//! alive until clear() is called.
+class LayoutCache {
+ public:
+  struct Layout {
+    ::vk::PipelineLayout pipeline_layout;
+    std::vector<::vk::DescriptorSetLayout> set_layouts;
+  };
+
+  LayoutCache() = default;
+  explicit LayoutCache(const ::vk::Device &device) : device_(device) {}
+
+  //! @brief Get or create the layouts matching a pipeline's interface
+  //! @param description The merged interface of every stage of a shader
+  //! @returns The shared layouts, set 0 is always a push descriptor set
+  auto get(const PipelineLayoutDescription &description) -> expected<Layout>;
+
+  //! @brief Get or create a single descriptor set layout
+  auto get(const DescriptorSetLayoutDescription &description)
+      -> expected<::vk::DescriptorSetLayout>;
+
+  //! @brief Use a layout owned elsewhere for every pipeline that declares
+  //! the given set, instead of one built from the reflected bindings. Must be
+  //! registered before any pipeline using the set is created.
+  void set_external_layout(uint32_t set,
+                           const ::vk::DescriptorSetLayout &layout) {
+    external_layouts_.insert_or_assign(set, layout);
+  }
+
+  //! @brief Destroy every cached layout
+  void clear();
+
+  [[nodiscard]] auto pipeline_layout_count() const {
+    return pipeline_layouts_.size();
+  }
+  [[nodiscard]] auto set_layout_count() const { return set_layouts_.size(); }
+
+ private:
+  struct Hash {
+    auto operator()(const auto &description) const {
+      return description.hash();
+    }
+  };
+
+  ::vk::Device device_;
+
+  std::unordered_map<uint32_t, ::vk::DescriptorSetLayout> external_layouts_;
+
+  std::unordered_map<DescriptorSetLayoutDescription, ::vk::DescriptorSetLayout,
+                     Hash>
+      set_layouts_;
+  std::unordered_map<PipelineLayoutDescription, Layout, Hash>
+      pipeline_layouts_;
+};
+
+}  // namespace wren::vk
@@ -14,7 +14,9 @@
 #include <vulkan/vulkan_handles.hpp>
 #include <vulkan/vulkan_structs.hpp>
 #include <wren/math/vector.hpp>
+#include <wren/utils/deletion_queue.hpp>
 #include <wren/utils/result.hpp>
+#include <wren/vk/vertex_layout.hpp>
 
 DEFINE_ERROR_IMPL("shaderc", shaderc_compilation_status)
 BOOST_DESCRIBE_ENUM(shaderc_compilation_status,
@@ -32,7 +34,42 @@ using spirv_t = std::vector<uint32_t>;
 
 namespace wren::vk {
 
-DESCRIBED_ENUM(ShaderType, Vertex, Fragment);
+DESCRIBED_ENUM(ShaderType, Vertex, Fragment, Compute);
+
+class LayoutCache;
+
+//! @brief The bindings of a single descriptor set, sorted by binding number
+struct DescriptorSetLayoutDescription {
+  uint32_t set = 0;
+  std::vector<::vk::DescriptorSetLayoutBinding> bindings;
+
+  [[nodiscard]] auto hash() const -> std::size_t;
+
+  auto operator==(const DescriptorSetLayoutDescription &) const
+      -> bool = default;
+};
+
+//! @brief Compact description of a pipeline's resource interface, merged
+//! across every stage of a shader. Two shaders with equal descriptions can
+//! share descriptor set and pipeline layouts.
+struct PipelineLayoutDescription {
+  //! @brief Sorted by set number, sets without bindings are omitted
+  std::vector<DescriptorSetLayoutDescription> sets;
+
+  //! @brief A single range covering the push constants of every stage, a
+  //! size of 0 means the pipeline has none
+  ::vk::PushConstantRange push_constant_range;
+
+  //! @brief Merge another stage's interface into this one, bindings present
+  //! in both have their stage flags combined
+  void merge(const PipelineLayoutDescription &other);
+
+  [[nodiscard]] auto has_set(uint32_t set) const -> bool;
+
+  [[nodiscard]] auto hash() const -> std::size_t;
+
+  auto operator==(const PipelineLayoutDescription &) const -> bool = default;
+};
 
 struct ShaderModule {
   reflect::spirv_t spirv;
@@ -42,14 +79,48 @@ struct ShaderModule {
   ShaderModule() = default;
   ShaderModule(reflect::spirv_t spirv, const ::vk::ShaderModule &module);
 
+  [[nodiscard]] auto stage() const { return stage_; }
+
   [[nodiscard]] auto get_vertex_input_bindings() const
-      -> std::vector<::vk::VertexInputBindingDescription>;
+      -> const std::vector<::vk::VertexInputBindingDescription> & {
+    return vertex_input_bindings_;
+  }
 
   [[nodiscard]] auto get_vertex_input_attributes() const
-      -> std::vector<::vk::VertexInputAttributeDescription>;
+      -> const std::vector<::vk::VertexInputAttributeDescription> & {
+    return vertex_input_attributes_;
+  }
+
+  [[nodiscard]] auto layout_description() const
+      -> const PipelineLayoutDescription & {
+    return layout_description_;
+  }
+
+ private:
+  //! @brief Walk the SPIR-V reflection data once and cache the results
+  void reflect();
+  void reflect_vertex_inputs();
+  void reflect_descriptor_sets();
+  void reflect_push_constants();
 
-  [[nodiscard]] auto get_descriptor_set_layout_bindings() const
-      -> std::vector<::vk::DescriptorSetLayoutBinding>;
+  ::vk::ShaderStageFlagBits stage_ = ::vk::ShaderStageFlagBits::eVertex;
+
+  std::vector<::vk::VertexInputBindingDescription> vertex_input_bindings_;
+  std::vector<::vk::VertexInputAttributeDescription> vertex_input_attributes_;
+  PipelineLayoutDescription layout_description_;
+};
+
+//! @brief What a pipeline renders into. With dynamic rendering only the
+//! attachment formats matter and render_pass is left null, so one pipeline
+//! works with any pass using the same formats.
+struct PipelineTarget {
+  ::vk::RenderPass render_pass;
+  ::vk::Format colour_format = ::vk::Format::eUndefined;
+  ::vk::Format depth_format = ::vk::Format::eUndefined;
+
+  [[nodiscard]] auto has_depth() const {
+    return depth_format != ::vk::Format::eUndefined;
+  }
 };
 
 class Shader {
@@ -63,6 +134,12 @@ class Shader {
   static auto create(const ::vk::Device &device,
                      const std::filesystem::path &shader_path) -> expected<Ptr>;
 
+  //! @brief Create a compute shader, its pipeline is made with
+  //! create_compute_pipeline
+  static auto create_compute(const ::vk::Device &device,
+                             const std::string &compute_shader)
+      -> expected<Ptr>;
+
   static auto compile_shader(const ::vk::Device &device,
                              const shaderc_shader_kind &shader_kind,
                              const std::string &filename,
@@ -73,29 +150,72 @@ class Shader {
   [[nodiscard]] auto pipeline_layout() const { return pipeline_layout_; }
   [[nodiscard]] auto descriptor_layout() const { return descriptor_layout_; }
 
+  //! @brief The resource interface of all stages, merged
+  [[nodiscard]] auto layout_description() const -> const auto & {
+    return layout_description_;
+  }
+
   void fragment_shader(const ShaderModule &fragment) {
     fragment_shader_module_ = fragment;
+    update_layout_description();
   }
 
   void vertex_shader(const ShaderModule &vertex) {
     vertex_shader_module_ = vertex;
+    update_layout_description();
+  }
+
+  void compute_shader(const ShaderModule &compute) {
+    compute_shader_module_ = compute;
+    update_layout_description();
   }
 
+  [[nodiscard]] auto is_compute() const {
+    return static_cast<bool>(compute_shader_module_.module);
+  }
+
+  [[nodiscard]] auto bind_point() const {
+    return is_compute() ? ::vk::PipelineBindPoint::eCompute
+                        : ::vk::PipelineBindPoint::eGraphics;
+  }
+
+  //! @brief (Re)create the pipeline, a replaced pipeline is retired into the
+  //! deletion queue since in flight frames may still be using it
+  //! @param vertex_layout Used for the vertex input when the vertex shader
+  //! reads mesh vertices, otherwise the reflected input is used
   auto create_graphics_pipeline(const ::vk::Device &device,
-                                const ::vk::RenderPass &render_pass,
-                                const math::Vec2f &size, bool depth)
+                                LayoutCache &layout_cache,
+                                utils::DeletionQueue &deletion_queue,
+                                const PipelineTarget &target,
+                                const math::Vec2f &size,
+                                const VertexLayout *vertex_layout = nullptr)
+      -> expected<void>;
+
+  //! @brief (Re)create the pipeline of a compute shader, retiring the old one
+  //! like create_graphics_pipeline does
+  auto create_compute_pipeline(const ::vk::Device &device,
+                               LayoutCache &layout_cache,
+                               utils::DeletionQueue &deletion_queue)
       -> expected<void>;
 
  private:
   static auto read_wren_shader_file(const std::filesystem::path &path)
       -> expected<std::map<ShaderType, std::string>>;
 
+  void update_layout_description();
+
+  //! @brief Use the cached layouts matching the shader's interface
+  auto update_layouts(LayoutCache &layout_cache) -> expected<void>;
+
   ::vk::DescriptorSetLayout descriptor_layout_;
   ::vk::PipelineLayout pipeline_layout_;
   ::vk::Pipeline pipeline_;
 
   ShaderModule vertex_shader_module_;
   ShaderModule fragment_shader_module_;
+  ShaderModule compute_shader_module_;
+
+  PipelineLayoutDescription layout_description_;
 };
 
 }  // namespace wren::vk
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include <wren/utils/deletion_queue.hpp>
+#include <wren/utils/result.hpp>
+
+namespace wren::vk {
+
+//! @brief A point on a queue's timeline, reached once everything submitted
+//! up to and including it has finished on the GPU
+struct TimelinePoint {
+  ::vk::Semaphore semaphore;
+  uint64_t value = 0;
+};
+
+//! @brief One batch of command buffers for SubmitQueue::submit
+struct Submission {
+  std::vector<::vk::CommandBuffer> command_buffers;
+
+  //! @brief Points to wait for before the given stages, they can be on the
+  //! timeline of any queue
+  std::vector<std::pair<TimelinePoint, ::vk::PipelineStageFlags>> waits;
+
+  //! @brief Binary semaphores, only needed for the swapchain
+  std::vector<std::pair<::vk::Semaphore, ::vk::PipelineStageFlags>>
+      binary_waits;
+  std::vector<::vk::Semaphore> binary_signals;
+};
+
+//! @brief Submits to a single queue. Every submit signals the next value of
+//! the queue's timeline semaphore, so the CPU and other queues can wait for
+//! a specific submit instead of the whole queue going idle.
+class SubmitQueue {
+ public:
+  //! @param deletion_queue Keyed on this queue's timeline from then on,
+  //! objects retired into it wait for everything submitted so far
+  static auto create(
+      const ::vk::Device &device, const ::vk::Queue &queue, uint32_t family,
+      const std::shared_ptr<utils::DeletionQueue> &deletion_queue = nullptr)
+      -> expected<std::shared_ptr<SubmitQueue>>;
+
+  SubmitQueue(const SubmitQueue &) = delete;
+  SubmitQueue(SubmitQueue &&) = delete;
+  auto operator=(const SubmitQueue &) = delete;
+  auto operator=(SubmitQueue &&) = delete;
+  ~SubmitQueue();
+
+  //! @brief Submit a batch, thread safe
+  //! @returns The point the batch signals once it's done
+  auto submit(const Submission &submission) -> expected<TimelinePoint>;
+
+  //! @brief The point signalled by the latest submit
+  [[nodiscard]] auto last_submitted() const -> TimelinePoint;
+
+  //! @brief The highest value the GPU has reached
+  [[nodiscard]] auto completed() const -> expected<uint64_t>;
+
+  //! @brief Check for a value without blocking
+  [[nodiscard]] auto is_complete(uint64_t value) const -> bool;
+
+  //! @brief Block until value has been reached
+  //! @param timeout In nanoseconds
+  //! @returns false when the timeout ran out first
+  auto wait(uint64_t value, uint64_t timeout = UINT64_MAX) const
+      -> expected<bool>;
+
+  [[nodiscard]] auto get() const { return queue_; }
+  [[nodiscard]] auto family() const { return family_; }
+  [[nodiscard]] auto semaphore() const { return semaphore_; }
+
+ private:
+  SubmitQueue(const ::vk::Device &device, const ::vk::Queue &queue,
+              uint32_t family)
+      : device_(device), queue_(queue), family_(family) {}
+
+  ::vk::Device device_;
+  ::vk::Queue queue_;
+  uint32_t family_ = 0;
+
+  ::vk::Semaphore semaphore_;
+  std::shared_ptr<utils::DeletionQueue> deletion_queue_;
+
+  mutable std::mutex mutex_;
+  uint64_t submitted_ = 0;
+};
+
+}  // namespace wren::vk
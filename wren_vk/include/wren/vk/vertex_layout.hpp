@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include <wren/math/matrix.hpp>
+#include <wren/math/vector.hpp>
+#include <wren/utils/enums.hpp>
+#include <wren/utils/result.hpp>
+
+namespace wren::vk {
+
+DEFINE_ERROR("VertexLayout", VertexLayoutErrors, MismatchedInput)
+
+DESCRIBED_ENUM(PositionFormat, Float32, Float16, Snorm16);
+DESCRIBED_ENUM(NormalFormat, Float32, Octahedral16);
+DESCRIBED_ENUM(ColourFormat, Float32, Unorm8, Constant);
+
+struct VertexLayoutOptions {
+  //! @brief Snorm16 positions are relative to the mesh's bounds, the mesh
+  //! hands out a matrix mapping them back that's folded into the model matrix
+  PositionFormat positions = PositionFormat::Snorm16;
+  //! @brief Octahedral normals need the shader to declare a vec2 and decode
+  //! it, the other formats are read as is
+  NormalFormat normals = NormalFormat::Octahedral16;
+  //! @brief Constant colours aren't stored per vertex, every vertex reads the
+  //! mesh's first colour from a binding with a stride of 0
+  ColourFormat colours = ColourFormat::Unorm8;
+  //! @brief Keep positions in their own vertex buffer so passes that only
+  //! read positions (depth prepasses, shadows) fetch nothing else
+  bool split_positions = true;
+};
+
+struct VertexInput {
+  std::vector<::vk::VertexInputBindingDescription> bindings;
+  std::vector<::vk::VertexInputAttributeDescription> attributes;
+};
+
+//! @brief Vertex data encoded for a VertexLayout, one buffer per binding
+struct EncodedVertices {
+  std::vector<std::vector<std::byte>> streams;
+  //! @brief Maps the stored positions back into model space
+  math::Mat4f dequantization = math::Mat4f::identity();
+};
+
+//! @brief How mesh vertices are stored on the GPU. Meshes encode their
+//! vertices with it and pipelines whose vertex shader reads the standard mesh
+//! inputs (position, normal and colour at locations 0, 1 and 2) take their
+//! vertex input from it instead of the reflected one.
+class VertexLayout {
+ public:
+  static constexpr uint32_t kPositionLocation = 0;
+  static constexpr uint32_t kNormalLocation = 1;
+  static constexpr uint32_t kColourLocation = 2;
+
+  explicit VertexLayout(const VertexLayoutOptions& options = {});
+
+  [[nodiscard]] auto options() const -> const VertexLayoutOptions& {
+    return options_;
+  }
+
+  //! @brief Bytes per vertex over every stream, constant colours excluded
+  [[nodiscard]] auto vertex_size() const -> uint32_t;
+
+  [[nodiscard]] auto binding_count() const {
+    return static_cast<uint32_t>(bindings_.size());
+  }
+
+  //! @brief The vertex input of a shader reading some of the mesh inputs,
+  //! with the attributes it doesn't read left out. Shaders reading any other
+  //! location get nothing and should keep their reflected input. Reading a
+  //! mesh input with the wrong number of components fails with
+  //! MismatchedInput, the meshes' buffers can't be read that way.
+  [[nodiscard]] auto vertex_input(
+      std::span<const ::vk::VertexInputAttributeDescription> reflected) const
+      -> expected<std::optional<VertexInput>>;
+
+  //! @brief Encode vertices into one stream per binding
+  //! @param colours Either one per vertex or empty, which is white
+  [[nodiscard]] auto encode(std::span<const math::Vec3f> positions,
+                            std::span<const math::Vec3f> normals,
+                            std::span<const math::Vec4f> colours) const
+      -> EncodedVertices;
+
+ private:
+  struct Attribute {
+    uint32_t binding = 0;
+    uint32_t offset = 0;
+    uint32_t size = 0;
+    ::vk::Format format = ::vk::Format::eUndefined;
+  };
+
+  //! @brief Append an attribute to a binding, creating the binding first
+  //! when needed
+  void add_attribute(uint32_t location, uint32_t binding, ::vk::Format format,
+                     uint32_t size);
+
+  VertexLayoutOptions options_;
+
+  std::array<Attribute, 3> attributes_{};
+  std::vector<::vk::VertexInputBindingDescription> bindings_;
+};
+
+}  // namespace wren::vk
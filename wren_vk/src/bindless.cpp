@@ -0,0 +1,165 @@
+#include "bindless.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <wren/vk/result.hpp>
+
+namespace wren::vk {
+
+// Descriptors the other sets of a pipeline layout can still use per stage
+constexpr uint32_t kReservedDescriptors = 32;
+
+auto BindlessHeap::is_supported(
+    const ::vk::PhysicalDeviceDescriptorIndexingFeatures &features) -> bool {
+  return features.runtimeDescriptorArray &&
+         features.descriptorBindingPartiallyBound &&
+         features.descriptorBindingUpdateUnusedWhilePending &&
+         features.descriptorBindingStorageBufferUpdateAfterBind &&
+         features.descriptorBindingSampledImageUpdateAfterBind &&
+         features.shaderSampledImageArrayNonUniformIndexing;
+}
+
+auto BindlessHeap::create(const ::vk::Device &device,
+                          const ::vk::PhysicalDevice &physical_device)
+    -> expected<std::shared_ptr<BindlessHeap>> {
+  auto heap = std::shared_ptr<BindlessHeap>(new BindlessHeap(device));
+
+  const auto properties =
+      physical_device.getProperties2<
+          ::vk::PhysicalDeviceProperties2,
+          ::vk::PhysicalDeviceDescriptorIndexingProperties>();
+  const auto &limits =
+      properties.get<::vk::PhysicalDeviceDescriptorIndexingProperties>();
+
+  const auto clamp = [](uint32_t wanted, uint32_t stage_limit,
+                        uint32_t set_limit) {
+    const auto limit = std::min(stage_limit, set_limit);
+    return std::min(wanted, limit > kReservedDescriptors
+                                ? limit - kReservedDescriptors
+                                : limit);
+  };
+
+  heap->buffers_.capacity =
+      clamp(kMaxStorageBuffers,
+            limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+            limits.maxDescriptorSetUpdateAfterBindStorageBuffers);
+  heap->images_.capacity = clamp(
+      kMaxSampledImages,
+      std::min(limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+               limits.maxPerStageDescriptorUpdateAfterBindSamplers),
+      std::min(limits.maxDescriptorSetUpdateAfterBindSampledImages,
+               limits.maxDescriptorSetUpdateAfterBindSamplers));
+
+  spdlog::debug("Bindless heap: {} buffers, {} images",
+                heap->buffers_.capacity, heap->images_.capacity);
+
+  {
+    const std::array pool_sizes = {
+        ::vk::DescriptorPoolSize{::vk::DescriptorType::eStorageBuffer,
+                                 heap->buffers_.capacity},
+        ::vk::DescriptorPoolSize{::vk::DescriptorType::eCombinedImageSampler,
+                                 heap->images_.capacity},
+    };
+
+    const ::vk::DescriptorPoolCreateInfo create_info(
+        ::vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind, 1, pool_sizes);
+    VK_TIE_RESULT(heap->pool_, device.createDescriptorPool(create_info));
+  }
+
+  {
+    const std::array bindings = {
+        ::vk::DescriptorSetLayoutBinding{
+            kStorageBufferBinding, ::vk::DescriptorType::eStorageBuffer,
+            heap->buffers_.capacity, ::vk::ShaderStageFlagBits::eAll},
+        ::vk::DescriptorSetLayoutBinding{
+            kSampledImageBinding, ::vk::DescriptorType::eCombinedImageSampler,
+            heap->images_.capacity, ::vk::ShaderStageFlagBits::eAll},
+    };
+
+    const ::vk::DescriptorBindingFlags binding_flags =
+        ::vk::DescriptorBindingFlagBits::ePartiallyBound |
+        ::vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+        ::vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+    const std::array flags = {binding_flags, binding_flags};
+
+    ::vk::DescriptorSetLayoutBindingFlagsCreateInfo flags_info(flags);
+    ::vk::DescriptorSetLayoutCreateInfo create_info(
+        ::vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
+        bindings, &flags_info);
+    VK_TIE_RESULT(heap->set_layout_,
+                  device.createDescriptorSetLayout(create_info));
+  }
+
+  {
+    const ::vk::DescriptorSetAllocateInfo alloc_info(heap->pool_,
+                                                     heap->set_layout_);
+    VK_TRY_RESULT(sets, device.allocateDescriptorSets(alloc_info));
+    heap->set_ = sets.front();
+  }
+
+  return heap;
+}
+
+BindlessHeap::~BindlessHeap() {
+  // Destroying the pool frees the set with it
+  device_.destroyDescriptorPool(pool_);
+  device_.destroyDescriptorSetLayout(set_layout_);
+}
+
+auto BindlessHeap::add_buffer(const ::vk::Buffer &buffer,
+                              ::vk::DeviceSize offset, ::vk::DeviceSize range)
+    -> expected<uint32_t> {
+  TRY_RESULT(const auto index, buffers_.acquire());
+
+  const ::vk::DescriptorBufferInfo buffer_info(buffer, offset, range);
+  const ::vk::WriteDescriptorSet write(set_, kStorageBufferBinding, index,
+                                      ::vk::DescriptorType::eStorageBuffer,
+                                      {}, buffer_info);
+  device_.updateDescriptorSets(write, {});
+
+  return index;
+}
+
+auto BindlessHeap::add_image(const ::vk::ImageView &view,
+                             const ::vk::Sampler &sampler,
+                             ::vk::ImageLayout layout) -> expected<uint32_t> {
+  TRY_RESULT(const auto index, images_.acquire());
+
+  const ::vk::DescriptorImageInfo image_info(sampler, view, layout);
+  const ::vk::WriteDescriptorSet write(
+      set_, kSampledImageBinding, index,
+      ::vk::DescriptorType::eCombinedImageSampler, image_info);
+  device_.updateDescriptorSets(write, {});
+
+  return index;
+}
+
+void BindlessHeap::remove_buffer(uint32_t index) { buffers_.release(index); }
+
+void BindlessHeap::remove_image(uint32_t index) { images_.release(index); }
+
+void BindlessHeap::bind(const ::vk::CommandBuffer &cmd,
+                        const ::vk::PipelineBindPoint &bind_point,
+                        const ::vk::PipelineLayout &layout) const {
+  cmd.bindDescriptorSets(bind_point, layout, kSet, set_, {});
+}
+
+auto BindlessHeap::Slots::acquire() -> expected<uint32_t> {
+  if (!free.empty()) {
+    const auto index = free.back();
+    free.pop_back();
+    return index;
+  }
+
+  if (next >= capacity) {
+    return std::unexpected(make_error_code(BindlessErrors::HeapFull));
+  }
+
+  return next++;
+}
+
+void BindlessHeap::Slots::release(uint32_t index) { free.push_back(index); }
+
+}  // namespace wren::vk
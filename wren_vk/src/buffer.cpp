@@ -7,19 +7,27 @@
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_enums.hpp>
 #include <vulkan/vulkan_structs.hpp>
+#include <wren/utils/scope_guard.hpp>
 
 namespace wren::vk {
 
-auto Buffer::create(const VmaAllocator& allocator, size_t size,
-                    VkBufferUsageFlags usage,
-                    const std::optional<VmaAllocationCreateFlags>& flags)
-    -> std::shared_ptr<Buffer> {
+auto Buffer::create(
+    const VmaAllocator& allocator, size_t size, VkBufferUsageFlags usage,
+    const std::optional<VmaAllocationCreateFlags>& flags,
+    const std::shared_ptr<utils::DeletionQueue>& deletion_queue,
+    std::span<const uint32_t> queue_families) -> std::shared_ptr<Buffer> {
   auto b = std::make_shared<Buffer>(allocator);
+  b->deletion_queue_ = deletion_queue;
 
   VkBufferCreateInfo create_info{};
   create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   create_info.size = size;
   create_info.usage = static_cast<VkBufferUsageFlags>(usage);
+  if (queue_families.size() > 1) {
+    create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    create_info.queueFamilyIndexCount = queue_families.size();
+    create_info.pQueueFamilyIndices = queue_families.data();
+  }
 
   VmaAllocationCreateInfo alloc_info{};
   alloc_info.usage = VMA_MEMORY_USAGE_AUTO;
@@ -51,40 +59,70 @@ auto Buffer::set_data_raw(const void* data, std::size_t size)
   return {};
 }
 
-auto Buffer::copy_buffer(const ::vk::Device& device,
-                         const ::vk::Queue& submit_queue,
-                         const ::vk::CommandPool& command_pool,
-                         const std::shared_ptr<Buffer>& src,
-                         const std::shared_ptr<Buffer>& dst, size_t size)
-    -> expected<void> {
+auto Buffer::copy_buffer(
+    const ::vk::Device& device, SubmitQueue& submit_queue,
+    const ::vk::CommandPool& command_pool, const std::shared_ptr<Buffer>& src,
+    const std::shared_ptr<Buffer>& dst, size_t size,
+    const std::shared_ptr<utils::DeletionQueue>& deletion_queue)
+    -> expected<TimelinePoint> {
   const ::vk::CommandBufferAllocateInfo alloc_info(
       command_pool, ::vk::CommandBufferLevel::ePrimary, 1);
 
-  VK_ERR_PROP(cmd_bufs, device.allocateCommandBuffers(alloc_info));
-
+  VK_TRY_RESULT(cmd_bufs, device.allocateCommandBuffers(alloc_info));
   const auto cmd_buf = cmd_bufs.front();
+  // Never submitted when anything below fails, it can go right away
+  utils::ScopeGuard free_cmd(
+      [&]() { device.freeCommandBuffers(command_pool, cmd_buf); });
 
-  ::vk::CommandBufferBeginInfo begin_info(
-      ::vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+  VK_CHECK_RESULT(cmd_buf.begin(::vk::CommandBufferBeginInfo(
+      ::vk::CommandBufferUsageFlagBits::eOneTimeSubmit)));
 
-  VK_ERR_PROP_VOID(cmd_buf.begin(begin_info));
-
-  ::vk::BufferCopy copy_region(0, 0, size);
+  const ::vk::BufferCopy copy_region(0, 0, size);
   cmd_buf.copyBuffer(src->get(), dst->get(), copy_region);
-  VK_ERR_PROP_VOID(cmd_buf.end());
-
-  ::vk::SubmitInfo submit_info({}, {}, cmd_buf);
-  VK_ERR_PROP_VOID(submit_queue.submit(submit_info));
-  VK_ERR_PROP_VOID(submit_queue.waitIdle());
 
-  device.freeCommandBuffers(command_pool, cmd_bufs);
+  // Later submits on the same queue are ordered behind the copy by this
+  const ::vk::BufferMemoryBarrier barrier(
+      ::vk::AccessFlagBits::eTransferWrite, ::vk::AccessFlagBits::eMemoryRead,
+      VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, dst->get(), 0, size);
+  cmd_buf.pipelineBarrier(::vk::PipelineStageFlagBits::eTransfer,
+                          ::vk::PipelineStageFlagBits::eAllCommands, {}, {},
+                          barrier, {});
+
+  VK_CHECK_RESULT(cmd_buf.end());
+
+  Submission submission;
+  submission.command_buffers.push_back(cmd_buf);
+  TRY_RESULT(const auto point, submit_queue.submit(submission));
+  free_cmd.dismiss();
+
+  // Holding src keeps the staging buffer alive until the copy has read it
+  auto release = [device, command_pool, cmd_buf, src]() {
+    device.freeCommandBuffers(command_pool, cmd_buf);
+  };
+  if (deletion_queue != nullptr) {
+    deletion_queue->push(point.value, std::move(release));
+  } else {
+    TRY_RESULT(submit_queue.wait(point.value));
+    release();
+  }
 
-  return {};
+  return point;
 }
 
 Buffer::~Buffer() {
   unmap();
-  vmaFreeMemory(allocator_, allocation_);
+
+  auto destroy = [allocator = allocator_,
+                  buffer = static_cast<VkBuffer>(buffer_),
+                  allocation = allocation_]() {
+    vmaDestroyBuffer(allocator, buffer, allocation);
+  };
+
+  if (deletion_queue_) {
+    deletion_queue_->push(std::move(destroy));
+  } else {
+    destroy();
+  }
 }
 
 }  // namespace wren::vk
@@ -1,31 +1,90 @@
 #include "image.hpp"
 
+#include <wren/vk/result.hpp>
+
 namespace wren::vk {
 
-auto Image::create(const ::vk::Device& device, const VmaAllocator& allocator,
-                   const ::vk::Format& format, const math::Vec2f& size,
-                   const ::vk::ImageUsageFlags& usage) -> expected<Image> {
-  Image image;
+namespace {
 
+auto image_create_info(const ::vk::Format& format, const math::Vec2f& size,
+                       const ::vk::ImageUsageFlags& usage,
+                       uint32_t mip_levels = 1) {
   ::vk::ImageCreateInfo image_info(
       {}, ::vk::ImageType::e2D, format,
       ::vk::Extent3D(static_cast<uint32_t>(size.x()),
                      static_cast<uint32_t>(size.y()), 1),
-      1, 1);
+      mip_levels, 1);
   image_info.setUsage(usage);
   image_info.setSharingMode(::vk::SharingMode::eExclusive);
 
+  return image_info;
+}
+
+}  // namespace
+
+auto Image::create(const ::vk::Device& device, const VmaAllocator& allocator,
+                   const ::vk::Format& format, const math::Vec2f& size,
+                   const ::vk::ImageUsageFlags& usage,
+                   VmaMemoryUsage memory_usage, uint32_t mip_levels)
+    -> expected<Image> {
+  Image image;
+
+  const auto info = static_cast<VkImageCreateInfo>(
+      image_create_info(format, size, usage, mip_levels));
+
   VmaAllocationCreateInfo alloc_info{};
-  alloc_info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
-  auto info = static_cast<VkImageCreateInfo>(image_info);
+  alloc_info.usage = memory_usage;
 
   VkImage tmp_image = nullptr;
-  vmaCreateImage(allocator, &info, &alloc_info, &tmp_image, &image.alloc_,
-                 nullptr);
+  VK_CHECK_RESULT(static_cast<::vk::Result>(vmaCreateImage(
+      allocator, &info, &alloc_info, &tmp_image, &image.alloc_, nullptr)));
 
   image.image_ = tmp_image;
 
   return image;
 }
 
+auto Image::create_aliasing(const VmaAllocator& allocator,
+                            const VmaAllocation& memory,
+                            const ::vk::Format& format,
+                            const math::Vec2f& size,
+                            const ::vk::ImageUsageFlags& usage)
+    -> expected<Image> {
+  Image image;
+
+  const auto info =
+      static_cast<VkImageCreateInfo>(image_create_info(format, size, usage));
+
+  VkImage tmp_image = nullptr;
+  VK_CHECK_RESULT(static_cast<::vk::Result>(
+      vmaCreateAliasingImage(allocator, memory, &info, &tmp_image)));
+
+  image.image_ = tmp_image;
+
+  return image;
+}
+
+void Image::destroy(const ::vk::Device& device,
+                    const VmaAllocator& allocator) const {
+  if (alloc_ != nullptr) {
+    vmaDestroyImage(allocator, image_, alloc_);
+  } else {
+    device.destroyImage(image_);
+  }
+}
+
+auto Image::memory_requirements(const ::vk::Device& device,
+                                const ::vk::Format& format,
+                                const math::Vec2f& size,
+                                const ::vk::ImageUsageFlags& usage)
+    -> expected<::vk::MemoryRequirements> {
+  // Vulkan 1.2 can only query the requirements of an existing image
+  VK_TRY_RESULT(image,
+                device.createImage(image_create_info(format, size, usage)));
+  const auto requirements = device.getImageMemoryRequirements(image);
+  device.destroyImage(image);
+
+  return requirements;
+}
+
 }  // namespace wren::vk
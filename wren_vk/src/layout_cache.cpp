@@ -0,0 +1,82 @@
+#include "layout_cache.hpp"
+
+#include <wren/vk/result.hpp>
+
+namespace wren::vk {
+
+auto LayoutCache::get(const PipelineLayoutDescription &description)
+    -> expected<Layout> {
+  if (const auto it = pipeline_layouts_.find(description);
+      it != pipeline_layouts_.end()) {
+    return it->second;
+  }
+
+  // Sets have to be contiguous, any holes get an empty layout
+  const auto &sets = description.sets;
+  const uint32_t set_count = sets.empty() ? 1 : sets.back().set + 1;
+
+  Layout layout;
+  layout.set_layouts.reserve(set_count);
+  for (uint32_t index = 0; index < set_count; ++index) {
+    const auto set =
+        std::ranges::find(sets, index, &DescriptorSetLayoutDescription::set);
+
+    if (const auto external = external_layouts_.find(index);
+        set != sets.end() && external != external_layouts_.end()) {
+      layout.set_layouts.push_back(external->second);
+      continue;
+    }
+
+    TRY_RESULT(const auto set_layout,
+               get(set != sets.end() ? *set
+                                     : DescriptorSetLayoutDescription{
+                                           .set = index}));
+    layout.set_layouts.push_back(set_layout);
+  }
+
+  ::vk::PipelineLayoutCreateInfo create_info({}, layout.set_layouts);
+  if (description.push_constant_range.size != 0) {
+    create_info.setPushConstantRanges(description.push_constant_range);
+  }
+  VK_TIE_RESULT(layout.pipeline_layout,
+                device_.createPipelineLayout(create_info));
+
+  pipeline_layouts_.emplace(description, layout);
+
+  return layout;
+}
+
+auto LayoutCache::get(const DescriptorSetLayoutDescription &description)
+    -> expected<::vk::DescriptorSetLayout> {
+  if (const auto it = set_layouts_.find(description);
+      it != set_layouts_.end()) {
+    return it->second;
+  }
+
+  // Only the first set is pushed
+  ::vk::DescriptorSetLayoutCreateInfo create_info(
+      description.set == 0
+          ? ::vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR
+          : ::vk::DescriptorSetLayoutCreateFlags{},
+      description.bindings);
+
+  VK_TRY_RESULT(set_layout, device_.createDescriptorSetLayout(create_info));
+
+  set_layouts_.emplace(description, set_layout);
+
+  return set_layout;
+}
+
+void LayoutCache::clear() {
+  for (const auto &[_, layout] : pipeline_layouts_) {
+    device_.destroyPipelineLayout(layout.pipeline_layout);
+  }
+  pipeline_layouts_.clear();
+
+  for (const auto &[_, set_layout] : set_layouts_) {
+    device_.destroyDescriptorSetLayout(set_layout);
+  }
+  set_layouts_.clear();
+}
+
+}  // namespace wren::vk
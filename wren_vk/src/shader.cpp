@@ -7,14 +7,17 @@
 // #include <wren/reflect/spirv_reflect.h>
 
 #include <algorithm>
+#include <boost/container_hash/hash.hpp>
 #include <cstdint>
 #include <shaderc/shaderc.hpp>
+#include <span>
 #include <vulkan/vulkan_enums.hpp>
 #include <vulkan/vulkan_handles.hpp>
 #include <wren/math/vector.hpp>
 #include <wren/utils/enums.hpp>
 #include <wren/utils/filesystem.hpp>
 #include <wren/utils/string_reader.hpp>
+#include <wren/vk/layout_cache.hpp>
 #include <wren/vk/result.hpp>
 // #include <wren_reflect/parser.hpp>
 
@@ -22,43 +25,128 @@
 
 namespace wren::vk {
 
-ShaderModule::ShaderModule(reflect::spirv_t spirv,
-                           const ::vk::ShaderModule &module)
-    : spirv(std::move(spirv)),
-      module(module),
-      reflection(std::make_shared<spv_reflect::ShaderModule>(this->spirv)) {}
+namespace {
+
+auto has_stencil(const ::vk::Format &format) -> bool {
+  switch (format) {
+    case ::vk::Format::eS8Uint:
+    case ::vk::Format::eD16UnormS8Uint:
+    case ::vk::Format::eD24UnormS8Uint:
+    case ::vk::Format::eD32SfloatS8Uint:
+      return true;
+    default:
+      return false;
+  }
+}
 
-auto ShaderModule::get_vertex_input_bindings() const
-    -> std::vector<::vk::VertexInputBindingDescription> {
-  uint32_t count = 0;
-  reflection->EnumerateInputVariables(&count, nullptr);
-  if (count == 0) return {};
+}  // namespace
 
-  std::vector<SpvReflectInterfaceVariable *> input_variables(count);
-  reflection->EnumerateInputVariables(&count, input_variables.data());
+void PipelineLayoutDescription::merge(const PipelineLayoutDescription &other) {
+  for (const auto &other_set : other.sets) {
+    auto set = std::ranges::lower_bound(sets, other_set.set, {},
+                                        &DescriptorSetLayoutDescription::set);
+    if (set == sets.end() || set->set != other_set.set) {
+      sets.insert(set, other_set);
+      continue;
+    }
 
-  uint32_t offset = 0;
-  std::vector<::vk::VertexInputBindingDescription> bindings;
-  bindings.reserve(count);
-  for (const auto &input : input_variables) {
-    if (static_cast<uint32_t>(input->built_in) != UINT32_MAX) continue;
+    for (const auto &other_binding : other_set.bindings) {
+      auto binding =
+          std::ranges::lower_bound(set->bindings, other_binding.binding, {},
+                                   &::vk::DescriptorSetLayoutBinding::binding);
+      if (binding == set->bindings.end() ||
+          binding->binding != other_binding.binding) {
+        set->bindings.insert(binding, other_binding);
+        continue;
+      }
+
+      if (binding->descriptorType != other_binding.descriptorType) {
+        spdlog::warn(
+            "Descriptor (set: {}, binding: {}) has mismatched types across "
+            "stages",
+            set->set, binding->binding);
+      }
+
+      binding->stageFlags |= other_binding.stageFlags;
+      binding->descriptorCount =
+          std::max(binding->descriptorCount, other_binding.descriptorCount);
+    }
+  }
+
+  // A stage can only appear in one range, so stages share a range spanning
+  // both of their blocks
+  const auto &other_range = other.push_constant_range;
+  if (other_range.size == 0) return;
+  if (push_constant_range.size == 0) {
+    push_constant_range = other_range;
+    return;
+  }
 
-    const auto width = input->numeric.scalar.width / 8;
-    const auto count = input->numeric.vector.component_count;
-    offset += width * count;
+  const auto begin = std::min(push_constant_range.offset, other_range.offset);
+  const auto end =
+      std::max(push_constant_range.offset + push_constant_range.size,
+               other_range.offset + other_range.size);
+  push_constant_range.stageFlags |= other_range.stageFlags;
+  push_constant_range.offset = begin;
+  push_constant_range.size = end - begin;
+}
+
+auto DescriptorSetLayoutDescription::hash() const -> std::size_t {
+  std::size_t seed = 0;
+  boost::hash_combine(seed, set);
+  for (const auto &binding : bindings) {
+    boost::hash_combine(seed, binding.binding);
+    boost::hash_combine(seed, static_cast<uint32_t>(binding.descriptorType));
+    boost::hash_combine(seed, binding.descriptorCount);
+    boost::hash_combine(seed,
+                        static_cast<VkShaderStageFlags>(binding.stageFlags));
   }
 
-  if (offset == 0) {
-    return {};
+  return seed;
+}
+
+auto PipelineLayoutDescription::has_set(uint32_t set) const -> bool {
+  return std::ranges::find(sets, set, &DescriptorSetLayoutDescription::set) !=
+         sets.end();
+}
+
+auto PipelineLayoutDescription::hash() const -> std::size_t {
+  std::size_t seed = 0;
+  for (const auto &set : sets) {
+    boost::hash_combine(seed, set.hash());
+  }
+  boost::hash_combine(seed, static_cast<VkShaderStageFlags>(
+                                push_constant_range.stageFlags));
+  boost::hash_combine(seed, push_constant_range.offset);
+  boost::hash_combine(seed, push_constant_range.size);
+
+  return seed;
+}
+
+ShaderModule::ShaderModule(reflect::spirv_t spirv,
+                           const ::vk::ShaderModule &module)
+    : spirv(std::move(spirv)),
+      module(module),
+      reflection(std::make_shared<spv_reflect::ShaderModule>(this->spirv)) {
+  reflect();
+}
+
+void ShaderModule::reflect() {
+  stage_ = static_cast<::vk::ShaderStageFlagBits>(reflection->GetShaderStage());
+
+  if (stage_ == ::vk::ShaderStageFlagBits::eVertex) {
+    reflect_vertex_inputs();
   }
 
-  return {{0, offset}};
+  reflect_descriptor_sets();
+  reflect_push_constants();
 }
 
-auto ShaderModule::get_vertex_input_attributes() const
-    -> std::vector<::vk::VertexInputAttributeDescription> {
+void ShaderModule::reflect_vertex_inputs() {
   uint32_t count = 0;
   reflection->EnumerateInputVariables(&count, nullptr);
+  if (count == 0) return;
+
   std::vector<SpvReflectInterfaceVariable *> input_variables(count);
   reflection->EnumerateInputVariables(&count, input_variables.data());
 
@@ -67,39 +155,69 @@ auto ShaderModule::get_vertex_input_attributes() const
   });
 
   uint32_t offset = 0;
-  std::vector<::vk::VertexInputAttributeDescription> attrs;
+  vertex_input_attributes_.reserve(count);
   for (const auto &input : input_variables) {
+    if (static_cast<uint32_t>(input->built_in) != UINT32_MAX) continue;
     if (input->location == UINT32_MAX) continue;
-    attrs.emplace_back(input->location, 0,
-                       static_cast<::vk::Format>(input->format), offset);
+
+    vertex_input_attributes_.emplace_back(
+        input->location, 0, static_cast<::vk::Format>(input->format), offset);
     offset += (input->numeric.scalar.width / 8) *
               input->numeric.vector.component_count;
   }
 
-  return attrs;
+  if (offset != 0) {
+    vertex_input_bindings_.emplace_back(0, offset);
+  }
 }
 
-auto ShaderModule::get_descriptor_set_layout_bindings() const
-    -> std::vector<::vk::DescriptorSetLayoutBinding> {
+void ShaderModule::reflect_descriptor_sets() {
   uint32_t count = 0;
   reflection->EnumerateDescriptorSets(&count, nullptr);
   std::vector<SpvReflectDescriptorSet *> spv_sets(count);
   reflection->EnumerateDescriptorSets(&count, spv_sets.data());
 
-  std::vector<::vk::DescriptorSetLayoutBinding> layouts;
-  for (const SpvReflectDescriptorSet *set : spv_sets) {
-    std::span<SpvReflectDescriptorBinding *> bindings(set->bindings,
-                                                      set->binding_count);
+  layout_description_.sets.reserve(count);
+  for (const SpvReflectDescriptorSet *spv_set : spv_sets) {
+    std::span<SpvReflectDescriptorBinding *> bindings(spv_set->bindings,
+                                                      spv_set->binding_count);
 
+    DescriptorSetLayoutDescription set{.set = spv_set->set};
+    set.bindings.reserve(bindings.size());
     for (SpvReflectDescriptorBinding *binding : bindings) {
-      layouts.emplace_back(
+      set.bindings.emplace_back(
           binding->binding,
           static_cast<::vk::DescriptorType>(binding->descriptor_type),
-          binding->count, ::vk::ShaderStageFlagBits::eVertex);
+          binding->count, stage_);
     }
+
+    std::ranges::sort(set.bindings, {},
+                      &::vk::DescriptorSetLayoutBinding::binding);
+    layout_description_.sets.push_back(std::move(set));
   }
 
-  return layouts;
+  std::ranges::sort(layout_description_.sets, {},
+                    &DescriptorSetLayoutDescription::set);
+}
+
+void ShaderModule::reflect_push_constants() {
+  uint32_t count = 0;
+  reflection->EnumeratePushConstantBlocks(&count, nullptr);
+  if (count == 0) return;
+
+  std::vector<SpvReflectBlockVariable *> blocks(count);
+  reflection->EnumeratePushConstantBlocks(&count, blocks.data());
+
+  // Only one push_constant block is allowed per stage, its offset is the one
+  // of its first member
+  const SpvReflectBlockVariable *block = blocks.front();
+  uint32_t end = block->member_count == 0 ? block->offset + block->size : 0;
+  for (const auto &member : std::span(block->members, block->member_count)) {
+    end = std::max(end, member.absolute_offset + member.size);
+  }
+
+  layout_description_.push_constant_range =
+      ::vk::PushConstantRange(stage_, block->offset, end - block->offset);
 }
 
 auto Shader::create(const ::vk::Device &device,
@@ -149,12 +267,36 @@ auto Shader::create(const ::vk::Device &device,
         shader->fragment_shader(module);
         break;
       }
+      case ShaderType::Compute: {
+        TRY_RESULT(
+            const auto module,
+            compile_shader(device,
+                           shaderc_shader_kind::shaderc_glsl_compute_shader,
+                           shader_path, content));
+        shader->compute_shader(module);
+        break;
+      }
     }
   }
 
   return shader;
 }
 
+auto Shader::create_compute(const ::vk::Device &device,
+                            const std::string &compute_shader)
+    -> expected<Ptr> {
+  const auto shader = std::make_shared<Shader>();
+
+  TRY_RESULT(
+      const auto compute,
+      compile_shader(device, shaderc_shader_kind::shaderc_glsl_compute_shader,
+                     "compute_shader", compute_shader));
+
+  shader->compute_shader(compute);
+
+  return shader;
+}
+
 auto Shader::compile_shader(const ::vk::Device &device,
                             const shaderc_shader_kind &shader_kind,
                             const std::string &filename,
@@ -183,38 +325,54 @@ auto Shader::compile_shader(const ::vk::Device &device,
   return ShaderModule{{spirv.begin(), spirv.end()}, module};
 }
 
+void Shader::update_layout_description() {
+  if (is_compute()) {
+    layout_description_ = compute_shader_module_.layout_description();
+    return;
+  }
+
+  layout_description_ = vertex_shader_module_.layout_description();
+  layout_description_.merge(fragment_shader_module_.layout_description());
+}
+
+auto Shader::update_layouts(LayoutCache &layout_cache) -> expected<void> {
+  // Layouts are shared between every shader with the same interface
+  TRY_RESULT(const auto layout, layout_cache.get(layout_description_));
+  descriptor_layout_ = layout.set_layouts.front();
+  pipeline_layout_ = layout.pipeline_layout;
+
+  return {};
+}
+
 auto Shader::create_graphics_pipeline(const ::vk::Device &device,
-                                      const ::vk::RenderPass &render_pass,
-                                      const math::Vec2f &size, bool depth)
+                                      LayoutCache &layout_cache,
+                                      utils::DeletionQueue &deletion_queue,
+                                      const PipelineTarget &target,
+                                      const math::Vec2f &size,
+                                      const VertexLayout *vertex_layout)
     -> expected<void> {
   ::vk::Result res = ::vk::Result::eSuccess;
 
-  // Descriptor Sets
-  const auto bindings =
-      vertex_shader_module_.get_descriptor_set_layout_bindings();
-  ::vk::DescriptorSetLayoutCreateInfo dl_create_info(
-      ::vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR, bindings);
-
-  VK_TIE_ERR_PROP(descriptor_layout_,
-                  device.createDescriptorSetLayout(dl_create_info));
-
-  ::vk::PipelineLayoutCreateInfo layout_create({}, descriptor_layout_);
-  std::tie(res, pipeline_layout_) = device.createPipelineLayout(layout_create);
-  if (res != ::vk::Result::eSuccess)
-    return std::unexpected(make_error_code(res));
+  TRY_RESULT(update_layouts(layout_cache));
 
   // Dynamic states
   std::array dynamic_states = {::vk::DynamicState::eViewport,
                                ::vk::DynamicState::eScissor};
   ::vk::PipelineDynamicStateCreateInfo dynamic_state({}, dynamic_states);
 
-  // Input binding/attributes
-  const auto input_bindings = vertex_shader_module_.get_vertex_input_bindings();
-  const auto input_attributes =
-      vertex_shader_module_.get_vertex_input_attributes();
+  // Input binding/attributes, mesh inputs are laid out like the meshes store
+  // them rather than tightly packed floats. A shader reading them any other
+  // way would read garbage, so it doesn't get a pipeline.
+  VertexInput input{vertex_shader_module_.get_vertex_input_bindings(),
+                    vertex_shader_module_.get_vertex_input_attributes()};
+  if (vertex_layout != nullptr) {
+    TRY_RESULT(const auto mesh_input,
+               vertex_layout->vertex_input(input.attributes));
+    if (mesh_input.has_value()) input = *mesh_input;
+  }
 
   ::vk::PipelineVertexInputStateCreateInfo vertex_input_info{
-      {}, input_bindings, input_attributes};
+      {}, input.bindings, input.attributes};
 
   ::vk::PipelineInputAssemblyStateCreateInfo input_assembly(
       {}, ::vk::PrimitiveTopology::eTriangleList, false);
@@ -251,6 +409,7 @@ auto Shader::create_graphics_pipeline(const ::vk::Device &device,
       {0.0, 0.0, 0.0, 0.0});
 
   // Depth / Stencil
+  const bool depth = target.has_depth();
   ::vk::PipelineDepthStencilStateCreateInfo depth_state(
       {}, depth, depth, ::vk::CompareOp::eGreaterOrEqual);
 
@@ -266,7 +425,23 @@ auto Shader::create_graphics_pipeline(const ::vk::Device &device,
   auto create_info = ::vk::GraphicsPipelineCreateInfo(
       {}, shader_stages, &vertex_input_info, &input_assembly, {},
       &viewport_state, &rasterization, &multisample, &depth_state,
-      &colour_blend, &dynamic_state, pipeline_layout_, render_pass);
+      &colour_blend, &dynamic_state, pipeline_layout_, target.render_pass);
+
+  // Without a render pass the attachment formats are given directly
+  const auto colour_formats =
+      target.colour_format != ::vk::Format::eUndefined
+          ? std::span<const ::vk::Format>(&target.colour_format, 1)
+          : std::span<const ::vk::Format>();
+  ::vk::PipelineRenderingCreateInfo rendering_info(
+      0, colour_formats, target.depth_format,
+      has_stencil(target.depth_format) ? target.depth_format
+                                       : ::vk::Format::eUndefined);
+  if (!target.render_pass) create_info.setPNext(&rendering_info);
+
+  if (pipeline_) {
+    deletion_queue.push(
+        [device, pipeline = pipeline_]() { device.destroyPipeline(pipeline); });
+  }
 
   std::tie(res, pipeline_) = device.createGraphicsPipeline({}, create_info);
   if (res != ::vk::Result::eSuccess)
@@ -275,6 +450,28 @@ auto Shader::create_graphics_pipeline(const ::vk::Device &device,
   return {};
 }
 
+auto Shader::create_compute_pipeline(const ::vk::Device &device,
+                                     LayoutCache &layout_cache,
+                                     utils::DeletionQueue &deletion_queue)
+    -> expected<void> {
+  TRY_RESULT(update_layouts(layout_cache));
+
+  const ::vk::PipelineShaderStageCreateInfo stage(
+      {}, ::vk::ShaderStageFlagBits::eCompute, compute_shader_module_.module,
+      "main");
+
+  if (pipeline_) {
+    deletion_queue.push(
+        [device, pipeline = pipeline_]() { device.destroyPipeline(pipeline); });
+  }
+
+  VK_TIE_RESULT(pipeline_, device.createComputePipeline(
+                               {}, ::vk::ComputePipelineCreateInfo(
+                                       {}, stage, pipeline_layout_)));
+
+  return {};
+}
+
 auto Shader::read_wren_shader_file(const std::filesystem::path &path)
     -> expected<std::map<ShaderType, std::string>> {
   const auto shader_file = utils::fs::read_file_to_string(path);
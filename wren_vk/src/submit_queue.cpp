@@ -0,0 +1,92 @@
+#include "submit_queue.hpp"
+
+#include <wren/vk/result.hpp>
+
+namespace wren::vk {
+
+auto SubmitQueue::create(
+    const ::vk::Device &device, const ::vk::Queue &queue, uint32_t family,
+    const std::shared_ptr<utils::DeletionQueue> &deletion_queue)
+    -> expected<std::shared_ptr<SubmitQueue>> {
+  auto submit_queue =
+      std::shared_ptr<SubmitQueue>(new SubmitQueue(device, queue, family));
+  submit_queue->deletion_queue_ = deletion_queue;
+
+  ::vk::SemaphoreTypeCreateInfo type_info(::vk::SemaphoreType::eTimeline, 0);
+  VK_TIE_RESULT(submit_queue->semaphore_,
+                device.createSemaphore({{}, &type_info}));
+
+  if (deletion_queue != nullptr) deletion_queue->pending_value(1);
+
+  return submit_queue;
+}
+
+SubmitQueue::~SubmitQueue() { device_.destroySemaphore(semaphore_); }
+
+auto SubmitQueue::submit(const Submission &submission)
+    -> expected<TimelinePoint> {
+  std::vector<::vk::Semaphore> wait_semaphores;
+  std::vector<uint64_t> wait_values;
+  std::vector<::vk::PipelineStageFlags> wait_stages;
+
+  for (const auto &[point, stages] : submission.waits) {
+    wait_semaphores.push_back(point.semaphore);
+    wait_values.push_back(point.value);
+    wait_stages.push_back(stages);
+  }
+
+  // Values for binary semaphores are ignored but the arrays have to match
+  for (const auto &[semaphore, stages] : submission.binary_waits) {
+    wait_semaphores.push_back(semaphore);
+    wait_values.push_back(0);
+    wait_stages.push_back(stages);
+  }
+
+  std::vector<::vk::Semaphore> signal_semaphores = submission.binary_signals;
+  std::vector<uint64_t> signal_values(signal_semaphores.size(), 0);
+
+  std::scoped_lock lock(mutex_);
+
+  const auto value = submitted_ + 1;
+  signal_semaphores.push_back(semaphore_);
+  signal_values.push_back(value);
+
+  ::vk::TimelineSemaphoreSubmitInfo timeline_info(wait_values, signal_values);
+  const ::vk::SubmitInfo submit_info(wait_semaphores, wait_stages,
+                                     submission.command_buffers,
+                                     signal_semaphores, &timeline_info);
+  VK_CHECK_RESULT(queue_.submit(submit_info));
+
+  submitted_ = value;
+
+  // Anything retired from now on may be used by this submit
+  if (deletion_queue_ != nullptr) deletion_queue_->pending_value(value + 1);
+
+  return TimelinePoint{semaphore_, value};
+}
+
+auto SubmitQueue::last_submitted() const -> TimelinePoint {
+  std::scoped_lock lock(mutex_);
+  return {semaphore_, submitted_};
+}
+
+auto SubmitQueue::completed() const -> expected<uint64_t> {
+  VK_TRY_RESULT(value, device_.getSemaphoreCounterValue(semaphore_));
+  return value;
+}
+
+auto SubmitQueue::is_complete(uint64_t value) const -> bool {
+  const auto completed_value = completed();
+  return completed_value.has_value() && completed_value.value() >= value;
+}
+
+auto SubmitQueue::wait(uint64_t value, uint64_t timeout) const
+    -> expected<bool> {
+  const ::vk::SemaphoreWaitInfo wait_info({}, semaphore_, value);
+  const auto res = device_.waitSemaphores(wait_info, timeout);
+  if (res == ::vk::Result::eTimeout) return false;
+  VK_CHECK_RESULT(res);
+  return true;
+}
+
+}  // namespace wren::vk
@@ -0,0 +1,273 @@
+#include "vertex_layout.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <wren/math/bounds.hpp>
+#include <wren/math/quantize.hpp>
+
+namespace wren::vk {
+
+namespace {
+
+//! @brief Components of the formats reflection gives shader inputs
+auto component_count(::vk::Format format) -> uint32_t {
+  switch (format) {
+    case ::vk::Format::eR32Sfloat:
+    case ::vk::Format::eR32Sint:
+    case ::vk::Format::eR32Uint:
+      return 1;
+    case ::vk::Format::eR32G32Sfloat:
+    case ::vk::Format::eR32G32Sint:
+    case ::vk::Format::eR32G32Uint:
+      return 2;
+    case ::vk::Format::eR32G32B32Sfloat:
+    case ::vk::Format::eR32G32B32Sint:
+    case ::vk::Format::eR32G32B32Uint:
+      return 3;
+    case ::vk::Format::eR32G32B32A32Sfloat:
+    case ::vk::Format::eR32G32B32A32Sint:
+    case ::vk::Format::eR32G32B32A32Uint:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+}  // namespace
+
+VertexLayout::VertexLayout(const VertexLayoutOptions& options)
+    : options_(options) {
+  const uint32_t attribute_binding = options.split_positions ? 1 : 0;
+
+  switch (options.positions) {
+    case PositionFormat::Float32:
+      add_attribute(kPositionLocation, 0, ::vk::Format::eR32G32B32Sfloat, 12);
+      break;
+    // Three component 16 bit formats are rarely supported for vertex input,
+    // the fourth component is padding
+    case PositionFormat::Float16:
+      add_attribute(kPositionLocation, 0, ::vk::Format::eR16G16B16A16Sfloat,
+                    8);
+      break;
+    case PositionFormat::Snorm16:
+      add_attribute(kPositionLocation, 0, ::vk::Format::eR16G16B16A16Snorm, 8);
+      break;
+  }
+
+  switch (options.normals) {
+    case NormalFormat::Float32:
+      add_attribute(kNormalLocation, attribute_binding,
+                    ::vk::Format::eR32G32B32Sfloat, 12);
+      break;
+    case NormalFormat::Octahedral16:
+      add_attribute(kNormalLocation, attribute_binding,
+                    ::vk::Format::eR16G16Snorm, 4);
+      break;
+  }
+
+  switch (options.colours) {
+    case ColourFormat::Float32:
+      add_attribute(kColourLocation, attribute_binding,
+                    ::vk::Format::eR32G32B32A32Sfloat, 16);
+      break;
+    case ColourFormat::Unorm8:
+      add_attribute(kColourLocation, attribute_binding,
+                    ::vk::Format::eR8G8B8A8Unorm, 4);
+      break;
+    case ColourFormat::Constant:
+      add_attribute(kColourLocation, binding_count(),
+                    ::vk::Format::eR8G8B8A8Unorm, 4);
+      bindings_.back().stride = 0;
+      break;
+  }
+}
+
+void VertexLayout::add_attribute(uint32_t location, uint32_t binding,
+                                 ::vk::Format format, uint32_t size) {
+  if (binding == bindings_.size()) {
+    bindings_.emplace_back(binding, 0, ::vk::VertexInputRate::eVertex);
+  }
+
+  auto& description = bindings_.at(binding);
+  attributes_.at(location) = {binding, description.stride, size, format};
+  description.stride += size;
+}
+
+auto VertexLayout::vertex_size() const -> uint32_t {
+  uint32_t size = 0;
+  for (const auto& binding : bindings_) size += binding.stride;
+  return size;
+}
+
+auto VertexLayout::vertex_input(
+    std::span<const ::vk::VertexInputAttributeDescription> reflected) const
+    -> expected<std::optional<VertexInput>> {
+  if (reflected.empty()) return std::nullopt;
+
+  const auto mesh_input = [this](const auto& attribute) {
+    return attribute.location < attributes_.size();
+  };
+  if (!std::ranges::all_of(reflected, mesh_input)) return std::nullopt;
+
+  VertexInput input;
+  for (const auto& attribute : reflected) {
+    const auto components = component_count(attribute.format);
+    bool matches = true;
+    switch (attribute.location) {
+      case kPositionLocation:
+        matches = components == 3;
+        break;
+      case kNormalLocation:
+        matches = components ==
+                  (options_.normals == NormalFormat::Octahedral16 ? 2U : 3U);
+        break;
+      case kColourLocation:
+        matches = components == 3 || components == 4;
+        break;
+      default:
+        break;
+    }
+    if (!matches) {
+      spdlog::error(
+          "Vertex input at location {} has {} components, the vertex layout "
+          "doesn't store it that way",
+          attribute.location, components);
+      return std::unexpected(VertexLayoutErrors::MismatchedInput);
+    }
+
+    const auto& stored = attributes_.at(attribute.location);
+    input.attributes.emplace_back(attribute.location, stored.binding,
+                                  stored.format, stored.offset);
+
+    if (std::ranges::find(input.bindings, stored.binding,
+                          &::vk::VertexInputBindingDescription::binding) ==
+        input.bindings.end()) {
+      input.bindings.push_back(bindings_.at(stored.binding));
+    }
+  }
+
+  std::ranges::sort(input.bindings, {},
+                    &::vk::VertexInputBindingDescription::binding);
+  return input;
+}
+
+auto VertexLayout::encode(std::span<const math::Vec3f> positions,
+                          std::span<const math::Vec3f> normals,
+                          std::span<const math::Vec4f> colours) const
+    -> EncodedVertices {
+  const auto count = positions.size();
+
+  EncodedVertices encoded;
+  encoded.streams.reserve(bindings_.size());
+  for (const auto& binding : bindings_) {
+    // Stride 0 bindings hold a single element
+    const auto element_size =
+        binding.stride != 0 ? binding.stride
+                            : attributes_.at(kColourLocation).size;
+    encoded.streams.emplace_back(
+        binding.stride != 0 ? element_size * count : element_size);
+  }
+
+  const auto write = [&](uint32_t location, std::size_t vertex,
+                         const auto& value) {
+    const auto& attribute = attributes_.at(location);
+    static_assert(std::is_trivially_copyable_v<
+                  std::remove_cvref_t<decltype(value)>>);
+    const auto stride = bindings_.at(attribute.binding).stride;
+    std::memcpy(encoded.streams.at(attribute.binding).data() +
+                    vertex * stride + attribute.offset,
+                &value, sizeof(value));
+  };
+
+  // Quantized positions are stored relative to the bounds so the precision
+  // is spent where the mesh is. The scale is uniform, normals are unaffected
+  // by the dequantization matrix apart from their length.
+  const auto bounds = math::AABB::from_points(positions);
+  math::Vec3f offset;
+  float scale = 1;
+  if (options_.positions != PositionFormat::Float32 && !bounds.empty()) {
+    offset = bounds.center();
+    if (options_.positions == PositionFormat::Snorm16) {
+      // Centred positions span half the size of the bounds either way, so
+      // half the largest size maps them onto the full [-1, 1] snorm range
+      const auto size = bounds.max - bounds.min;
+      scale = 0.5F * std::max({size.x(), size.y(), size.z()});
+      if (scale <= 0) scale = 1;
+    }
+
+    encoded.dequantization.at(0, 0) = scale;
+    encoded.dequantization.at(1, 1) = scale;
+    encoded.dequantization.at(2, 2) = scale;
+    encoded.dequantization.at(3, 0) = offset.x();
+    encoded.dequantization.at(3, 1) = offset.y();
+    encoded.dequantization.at(3, 2) = offset.z();
+  }
+
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto& position = positions[i];
+    switch (options_.positions) {
+      case PositionFormat::Float32:
+        write(kPositionLocation, i,
+              std::array{position.x(), position.y(), position.z()});
+        break;
+      case PositionFormat::Float16:
+        write(kPositionLocation, i,
+              std::array{math::quantize_half(position.x() - offset.x()),
+                         math::quantize_half(position.y() - offset.y()),
+                         math::quantize_half(position.z() - offset.z()),
+                         math::quantize_half(1.0F)});
+        break;
+      case PositionFormat::Snorm16:
+        write(kPositionLocation, i,
+              std::array{
+                  math::quantize_snorm<int16_t>(
+                      (position.x() - offset.x()) / scale),
+                  math::quantize_snorm<int16_t>(
+                      (position.y() - offset.y()) / scale),
+                  math::quantize_snorm<int16_t>(
+                      (position.z() - offset.z()) / scale),
+                  math::quantize_snorm<int16_t>(1.0F)});
+        break;
+    }
+
+    const auto normal = i < normals.size() ? normals[i] : math::Vec3f{};
+    switch (options_.normals) {
+      case NormalFormat::Float32:
+        write(kNormalLocation, i,
+              std::array{normal.x(), normal.y(), normal.z()});
+        break;
+      case NormalFormat::Octahedral16: {
+        const auto octahedral = math::octahedral_encode(normal);
+        write(kNormalLocation, i,
+              std::array{math::quantize_snorm<int16_t>(octahedral.x()),
+                         math::quantize_snorm<int16_t>(octahedral.y())});
+        break;
+      }
+    }
+
+    if (options_.colours == ColourFormat::Constant && i != 0) continue;
+
+    const auto colour = i < colours.size() ? colours[i] : math::Vec4f{1.0F};
+    switch (options_.colours) {
+      case ColourFormat::Float32:
+        write(kColourLocation, i,
+              std::array{colour.x(), colour.y(), colour.z(), colour.w()});
+        break;
+      case ColourFormat::Unorm8:
+      case ColourFormat::Constant:
+        write(kColourLocation, i,
+              std::array{math::quantize_unorm<uint8_t>(colour.x()),
+                         math::quantize_unorm<uint8_t>(colour.y()),
+                         math::quantize_unorm<uint8_t>(colour.z()),
+                         math::quantize_unorm<uint8_t>(colour.w())});
+        break;
+    }
+  }
+
+  return encoded;
+}
+
+}  // namespace wren::vk